@@ -1,8 +1,13 @@
 #include <sophiatx/chain/block_log.hpp>
+#include <sophiatx/chain/compressed_block_log.hpp>
+#include <atomic>
+#include <cstring>
 #include <fstream>
 #include <fc/io/raw.hpp>
 
 #include <boost/thread/mutex.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
 #include <boost/interprocess/sync/lock_options.hpp>
 
@@ -15,9 +20,35 @@ namespace sophiatx { namespace chain {
 
    boost::interprocess::defer_lock_type defer_lock;
 
+   namespace bip = boost::interprocess;
+
    namespace detail {
+      /* Read only mapping of a log file. The mapping may be larger than the file, only the part
+       * below the published offsets is ever accessed, so the bytes past the end of file are never touched.
+       */
+      class mapped_log_file {
+         public:
+            mapped_log_file( const fc::path& file, uint64_t size ) :
+               mapping( file.generic_string().c_str(), bip::read_only ),
+               region( mapping, bip::read_only, 0, size )
+            {}
+
+            const char* data()const { return static_cast< const char* >( region.get_address() ); }
+            uint64_t    size()const { return region.get_size(); }
+
+         private:
+            bip::file_mapping    mapping;
+            bip::mapped_region   region;
+      };
+
+      typedef std::shared_ptr< const mapped_log_file > mapped_log_file_ptr;
+
       class block_log_impl {
          public:
+            // Mappings grow in these steps so that appends rarely force readers to remap
+            static const uint64_t    block_map_step = 256 * 1024 * 1024;
+            static const uint64_t    index_map_step = 16 * 1024 * 1024;
+
             optional< signed_block > head;
             block_id_type            head_id;
             std::fstream             block_stream;
@@ -29,8 +60,65 @@ namespace sophiatx { namespace chain {
 
             bool                     use_locking = true;
 
+            /// Set when the log is opened by open_read_only(), nothing is then written to any of the files
+            bool                     read_only = false;
+
+            /// Set when the log is in the compressed format, all operations are then forwarded to it
+            std::unique_ptr< compressed_block_log > compressed;
+
             boost::mutex             mtx;
 
+            /* Readers go through the mappings without taking mtx. The writer publishes the end of the
+             * block file before the head block number, readers load them in the opposite order, so every
+             * block up to published_head_num lies completely below published_block_end.
+             */
+            std::atomic< uint32_t >  published_head_num{ 0 };
+            std::atomic< uint64_t >  published_block_end{ 0 };
+
+            mapped_log_file_ptr      block_map;
+            mapped_log_file_ptr      index_map;
+            boost::mutex             remap_mtx;
+
+            void publish( uint32_t head_num, uint64_t block_end )
+            {
+               published_block_end.store( block_end, std::memory_order_release );
+               published_head_num.store( head_num, std::memory_order_release );
+            }
+
+            /// Returns a mapping of at least required_size bytes, remapping the file if the current one is too small
+            mapped_log_file_ptr get_mapping( mapped_log_file_ptr& map, const fc::path& file, uint64_t required_size, uint64_t step )
+            {
+               auto current = std::atomic_load( &map );
+               if( current && current->size() >= required_size )
+                  return current;
+
+               scoped_lock lock( remap_mtx );
+               current = std::atomic_load( &map );
+               if( current && current->size() >= required_size )
+                  return current;
+
+               // Readers still holding the old mapping keep it alive until they are done
+               current = std::make_shared< const mapped_log_file >( file, ( required_size / step + 1 ) * step );
+               std::atomic_store( &map, current );
+               return current;
+            }
+
+            mapped_log_file_ptr get_block_mapping( uint64_t required_size )
+            {
+               return get_mapping( block_map, block_file, required_size, block_map_step );
+            }
+
+            mapped_log_file_ptr get_index_mapping( uint64_t required_size )
+            {
+               return get_mapping( index_map, index_file, required_size, index_map_step );
+            }
+
+            void reset_mappings()
+            {
+               std::atomic_store( &block_map, mapped_log_file_ptr() );
+               std::atomic_store( &index_map, mapped_log_file_ptr() );
+            }
+
             inline void check_block_read()
             {
                try
@@ -101,12 +189,26 @@ namespace sophiatx { namespace chain {
       flush();
    }
 
-   void block_log::open( const fc::path& file )
+   void block_log::open( const fc::path& file, uint32_t compressed_chunk_size )
    {
       if( my->block_stream.is_open() )
          my->block_stream.close();
       if( my->index_stream.is_open() )
          my->index_stream.close();
+      my->reset_mappings();
+      my->publish( 0, 0 );
+      my->compressed.reset();
+
+      // Existing logs keep their format, compressed_chunk_size only selects the format of a new log
+      bool new_log = !fc::exists( file ) || fc::file_size( file ) == 0;
+      if( compressed_block_log::is_compressed( file ) || ( new_log && compressed_chunk_size > 0 ) )
+      {
+         ilog( "Opening compressed block log" );
+         my->block_file = file;
+         my->compressed.reset( new compressed_block_log() );
+         my->compressed->open( file, compressed_chunk_size ? compressed_chunk_size : compressed_block_log::default_blocks_per_chunk );
+         return;
+      }
 
       my->block_file = file;
       my->index_file = fc::path( file.generic_string() + ".index" );
@@ -140,6 +242,7 @@ namespace sophiatx { namespace chain {
       if( log_size )
       {
          ilog( "Log is nonempty" );
+         my->publish( 0, log_size );
          my->head = read_head();
          my->head_id = my->head->id();
 
@@ -182,6 +285,50 @@ namespace sophiatx { namespace chain {
          my->index_stream.open( my->index_file.generic_string().c_str(), LOG_WRITE );
          my->index_write = true;
       }
+
+      // From now on the streams are only used for appending, all reads go through the mappings
+      my->check_block_write();
+      my->check_index_write();
+      my->index_stream.flush();
+      my->publish( my->head.has_value() ? my->head->block_num() : 0, log_size );
+   }
+
+   void block_log::open_read_only( const fc::path& file )
+   {
+      try
+      {
+         close();
+         my->read_only = true;
+         my->block_file = file;
+
+         FC_ASSERT( fc::exists( file ), "Block log does not exist.", ("file", file) );
+         if( compressed_block_log::is_compressed( file ) )
+         {
+            my->compressed.reset( new compressed_block_log() );
+            my->compressed->open_read_only( file );
+            return;
+         }
+
+         my->index_file = fc::path( file.generic_string() + ".index" );
+
+         auto log_size = fc::file_size( my->block_file );
+         if( !log_size )
+            return;
+
+         my->publish( 0, log_size );
+         my->head = read_head();
+         my->head_id = my->head->id();
+
+         // The index is rebuilt only by the writer, reads by block number need it to cover the whole log
+         uint32_t head_num = my->head->block_num();
+         auto index_size = fc::exists( my->index_file ) ? fc::file_size( my->index_file ) : 0;
+         FC_ASSERT( index_size == sizeof( uint64_t ) * head_num, "Block log index does not match the block log, it is rebuilt when a node opens the log.",
+            ("index_size", index_size)("head_block_num", head_num) );
+
+         my->publish( head_num, log_size );
+         FC_ASSERT( read_block_by_num( head_num )->id() == my->head_id, "Block log index does not point to the head block." );
+      }
+      FC_LOG_AND_RETHROW()
    }
 
    void block_log::close()
@@ -191,13 +338,23 @@ namespace sophiatx { namespace chain {
 
    bool block_log::is_open()const
    {
-      return my->block_stream.is_open();
+      if( my->compressed )
+         return my->compressed->is_open();
+
+      return my->block_stream.is_open() || ( my->read_only && my->block_file != fc::path() );
    }
 
    uint64_t block_log::append( const signed_block& b )
    {
       try
       {
+         if( my->compressed )
+         {
+            my->compressed->append( b );
+            return b.block_num() - 1;
+         }
+
+         FC_ASSERT( !my->read_only, "Block log is opened read only." );
          scoped_lock lock( my->mtx, defer_lock );
 
          if( my->use_locking )
@@ -216,8 +373,13 @@ namespace sophiatx { namespace chain {
          my->block_stream.write( data.data(), data.size() );
          my->block_stream.write( (char*)&pos, sizeof( pos ) );
          my->index_stream.write( (char*)&pos, sizeof( pos ) );
+
+         // Readers access the files through the mappings, hand the data over to the OS before publishing it
+         my->block_stream.flush();
+         my->index_stream.flush();
          my->head = b;
          my->head_id = b.id();
+         my->publish( b.block_num(), pos + data.size() + sizeof( pos ) );
 
          return pos;
       }
@@ -226,6 +388,9 @@ namespace sophiatx { namespace chain {
 
    void block_log::flush()
    {
+      if( my->compressed )
+         return my->compressed->flush();
+
       scoped_lock lock( my->mtx, defer_lock );
 
             if( my->use_locking )
@@ -239,11 +404,12 @@ namespace sophiatx { namespace chain {
 
    std::pair< signed_block, uint64_t > block_log::read_block( uint64_t pos )const
    {
-      scoped_lock lock( my->mtx, defer_lock );
-
-      if( my->use_locking )
+      if( my->compressed )
       {
-         lock.lock();;
+         // Positions in the compressed log are block numbers counted from zero
+         auto b = my->compressed->read_block_by_num( pos + 1 );
+         FC_ASSERT( b.has_value(), "Block position is past the end of block log.", ("pos", pos) );
+         return std::make_pair( std::move( *b ), pos + 1 );
       }
 
       return read_block_helper( pos );
@@ -253,12 +419,14 @@ namespace sophiatx { namespace chain {
    {
       try
       {
-         my->check_block_read();
+         uint64_t block_end = my->published_block_end.load( std::memory_order_acquire );
+         FC_ASSERT( pos < block_end, "Block position is past the end of block log.", ("pos", pos)("end", block_end) );
 
-         my->block_stream.seekg( pos );
+         auto map = my->get_block_mapping( block_end );
+         fc::datastream< const char* > ds( map->data() + pos, block_end - pos );
          std::pair<signed_block,uint64_t> result;
-         fc::raw::unpack( my->block_stream, result.first, 0 );
-         result.second = uint64_t(my->block_stream.tellg()) + 8;
+         fc::raw::unpack( ds, result.first, 0 );
+         result.second = pos + ds.tellp() + 8;
          return result;
       }
       FC_LOG_AND_RETHROW()
@@ -268,12 +436,8 @@ namespace sophiatx { namespace chain {
    {
       try
       {
-         scoped_lock lock( my->mtx, defer_lock );
-
-         if( my->use_locking )
-         {
-            lock.lock();;
-         }
+         if( my->compressed )
+            return my->compressed->read_block_by_num( block_num );
 
          optional< signed_block > b;
          uint64_t pos = get_block_pos_helper( block_num );
@@ -287,14 +451,56 @@ namespace sophiatx { namespace chain {
       FC_LOG_AND_RETHROW()
    }
 
-   uint64_t block_log::get_block_pos( uint32_t block_num ) const
+   std::vector< std::vector< char > > block_log::read_raw_blocks( uint32_t first_block_num, uint32_t count )const
    {
-      scoped_lock lock( my->mtx, defer_lock );
-
-      if( my->use_locking )
+      try
       {
-         lock.lock();;
+         std::vector< std::vector< char > > result;
+         if( count == 0 )
+            return result;
+
+         if( my->compressed )
+            return my->compressed->read_raw_blocks( first_block_num, count );
+
+         uint32_t head_num = my->published_head_num.load( std::memory_order_acquire );
+         uint64_t block_end = my->published_block_end.load( std::memory_order_acquire );
+         FC_ASSERT( first_block_num > 0 && uint64_t( first_block_num ) + count - 1 <= head_num,
+            "Requested blocks are not in block log.", ("first", first_block_num)("count", count)("head", head_num) );
+
+         // Block data spans from its position up to the back pointer preceding the next block
+         bool includes_head = uint64_t( first_block_num ) + count - 1 == head_num;
+         std::vector< uint64_t > positions( count + 1 );
+         auto index = my->get_index_mapping( sizeof( uint64_t ) * ( includes_head ? head_num : first_block_num + count ) );
+         memcpy( positions.data(), index->data() + sizeof( uint64_t ) * ( first_block_num - 1 ),
+            sizeof( uint64_t ) * ( includes_head ? count : count + 1 ) );
+
+         auto blocks = my->get_block_mapping( block_end );
+         if( includes_head )
+         {
+            // A block appended meanwhile may already be below block_end, find the end of the last block by unpacking it
+            fc::datastream< const char* > ds( blocks->data() + positions[ count - 1 ], block_end - positions[ count - 1 ] );
+            signed_block last;
+            fc::raw::unpack( ds, last, 0 );
+            positions[ count ] = positions[ count - 1 ] + ds.tellp() + sizeof( uint64_t );
+         }
+
+         result.reserve( count );
+         for( uint32_t i = 0; i < count; ++i )
+         {
+            const char* begin = blocks->data() + positions[ i ];
+            const char* end = blocks->data() + positions[ i + 1 ] - sizeof( uint64_t );
+            result.emplace_back( begin, end );
+         }
+
+         return result;
       }
+      FC_LOG_AND_RETHROW()
+   }
+
+   uint64_t block_log::get_block_pos( uint32_t block_num ) const
+   {
+      if( my->compressed )
+         return block_num > 0 && block_num <= my->compressed->head_block_num() ? block_num - 1 : npos;
 
       return get_block_pos_helper( block_num );
    }
@@ -303,13 +509,12 @@ namespace sophiatx { namespace chain {
    {
       try
       {
-         my->check_index_read();
-
-         if( !( my->head.has_value() && block_num <= protocol::block_header::num_from_id( my->head_id ) && block_num > 0 ) )
+         if( !( block_num > 0 && block_num <= my->published_head_num.load( std::memory_order_acquire ) ) )
             return npos;
-         my->index_stream.seekg( sizeof( uint64_t ) * ( block_num - 1 ) );
+
+         auto index = my->get_index_mapping( sizeof( uint64_t ) * block_num );
          uint64_t pos;
-         my->index_stream.read( (char*)&pos, sizeof( pos ) );
+         memcpy( &pos, index->data() + sizeof( uint64_t ) * ( block_num - 1 ), sizeof( pos ) );
          return pos;
       }
       FC_LOG_AND_RETHROW()
@@ -319,18 +524,16 @@ namespace sophiatx { namespace chain {
    {
       try
       {
-         scoped_lock lock( my->mtx, defer_lock );
-
-         if( my->use_locking )
-         {
-            lock.lock();;
-         }
+         if( my->compressed )
+            return my->compressed->read_head();
 
-         my->check_block_read();
+         // The last 8 bytes of the published part of the log point to the head block
+         uint64_t block_end = my->published_block_end.load( std::memory_order_acquire );
+         FC_ASSERT( block_end >= sizeof( uint64_t ), "Block log is empty." );
 
+         auto map = my->get_block_mapping( block_end );
          uint64_t pos;
-         my->block_stream.seekg( -sizeof(pos), std::ios::end );
-         my->block_stream.read( (char*)&pos, sizeof(pos) );
+         memcpy( &pos, map->data() + block_end - sizeof( pos ), sizeof( pos ) );
          return read_block_helper( pos ).first;
       }
       FC_LOG_AND_RETHROW()
@@ -338,6 +541,9 @@ namespace sophiatx { namespace chain {
 
    const optional< signed_block >& block_log::head()const
    {
+      if( my->compressed )
+         return my->compressed->head();
+
       scoped_lock lock( my->mtx, defer_lock );
 
       if( my->use_locking )
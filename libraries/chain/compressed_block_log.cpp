@@ -0,0 +1,496 @@
+#include <sophiatx/chain/compressed_block_log.hpp>
+#include <fc/compress/zlib.hpp>
+#include <fc/io/raw.hpp>
+
+#include <boost/thread/mutex.hpp>
+
+#include <cstring>
+#include <fstream>
+
+#define LOG_RW ( std::ios::in | std::ios::out | std::ios::binary )
+#define LOG_READ ( std::ios::in | std::ios::binary )
+
+namespace sophiatx { namespace chain {
+
+   typedef boost::unique_lock< boost::mutex > unique_lock;
+
+   namespace detail {
+      static const char       compressed_log_magic[8] = { 'S', 'P', 'H', 'X', 'Z', 'L', 'O', 'G' };
+      static const uint32_t   compressed_log_version = 1;
+      static const uint64_t   compressed_log_header_size = sizeof( compressed_log_magic ) + 2 * sizeof( uint32_t );
+
+      struct decoded_chunk
+      {
+         uint32_t                chunk_num = 0;
+         std::vector< char >     data;
+         /// Offsets of the blocks in data, the last entry is the end of the last block
+         std::vector< uint32_t > offsets;
+      };
+
+      class compressed_block_log_impl {
+         public:
+            optional< signed_block >                  head;
+            fc::path                                  block_file;
+            fc::path                                  index_file;
+            fc::path                                  tail_file;
+            std::fstream                              block_stream;
+            std::fstream                              index_stream;
+            std::fstream                              tail_stream;
+
+            /// Set when the log is opened by open_read_only(), nothing is then written to any of the files
+            bool                                      read_only = false;
+
+            uint32_t                                  blocks_per_chunk = 0;
+            std::vector< uint64_t >                   chunk_positions;
+            uint64_t                                  block_end = compressed_log_header_size;
+            std::vector< std::vector< char > >        tail_blocks;
+
+            /// Most recently decompressed chunk, serves sequential reads without decompressing the chunk again
+            std::shared_ptr< const decoded_chunk >    last_chunk;
+
+            boost::mutex                              mtx;
+
+            uint32_t head_num()const
+            {
+               return chunk_positions.size() * blocks_per_chunk + tail_blocks.size();
+            }
+
+            void open_stream( std::fstream& stream, const fc::path& file, std::ios::openmode extra = std::ios::openmode() )
+            {
+               if( stream.is_open() )
+                  stream.close();
+               stream.exceptions( std::fstream::failbit | std::fstream::badbit );
+               stream.open( file.generic_string().c_str(), ( read_only ? LOG_READ : LOG_RW ) | extra );
+            }
+
+            uint64_t existing_file_size( const fc::path& file )const
+            {
+               return fc::exists( file ) ? fc::file_size( file ) : 0;
+            }
+
+            void read_header()
+            {
+               char magic[ sizeof( compressed_log_magic ) ];
+               uint32_t version;
+               block_stream.seekg( 0 );
+               block_stream.read( magic, sizeof( magic ) );
+               block_stream.read( (char*)&version, sizeof( version ) );
+               block_stream.read( (char*)&blocks_per_chunk, sizeof( blocks_per_chunk ) );
+
+               FC_ASSERT( memcmp( magic, compressed_log_magic, sizeof( magic ) ) == 0, "Not a compressed block log.", ("file", block_file) );
+               FC_ASSERT( version == compressed_log_version, "Unsupported compressed block log version.", ("version", version) );
+               FC_ASSERT( blocks_per_chunk > 0, "Invalid number of blocks per chunk in compressed block log header." );
+            }
+
+            uint32_t read_chunk_size( uint64_t pos )
+            {
+               uint32_t size;
+               block_stream.seekg( pos );
+               block_stream.read( (char*)&size, sizeof( size ) );
+               return size;
+            }
+
+            void load_index()
+            {
+               uint64_t file_size = fc::file_size( block_file );
+               uint64_t index_size = existing_file_size( index_file );
+
+               chunk_positions.resize( index_size / sizeof( uint64_t ) );
+               if( chunk_positions.size() )
+               {
+                  index_stream.seekg( 0 );
+                  index_stream.read( (char*)chunk_positions.data(), chunk_positions.size() * sizeof( uint64_t ) );
+               }
+
+               bool valid = index_size % sizeof( uint64_t ) == 0;
+               if( valid && chunk_positions.size() )
+               {
+                  uint64_t last = chunk_positions.back();
+                  valid = chunk_positions.front() == compressed_log_header_size && last + sizeof( uint32_t ) <= file_size
+                     && last + sizeof( uint32_t ) + read_chunk_size( last ) == file_size;
+               }
+               else if( valid )
+               {
+                  valid = file_size == compressed_log_header_size;
+               }
+
+               if( !valid )
+               {
+                  ilog( "Reconstructing Compressed Block Log Index..." );
+                  chunk_positions.clear();
+
+                  uint64_t pos = compressed_log_header_size;
+                  while( pos + sizeof( uint32_t ) <= file_size )
+                  {
+                     uint64_t next = pos + sizeof( uint32_t ) + read_chunk_size( pos );
+                     if( next > file_size )
+                        break;
+                     chunk_positions.push_back( pos );
+                     pos = next;
+                  }
+
+                  if( pos != file_size )
+                  {
+                     // Blocks of an incomplete chunk are still in the tail file, it is written again from there
+                     wlog( "Dropping incomplete chunk at the end of compressed block log", ("pos", pos)("file_size", file_size) );
+                     if( !read_only )
+                     {
+                        block_stream.close();
+                        fc::resize_file( block_file, pos );
+                        open_stream( block_stream, block_file );
+                     }
+                  }
+
+                  if( !read_only )
+                  {
+                     open_stream( index_stream, index_file, std::ios::trunc );
+                     index_stream.write( (const char*)chunk_positions.data(), chunk_positions.size() * sizeof( uint64_t ) );
+                     index_stream.flush();
+                  }
+               }
+
+               block_end = chunk_positions.size() ? chunk_positions.back() + sizeof( uint32_t ) + read_chunk_size( chunk_positions.back() )
+                                                  : compressed_log_header_size;
+            }
+
+            void load_tail()
+            {
+               uint64_t tail_size = existing_file_size( tail_file );
+               uint32_t chunk_head_num = chunk_positions.size() * blocks_per_chunk;
+               bool rewrite = false;
+
+               tail_blocks.clear();
+               if( tail_size )
+                  tail_stream.seekg( 0 );
+               uint64_t pos = 0;
+               while( pos + sizeof( uint32_t ) <= tail_size )
+               {
+                  uint32_t size;
+                  tail_stream.read( (char*)&size, sizeof( size ) );
+                  if( pos + sizeof( uint32_t ) + size > tail_size )
+                     break;
+
+                  std::vector< char > data( size );
+                  tail_stream.read( data.data(), size );
+                  pos += sizeof( uint32_t ) + size;
+
+                  // The process may have stopped after the chunk was written but before the tail was emptied
+                  auto block_num = fc::raw::unpack_from_vector< signed_block >( data, 0 ).block_num();
+                  if( block_num <= chunk_head_num )
+                  {
+                     rewrite = true;
+                     continue;
+                  }
+
+                  FC_ASSERT( block_num == chunk_head_num + tail_blocks.size() + 1, "Unexpected block in compressed block log tail.",
+                     ("block_num", block_num)("expected", chunk_head_num + tail_blocks.size() + 1) );
+                  tail_blocks.push_back( std::move( data ) );
+               }
+
+               FC_ASSERT( tail_blocks.size() <= blocks_per_chunk, "Compressed block log tail holds more than one chunk of blocks.",
+                  ("tail_blocks", tail_blocks.size())("blocks_per_chunk", blocks_per_chunk) );
+
+               // A read only log serves a full tail from the tail blocks, they are only compressed by the writer
+               if( read_only )
+                  return;
+
+               if( rewrite || pos != tail_size )
+                  write_tail();
+
+               if( tail_blocks.size() >= blocks_per_chunk )
+                  write_chunk();
+            }
+
+            void write_tail()
+            {
+               open_stream( tail_stream, tail_file, std::ios::trunc );
+               for( const auto& data : tail_blocks )
+               {
+                  uint32_t size = data.size();
+                  tail_stream.write( (const char*)&size, sizeof( size ) );
+                  tail_stream.write( data.data(), data.size() );
+               }
+               tail_stream.flush();
+            }
+
+            /// Compresses the blocks of the tail into a new chunk and empties the tail
+            void write_chunk()
+            {
+               uint32_t count = tail_blocks.size();
+               std::vector< char > payload( sizeof( uint32_t ) * ( count + 1 ) );
+               memcpy( payload.data(), &count, sizeof( count ) );
+               for( uint32_t i = 0; i < count; ++i )
+               {
+                  uint32_t offset = payload.size() - sizeof( uint32_t ) * ( count + 1 );
+                  memcpy( payload.data() + sizeof( uint32_t ) * ( i + 1 ), &offset, sizeof( offset ) );
+                  payload.insert( payload.end(), tail_blocks[i].begin(), tail_blocks[i].end() );
+               }
+
+               auto compressed = fc::zlib_compress( payload.data(), payload.size() );
+               uint32_t size = compressed.size();
+               uint64_t pos = block_end;
+
+               block_stream.seekp( pos );
+               block_stream.write( (const char*)&size, sizeof( size ) );
+               block_stream.write( compressed.data(), compressed.size() );
+               block_stream.flush();
+
+               index_stream.seekp( chunk_positions.size() * sizeof( uint64_t ) );
+               index_stream.write( (const char*)&pos, sizeof( pos ) );
+               index_stream.flush();
+
+               chunk_positions.push_back( pos );
+               block_end = pos + sizeof( size ) + size;
+
+               tail_blocks.clear();
+               write_tail();
+            }
+
+            std::shared_ptr< const decoded_chunk > read_chunk( uint32_t chunk_num, unique_lock& lock )
+            {
+               if( last_chunk && last_chunk->chunk_num == chunk_num )
+                  return last_chunk;
+
+               uint64_t pos = chunk_positions[ chunk_num ];
+               std::vector< char > compressed( read_chunk_size( pos ) );
+               block_stream.read( compressed.data(), compressed.size() );
+
+               // Decompression does not touch shared state, let other readers in meanwhile
+               lock.unlock();
+               auto chunk = std::make_shared< decoded_chunk >();
+               chunk->chunk_num = chunk_num;
+               auto payload = fc::zlib_decompress( compressed.data(), compressed.size() );
+
+               uint32_t count;
+               FC_ASSERT( payload.size() >= sizeof( count ), "Corrupted chunk in compressed block log.", ("chunk", chunk_num) );
+               memcpy( &count, payload.data(), sizeof( count ) );
+               uint64_t header_size = sizeof( uint32_t ) * ( uint64_t( count ) + 1 );
+               FC_ASSERT( count == blocks_per_chunk && payload.size() >= header_size, "Corrupted chunk in compressed block log.",
+                  ("chunk", chunk_num)("count", count) );
+
+               chunk->offsets.resize( count + 1 );
+               memcpy( chunk->offsets.data(), payload.data() + sizeof( count ), sizeof( uint32_t ) * count );
+               chunk->offsets[ count ] = payload.size() - header_size;
+               chunk->data.assign( payload.begin() + header_size, payload.end() );
+               lock.lock();
+
+               last_chunk = chunk;
+               return chunk;
+            }
+
+            std::vector< char > read_raw_block( uint32_t block_num, unique_lock& lock )
+            {
+               uint32_t chunk_num = ( block_num - 1 ) / blocks_per_chunk;
+               uint32_t index = ( block_num - 1 ) % blocks_per_chunk;
+               if( chunk_num >= chunk_positions.size() )
+                  return tail_blocks[ index ];
+
+               auto chunk = read_chunk( chunk_num, lock );
+               FC_ASSERT( chunk->offsets[ index ] <= chunk->offsets[ index + 1 ] && chunk->offsets[ index + 1 ] <= chunk->data.size(),
+                  "Corrupted chunk in compressed block log.", ("chunk", chunk_num) );
+               return std::vector< char >( chunk->data.begin() + chunk->offsets[ index ], chunk->data.begin() + chunk->offsets[ index + 1 ] );
+            }
+      };
+   }
+
+   compressed_block_log::compressed_block_log()
+   :my( new detail::compressed_block_log_impl() )
+   {}
+
+   compressed_block_log::~compressed_block_log()
+   {
+      if( is_open() )
+         flush();
+   }
+
+   bool compressed_block_log::is_compressed( const fc::path& file )
+   {
+      if( !fc::exists( file ) || fc::file_size( file ) < sizeof( detail::compressed_log_magic ) )
+         return false;
+
+      char magic[ sizeof( detail::compressed_log_magic ) ];
+      std::ifstream stream( file.generic_string().c_str(), std::ios::in | std::ios::binary );
+      stream.read( magic, sizeof( magic ) );
+      return stream && memcmp( magic, detail::compressed_log_magic, sizeof( magic ) ) == 0;
+   }
+
+   void compressed_block_log::open( const fc::path& file, uint32_t blocks_per_chunk )
+   {
+      try
+      {
+         close();
+
+         my->block_file = file;
+         my->index_file = fc::path( file.generic_string() + ".index" );
+         my->tail_file = fc::path( file.generic_string() + ".tail" );
+
+         if( !fc::exists( my->block_file ) || fc::file_size( my->block_file ) == 0 )
+         {
+            FC_ASSERT( blocks_per_chunk > 0, "Compressed block log needs at least one block per chunk." );
+            ilog( "Creating compressed block log with ${n} blocks per chunk", ("n", blocks_per_chunk) );
+
+            std::ofstream header( my->block_file.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+            header.write( detail::compressed_log_magic, sizeof( detail::compressed_log_magic ) );
+            header.write( (const char*)&detail::compressed_log_version, sizeof( detail::compressed_log_version ) );
+            header.write( (const char*)&blocks_per_chunk, sizeof( blocks_per_chunk ) );
+            header.close();
+
+            fc::remove_all( my->index_file );
+            fc::remove_all( my->tail_file );
+         }
+
+         // Create the index and tail files if they are missing
+         std::ofstream( my->index_file.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::app );
+         std::ofstream( my->tail_file.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::app );
+
+         load();
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
+   void compressed_block_log::open_read_only( const fc::path& file )
+   {
+      try
+      {
+         close();
+
+         my->read_only = true;
+         my->block_file = file;
+         my->index_file = fc::path( file.generic_string() + ".index" );
+         my->tail_file = fc::path( file.generic_string() + ".tail" );
+
+         FC_ASSERT( is_compressed( file ), "Not a compressed block log.", ("file", file) );
+         load();
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
+   void compressed_block_log::load()
+   {
+      my->open_stream( my->block_stream, my->block_file );
+      if( fc::exists( my->index_file ) )
+         my->open_stream( my->index_stream, my->index_file );
+      if( fc::exists( my->tail_file ) )
+         my->open_stream( my->tail_stream, my->tail_file );
+
+      my->read_header();
+      my->load_index();
+      my->load_tail();
+
+      if( my->head_num() )
+      {
+         unique_lock lock( my->mtx );
+         my->head = fc::raw::unpack_from_vector< signed_block >( my->read_raw_block( my->head_num(), lock ), 0 );
+      }
+   }
+
+   void compressed_block_log::close()
+   {
+      my.reset( new detail::compressed_block_log_impl() );
+   }
+
+   bool compressed_block_log::is_open()const
+   {
+      return my->block_stream.is_open();
+   }
+
+   void compressed_block_log::append( const signed_block& b )
+   {
+      try
+      {
+         unique_lock lock( my->mtx );
+
+         FC_ASSERT( !my->read_only, "Compressed block log is opened read only." );
+         FC_ASSERT( b.block_num() == my->head_num() + 1, "Append to compressed block log occuring at wrong position.",
+            ("block_num", b.block_num())("expected", my->head_num() + 1) );
+
+         auto data = fc::raw::pack_to_vector( b );
+         uint32_t size = data.size();
+         my->tail_stream.seekp( 0, std::ios::end );
+         my->tail_stream.write( (const char*)&size, sizeof( size ) );
+         my->tail_stream.write( data.data(), data.size() );
+         my->tail_stream.flush();
+
+         my->tail_blocks.push_back( std::move( data ) );
+         my->head = b;
+
+         if( my->tail_blocks.size() >= my->blocks_per_chunk )
+            my->write_chunk();
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
+   void compressed_block_log::flush()
+   {
+      unique_lock lock( my->mtx );
+      my->block_stream.flush();
+      my->index_stream.flush();
+      my->tail_stream.flush();
+   }
+
+   optional< signed_block > compressed_block_log::read_block_by_num( uint32_t block_num )const
+   {
+      try
+      {
+         unique_lock lock( my->mtx );
+
+         optional< signed_block > b;
+         if( block_num > 0 && block_num <= my->head_num() )
+         {
+            b = fc::raw::unpack_from_vector< signed_block >( my->read_raw_block( block_num, lock ), 0 );
+            FC_ASSERT( b->block_num() == block_num , "Wrong block was read from block log.", ( "returned", b->block_num() )( "expected", block_num ));
+         }
+         return b;
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
+   std::vector< std::vector< char > > compressed_block_log::read_raw_blocks( uint32_t first_block_num, uint32_t count )const
+   {
+      try
+      {
+         unique_lock lock( my->mtx );
+
+         FC_ASSERT( first_block_num > 0 && uint64_t( first_block_num ) + count - 1 <= my->head_num(),
+            "Requested blocks are not in block log.", ("first", first_block_num)("count", count)("head", my->head_num()) );
+
+         std::vector< std::vector< char > > result;
+         result.reserve( count );
+         for( uint32_t i = 0; i < count; ++i )
+            result.push_back( my->read_raw_block( first_block_num + i, lock ) );
+         return result;
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
+   signed_block compressed_block_log::read_head()const
+   {
+      auto head_num = head_block_num();
+      FC_ASSERT( head_num > 0, "Block log is empty." );
+      return *read_block_by_num( head_num );
+   }
+
+   const optional< signed_block >& compressed_block_log::head()const
+   {
+      unique_lock lock( my->mtx );
+      return my->head;
+   }
+
+   uint32_t compressed_block_log::head_block_num()const
+   {
+      unique_lock lock( my->mtx );
+      return my->head_num();
+   }
+
+   uint32_t compressed_block_log::blocks_per_chunk()const
+   {
+      return my->blocks_per_chunk;
+   }
+
+   uint32_t compressed_block_log::chunk_count()const
+   {
+      unique_lock lock( my->mtx );
+      return my->chunk_positions.size();
+   }
+
+} } // sophiatx::chain
@@ -14,6 +14,7 @@
 #include <sophiatx/chain/custom_content_object.hpp>
 #include <sophiatx/chain/transaction_object.hpp>
 #include <sophiatx/chain/shared_db_merkle.hpp>
+#include <sophiatx/chain/state_snapshot.hpp>
 #include <sophiatx/chain/operation_notification.hpp>
 #include <sophiatx/chain/witness_schedule.hpp>
 #include <sophiatx/chain/application_object.hpp>
@@ -27,12 +28,19 @@
 
 #include <fc/io/fstream.hpp>
 
+#include <sophiatx/chain/util/bounded_queue.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/bind.hpp>
 #include <boost/scope_exit.hpp>
+#include <boost/thread.hpp>
 
 #include <cstdint>
 #include <deque>
 #include <fstream>
 #include <functional>
+#include <future>
+#include <thread>
 
 namespace sophiatx { namespace chain {
 
@@ -84,13 +92,29 @@ void database::open( const open_args& args, const genesis_state_type& genesis)
       initialize_indexes();
       initialize_evaluators();
 
-      if( !find< dynamic_global_property_object >() )
+      if( is_read_only() )
+      {
+         // The state, the block log and the undo history belong to the node which has the database opened read write
+         with_read_lock( [&]()
+         {
+            FC_ASSERT( find< dynamic_global_property_object >(), "Read only database has not been initialized by a node yet" );
+            init_hardforks();
+         });
+         return;
+      }
+
+      if( args.snapshot_import != fc::path() )
+         with_write_lock( [&]()
+         {
+            import_snapshot( args.snapshot_import, chain_id );
+         });
+      else if( !find< dynamic_global_property_object >() )
          with_write_lock( [&]()
          {
             init_genesis( genesis, chain_id);
          });
 
-      _block_log.open( args.shared_mem_dir / "block_log" );
+      _block_log.open( args.shared_mem_dir / "block_log", args.block_log_chunk_size );
 
       auto log_head = _block_log.head();
 
@@ -100,6 +124,7 @@ void database::open( const open_args& args, const genesis_state_type& genesis)
          undo_all();
          FC_ASSERT( revision() == head_block_num(), "Chainbase revision does not match head block num",
             ("rev", revision())("head_block", head_block_num()) );
+         set_flat_undo( args.flat_undo_log );
          if (args.do_validate_invariants)
             validate_invariants();
       });
@@ -169,7 +194,6 @@ uint32_t database::reindex( const open_args& args, const genesis_state_type& gen
       with_write_lock( [&]()
       {
          _block_log.set_locking( false );
-         auto itr = _block_log.read_block( 0 );
          auto last_block_num = _block_log.head()->block_num();
          if( args.stop_replay_at > 0 && args.stop_replay_at < last_block_num )
             last_block_num = args.stop_replay_at;
@@ -178,24 +202,43 @@ uint32_t database::reindex( const open_args& args, const genesis_state_type& gen
             args.benchmark.second( 0, get_abstract_index_cntr() );
          }
 
-         while( itr.first.block_num() != last_block_num )
+         _replay_stage_stats.clear();
+         _replay_stage_stats.resize( 1 );
+         _replay_stage_stats[0].stage = "apply";
+
+         auto apply_replayed_block = [&]( const signed_block& block, const block_ids* ids )
          {
-            auto cur_block_num = itr.first.block_num();
+            auto cur_block_num = block.block_num();
             if( cur_block_num % 10000 == 0 )
                std::cerr << "   " << double( cur_block_num * 100 ) / last_block_num << "%   " << cur_block_num << " of " << last_block_num <<
                "   (" << (get_free_memory() / (1024*1024)) << "M free)\n";
-            apply_block( itr.first, skip_flags );
+
+            auto start = fc::time_point::now();
+            apply_block( block, skip_flags, ids );
+            _replay_stage_stats[0].busy_us += ( fc::time_point::now() - start ).count();
+            ++_replay_stage_stats[0].blocks;
+            last_block_number = cur_block_num;
 
             if( (args.benchmark.first > 0) && (cur_block_num % args.benchmark.first == 0) )
                args.benchmark.second( cur_block_num, get_abstract_index_cntr() );
-            itr = _block_log.read_block( itr.second );
+         };
+
+         if( args.replay_decode_threads > 0 )
+         {
+            replay_blocks_pipelined( last_block_num, args, apply_replayed_block );
          }
+         else
+         {
+            auto itr = _block_log.read_block( 0 );
+            while( itr.first.block_num() != last_block_num )
+            {
+               apply_replayed_block( itr.first, nullptr );
+               itr = _block_log.read_block( itr.second );
+            }
 
-         apply_block( itr.first, skip_flags );
-         last_block_number = itr.first.block_num();
+            apply_replayed_block( itr.first, nullptr );
+         }
 
-         if( (args.benchmark.first > 0) && (last_block_number % args.benchmark.first == 0) )
-            args.benchmark.second( last_block_number, get_abstract_index_cntr() );
          set_revision( head_block_num() );
          _block_log.set_locking( true );
       });
@@ -214,6 +257,131 @@ uint32_t database::reindex( const open_args& args, const genesis_state_type& gen
 
 }
 
+namespace {
+   template< typename BlockIds >
+   struct replay_batch
+   {
+      std::vector< signed_block >  blocks;
+      std::vector< BlockIds >      ids;
+   };
+}
+
+void database::replay_blocks_pipelined( uint32_t last_block_num, const open_args& args,
+                                        const std::function< void( const signed_block&, const block_ids* ) >& apply )
+{
+   const uint32_t batch_size = 100;
+
+   typedef replay_batch< block_ids > batch_type;
+
+   util::bounded_queue< std::future< batch_type > > batches( std::max< uint32_t >( args.replay_queue_size, 1 ) );
+   std::atomic< uint64_t > read_blocks( 0 ), read_us( 0 ), read_wait_us( 0 ), decoded_blocks( 0 ), decode_us( 0 );
+
+   _replay_stage_stats.resize( 3 );
+   _replay_stage_stats[1].stage = "read";
+   _replay_stage_stats[2].stage = "decode";
+   auto update_stage_stats = [&]()
+   {
+      _replay_stage_stats[1].blocks = read_blocks;
+      _replay_stage_stats[1].busy_us = read_us;
+      _replay_stage_stats[1].wait_us = read_wait_us;
+      _replay_stage_stats[2].blocks = decoded_blocks;
+      _replay_stage_stats[2].busy_us = decode_us;
+   };
+
+   boost::asio::io_service decode_ios;
+   std::unique_ptr< boost::asio::io_service::work > decode_work( new boost::asio::io_service::work( decode_ios ) );
+   boost::thread_group decoders;
+   for( uint32_t i = 0; i < args.replay_decode_threads; ++i )
+      decoders.create_thread( boost::bind( &boost::asio::io_service::run, &decode_ios ) );
+
+   // Reads raw batches from the block log and hands them to the decoder pool. Futures are queued
+   // in block order, so the apply loop consumes them in order regardless of which decoder finishes first.
+   std::thread reader( [&]()
+   {
+      for( uint32_t first = 1; first <= last_block_num; first += batch_size )
+      {
+         uint32_t count = std::min( batch_size, last_block_num - first + 1 );
+         auto prom = std::make_shared< std::promise< batch_type > >();
+         auto fut = prom->get_future();
+         bool read_failed = false;
+
+         try
+         {
+            auto start = fc::time_point::now();
+            auto raw = std::make_shared< std::vector< std::vector< char > > >( _block_log.read_raw_blocks( first, count ) );
+            read_us += ( fc::time_point::now() - start ).count();
+            read_blocks += count;
+
+            decode_ios.post( [prom, raw, &decoded_blocks, &decode_us]()
+            {
+               try
+               {
+                  auto start = fc::time_point::now();
+                  batch_type batch;
+                  batch.blocks.resize( raw->size() );
+                  batch.ids.resize( raw->size() );
+                  for( size_t i = 0; i < raw->size(); ++i )
+                  {
+                     fc::raw::unpack_from_vector( (*raw)[i], batch.blocks[i], 0 );
+                     batch.ids[i].block_id = batch.blocks[i].id();
+                     batch.ids[i].transaction_ids.reserve( batch.blocks[i].transactions.size() );
+                     for( const auto& trx : batch.blocks[i].transactions )
+                        batch.ids[i].transaction_ids.push_back( trx.id() );
+                  }
+                  decode_us += ( fc::time_point::now() - start ).count();
+                  decoded_blocks += batch.blocks.size();
+                  prom->set_value( std::move( batch ) );
+               }
+               catch( ... )
+               {
+                  prom->set_exception( std::current_exception() );
+               }
+            });
+         }
+         catch( ... )
+         {
+            prom->set_exception( std::current_exception() );
+            read_failed = true;
+         }
+
+         auto start = fc::time_point::now();
+         if( !batches.push( std::move( fut ) ) || read_failed )
+            break;
+         read_wait_us += ( fc::time_point::now() - start ).count();
+      }
+   });
+
+   BOOST_SCOPE_EXIT(&batches, &reader, &decode_work, &decode_ios, &decoders) {
+      batches.close();
+      reader.join();
+      decode_work.reset();
+      decode_ios.stop();
+      decoders.join_all();
+   } BOOST_SCOPE_EXIT_END
+
+   block_id_type previous_id = head_block_id();
+   uint32_t applied = 0;
+   std::future< batch_type > fut;
+   while( applied < last_block_num )
+   {
+      auto start = fc::time_point::now();
+      SOPHIATX_ASSERT( batches.pop( fut ), block_log_exception, "Replay pipeline stopped at block ${n}", ("n", applied) );
+      batch_type batch = fut.get();
+      _replay_stage_stats[0].wait_us += ( fc::time_point::now() - start ).count();
+
+      for( size_t i = 0; i < batch.blocks.size(); ++i )
+      {
+         SOPHIATX_ASSERT( batch.blocks[i].previous == previous_id, block_log_exception,
+                          "Block ${n} in block log does not link to previous block", ("n", applied + 1) );
+         previous_id = batch.ids[i].block_id;
+
+         update_stage_stats();
+         apply( batch.blocks[i], &batch.ids[i] );
+         ++applied;
+      }
+   }
+}
+
 void database::close(bool rewind)
 {
    try
@@ -223,7 +391,8 @@ void database::close(bool rewind)
       // DB state (issue #336).
       clear_pending();
 
-      chainbase::database::flush();
+      if( !is_read_only() )
+         chainbase::database::flush();
       chainbase::database::close();
 
       _block_log.close();
@@ -233,6 +402,47 @@ void database::close(bool rewind)
    FC_CAPTURE_AND_RETHROW()
 }
 
+fc::sha256 database::export_snapshot( const fc::path& file )
+{ try {
+   FC_ASSERT( !_pending_tx_session.has_value(), "Cannot export a snapshot while pending transactions are applied" );
+
+   snapshot_header header;
+   header.chain_id = get_chain_id();
+   header.head_block_num = head_block_num();
+   header.head_block_id = head_block_id();
+   header.head_block_time = head_block_time();
+
+   auto start = fc::time_point::now();
+   auto digest = sophiatx::chain::export_snapshot( *this, header, file );
+   ilog( "Exported state at block ${b} to ${f} in ${t} ms, state digest ${d}",
+      ("b", header.head_block_num)("f", file)("t", ( fc::time_point::now() - start ).count() / 1000)("d", digest) );
+   return digest;
+} FC_CAPTURE_AND_RETHROW( (file) ) }
+
+fc::sha256 database::get_state_digest()
+{ try {
+   snapshot_header header;
+   header.chain_id = get_chain_id();
+   header.head_block_num = head_block_num();
+   header.head_block_id = head_block_id();
+   header.head_block_time = head_block_time();
+   return sophiatx::chain::export_snapshot( *this, header );
+} FC_CAPTURE_AND_RETHROW() }
+
+void database::import_snapshot( const fc::path& file, const chain_id_type& chain_id )
+{ try {
+   ilog( "Importing state from snapshot ${f}", ("f", file) );
+   auto start = fc::time_point::now();
+
+   auto header = sophiatx::chain::import_snapshot( *this, file, chain_id );
+   set_revision( header.head_block_num );
+
+   FC_ASSERT( head_block_num() == header.head_block_num && head_block_id() == header.head_block_id,
+      "Imported state does not match the head block of the snapshot", ("head", head_block_id())("snapshot", header.head_block_id) );
+
+   ilog( "Imported state at block ${b} in ${t} ms", ("b", header.head_block_num)("t", ( fc::time_point::now() - start ).count() / 1000) );
+} FC_CAPTURE_AND_RETHROW( (file) ) }
+
 bool database::is_known_block( const block_id_type& id )const
 { try {
    return fetch_block_by_id( id ).has_value();
@@ -436,7 +646,7 @@ void database::pay_fee( const account_object& account, asset fee )
    if( fee.amount == 0 )
       return;
 
-   FC_ASSERT(fee.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"));
+   FC_ASSERT(fee.symbol == chain::sophiatx_config::params().symbol);
 
    FC_ASSERT( account.balance >= fee );
    adjust_balance( account, -fee );
@@ -456,7 +666,7 @@ asset database::process_operation_fee( const operation& op )
       typedef asset result_type;
       result_type operator()(const base_operation& bop){
          if(bop.has_special_fee() || db->is_private_net())
-            return asset(0, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"));
+            return asset(0, chain::sophiatx_config::params().symbol);
          asset req_fee = bop.get_required_fee(bop.fee.symbol);
          FC_ASSERT(bop.fee.symbol == req_fee.symbol, "fee cannot be paid in with symbol ${s}", ("s", bop.fee.symbol));
          FC_ASSERT(bop.fee >= req_fee);
@@ -464,12 +674,12 @@ asset database::process_operation_fee( const operation& op )
          const auto& fee_payer = db->get_account(sponsor? *sponsor : bop.get_fee_payer());
 
          asset to_pay;
-         if(bop.fee.symbol==chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL")){
+         if(bop.fee.symbol==chain::sophiatx_config::params().symbol){
             to_pay = bop.fee;
          }else{
             to_pay = db->to_sophiatx(bop.fee);
          }
-         FC_ASSERT(to_pay.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") && to_pay.amount >= 0);
+         FC_ASSERT(to_pay.symbol == chain::sophiatx_config::params().symbol && to_pay.amount >= 0);
          db->pay_fee(fee_payer, to_pay);
          return to_pay;
       };
@@ -669,7 +879,7 @@ void database::push_transaction( const signed_transaction& trx, uint32_t skip )
    {
       try
       {
-         FC_ASSERT( fc::raw::pack_size(trx) <= chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_TRANSACTION_SIZE"), "Transaction size is bigger than SOPHIATX_MAX_TRANSACTION_SIZE");
+         FC_ASSERT( fc::raw::pack_size(trx) <= chain::sophiatx_config::params().max_transaction_size, "Transaction size is bigger than SOPHIATX_MAX_TRANSACTION_SIZE");
          set_producing( true );
          detail::with_skip_flags( *this, skip,
             [&]()
@@ -847,7 +1057,7 @@ signed_block database::_generate_block(
    // TODO:  Move this to _push_block() so session is restored.
    if( !(skip & skip_block_size_check) )
    {
-      FC_ASSERT( fc::raw::pack_size(pending_block) <= chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_BLOCK_SIZE") );
+      FC_ASSERT( fc::raw::pack_size(pending_block) <= chain::sophiatx_config::params().max_block_size );
    }
 
    push_block( pending_block, skip );
@@ -890,6 +1100,30 @@ void database::clear_pending()
    FC_CAPTURE_AND_RETHROW()
 }
 
+void database::set_signature_recovery_threads( uint32_t threads )
+{
+   if( threads == 0 )
+      _signature_recovery_pool.reset();
+   else if( !_signature_recovery_pool || _signature_recovery_pool->thread_count() != threads )
+      _signature_recovery_pool.reset( new signature_recovery_pool( threads ) );
+}
+
+void database::set_signature_key_cache_size( size_t max_keys )
+{
+   if( max_keys == 0 )
+      _signature_key_cache.reset();
+   else
+      _signature_key_cache.reset( new signature_key_cache( max_keys ) );
+}
+
+optional<signature_key_cache::stats> database::get_signature_key_cache_stats()const
+{
+   optional<signature_key_cache::stats> result;
+   if( _signature_key_cache )
+      result = _signature_key_cache->get_stats();
+   return result;
+}
+
 account_name_type database::get_scheduled_witness( uint32_t slot_num )const
 {
    const dynamic_global_property_object& dpo = get_dynamic_global_properties();
@@ -904,7 +1138,7 @@ fc::time_point_sec database::get_slot_time(uint32_t slot_num)const
    if( slot_num == 0 )
       return fc::time_point_sec();
 
-   auto interval = chain::sophiatx_config::get<uint32_t>("SOPHIATX_BLOCK_INTERVAL");
+   auto interval = chain::sophiatx_config::params().block_interval;
    const dynamic_global_property_object& dpo = get_dynamic_global_properties();
 
    if( head_block_num() == 0 )
@@ -929,7 +1163,7 @@ uint32_t database::get_slot_at_time(fc::time_point_sec when)const
    fc::time_point_sec first_slot_time = get_slot_time( 1 );
    if( when < first_slot_time )
       return 0;
-   return (when - first_slot_time).to_seconds() / chain::sophiatx_config::get<uint32_t>("SOPHIATX_BLOCK_INTERVAL") + 1;
+   return (when - first_slot_time).to_seconds() / chain::sophiatx_config::params().block_interval + 1;
 }
 
 void  database::vest( const account_name_type& name, const share_type delta)
@@ -1060,7 +1294,7 @@ void database::clear_null_account_balance()
 {
 
    const auto& null_account = get_account( SOPHIATX_NULL_ACCOUNT );
-   asset total_sophiatx( 0, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") );
+   asset total_sophiatx( 0, chain::sophiatx_config::params().symbol );
 
    if( null_account.balance.amount > 0 )
    {
@@ -1158,7 +1392,7 @@ void database::process_vesting_withdrawals()
       //if( to_withdraw > 0 )
       //   adjust_proxied_witness_votes( from_account, -to_withdraw );
 
-      push_virtual_operation( fill_vesting_withdraw_operation( from_account.name, from_account.name, asset( to_withdraw, VESTS_SYMBOL ), asset( to_withdraw, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") ) ) );
+      push_virtual_operation( fill_vesting_withdraw_operation( from_account.name, from_account.name, asset( to_withdraw, VESTS_SYMBOL ), asset( to_withdraw, chain::sophiatx_config::params().symbol ) ) );
    }
 }
 
@@ -1204,7 +1438,7 @@ void database::process_funds()
 
    modify( props, [&]( dynamic_global_property_object& p )
    {
-        p.current_supply           += asset( witness_reward, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") );
+        p.current_supply           += asset( witness_reward, chain::sophiatx_config::params().symbol );
         p.total_vesting_shares     += asset( witness_reward, VESTS_SYMBOL );
    });
 
@@ -1325,6 +1559,7 @@ void database::initialize_indexes()
    add_core_index< application_index                       >(shared_from_this());
    add_core_index< application_buying_index                >(shared_from_this());
    add_core_index< custom_content_index                    >(shared_from_this());
+   add_core_index< custom_content_recipient_index          >(shared_from_this());
    add_core_index< account_fee_sponsor_index               >(shared_from_this());
    add_core_index< account_bandwidth_index                 >(shared_from_this());
    _plugin_index_signal();
@@ -1387,7 +1622,7 @@ void database::init_genesis( genesis_state_type genesis, chain_id_type chain_id)
                                 {
                                      a.name = SOPHIATX_INIT_MINER_NAME;
                                      a.memo_key = init_public_key;
-                                     a.balance  = asset( genesis.initial_balace, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") );
+                                     a.balance  = asset( genesis.initial_balace, chain::sophiatx_config::params().symbol );
                                      a.holdings_considered_for_interests = a.balance.amount * 2;
                                 } );
 
@@ -1402,10 +1637,10 @@ void database::init_genesis( genesis_state_type genesis, chain_id_type chain_id)
       create< witness_object >( [&]( witness_object& w )
                                 {
                                      w.owner        = SOPHIATX_INIT_MINER_NAME;
-                                     w.signing_key  = chain::sophiatx_config::get<protocol::public_key_type>("SOPHIATX_INIT_PUBLIC_MINING_KEY");
+                                     w.signing_key  = chain::sophiatx_config::params().init_public_mining_key;
                                      w.schedule = witness_object::top19;
                                      if(genesis.is_private_net)
-                                        w.props.account_creation_fee = asset (0, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"));
+                                        w.props.account_creation_fee = asset (0, chain::sophiatx_config::params().symbol);
                                 } );
 
       for( const auto &acc: genesis.initial_accounts) {
@@ -1424,7 +1659,7 @@ void database::init_genesis( genesis_state_type genesis, chain_id_type chain_id)
             create<account_object>([ & ](account_object &a) {
                  a.name = acc.name;
                  a.memo_key = acc.key;
-                 a.balance = asset(acc.balance, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"));
+                 a.balance = asset(acc.balance, chain::sophiatx_config::params().symbol);
                  a.holdings_considered_for_interests = a.balance.amount * 2;
                  a.recovery_account = SOPHIATX_INIT_MINER_NAME;
                  a.reset_account = SOPHIATX_INIT_MINER_NAME;
@@ -1445,9 +1680,9 @@ void database::init_genesis( genesis_state_type genesis, chain_id_type chain_id)
          p.time = genesis.genesis_time;
          p.recent_slots_filled = fc::uint128::max_value();
          p.participation_count = 128;
-         p.current_supply = asset( total_initial_balance, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") );
-         p.maximum_block_size = chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_BLOCK_SIZE");
-         p.witness_required_vesting = asset(genesis.is_private_net? 0 : chain::sophiatx_config::get<uint64_t>("SOPHIATX_INITIAL_WITNESS_REQUIRED_VESTING_BALANCE"), VESTS_SYMBOL);
+         p.current_supply = asset( total_initial_balance, chain::sophiatx_config::params().symbol );
+         p.maximum_block_size = chain::sophiatx_config::params().max_block_size;
+         p.witness_required_vesting = asset(genesis.is_private_net? 0 : chain::sophiatx_config::params().initial_witness_required_vesting_balance, VESTS_SYMBOL);
          p.genesis_time = genesis.genesis_time;
          p.chain_id = chain_id;
          p.private_net = genesis.is_private_net;
@@ -1455,7 +1690,7 @@ void database::init_genesis( genesis_state_type genesis, chain_id_type chain_id)
 
       create< economic_model_object >( [&]( economic_model_object& e )
                                                 {
-                                                    e.init_economics(total_initial_balance, chain::sophiatx_config::get<int64_t>("SOPHIATX_TOTAL_SUPPLY"));
+                                                    e.init_economics(total_initial_balance, chain::sophiatx_config::params().total_supply);
                                                 } );
       // Nothing to do
       create< feed_history_object >( [&]( feed_history_object& o ) {o.symbol = SBD1_SYMBOL;});
@@ -1475,7 +1710,7 @@ void database::init_genesis( genesis_state_type genesis, chain_id_type chain_id)
       // Create witness scheduler
       create< witness_schedule_object >( [&]( witness_schedule_object& wso )
       {
-         wso.current_shuffled_witnesses.reserve(chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_WITNESSES"));
+         wso.current_shuffled_witnesses.reserve(chain::sophiatx_config::params().max_witnesses);
          wso.current_shuffled_witnesses.emplace_back(SOPHIATX_INIT_MINER_NAME);
       } );
    }
@@ -1524,16 +1759,26 @@ void database::notify_changed_objects()
 
 //////////////////// private methods ////////////////////
 
-void database::apply_block( const signed_block& next_block, uint32_t skip )
+void database::apply_block( const signed_block& next_block, uint32_t skip, const block_ids* ids )
 { try {
    //fc::time_point begin_time = fc::time_point::now();
 
+   _precomputed_ids = ids;
+   _precomputed_ids_block = ids ? &next_block : nullptr;
+   BOOST_SCOPE_EXIT(this_) {
+      this_->_precomputed_ids = nullptr;
+      this_->_precomputed_ids_block = nullptr;
+   } BOOST_SCOPE_EXIT_END
+
    auto block_num = next_block.block_num();
    if( _checkpoints.size() && _checkpoints.rbegin()->second != block_id_type() )
    {
       auto itr = _checkpoints.find( block_num );
       if( itr != _checkpoints.end() )
-         FC_ASSERT( next_block.id() == itr->second, "Block did not match checkpoint", ("checkpoint",*itr)("block_id",next_block.id()) );
+      {
+         auto block_id = applied_block_id( next_block );
+         FC_ASSERT( block_id == itr->second, "Block did not match checkpoint", ("checkpoint",*itr)("block_id",block_id) );
+      }
 
       if( _checkpoints.rbegin()->first >= block_num )
          skip = skip_witness_signature
@@ -1657,11 +1902,28 @@ void database::_apply_block( const signed_block& next_block )
       }
    }
 
+   BOOST_SCOPE_EXIT(this_) {
+      this_->_recovered_block_keys.reset();
+      this_->_recovered_keys_block = nullptr;
+   } BOOST_SCOPE_EXIT_END
+
+   bool recover_witness = !( skip & skip_witness_signature );
+   bool recover_transactions = !( skip & ( skip_transaction_signatures | skip_authority_check ) ) && next_block.transactions.size();
+   if( _signature_recovery_pool && ( recover_witness || recover_transactions ) )
+   {
+      _recovered_block_keys = _signature_recovery_pool->recover( next_block, get_chain_id(),
+            has_hardfork(SOPHIATX_HARDFORK_1_1) ? fc::ecc::bip_0062 : fc::ecc::fc_canonical,
+            recover_witness, recover_transactions, _signature_key_cache.get() );
+      _recovered_keys_block = &next_block;
+   }
+
    const witness_object& signing_witness = validate_block_header(skip, next_block);
 
    _current_block_num    = next_block_num;
    _current_trx_in_block = 0;
 
+   notify_pre_apply_block( next_block );
+
    const auto& gprops = get_dynamic_global_properties();
    auto block_size = fc::raw::pack_size( next_block );
    FC_ASSERT( block_size <= gprops.maximum_block_size, "Block Size is too Big", ("next_block_num",next_block_num)("block_size", block_size)("max",gprops.maximum_block_size) );
@@ -1836,7 +2098,7 @@ void database::process_interests() {
       while( const account_object *a = find_account(id)) {
          share_type interest = 0;
 
-         if( head_block_num() > chain::sophiatx_config::get<uint32_t>("SOPHIATX_INTEREST_DELAY")) {
+         if( head_block_num() > chain::sophiatx_config::params().interest_delay) {
             modify(econ, [ & ](economic_model_object &eo) {
                interest = eo.withdraw_interests(a->holdings_considered_for_interests,
                      std::min(uint32_t(interest_blocks), head_block_num()));
@@ -1845,7 +2107,7 @@ void database::process_interests() {
 
          if( interest > 0 ) {
             supply_increase += interest;
-            push_virtual_operation(interest_operation(a->name, asset(interest, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"))));
+            push_virtual_operation(interest_operation(a->name, asset(interest, chain::sophiatx_config::params().symbol)));
             if( has_hardfork(SOPHIATX_HARDFORK_1_1))
                adjust_proxied_witness_votes(*a, interest);
          }
@@ -1857,7 +2119,7 @@ void database::process_interests() {
          id += interest_blocks;
       }
 
-      adjust_supply(asset(supply_increase, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL")));
+      adjust_supply(asset(supply_increase, chain::sophiatx_config::params().symbol));
    }FC_CAPTURE_AND_RETHROW()
 }
 
@@ -1871,7 +2133,7 @@ void database::process_header_extensions( const signed_block& next_block )
 
 void database::update_median_feeds() {
 try {
-   if( (head_block_num() % chain::sophiatx_config::get<uint32_t>("SOPHIATX_BLOCKS_PER_HOUR")) != 0 )
+   if( (head_block_num() % chain::sophiatx_config::params().blocks_per_hour) != 0 )
       return;
 
    auto now = head_block_time();
@@ -1888,7 +2150,7 @@ try {
    }
 
    for ( const auto& feed: all_feeds){
-      if( feed.second.size() >= chain::sophiatx_config::get<size_t>("SOPHIATX_MIN_FEEDS"))
+      if( feed.second.size() >= chain::sophiatx_config::params().min_feeds)
       {
          vector<price> f = feed.second;
          std::sort( f.begin(), f.end() );
@@ -1914,9 +2176,23 @@ void database::apply_transaction(const signed_transaction& trx, uint32_t skip)
    notify_on_applied_transaction( trx );
 }
 
+block_id_type database::applied_block_id( const signed_block& b )const
+{
+   return _precomputed_ids_block == &b ? _precomputed_ids->block_id : b.id();
+}
+
+transaction_id_type database::applied_transaction_id( const signed_transaction& trx )const
+{
+   if( _precomputed_ids_block != nullptr && _current_trx_in_block >= 0 &&
+       size_t(_current_trx_in_block) < _precomputed_ids->transaction_ids.size() &&
+       &_precomputed_ids_block->transactions[ _current_trx_in_block ] == &trx )
+      return _precomputed_ids->transaction_ids[ _current_trx_in_block ];
+   return trx.id();
+}
+
 void database::_apply_transaction(const signed_transaction& trx)
 { try {
-   _current_trx_id = trx.id();
+   _current_trx_id = applied_transaction_id( trx );
    _current_virtual_op = 0;
    uint32_t skip = node_properties().skip_flags;
 
@@ -1926,7 +2202,7 @@ void database::_apply_transaction(const signed_transaction& trx)
 
    auto& trx_idx = get_index<transaction_index>();
    const chain_id_type& chain_id = get_chain_id();
-   auto trx_id = trx.id();
+   auto trx_id = _current_trx_id;
    // idump((trx_id)(skip&skip_transaction_dupe_check));
    FC_ASSERT( (skip & skip_transaction_dupe_check) ||
               trx_idx.indices().get<by_trx_id>().find(trx_id) == trx_idx.indices().get<by_trx_id>().end(),
@@ -1937,10 +2213,23 @@ void database::_apply_transaction(const signed_transaction& trx)
       auto get_active  = [&]( const string& name ) { return authority( get< account_authority_object, by_account >( name ).active ); };
       auto get_owner   = [&]( const string& name ) { return authority( get< account_authority_object, by_account >( name ).owner );  };
 
+      // Use the keys recovered by the signature recovery pool if this transaction is part of the block being applied
+      const flat_set<public_key_type>* recovered_keys = nullptr;
+      if( _recovered_keys_block != nullptr && _current_trx_in_block >= 0 &&
+          size_t(_current_trx_in_block) < _recovered_block_keys->transaction_keys.size() &&
+          &_recovered_keys_block->transactions[ _current_trx_in_block ] == &trx &&
+          _recovered_block_keys->transaction_keys[ _current_trx_in_block ].has_value() )
+         recovered_keys = &(*_recovered_block_keys->transaction_keys[ _current_trx_in_block ]);
+
       try
       {
-         trx.verify_authority( chain_id, get_active, get_owner, SOPHIATX_MAX_SIG_CHECK_DEPTH,
-                               has_hardfork(SOPHIATX_HARDFORK_1_1) ? fc::ecc::bip_0062 : fc::ecc::fc_canonical);
+         auto canon_type = has_hardfork(SOPHIATX_HARDFORK_1_1) ? fc::ecc::bip_0062 : fc::ecc::fc_canonical;
+         if( recovered_keys )
+            trx.verify_authority( *recovered_keys, get_active, get_owner, SOPHIATX_MAX_SIG_CHECK_DEPTH );
+         else if( _signature_key_cache )
+            trx.verify_authority( trx.get_signature_keys( chain_id, canon_type, *_signature_key_cache ), get_active, get_owner, SOPHIATX_MAX_SIG_CHECK_DEPTH );
+         else
+            trx.verify_authority( chain_id, get_active, get_owner, SOPHIATX_MAX_SIG_CHECK_DEPTH, canon_type );
       }
       catch( protocol::tx_missing_active_auth& e )
       {
@@ -1995,10 +2284,25 @@ void database::apply_operation(const operation& op)
 
    note.fee_payer = get_fee_payer(op);
 
+   if( !_operation_profiler.enabled() )
+   {
+      notify_pre_apply_operation( note );
+      process_operation_fee(op);
+      _evaluator_registry.get_evaluator( op ).apply( op );
+      notify_post_apply_operation( note );
+      return;
+   }
+
+   operation_profiler::timer timer( _operation_profiler, op.which() );
    notify_pre_apply_operation( note );
+   timer.lap( operation_profiler::signal_phase );
    process_operation_fee(op);
+   timer.lap( operation_profiler::fee_phase );
    _evaluator_registry.get_evaluator( op ).apply( op );
+   timer.lap( operation_profiler::evaluate_phase );
    notify_post_apply_operation( note );
+   timer.lap( operation_profiler::signal_phase );
+   timer.finish();
 }
 
 void database::process_operations(const signed_transaction& trx) {
@@ -2047,7 +2351,7 @@ void database::update_accounts_bandwidth(const flat_set< account_name_type >& ac
             abo.last_block_num_reset = act_head_block;
          });
       } else {
-         if (act_head_block - acc_bandwidth->last_block_num_reset > chain::sophiatx_config::get<uint32_t>("SOPHIATX_LIMIT_BANDWIDTH_BLOCKS")) {
+         if (act_head_block - acc_bandwidth->last_block_num_reset > chain::sophiatx_config::params().limit_bandwidth_blocks) {
             this->modify(*acc_bandwidth, [&](account_bandwidth_object &abo) {
                abo.act_fee_free_bandwidth = fee_free_ops_bandwidth;
                abo.act_fee_free_ops_count = fee_free_ops_count;
@@ -2062,22 +2366,22 @@ void database::update_accounts_bandwidth(const flat_set< account_name_type >& ac
       }
 
       // Validates max fee-free allowed bandwidth/ops count
-      SOPHIATX_ASSERT(acc_bandwidth->act_fee_free_bandwidth <= chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_ALLOWED_BANDWIDTH"), tx_exceeded_bandwidth,
+      SOPHIATX_ASSERT(acc_bandwidth->act_fee_free_bandwidth <= chain::sophiatx_config::params().max_allowed_bandwidth, tx_exceeded_bandwidth,
                       "Fee-free operations max. allowed bandwidth [Bytes] exceeded."
                       "Wait for the next counter reset, which happens after block# " +
-                      std::to_string(acc_bandwidth->last_block_num_reset + chain::sophiatx_config::get<uint32_t>("SOPHIATX_LIMIT_BANDWIDTH_BLOCKS")),
-                      ("next_block_num_reset", acc_bandwidth->last_block_num_reset + chain::sophiatx_config::get<uint32_t>("SOPHIATX_LIMIT_BANDWIDTH_BLOCKS"))
+                      std::to_string(acc_bandwidth->last_block_num_reset + chain::sophiatx_config::params().limit_bandwidth_blocks),
+                      ("next_block_num_reset", acc_bandwidth->last_block_num_reset + chain::sophiatx_config::params().limit_bandwidth_blocks)
                       ("act_bandwidth", acc_bandwidth->act_fee_free_bandwidth)
-                      ("max_allowed_bandwidth", chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_ALLOWED_BANDWIDTH"))
+                      ("max_allowed_bandwidth", chain::sophiatx_config::params().max_allowed_bandwidth)
       );
 
-      SOPHIATX_ASSERT(acc_bandwidth->act_fee_free_ops_count <= chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_ALLOWED_OPS_COUNT"), tx_exceeded_bandwidth,
+      SOPHIATX_ASSERT(acc_bandwidth->act_fee_free_ops_count <= chain::sophiatx_config::params().max_allowed_ops_count, tx_exceeded_bandwidth,
                       "Fee-free operations max. allowed count exceeded."
                       "Wait for the next counter reset, which happens after block# " +
-                      std::to_string(acc_bandwidth->last_block_num_reset + chain::sophiatx_config::get<uint32_t>("SOPHIATX_LIMIT_BANDWIDTH_BLOCKS")),
-                      ("next_block_num_reset", acc_bandwidth->last_block_num_reset + chain::sophiatx_config::get<uint32_t>("SOPHIATX_LIMIT_BANDWIDTH_BLOCKS"))
+                      std::to_string(acc_bandwidth->last_block_num_reset + chain::sophiatx_config::params().limit_bandwidth_blocks),
+                      ("next_block_num_reset", acc_bandwidth->last_block_num_reset + chain::sophiatx_config::params().limit_bandwidth_blocks)
                       ("act_ops_count", acc_bandwidth->act_fee_free_ops_count)
-                      ("max_allowed_ops_count", chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_ALLOWED_OPS_COUNT"))
+                      ("max_allowed_ops_count", chain::sophiatx_config::params().max_allowed_ops_count)
       );
    }
 }
@@ -2089,8 +2393,13 @@ const witness_object& database::validate_block_header( uint32_t skip, const sign
    const witness_object& witness = get_witness( next_block.witness );
 
    if( !(skip&skip_witness_signature) )
-      FC_ASSERT( next_block.validate_signee( witness.signing_key,
-            has_hardfork(SOPHIATX_HARDFORK_1_1) ? fc::ecc::bip_0062 : fc::ecc::fc_canonical ) );
+   {
+      if( _recovered_keys_block == &next_block && _recovered_block_keys->witness_signee.has_value() )
+         FC_ASSERT( *_recovered_block_keys->witness_signee == witness.signing_key );
+      else
+         FC_ASSERT( next_block.validate_signee( witness.signing_key,
+               has_hardfork(SOPHIATX_HARDFORK_1_1) ? fc::ecc::bip_0062 : fc::ecc::fc_canonical ) );
+   }
 
    if( !(skip&skip_witness_schedule_check) )
    {
@@ -2110,7 +2419,7 @@ void database::create_block_summary(const signed_block& next_block)
 { try {
    block_summary_id_type sid( next_block.block_num() & 0xffff );
    modify( get< block_summary_object >( sid ), [&](block_summary_object& p) {
-         p.block_id = next_block.id();
+         p.block_id = applied_block_id( next_block );
    });
 } FC_CAPTURE_AND_RETHROW() }
 
@@ -2135,7 +2444,7 @@ void database::update_global_dynamic_data( const signed_block& b )
                w.total_missed++;
                wlog("Witness ${w} missed block at time ${t}", ("w", witness_missed.owner)("t", get_slot_time(i + 1)));
 
-               if( head_block_num() - w.last_confirmed_block_num  > chain::sophiatx_config::get<uint32_t>("SOPHIATX_BLOCKS_PER_DAY") )
+               if( head_block_num() - w.last_confirmed_block_num  > chain::sophiatx_config::params().blocks_per_day )
                {
                   w.signing_key = public_key_type();
                   push_virtual_operation( shutdown_witness_operation( w.owner ) );
@@ -2158,20 +2467,20 @@ void database::update_global_dynamic_data( const signed_block& b )
       }
 
       dgp.head_block_number = b.block_num();
-      dgp.head_block_id = b.id();
+      dgp.head_block_id = applied_block_id( b );
       dgp.time = b.timestamp;
       dgp.current_aslot += missed_blocks+1;
       if(!is_private_net()){
          uint64_t switch_block;
          if(has_hardfork(SOPHIATX_HARDFORK_1_1))
-            switch_block = chain::sophiatx_config::get<uint32_t>("SOPHIATX_WITNESS_VESTING_INCREASE_DAYS_HF") * chain::sophiatx_config::get<uint32_t>("SOPHIATX_BLOCKS_PER_DAY");
+            switch_block = chain::sophiatx_config::params().witness_vesting_increase_days_hf * chain::sophiatx_config::params().blocks_per_day;
          else
-            switch_block = SOPHIATX_WITNESS_VESTING_INCREASE_DAYS * chain::sophiatx_config::get<uint32_t>("SOPHIATX_BLOCKS_PER_DAY");
+            switch_block = SOPHIATX_WITNESS_VESTING_INCREASE_DAYS * chain::sophiatx_config::params().blocks_per_day;
 
          if( head_block_num() >= switch_block ){
-            dgp.witness_required_vesting = asset(chain::sophiatx_config::get<uint64_t>("SOPHIATX_FINAL_WITNESS_REQUIRED_VESTING_BALANCE"), VESTS_SYMBOL);
+            dgp.witness_required_vesting = asset(chain::sophiatx_config::params().final_witness_required_vesting_balance, VESTS_SYMBOL);
          }else
-            dgp.witness_required_vesting = asset(chain::sophiatx_config::get<uint64_t>("SOPHIATX_INITIAL_WITNESS_REQUIRED_VESTING_BALANCE"), VESTS_SYMBOL);
+            dgp.witness_required_vesting = asset(chain::sophiatx_config::params().initial_witness_required_vesting_balance, VESTS_SYMBOL);
       }
    } );
 
@@ -2205,12 +2514,12 @@ void database::update_last_irreversible_block()
     * Prior to voting taking over, we must be more conservative...
     *
     */
-   if( head_block_num() < chain::sophiatx_config::get<uint32_t>("SOPHIATX_START_MINER_VOTING_BLOCK") )
+   if( head_block_num() < chain::sophiatx_config::params().start_miner_voting_block )
    {
       modify( dpo, [&]( dynamic_global_property_object& _dpo )
       {
-         if ( head_block_num() > chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_WITNESSES"))
-            _dpo.last_irreversible_block_num = head_block_num() - chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_WITNESSES");
+         if ( head_block_num() > chain::sophiatx_config::params().max_witnesses)
+            _dpo.last_irreversible_block_num = head_block_num() - chain::sophiatx_config::params().max_witnesses;
       } );
    }
    else
@@ -2284,6 +2593,9 @@ void database::clear_expired_transactions()
    const auto& dedupe_index = transaction_idx.indices().get< by_expiration >();
    while( ( !dedupe_index.empty() ) && ( head_block_time() > dedupe_index.begin()->expiration ) )
       remove( *dedupe_index.begin() );
+
+   if( _signature_key_cache )
+      _signature_key_cache->remove_expired( head_block_time() );
 }
 
 void database::create_vesting( const account_object& a, const asset& delta){
@@ -2301,7 +2613,7 @@ void database::create_vesting( const account_object& a, const asset& delta){
 
 void database::modify_balance( const account_object& a, const asset& delta, bool check_balance )
 {
-   FC_ASSERT(delta.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"), "invalid symbol");
+   FC_ASSERT(delta.symbol == chain::sophiatx_config::params().symbol, "invalid symbol");
 
    modify( a, [&]( account_object& acnt )
    {
@@ -2337,7 +2649,7 @@ void database::adjust_supply( const asset& delta )
 {
    const auto& props = get_dynamic_global_properties();
 
-    if( delta.symbol.value == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL").value )
+    if( delta.symbol.value == chain::sophiatx_config::params().symbol.value )
     {
         FC_ASSERT( props.current_supply.amount.value + delta.amount >= 0 );
         modify( props, [&]( dynamic_global_property_object& props )
@@ -2354,7 +2666,7 @@ void database::adjust_supply( const asset& delta )
 
 asset database::get_balance( const account_object& a, asset_symbol_type symbol )const
 {
-   if( symbol.value == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL").value) {
+   if( symbol.value == chain::sophiatx_config::params().symbol.value) {
        return a.balance;
    } else {
          FC_ASSERT( false, "invalid symbol" );
@@ -2480,7 +2792,7 @@ void database::validate_invariants()const
       if(is_private_net())
          return;
       const auto& account_idx = get_index<account_index>().indices().get<by_id>();
-      asset total_supply = asset( 0, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") );
+      asset total_supply = asset( 0, chain::sophiatx_config::params().symbol );
       asset total_vesting = asset( 0, VESTS_SYMBOL );
 
       const auto& gpo = get_dynamic_global_properties();
@@ -2503,20 +2815,20 @@ void database::validate_invariants()const
       {
          total_supply += itr->sophiatx_balance;
 
-         if( itr->pending_fee.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") )
+         if( itr->pending_fee.symbol == chain::sophiatx_config::params().symbol )
             total_supply += itr->pending_fee;
          else
             FC_ASSERT( false, "found escrow pending fee that is not SPHTX" );
       }
 
 
-      FC_ASSERT( gpo.current_supply == total_supply + asset(total_vesting.amount, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL")), "", ("gpo.current_supply",gpo.current_supply)("total_supply",total_supply) );
+      FC_ASSERT( gpo.current_supply == total_supply + asset(total_vesting.amount, chain::sophiatx_config::params().symbol), "", ("gpo.current_supply",gpo.current_supply)("total_supply",total_supply) );
       FC_ASSERT( gpo.total_vesting_shares == total_vesting, "", ("gpo.total_vesting_shares",gpo.total_vesting_shares)("total_vesting",total_vesting) );
 
       FC_ASSERT( (gpo.current_supply.amount + econ.interest_pool_from_fees + econ.interest_pool_from_coinbase +
                  econ.mining_pool_from_fees + econ.mining_pool_from_coinbase + econ.promotion_pool + econ.burn_pool) ==
-                 chain::sophiatx_config::get<int64_t>("SOPHIATX_TOTAL_SUPPLY"),
-                         "difference is $diff", ("diff", chain::sophiatx_config::get<int64_t>("SOPHIATX_TOTAL_SUPPLY") -
+                 chain::sophiatx_config::params().total_supply,
+                         "difference is $diff", ("diff", chain::sophiatx_config::params().total_supply -
                  (gpo.current_supply.amount + econ.interest_pool_from_fees + econ.interest_pool_from_coinbase +
                  econ.mining_pool_from_fees + econ.mining_pool_from_coinbase + econ.promotion_pool + econ.burn_pool)));
 
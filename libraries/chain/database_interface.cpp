@@ -32,6 +32,10 @@ void database_interface::notify_post_apply_operation(const operation_notificatio
    SOPHIATX_TRY_NOTIFY(post_apply_operation, note)
 }
 
+void database_interface::notify_pre_apply_block(const signed_block &block) {
+   SOPHIATX_TRY_NOTIFY(pre_apply_block, block)
+}
+
 void database_interface::notify_applied_block(const signed_block &block) {
    SOPHIATX_TRY_NOTIFY(applied_block, block)
 }
@@ -56,6 +60,7 @@ void database_interface::wipe( const fc::path& shared_mem_dir, bool include_bloc
    {
       fc::remove_all( shared_mem_dir / "block_log" );
       fc::remove_all( shared_mem_dir / "block_log.index" );
+      fc::remove_all( shared_mem_dir / "block_log.tail" );
    }
 }
 
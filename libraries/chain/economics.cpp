@@ -8,34 +8,34 @@ using namespace sophiatx::protocol;
 
 void economic_model_object::init_economics(share_type _init_supply, share_type _total_supply){
    share_type coinbase = _total_supply - _init_supply;
-   mining_pool_from_coinbase = coinbase * chain::sophiatx_config::get<int64_t>("SOPHIATX_MINING_POOL_PERCENTAGE") / SOPHIATX_100_PERCENT;
-   interest_pool_from_coinbase = coinbase * chain::sophiatx_config::get<int64_t>("SOPHIATX_INTEREST_POOL_PERCENTAGE") / SOPHIATX_100_PERCENT;
-   promotion_pool = coinbase * chain::sophiatx_config::get<int64_t>("SOPHIATX_PROMOTION_POOL_PERCENTAGE") / SOPHIATX_100_PERCENT;
+   mining_pool_from_coinbase = coinbase * static_cast<int64_t>(chain::sophiatx_config::params().mining_pool_percentage) / SOPHIATX_100_PERCENT;
+   interest_pool_from_coinbase = coinbase * static_cast<int64_t>(chain::sophiatx_config::params().interest_pool_percentage) / SOPHIATX_100_PERCENT;
+   promotion_pool = coinbase * static_cast<int64_t>(chain::sophiatx_config::params().promotion_pool_percentage) / SOPHIATX_100_PERCENT;
    initial_promotion_pool = promotion_pool;
    init_supply = _init_supply;
    total_supply = _total_supply;
-   coinbase_block_reward = mining_pool_from_coinbase / chain::sophiatx_config::get<int64_t>("SOPHIATX_COINBASE_BLOCKS");
+   coinbase_block_reward = mining_pool_from_coinbase / static_cast<int64_t>(chain::sophiatx_config::params().coinbase_blocks);
 }
 
 share_type economic_model_object::get_mining_reward(uint32_t block_number)const{
-   uint32_t blocks_to_coinbase_end = chain::sophiatx_config::get<uint32_t>("SOPHIATX_COINBASE_BLOCKS") - block_number;
+   uint32_t blocks_to_coinbase_end = chain::sophiatx_config::params().coinbase_blocks - block_number;
    //mining reward consist of coinbase reward, which uniformly distributes mining pool among SOPHIATX_COINBASE_BLOCKS rewards,
    // and fees rewards, where each block is rewarded one 1/(SOPHIATX_BLOCKS_PER_DAY * 7) of the current pool.
    share_type reward = mining_pool_from_coinbase / blocks_to_coinbase_end;
-   reward += mining_pool_from_fees / (chain::sophiatx_config::get<uint32_t>("SOPHIATX_BLOCKS_PER_DAY") * 7);
+   reward += mining_pool_from_fees / (chain::sophiatx_config::params().blocks_per_day * 7);
    return reward;
 }
 
 share_type economic_model_object::withdraw_mining_reward(uint32_t block_number, uint32_t nominator, uint32_t denominator){
    //mining reward consist of coinbase reward, which uniformly distributes mining pool among SOPHIATX_COINBASE_BLOCKS rewards,
    // and fees rewards, where each block is rewarded one 1/(SOPHIATX_BLOCKS_PER_DAY * 7) of the current pool.
-   if( block_number <= chain::sophiatx_config::get<uint32_t>("SOPHIATX_INTEREST_DELAY") )
+   if( block_number <= chain::sophiatx_config::params().interest_delay )
       return 0;
    share_type reward_from_coinbase = coinbase_block_reward;
    reward_from_coinbase = (reward_from_coinbase * nominator) / denominator;
    reward_from_coinbase = std::min(reward_from_coinbase, mining_pool_from_coinbase);
 
-   share_type reward_from_fees = mining_pool_from_fees / (chain::sophiatx_config::get<uint32_t>("SOPHIATX_BLOCKS_PER_DAY") * 7);
+   share_type reward_from_fees = mining_pool_from_fees / (chain::sophiatx_config::params().blocks_per_day * 7);
    reward_from_fees = (reward_from_fees * nominator) / denominator;
    reward_from_fees = std::min(reward_from_fees, mining_pool_from_fees);
 
@@ -57,9 +57,9 @@ void economic_model_object::record_block(uint32_t generated_block, share_type cu
    //                promotion_pool + current_supply + burn_pool== total_supply);
 }
 
-#define SOPHIATX_TOTAL_INTERESTS ((chain::sophiatx_config::get<uint64_t>("SOPHIATX_TOTAL_SUPPLY") \
-        - chain::sophiatx_config::get<uint64_t>("SOPHIATX_INIT_SUPPLY")) * \
-chain::sophiatx_config::get<uint64_t>("SOPHIATX_INTEREST_POOL_PERCENTAGE") / uint64_t(SOPHIATX_100_PERCENT))
+#define SOPHIATX_TOTAL_INTERESTS ((static_cast<uint64_t>(chain::sophiatx_config::params().total_supply) \
+        - static_cast<uint64_t>(chain::sophiatx_config::params().init_supply)) * \
+static_cast<uint64_t>(chain::sophiatx_config::params().interest_pool_percentage) / uint64_t(SOPHIATX_100_PERCENT))
 
 share_type economic_model_object::withdraw_interests(share_type holding, uint32_t period) {
    try {
@@ -68,11 +68,11 @@ share_type economic_model_object::withdraw_interests(share_type holding, uint32_
          return 0;
       share_type total_coinbase_for_period = share_type(std::min(uint64_t(interest_pool_from_coinbase.value),
                                                                  (SOPHIATX_TOTAL_INTERESTS * period /
-                                                                 chain::sophiatx_config::get<uint64_t>("SOPHIATX_COINBASE_BLOCKS"))));
+                                                                 static_cast<uint64_t>(chain::sophiatx_config::params().coinbase_blocks))));
       share_type coinbase_reward = (uint128_t(holding.value) * uint128_t(total_coinbase_for_period.value) /
                                     uint128_t(accumulated_supply.value)).to_uint64();
       share_type fees_reward = (
-            uint128_t(interest_pool_from_fees.value * SOPHIATX_INTEREST_BLOCKS / chain::sophiatx_config::get<uint64_t>("SOPHIATX_INTEREST_FEES_TIME")) *
+            uint128_t(interest_pool_from_fees.value * SOPHIATX_INTEREST_BLOCKS / static_cast<uint64_t>(chain::sophiatx_config::params().interest_fees_time)) *
             uint128_t(holding.value) / uint128_t(accumulated_supply.value)).to_uint64();
       interest_pool_from_fees -= fees_reward;
       interest_pool_from_coinbase -= coinbase_reward;
@@ -81,10 +81,10 @@ share_type economic_model_object::withdraw_interests(share_type holding, uint32_
 }
 
 void economic_model_object::add_fee(share_type fee) {
-   auto to_burn = fee * chain::sophiatx_config::get<int64_t>("SOPHIATX_BURN_FEE_PERCENTAGE") / SOPHIATX_100_PERCENT;
+   auto to_burn = fee * static_cast<int64_t>(chain::sophiatx_config::params().burn_fee_percentage) / SOPHIATX_100_PERCENT;
    fee = fee - to_burn;
-   auto to_mining_pool = fee * chain::sophiatx_config::get<int64_t>("SOPHIATX_MINING_POOL_PERCENTAGE") / SOPHIATX_100_PERCENT;
-   auto to_promotion_pool = fee * chain::sophiatx_config::get<int64_t>("SOPHIATX_PROMOTION_POOL_PERCENTAGE") / SOPHIATX_100_PERCENT;
+   auto to_mining_pool = fee * static_cast<int64_t>(chain::sophiatx_config::params().mining_pool_percentage) / SOPHIATX_100_PERCENT;
+   auto to_promotion_pool = fee * static_cast<int64_t>(chain::sophiatx_config::params().promotion_pool_percentage) / SOPHIATX_100_PERCENT;
    mining_pool_from_fees += to_mining_pool;
    promotion_pool += to_promotion_pool;
    burn_pool += to_burn;
@@ -93,9 +93,9 @@ void economic_model_object::add_fee(share_type fee) {
 }
 
 share_type economic_model_object::get_available_promotion_pool(uint32_t block_number) const{
-   uint128_t blocks_to_coinbase_end = chain::sophiatx_config::get<uint128_t>("SOPHIATX_COINBASE_BLOCKS") - block_number;
+   uint128_t blocks_to_coinbase_end = static_cast<uint128_t>(chain::sophiatx_config::params().coinbase_blocks) - block_number;
    //share_type locked_pool = promotion_pool_per_day * blocks_to_coinbase_end / SOPHIATX_BLOCKS_PER_DAY;
-   share_type locked_pool = (((((uint128_t)initial_promotion_pool.value * (uint128_t)262144) / chain::sophiatx_config::get<uint128_t>("SOPHIATX_COINBASE_BLOCKS")) * blocks_to_coinbase_end ) / (uint128_t)262144).to_uint64();
+   share_type locked_pool = (((((uint128_t)initial_promotion_pool.value * (uint128_t)262144) / static_cast<uint128_t>(chain::sophiatx_config::params().coinbase_blocks)) * blocks_to_coinbase_end ) / (uint128_t)262144).to_uint64();
    FC_ASSERT(promotion_pool >= locked_pool);
    return promotion_pool - locked_pool;
 }
@@ -3,6 +3,9 @@
 #include <sophiatx/chain/custom_operation_interpreter.hpp>
 #include <sophiatx/chain/index.hpp>
 
+#include <chrono>
+#include <limits>
+
 namespace sophiatx {
 namespace chain {
 
@@ -44,7 +47,14 @@ void hybrid_database::open(const open_args &args, const genesis_state_type &gene
 
 void hybrid_database::close(bool /*rewind*/) {
    try {
-      _running = false;
+      {
+         std::lock_guard<std::mutex> guard(_sync_mutex);
+         _running = false;
+      }
+      _sync_cv.notify_all();
+
+      if( _apply_thread.joinable())
+         _apply_thread.join();
 
       with_write_lock([ & ]() {
            modify(get_hybrid_db_properties(), [ & ](hybrid_db_property_object &_hdpo) {
@@ -56,7 +66,13 @@ void hybrid_database::close(bool /*rewind*/) {
       chainbase::database::flush();
       chainbase::database::close();
 
-      boost::this_thread::sleep_for(boost::chrono::seconds(chain::sophiatx_config::get<uint32_t>("SOPHIATX_BLOCK_INTERVAL")));
+      // The fetcher may be waiting for a reply of the full node
+      if( _fetch_done.valid() && !_fetch_done.ready()) {
+         try {
+            _fetch_done.wait(fc::seconds(chain::sophiatx_config::params().block_interval));
+         }
+         catch( const fc::exception & ) {}
+      }
       if( _remote_api_thread.is_running())
          _remote_api_thread.quit();
 
@@ -64,76 +80,283 @@ void hybrid_database::close(bool /*rewind*/) {
    FC_CAPTURE_AND_RETHROW()
 }
 
+hybrid_sync_stats hybrid_database::get_sync_stats() const {
+   std::lock_guard<std::mutex> guard(_sync_mutex);
+   hybrid_sync_stats stats = _sync_stats;
+   if( stats.remote_op_number > stats.head_op_number )
+      stats.lag_ops = stats.remote_op_number - stats.head_op_number;
+   return stats;
+}
+
+void hybrid_database::start_sync_with_full_node() {
+   _sync_stats.head_op_number = _head_op_number;
+   _sync_stats.remote_op_number = _head_op_number;
+   _report_time = fc::time_point::now();
+
+   uint64_t start = _head_op_number + 1;
+   _apply_thread = std::thread([ this ]() { apply_queued_messages(); });
+   _fetch_done = _remote_api_thread.async([ this, start ]() { fetch_messages(start); });
+}
+
+void hybrid_database::fetch_messages(uint64_t next_op_number) {
+   const auto block_interval = std::chrono::seconds(chain::sophiatx_config::params().block_interval);
+   // Cleared when the full node does not serve subscriptions, it is polled for good then
+   bool subscriptions_served = true;
+
+   while( _running ) {
+      bool caught_up = true;
+      try {
+         if( !fetch_page(next_op_number, caught_up))
+            return;
+
+         if( caught_up && subscriptions_served ) {
+            uint64_t generation;
+            {
+               // Messages may be pushed before the subscription call returns
+               std::lock_guard<std::mutex> guard(_sync_mutex);
+               generation = ++_subscription;
+               _notice_op_number = next_op_number;
+               _notice_dropped = 0;
+               _sync_stats.subscribed = true;
+               _sync_stats.lagging = false;
+               _sync_stats.subscriptions++;
+            }
+
+            subscriptions_served = remote::remote_db::subscribe_app_custom_messages(_app_id, next_op_number,
+                                                                                    [ this, generation ](remote::received_object obj) {
+                 on_notice(generation, std::move(obj));
+            });
+
+            if( subscriptions_served ) {
+               ilog("Following messages of app ${a} pushed by the full node from ${n}",
+                    ("a", _app_id)("n", next_op_number));
+               follow_subscription();
+            }
+
+            {
+               std::lock_guard<std::mutex> guard(_sync_mutex);
+               _sync_stats.subscribed = false;
+               _sync_stats.lagging = false;
+               next_op_number = _notice_op_number;
+            }
+
+            if( subscriptions_served ) {
+               if( _running )
+                  wlog("Polling messages of app ${a} from ${n} until caught up", ("a", _app_id)("n", next_op_number));
+               continue;
+            }
+         }
+      }
+      catch( const fc::exception &e ) {
+         elog("Failed to fetch messages of app ${a} from the full node: ${e}", ("a", _app_id)("e", e.to_detail_string()));
+      }
 
-bool hybrid_database::is_sync() const {
-   if( _head_op_id == _head_op_number && _head_op_number == 0 )
-      return false;
+      if( caught_up ) {
+         std::unique_lock<std::mutex> lock(_sync_mutex);
+         _sync_cv.wait_for(lock, block_interval, [ this ]() { return !_running; });
+      }
+   }
+}
 
-   auto result = remote::remote_db::get_app_custom_messages({_app_id, std::numeric_limits<uint64_t>::max(), 1});
+bool hybrid_database::fetch_page(uint64_t &next_op_number, bool &caught_up) {
+   auto results = remote::remote_db::get_app_custom_messages(
+         {_app_id, next_op_number - 1 + SOPHIATX_API_SINGLE_QUERY_LIMIT, SOPHIATX_API_SINGLE_QUERY_LIMIT});
 
-   if( result.empty() || result.begin()->second.id != _head_op_id )
-      return false;
+   {
+      std::lock_guard<std::mutex> guard(_sync_mutex);
+      _sync_stats.fetched_pages++;
+   }
 
+   uint64_t queued = 0;
+   for( auto &r : results ) {
+      if( r.first < next_op_number )
+         continue;
+      if( !queue_message(r.first, std::move(r.second)))
+         return false;
+      next_op_number = r.first + 1;
+      queued++;
+   }
+   caught_up = queued < SOPHIATX_API_SINGLE_QUERY_LIMIT;
    return true;
 }
 
-const remote::get_app_custom_messages_return::iterator &
-hybrid_database::get_unprocessed_op(const remote::get_app_custom_messages_return::iterator &start,
-                                    const remote::get_app_custom_messages_return::iterator &end, size_t size) const {
+void hybrid_database::follow_subscription() {
+   const auto block_interval = std::chrono::seconds(chain::sophiatx_config::params().block_interval);
+   // Latest message of the app on the full node which was not pushed yet at the previous check
+   uint64_t overdue = 0;
+
+   while( true ) {
+      bool lagging;
+      {
+         std::unique_lock<std::mutex> lock(_sync_mutex);
+         _sync_cv.wait_for(lock, block_interval, [ this ]() {
+              return !_running || !_sync_stats.subscribed || _sync_stats.lagging;
+         });
+         if( !_running || !_sync_stats.subscribed )
+            return;
+         lagging = _sync_stats.lagging;
+      }
+
+      if( !remote::remote_db::initialized()) {
+         wlog("The full node disconnected, app ${a} is not followed anymore", ("a", _app_id));
+         return;
+      }
+
+      try {
+         if( lagging ) {
+            // Pushes are dropped meanwhile, the queue is filled from pages as the apply thread makes room
+            uint64_t next_op_number;
+            {
+               std::lock_guard<std::mutex> guard(_sync_mutex);
+               next_op_number = _notice_op_number;
+            }
+
+            bool caught_up = false;
+            if( !fetch_page(next_op_number, caught_up))
+               return;
+
+            std::lock_guard<std::mutex> guard(_sync_mutex);
+            _notice_op_number = next_op_number;
+            if( caught_up && _notice_dropped < next_op_number )
+               _sync_stats.lagging = false;
+            overdue = 0;
+            continue;
+         }
+
+         auto latest = remote::remote_db::get_app_custom_messages({_app_id, std::numeric_limits<uint64_t>::max(), 1});
+         uint64_t remote_op_number = 0;
+         if( !latest.empty() && latest.rbegin()->second.app_id == _app_id )
+            remote_op_number = latest.rbegin()->first;
+
+         std::lock_guard<std::mutex> guard(_sync_mutex);
+         _sync_stats.remote_op_number = std::max(_sync_stats.remote_op_number, remote_op_number);
+         if( _sync_stats.lagging ) {
+            overdue = 0;
+            continue;
+         }
+         if( overdue && _notice_op_number <= overdue ) {
+            wlog("The full node stopped pushing messages of app ${a}, ${n} was not received",
+                 ("a", _app_id)("n", _notice_op_number));
+            return;
+         }
+         overdue = remote_op_number >= _notice_op_number ? remote_op_number : 0;
+      }
+      catch( const fc::exception &e ) {
+         elog("Failed to follow the subscription to app ${a}: ${e}", ("a", _app_id)("e", e.to_detail_string()));
+         return;
+      }
+   }
+}
+
+void hybrid_database::on_notice(uint64_t generation, remote::received_object obj) {
+   uint64_t sequence = obj.app_message_sequence;
+   {
+      std::lock_guard<std::mutex> guard(_sync_mutex);
+      if( !_sync_stats.subscribed || generation != _subscription )
+         return;
 
-   if( start->second.id > _head_op_id || start == end )
-      return start;
+      _sync_stats.received_notices++;
+      _sync_stats.remote_op_number = std::max(_sync_stats.remote_op_number, sequence);
 
-   auto mid = start;
+      // Polled already while the subscription was lagging
+      if( sequence < _notice_op_number )
+         return;
 
-   std::advance(mid, size / 2);
-   if( std::distance(mid, end) > static_cast<int64_t>(size / 2))
-      return start;
+      if( _sync_stats.lagging ) {
+         _notice_dropped = std::max(_notice_dropped, sequence);
+         return;
+      }
 
-   if( mid->second.id == _head_op_id ) {
-      return ++mid;
-   } else if( mid->second.id > _head_op_id ) {
-      return get_unprocessed_op(start, --mid, size / 2);
-   } else {
-      return get_unprocessed_op(++mid, end, size / 2);
+      if( sequence != _notice_op_number ) {
+         wlog("Pushed message ${s} of app ${a} does not follow ${n}", ("s", sequence)("a", _app_id)("n", _notice_op_number));
+         _sync_stats.subscribed = false;
+      } else if( queue_full()) {
+         // Waiting for room would hold up the connection, the fetcher polls the messages instead
+         _sync_stats.lagging = true;
+         _notice_dropped = sequence;
+      } else {
+         _sync_queue.emplace_back(sequence, std::move(obj));
+         _notice_op_number++;
+      }
    }
+   _sync_cv.notify_all();
 }
 
-void hybrid_database::start_sync_with_full_node() {
-   _remote_api_thread.async([ & ]() {
-                                 while( _running ) {
-                                    do {
-                                       if( is_sync())
-                                          break;
+bool hybrid_database::queue_full() const {
+   // Room for two pages, the next page is fetched while the previous one is applied
+   return _sync_queue.size() >= 2 * SOPHIATX_API_SINGLE_QUERY_LIMIT;
+}
+
+bool hybrid_database::queue_message(uint64_t sequence, remote::received_object obj) {
+   {
+      std::unique_lock<std::mutex> lock(_sync_mutex);
+      _sync_cv.wait(lock, [ this ]() { return !_running || !queue_full(); });
+      if( !_running )
+         return false;
+
+      _sync_queue.emplace_back(sequence, std::move(obj));
+      _sync_stats.remote_op_number = std::max(_sync_stats.remote_op_number, sequence);
+   }
+   _sync_cv.notify_all();
+   return true;
+}
 
-                                       auto results = remote::remote_db::get_app_custom_messages(
-                                             {_app_id, _head_op_number + SOPHIATX_API_SINGLE_QUERY_LIMIT,
-                                              SOPHIATX_API_SINGLE_QUERY_LIMIT});
+void hybrid_database::apply_queued_messages() {
+   std::vector<queued_message> batch;
 
-                                       if( results.empty())
-                                          break;
+   while( true ) {
+      {
+         std::unique_lock<std::mutex> lock(_sync_mutex);
+         _sync_cv.wait(lock, [ this ]() { return !_running || !_sync_queue.empty(); });
+         if( !_running )
+            return;
 
-                                       auto itr = results.begin();
+         auto end = _sync_queue.begin() + std::min<size_t>(_sync_queue.size(), SOPHIATX_API_SINGLE_QUERY_LIMIT);
+         batch.assign(std::make_move_iterator(_sync_queue.begin()), std::make_move_iterator(end));
+         _sync_queue.erase(_sync_queue.begin(), end);
+      }
+      _sync_cv.notify_all();
 
-                                       if( _head_op_id != 0 )
-                                          itr = get_unprocessed_op(results.begin(), results.end(), results.size());
+      apply_batch(batch);
+   }
+}
 
-                                       if( itr == results.end())
-                                          break;
+void hybrid_database::apply_batch(const std::vector<queued_message> &batch) {
+   uint64_t applied = 0;
+   fc::time_point_sec last_received;
+
+   with_write_lock([ & ]() {
+        for( const auto &m : batch ) {
+           if( m.first <= _head_op_number )
+              continue;
+
+           apply_custom_op(m.second);
+           _head_op_number = m.first;
+           _head_op_id = m.second.id;
+           last_received = m.second.received;
+           applied++;
+        }
+   });
+
+   auto now = fc::time_point::now();
+   std::lock_guard<std::mutex> guard(_sync_mutex);
+   _sync_stats.head_op_number = _head_op_number;
+   _sync_stats.applied_ops += applied;
+   _sync_stats.applied_batches++;
+   if( applied )
+      _sync_stats.lag_seconds = std::max<int64_t>(0, (now - fc::time_point(last_received)).to_seconds());
+
+   auto elapsed = now - _report_time;
+   if( elapsed < fc::seconds(10))
+      return;
 
-                                       for( ; itr != results.end(); ++itr ) {
-                                          if( itr->second.id > _head_op_id || itr->second.id == 0 ) {
-                                             apply_custom_op(itr->second);
-                                             _head_op_number++;
-                                             _head_op_id = itr->second.id;
-                                          }
-                                       }
-                                    } while( true );
-                                    boost::this_thread::sleep_for(boost::chrono::seconds(chain::sophiatx_config::get<uint32_t>("SOPHIATX_BLOCK_INTERVAL")));
-                                 }
-                            }
+   _sync_stats.ops_per_second = ( _sync_stats.applied_ops - _report_applied_ops ) * 1000000 / elapsed.count();
+   _report_time = now;
+   _report_applied_ops = _sync_stats.applied_ops;
 
-   );
+   if( _sync_stats.remote_op_number > _head_op_number )
+      ilog("Synchronizing messages of app ${a}: ${h} of ${r}, ${s} messages per second",
+           ("a", _app_id)("h", _head_op_number)("r", _sync_stats.remote_op_number)("s", _sync_stats.ops_per_second));
 }
 
 void hybrid_database::apply_custom_op(const remote::received_object &obj) {
@@ -152,9 +375,7 @@ void hybrid_database::apply_custom_op(const remote::received_object &obj) {
       std::copy(out.begin(), out.end(), std::back_inserter(op.data));
 
       try {
-         with_write_lock([ & ]() {
-              eval->apply(op);
-         });
+         eval->apply(op);
       }
       catch( const fc::exception &e ) {
          edump((e));
@@ -173,9 +394,7 @@ void hybrid_database::apply_custom_op(const remote::received_object &obj) {
       op.json = obj.data;
 
       try {
-         with_write_lock([ & ]() {
-              eval->apply(op);
-         });
+         eval->apply(op);
       }
       catch( const fc::exception &e ) {
          edump((e));
@@ -59,7 +59,7 @@ namespace sophiatx { namespace chain {
          account_name_type reset_account = SOPHIATX_NULL_ACCOUNT;
          time_point_sec    last_account_recovery;
 
-         asset             balance = asset( 0, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") );  ///< total liquid shares held by this account
+         asset             balance = asset( 0, chain::sophiatx_config::params().symbol );  ///< total liquid shares held by this account
          asset             vesting_shares = asset( 0, VESTS_SYMBOL ); ///< total vesting shares held by this account, controls its voting power
 
          asset             vesting_withdraw_rate = asset( 0, VESTS_SYMBOL ); ///< at the time this is updated it can be at most vesting_shares/104
@@ -179,7 +179,6 @@ namespace sophiatx { namespace chain {
 
    struct by_name;
    struct by_proxy;
-   struct by_balance;
    struct by_next_vesting_withdrawal;
 
    /**
@@ -198,8 +197,6 @@ namespace sophiatx { namespace chain {
                member< account_object, account_name_type, &account_object::name >
             > /// composite key by proxy
          >,
-         ordered_non_unique< tag <by_balance>,
-            const_mem_fun< account_object, share_type, &account_object::total_balance> >,
          ordered_unique< tag< by_next_vesting_withdrawal >,
             composite_key< account_object,
                member< account_object, time_point_sec, &account_object::next_vesting_withdrawal >,
@@ -31,6 +31,14 @@ namespace sophiatx { namespace chain {
     *
     * The main file is the only file that needs to persist. The index file can be reconstructed during a
     * linear scan of the main file.
+    *
+    * Both files are mapped read only. Reads do not take any lock, they see every block up to the head
+    * published by the last append. Appends are written through the file streams by a single writer and
+    * published only after they were flushed.
+    *
+    * A log created in the compressed format (see compressed_block_log) is detected when it is opened and all
+    * operations are forwarded to it. Block positions are then block numbers counted from zero, callers should
+    * treat positions as opaque values obtained from get_block_pos() and read_block().
     */
 
    class block_log {
@@ -38,7 +46,17 @@ namespace sophiatx { namespace chain {
          block_log();
          ~block_log();
 
-         void open( const fc::path& file );
+         /**
+          * Opens the log. A new log is created in the compressed format with compressed_chunk_size blocks per chunk
+          * if it is non zero, an existing log is opened in the format it was written in.
+          */
+         void open( const fc::path& file, uint32_t compressed_chunk_size = 0 );
+
+         /**
+          * Opens an existing log of either format for reading only, e.g. by tools inspecting the log of a running
+          * node. Nothing is written, a raw log whose index does not match it is rejected instead of reindexed.
+          */
+         void open_read_only( const fc::path& file );
          void close();
          bool is_open()const;
 
@@ -47,6 +65,12 @@ namespace sophiatx { namespace chain {
          std::pair< signed_block, uint64_t > read_block( uint64_t file_pos )const;
          optional< signed_block > read_block_by_num( uint32_t block_num )const;
 
+         /**
+          * Read serialized data of blocks [first_block_num, first_block_num + count) in one sequential read
+          * without unpacking them. Used by the replay pipeline to move deserialization off the reading thread.
+          */
+         std::vector< std::vector< char > > read_raw_blocks( uint32_t first_block_num, uint32_t count )const;
+
          /**
           * Return offset of block in file, or block_log::npos if it does not exist.
           */
@@ -0,0 +1,76 @@
+#pragma once
+#include <fc/filesystem.hpp>
+#include <sophiatx/protocol/block.hpp>
+
+namespace sophiatx { namespace chain {
+
+   using namespace sophiatx::protocol;
+
+   namespace detail { class compressed_block_log_impl; }
+
+   /* Compressed variant of the block log. Blocks are grouped into chunks of a fixed number of blocks,
+    * every chunk is zlib compressed separately so that reading a block decompresses only its chunk.
+    *
+    * +--------+-------------------+-------------+-------------------+-------------+-----+
+    * | Header | Size of Chunk 1   | Chunk 1     | Size of Chunk 2   | Chunk 2     | ... |
+    * +--------+-------------------+-------------+-------------------+-------------+-----+
+    *
+    * The header is the magic string followed by the format version and the number of blocks per chunk.
+    * A decompressed chunk holds the number of blocks, the offsets of the blocks within the block data
+    * and the packed blocks themselves.
+    *
+    * +-------+-------------------+-----+-------------------+---------+-----+------------+
+    * | Count | Offset of Block 1 | ... | Offset of Block N | Block 1 | ... | Block N    |
+    * +-------+-------------------+-----+-------------------+---------+-----+------------+
+    *
+    * The index file holds the position of each chunk in the main file. Blocks of the last chunk which is
+    * not full yet are kept uncompressed in the tail file, each prefixed by its size. Once the chunk is full it
+    * is compressed, appended to the main file and the tail file is emptied.
+    *
+    * Like in the raw block log, the main file is the only file that needs to persist together with the
+    * tail. The index file is reconstructed from the chunk sizes when it does not match the main file.
+    */
+   class compressed_block_log {
+      public:
+         static const uint32_t default_blocks_per_chunk = 256;
+
+         compressed_block_log();
+         ~compressed_block_log();
+
+         /// Checks whether file is a compressed block log
+         static bool is_compressed( const fc::path& file );
+
+         /**
+          * Opens the log, blocks_per_chunk is used only when a new log is created, existing logs keep the value
+          * they were created with.
+          */
+         void open( const fc::path& file, uint32_t blocks_per_chunk = default_blocks_per_chunk );
+
+         /**
+          * Opens an existing log for reading only, e.g. by tools inspecting the log of a running node. Nothing is
+          * written: an index which does not match the main file is rebuilt in memory and an incomplete trailing chunk
+          * is ignored.
+          */
+         void open_read_only( const fc::path& file );
+         void close();
+         bool is_open()const;
+
+         void append( const signed_block& b );
+         void flush();
+
+         optional< signed_block > read_block_by_num( uint32_t block_num )const;
+         std::vector< std::vector< char > > read_raw_blocks( uint32_t first_block_num, uint32_t count )const;
+         signed_block read_head()const;
+         const optional< signed_block >& head()const;
+         uint32_t head_block_num()const;
+
+         uint32_t blocks_per_chunk()const;
+         uint32_t chunk_count()const;
+
+      private:
+         void load();
+
+         std::unique_ptr< detail::compressed_block_log_impl > my;
+   };
+
+} }
@@ -16,6 +16,10 @@
 
 namespace sophiatx { namespace chain {
 
+/**
+ * Document sent by a custom_json or custom_binary operation. The payload is stored once, the recipients reference it
+ * with custom_content_recipient_object.
+ */
 class custom_content_object: public object< custom_content_object_type, custom_content_object> {
 public:
    template<typename Constructor, typename Allocator>
@@ -27,12 +31,10 @@ public:
 
    uint64_t app_id;
    account_name_type sender;
-   account_name_type recipient;
 
    shared_vector<account_name_type> all_recipients;
 
    uint64_t sender_sequence = 0;
-   uint64_t recipient_sequence = 0;
    uint64_t app_message_sequence = 0;
    time_point_sec received;
 
@@ -41,6 +43,26 @@ public:
    shared_string json;
 };
 
+/**
+ * Entry of a document in the documents received by one of its recipients
+ */
+class custom_content_recipient_object: public object< custom_content_recipient_object_type, custom_content_recipient_object> {
+public:
+   template<typename Constructor, typename Allocator>
+   custom_content_recipient_object(Constructor &&c, allocator<Allocator> a) {
+      c(*this);
+   }
+
+   id_type id;
+
+   uint64_t app_id;
+   account_name_type recipient;
+   uint64_t recipient_sequence = 0;
+   time_point_sec received;
+
+   custom_content_id_type content;
+};
+
 struct by_id;
 struct by_app_id;
 struct by_sender;
@@ -68,14 +90,6 @@ typedef multi_index_container<
                >,
                composite_key_compare< std::less< account_name_type >, std::greater<uint64_t>, std::greater< uint64_t > >
             >,
-            ordered_non_unique< tag< by_recipient >,
-               composite_key< custom_content_object,
-                     member< custom_content_object, account_name_type, &custom_content_object::recipient>,
-                     member< custom_content_object, uint64_t, &custom_content_object::app_id>,
-                     member< custom_content_object, uint64_t, &custom_content_object::recipient_sequence>
-               >,
-               composite_key_compare< std::less< account_name_type >, std::greater<uint64_t>, std::greater< uint64_t > >
-            >,
             ordered_non_unique< tag< by_sender_time >,
                composite_key< custom_content_object,
                      member< custom_content_object, account_name_type, &custom_content_object::sender>,
@@ -83,24 +97,72 @@ typedef multi_index_container<
                      member< custom_content_object, time_point_sec, &custom_content_object::received>
                >,
                composite_key_compare< std::less< account_name_type >, std::greater<uint64_t>, std::greater< time_point_sec > >
+            >
+      >,
+      allocator< custom_content_object >
+> custom_content_index;
+
+typedef multi_index_container<
+      custom_content_recipient_object,
+      indexed_by<
+            ordered_unique< tag< by_id >,
+                    member< custom_content_recipient_object, custom_content_recipient_object::id_type, &custom_content_recipient_object::id > >,
+            ordered_non_unique< tag< by_recipient >,
+               composite_key< custom_content_recipient_object,
+                     member< custom_content_recipient_object, account_name_type, &custom_content_recipient_object::recipient>,
+                     member< custom_content_recipient_object, uint64_t, &custom_content_recipient_object::app_id>,
+                     member< custom_content_recipient_object, uint64_t, &custom_content_recipient_object::recipient_sequence>
+               >,
+               composite_key_compare< std::less< account_name_type >, std::greater<uint64_t>, std::greater< uint64_t > >
             >,
             ordered_non_unique< tag< by_recipient_time >,
-               composite_key< custom_content_object,
-                     member< custom_content_object, account_name_type, &custom_content_object::recipient>,
-                     member< custom_content_object, uint64_t, &custom_content_object::app_id>,
-                     member< custom_content_object, time_point_sec, &custom_content_object::received>
+               composite_key< custom_content_recipient_object,
+                     member< custom_content_recipient_object, account_name_type, &custom_content_recipient_object::recipient>,
+                     member< custom_content_recipient_object, uint64_t, &custom_content_recipient_object::app_id>,
+                     member< custom_content_recipient_object, time_point_sec, &custom_content_recipient_object::received>
                >,
                composite_key_compare< std::less< account_name_type >, std::greater<uint64_t>, std::greater< time_point_sec > >
             >
       >,
-      allocator< custom_content_object >
-> custom_content_index;
+      allocator< custom_content_recipient_object >
+> custom_content_recipient_index;
 
 
 }} //namespace
 
 
 FC_REFLECT(sophiatx::chain::custom_content_object,
-           (id)(app_id)(sender)(recipient)(binary)(data)(json)(received)(sender_sequence)(recipient_sequence)(app_message_sequence)
+           (id)(app_id)(sender)(all_recipients)(binary)(data)(json)(received)(sender_sequence)(app_message_sequence)
 )
 CHAINBASE_SET_INDEX_TYPE( sophiatx::chain::custom_content_object, sophiatx::chain::custom_content_index )
+
+FC_REFLECT(sophiatx::chain::custom_content_recipient_object,
+           (id)(app_id)(recipient)(recipient_sequence)(received)(content)
+)
+CHAINBASE_SET_INDEX_TYPE( sophiatx::chain::custom_content_recipient_object, sophiatx::chain::custom_content_recipient_index )
+
+namespace helpers
+{
+   template <>
+   class index_statistic_provider<sophiatx::chain::custom_content_index>
+   {
+   public:
+      typedef sophiatx::chain::custom_content_index IndexType;
+
+      index_statistic_info gather_statistics(const IndexType& index, bool onlyStaticInfo) const
+      {
+         index_statistic_info info;
+         gather_index_static_data(index, &info);
+
+         if(onlyStaticInfo == false)
+         {
+            for(const auto& o : index)
+               info._item_additional_allocation += o.data.capacity() + o.json.capacity() +
+                  o.all_recipients.capacity()*sizeof(sophiatx::chain::account_name_type);
+         }
+
+         return info;
+      }
+   };
+
+} /// namespace helpers
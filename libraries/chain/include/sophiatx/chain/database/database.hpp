@@ -4,6 +4,8 @@
 #pragma once
 #include <sophiatx/chain/database/database_interface.hpp>
 #include <sophiatx/chain/evaluator_registry.hpp>
+#include <sophiatx/chain/signature_recovery_pool.hpp>
+#include <sophiatx/chain/operation_profiler.hpp>
 
 namespace sophiatx {
 namespace chain {
@@ -50,6 +52,18 @@ public:
 
    void close(bool rewind = true);
 
+   /**
+    * @brief Write the state of all core and plugin indices to a portable snapshot file
+    *
+    * The snapshot can be loaded by a node of any build through open_args::snapshot_import, see state_snapshot.hpp.
+    *
+    * @return digest of the exported state
+    */
+   fc::sha256 export_snapshot(const fc::path &file);
+
+   /// Digest of the state of all core and plugin indices, equal to the digest of a snapshot exported at this point
+   fc::sha256 get_state_digest();
+
    //////////////////// db_block.cpp ////////////////////
 
    /**
@@ -145,6 +159,32 @@ public:
 
    void clear_pending();
 
+   /**
+    * @brief Set number of threads used to recover block signatures before the block is applied
+    *
+    * Transaction signer keys and the witness signee of every pushed block are recovered in parallel
+    * and the serial authority check only matches the recovered keys. Passing 0 disables the pre-pass.
+    */
+   void set_signature_recovery_threads( uint32_t threads );
+
+   /**
+    * @brief Set max number of recovered signature keys kept between mempool admission and block application
+    *
+    * Keys recovered from transaction signatures are cached until the transaction expires, so transactions
+    * seen before in the mempool, in pending state rebuilds or on another fork are not recovered again.
+    * Passing 0 disables the cache.
+    */
+   void set_signature_key_cache_size( size_t max_keys );
+   optional<signature_key_cache::stats> get_signature_key_cache_stats()const;
+
+   /**
+    * @brief Per operation type latencies of fee processing, evaluation and plugin signal handlers
+    *
+    * Profiling is off by default and can be switched on and off at any time, the stats are kept until reset.
+    */
+   operation_profiler& get_operation_profiler() { return _operation_profiler; }
+   const operation_profiler& get_operation_profiler()const { return _operation_profiler; }
+
    //////////////////// db_witness_schedule.cpp ////////////////////
 
    /**
@@ -262,6 +302,8 @@ public:
 
    void init_genesis(genesis_state_type genesis, chain_id_type chain_id);
 
+   void import_snapshot(const fc::path &file, const chain_id_type &chain_id);
+
    /**
     *  This method validates transactions without adding it to the pending state.
     *  @throw if an error occurs
@@ -293,7 +335,31 @@ protected:
 private:
    std::optional<chainbase::database::session> _pending_tx_session;
 
-   void apply_block(const signed_block &next_block, uint32_t skip = skip_nothing);
+   /// Ids of a block and of its transactions, computed before the block is applied
+   struct block_ids
+   {
+      block_id_type                    block_id;
+      std::vector<transaction_id_type> transaction_ids;
+   };
+
+   /**
+    * @brief Replay blocks 1..last_block_num from block log through a read -> deserialize -> apply pipeline
+    *
+    * A reader thread streams raw block data from the block log, a pool of args.replay_decode_threads threads unpacks
+    * the blocks and computes the ids of the blocks and their transactions and the calling thread applies them in
+    * order, reusing the ids.
+    */
+   void replay_blocks_pipelined( uint32_t last_block_num, const open_args &args,
+                                 const std::function<void(const signed_block &, const block_ids *)> &apply );
+
+   /// Applies the block, ids are computed from the block unless they are passed in
+   void apply_block(const signed_block &next_block, uint32_t skip = skip_nothing, const block_ids *ids = nullptr);
+
+   /// Id of the block being applied, precomputed if available
+   block_id_type applied_block_id(const signed_block &b) const;
+
+   /// Id of the transaction being applied, precomputed if it is part of the block being applied
+   transaction_id_type applied_transaction_id(const signed_transaction &trx) const;
 
    void apply_transaction(const signed_transaction &trx, uint32_t skip = skip_nothing);
 
@@ -361,6 +427,19 @@ private:
 
    block_log _block_log;
 
+   std::unique_ptr<signature_recovery_pool> _signature_recovery_pool;
+   /// Keys recovered for the block which is currently being applied
+   optional<signature_recovery_pool::block_keys> _recovered_block_keys;
+   const signed_block *_recovered_keys_block = nullptr;
+
+   /// Ids precomputed for the block which is currently being applied
+   const block_ids *_precomputed_ids = nullptr;
+   const signed_block *_precomputed_ids_block = nullptr;
+
+   std::unique_ptr<signature_key_cache> _signature_key_cache;
+
+   operation_profiler _operation_profiler;
+
    flat_map<uint32_t, block_id_type> _checkpoints;
 };
 
@@ -85,6 +85,19 @@ public:
       // The following fields are only used on reindexing
       uint32_t stop_replay_at = 0;
       TBenchmark benchmark = TBenchmark(0, [](uint32_t, const abstract_index_cntr_t &) {});
+      uint32_t replay_decode_threads = 0; ///< number of block deserializer threads, 0 replays on a single thread
+      uint32_t replay_queue_size = 64;    ///< max number of block batches read ahead of the apply loop
+      uint32_t block_log_chunk_size = 0;  ///< blocks per chunk of a newly created compressed block log, 0 creates a raw block log
+      bool flat_undo_log = false;         ///< keep undo history in flat append-only logs instead of per session trees
+      fc::path snapshot_import;           ///< build the state of an empty database from this snapshot instead of genesis
+   };
+
+   /// Progress of a single replay stage, reported on every benchmark interval during reindex
+   struct replay_stage_stats {
+      std::string stage;
+      uint64_t blocks = 0;  ///< blocks processed by the stage
+      uint64_t busy_us = 0; ///< time spent processing blocks
+      uint64_t wait_us = 0; ///< time spent waiting for the previous stage
    };
 
    /**
@@ -184,6 +197,8 @@ public:
       notify_post_apply_operation(note);
    }
 
+   void notify_pre_apply_block(const signed_block &block);
+
    void notify_applied_block(const signed_block &block);
 
    void notify_on_pending_transaction(const signed_transaction &tx);
@@ -198,6 +213,12 @@ public:
    boost::signals2::signal<void(const operation_notification &)> pre_apply_operation;
    boost::signals2::signal<void(const operation_notification &)> post_apply_operation;
 
+   /**
+    *  This signal is emitted before the transactions of a block are applied. The block may still fail
+    *  to apply, in that case it is not followed by applied_block.
+    */
+   boost::signals2::signal<void(const signed_block &)> pre_apply_block;
+
    /**
     *  This signal is emitted after all operations and virtual operation for a
     *  block have been applied but before the get_applied_operations() are cleared.
@@ -286,9 +307,13 @@ public:
 
    typedef void on_reindex_done_t(bool, uint32_t);
 
-   void on_reindex_start_connect(on_reindex_start_t functor) { _on_reindex_start.connect(functor); }
+   void on_reindex_start_connect(std::function<on_reindex_start_t> functor) { _on_reindex_start.connect(functor); }
+
+   void on_reindex_done_connect(std::function<on_reindex_done_t> functor) { _on_reindex_done.connect(functor); }
 
-   void on_reindex_done_connect(on_reindex_done_t functor) { _on_reindex_done.connect(functor); }
+   const std::vector<replay_stage_stats> &get_replay_stage_stats() const {
+      return _replay_stage_stats;
+   }
 
    chain_id_type get_chain_id() const {
       return get_dynamic_global_properties().chain_id;
@@ -323,6 +348,8 @@ protected:
    flat_map<uint64_t, std::shared_ptr<custom_operation_interpreter> > _custom_operation_interpreters;
    std::string _json_schema;
 
+   std::vector<replay_stage_stats> _replay_stage_stats;
+
    boost::signals2::signal<on_reindex_start_t> _on_reindex_start;
    boost::signals2::signal<on_reindex_done_t> _on_reindex_done;
 
@@ -331,4 +358,6 @@ protected:
 }
 }
 
+FC_REFLECT( sophiatx::chain::database_interface::replay_stage_stats, (stage)(blocks)(busy_us)(wait_us) )
+
 #endif //SOPHIATX_DATABASE_INTERFACE_HPP
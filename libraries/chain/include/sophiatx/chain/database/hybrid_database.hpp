@@ -7,6 +7,12 @@
 
 #include <fc/thread/thread.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 namespace sophiatx {
 namespace chain {
 
@@ -17,6 +23,32 @@ using sophiatx::protocol::asset;
 using sophiatx::protocol::asset_symbol_type;
 using sophiatx::protocol::price;
 
+/// Progress of a light node following the app messages of its full node
+struct hybrid_sync_stats
+{
+   /// Sequence of the last applied app message
+   uint64_t    head_op_number = 0;
+   /// Latest sequence known to exist on the full node
+   uint64_t    remote_op_number = 0;
+   /// Messages known to exist on the full node which are not applied yet
+   uint64_t    lag_ops = 0;
+   /// Time between the last applied message being received by the chain and being applied
+   uint32_t    lag_seconds = 0;
+   uint64_t    applied_ops = 0;
+   /// Write locks taken to apply the messages
+   uint64_t    applied_batches = 0;
+   uint64_t    fetched_pages = 0;
+   /// Messages pushed by the full node
+   uint64_t    received_notices = 0;
+   /// Messages applied per second over the last report interval
+   uint64_t    ops_per_second = 0;
+   /// Set while the full node pushes new messages, otherwise they are polled every block interval
+   bool        subscribed = false;
+   /// Set while pushed messages are dropped because the queue is full, they are polled until the queue caught up
+   bool        lagging = false;
+   /// Subscriptions made, a lost subscription is replaced once polling caught up again
+   uint64_t    subscriptions = 0;
+};
 
 /**
  *   @class database
@@ -120,16 +152,45 @@ public:
       not_implemented();
    }
 
-private:
+   hybrid_sync_stats get_sync_stats() const;
 
+private:
+   typedef std::pair<uint64_t, remote::received_object> queued_message;
+
+   /**
+    * Messages are fetched from the full node on the remote api thread and applied on the apply thread, so the next
+    * page is fetched while the current one is applied. Once a page comes back short the light node is caught up
+    * and subscribes to the messages of its app, new messages are then pushed by the full node into the same queue.
+    * When a pushed message does not continue the sequence, the full node disconnects or stops pushing messages which
+    * exist, the messages are polled again until the light node caught up and subscribes again. Subscriptions cannot
+    * be cancelled, pushes of the lost ones are told apart by the generation of their subscription and dropped.
+    */
    void start_sync_with_full_node();
 
-   bool is_sync() const;
+   void fetch_messages(uint64_t next_op_number);
+
+   /// Queues the next page of messages, returns false once the database is closing
+   bool fetch_page(uint64_t &next_op_number, bool &caught_up);
+
+   /**
+    * Polls the messages dropped while the subscription was lagging and checks every block interval that the full
+    * node still pushes the messages, returns once the subscription is lost
+    */
+   void follow_subscription();
 
-   const remote::get_app_custom_messages_return::iterator &
-   get_unprocessed_op(const remote::get_app_custom_messages_return::iterator &start,
-                      const remote::get_app_custom_messages_return::iterator &end,
-                      size_t size) const;
+   /// Passed the messages pushed by the full node on the thread of the connection, never blocks
+   void on_notice(uint64_t generation, remote::received_object obj);
+
+   /// The caller holds _sync_mutex
+   bool queue_full() const;
+
+   /// Blocks while the queue is full, returns false once the database is closing
+   bool queue_message(uint64_t sequence, remote::received_object obj);
+
+   void apply_queued_messages();
+
+   /// Applies the messages under a single write lock, messages applied already are skipped
+   void apply_batch(const std::vector<queued_message> &batch);
 
    void apply_custom_op(const remote::received_object &obj);
 
@@ -140,10 +201,30 @@ private:
    uint64_t _head_op_id;
    uint64_t _app_id;
    fc::thread _remote_api_thread;
-   bool _running;
+   fc::future<void> _fetch_done;
+   std::thread _apply_thread;
+   std::atomic<bool> _running{false};
+
+   mutable std::mutex _sync_mutex;
+   std::condition_variable _sync_cv;
+   /// Fetched or pushed messages waiting to be applied, in the order of their sequence
+   std::deque<queued_message> _sync_queue;
+   /// Generation of the current subscription, pushes of other generations are dropped
+   uint64_t _subscription = 0;
+   /// Sequence of the next message pushed by the full node
+   uint64_t _notice_op_number = 0;
+   /// Latest sequence dropped while the subscription was lagging
+   uint64_t _notice_dropped = 0;
+   hybrid_sync_stats _sync_stats;
+   fc::time_point _report_time;
+   uint64_t _report_applied_ops = 0;
 };
 
 }
 }
 
+FC_REFLECT(sophiatx::chain::hybrid_sync_stats,
+           (head_op_number)(remote_op_number)(lag_ops)(lag_seconds)(applied_ops)(applied_batches)(fetched_pages)
+           (received_notices)(ops_per_second)(subscribed)(lagging)(subscriptions))
+
 #endif //SOPHIATX_HYBRID_DATABASE_HPP
@@ -9,6 +9,51 @@
 
 namespace sophiatx { namespace chain {
 
+/**
+ * Typed snapshot of the chain configuration values used during block and transaction processing.
+ * It is filled once from the same variant object that get_config() returns, so both views always agree.
+ * Use sophiatx_config::params() on hot paths instead of the string keyed get<T>().
+ */
+struct sophiatx_params {
+    bool                          is_private_net = false;
+    protocol::asset_symbol_type   symbol;
+    protocol::public_key_type     init_public_key;
+    protocol::public_key_type     init_public_mining_key;
+
+    uint32_t    block_interval = 0;
+    uint32_t    blocks_per_hour = 0;
+    uint32_t    blocks_per_day = 0;
+    uint32_t    start_miner_voting_block = 0;
+
+    int64_t     init_supply = 0;
+    int64_t     total_supply = 0;
+    uint32_t    promotion_pool_percentage = 0;
+    uint32_t    mining_pool_percentage = 0;
+    uint32_t    interest_pool_percentage = 0;
+    uint32_t    burn_fee_percentage = 0;
+    uint32_t    interest_delay = 0;
+    uint32_t    interest_fees_time = 0;
+    uint32_t    coinbase_blocks = 0;
+    uint32_t    min_account_creation_fee = 0;
+
+    uint64_t    initial_witness_required_vesting_balance = 0;
+    uint64_t    final_witness_required_vesting_balance = 0;
+    uint32_t    witness_vesting_increase_days_hf = 0;
+    uint32_t    max_witnesses = 0;
+    uint32_t    max_voted_witnesses_hf0 = 0;
+    uint32_t    max_runner_witnesses_hf0 = 0;
+    uint32_t    hardfork_required_witnesses = 0;
+    uint32_t    max_account_witness_votes = 0;
+    uint32_t    min_feeds = 0;
+
+    uint32_t    limit_bandwidth_blocks = 0;
+    uint32_t    max_allowed_bandwidth = 0;
+    uint32_t    max_allowed_ops_count = 0;
+    uint32_t    max_transaction_size = 0;
+    uint32_t    min_block_size_limit = 0;
+    uint32_t    max_block_size = 0;
+};
+
 class sophiatx_config {
 
 public:
@@ -17,6 +62,7 @@ public:
         FC_ASSERT(config.get_object().size(), "can not init sophiatx_config with empty object!");
         instance().config_ = config.get_object();
         instance().config_loaded_ = true;
+        load_params();
         protocol::protocol_config::init(instance().config_);
     }
 
@@ -122,6 +168,7 @@ public:
         instance().config_["SOPHIATX_TEMP_ACCOUNT"] = SOPHIATX_TEMP_ACCOUNT;
         instance().config_["SOPHIATX_PROXY_TO_SELF_ACCOUNT"] = SOPHIATX_PROXY_TO_SELF_ACCOUNT;
 
+        load_params();
         protocol::protocol_config::init(instance().config_);
     }
 
@@ -138,6 +185,11 @@ public:
         return type;
     }
 
+    inline static const sophiatx_params& params() {
+        FC_ASSERT(instance().config_loaded_, "sophiatx_config is not initialized!");
+        return instance().params_;
+    }
+
 private:
     sophiatx_config() : config_loaded_(false) {}
     ~sophiatx_config() {}
@@ -147,8 +199,59 @@ private:
         return instance;
     }
 
+    template<typename T>
+    inline static void load_param( const char* index, T& value ) {
+        auto itr = instance().config_.find(index);
+        if( itr != instance().config_.end() )
+            fc::from_variant(itr->value(), value);
+    }
+
+    /// Configs received from older remote nodes may lack some keys, those keep their defaults
+    inline static void load_params() {
+        sophiatx_params p;
+        load_param("IS_PRIVATE_NET", p.is_private_net);
+        load_param("SOPHIATX_SYMBOL", p.symbol);
+        load_param("SOPHIATX_INIT_PUBLIC_KEY", p.init_public_key);
+        load_param("SOPHIATX_INIT_PUBLIC_MINING_KEY", p.init_public_mining_key);
+
+        load_param("SOPHIATX_BLOCK_INTERVAL", p.block_interval);
+        load_param("SOPHIATX_BLOCKS_PER_HOUR", p.blocks_per_hour);
+        load_param("SOPHIATX_BLOCKS_PER_DAY", p.blocks_per_day);
+        load_param("SOPHIATX_START_MINER_VOTING_BLOCK", p.start_miner_voting_block);
+
+        load_param("SOPHIATX_INIT_SUPPLY", p.init_supply);
+        load_param("SOPHIATX_TOTAL_SUPPLY", p.total_supply);
+        load_param("SOPHIATX_PROMOTION_POOL_PERCENTAGE", p.promotion_pool_percentage);
+        load_param("SOPHIATX_MINING_POOL_PERCENTAGE", p.mining_pool_percentage);
+        load_param("SOPHIATX_INTEREST_POOL_PERCENTAGE", p.interest_pool_percentage);
+        load_param("SOPHIATX_BURN_FEE_PERCENTAGE", p.burn_fee_percentage);
+        load_param("SOPHIATX_INTEREST_DELAY", p.interest_delay);
+        load_param("SOPHIATX_INTEREST_FEES_TIME", p.interest_fees_time);
+        load_param("SOPHIATX_COINBASE_BLOCKS", p.coinbase_blocks);
+        load_param("SOPHIATX_MIN_ACCOUNT_CREATION_FEE", p.min_account_creation_fee);
+
+        load_param("SOPHIATX_INITIAL_WITNESS_REQUIRED_VESTING_BALANCE", p.initial_witness_required_vesting_balance);
+        load_param("SOPHIATX_FINAL_WITNESS_REQUIRED_VESTING_BALANCE", p.final_witness_required_vesting_balance);
+        load_param("SOPHIATX_WITNESS_VESTING_INCREASE_DAYS_HF", p.witness_vesting_increase_days_hf);
+        load_param("SOPHIATX_MAX_WITNESSES", p.max_witnesses);
+        load_param("SOPHIATX_MAX_VOTED_WITNESSES_HF0", p.max_voted_witnesses_hf0);
+        load_param("SOPHIATX_MAX_RUNNER_WITNESSES_HF0", p.max_runner_witnesses_hf0);
+        load_param("SOPHIATX_HARDFORK_REQUIRED_WITNESSES", p.hardfork_required_witnesses);
+        load_param("SOPHIATX_MAX_ACCOUNT_WITNESS_VOTES", p.max_account_witness_votes);
+        load_param("SOPHIATX_MIN_FEEDS", p.min_feeds);
+
+        load_param("SOPHIATX_LIMIT_BANDWIDTH_BLOCKS", p.limit_bandwidth_blocks);
+        load_param("SOPHIATX_MAX_ALLOWED_BANDWIDTH", p.max_allowed_bandwidth);
+        load_param("SOPHIATX_MAX_ALLOWED_OPS_COUNT", p.max_allowed_ops_count);
+        load_param("SOPHIATX_MAX_TRANSACTION_SIZE", p.max_transaction_size);
+        load_param("SOPHIATX_MIN_BLOCK_SIZE_LIMIT", p.min_block_size_limit);
+        load_param("SOPHIATX_MAX_BLOCK_SIZE", p.max_block_size);
+        instance().params_ = p;
+    }
+
     bool config_loaded_;
     fc::mutable_variant_object config_;
+    sophiatx_params params_;
 };
 
 } } // sophiatx::protocol
@@ -25,7 +25,7 @@ namespace sophiatx { namespace chain {
       public:
          template< typename Constructor, typename Allocator >
          dynamic_global_property_object( Constructor&& c, allocator< Allocator > a ) :
-                 witness_required_vesting(chain::sophiatx_config::get<uint64_t>("SOPHIATX_INITIAL_WITNESS_REQUIRED_VESTING_BALANCE"), chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") )
+                 witness_required_vesting(chain::sophiatx_config::params().initial_witness_required_vesting_balance, chain::sophiatx_config::params().symbol )
          {
             c( *this );
          }
@@ -39,9 +39,9 @@ namespace sophiatx { namespace chain {
          time_point_sec    time;
          account_name_type current_witness;
 
-         asset       current_supply             = asset( 0, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") );
+         asset       current_supply             = asset( 0, chain::sophiatx_config::params().symbol );
          asset       total_vesting_shares       = asset( 0, VESTS_SYMBOL );
-         asset       total_reward_fund    = asset( 0, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") );
+         asset       total_reward_fund    = asset( 0, chain::sophiatx_config::params().symbol );
 
          asset       witness_required_vesting;
 
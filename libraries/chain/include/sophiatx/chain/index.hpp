@@ -1,6 +1,7 @@
 #pragma once
 
 #include <sophiatx/chain/database/database_interface.hpp>
+#include <sophiatx/chain/state_snapshot.hpp>
 
 namespace sophiatx {
 namespace chain {
@@ -9,6 +10,7 @@ template<typename MultiIndexType>
 void _add_index_impl(const std::weak_ptr<database_interface> &db) {
    if( auto ptr = db.lock() ) {
       ptr->add_index<MultiIndexType>();
+      ptr->add_index_extension<MultiIndexType>( std::make_shared< snapshot_index< MultiIndexType > >( *ptr ) );
    } else {
       FC_ASSERT(false, "DB pointer does not exist!");
    }
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <sophiatx/protocol/operations.hpp>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+namespace sophiatx { namespace chain {
+
+using protocol::operation;
+
+/**
+ * Call counts and latency histograms of the phases of database::apply_operation, kept per operation type.
+ *
+ * Latencies are counted in power of two nanosecond buckets, so recording a call is a handful of relaxed atomic
+ * increments and the stats can be read from API threads while blocks are applied. A disabled profiler costs a
+ * single flag check per operation.
+ */
+class operation_profiler
+{
+   public:
+      enum phase_type
+      {
+         fee_phase,        ///< process_operation_fee
+         evaluate_phase,   ///< evaluator apply
+         signal_phase,     ///< pre and post apply operation signal handlers of plugins
+         phase_count
+      };
+
+      /// Bucket i counts calls which took less than 2^i ns, the last bucket counts everything slower
+      static constexpr uint32_t bucket_count = 40;
+
+      struct phase_stats
+      {
+         uint64_t                count = 0;
+         uint64_t                total_ns = 0;
+         uint64_t                max_ns = 0;
+         /// Upper bounds of the histogram buckets the percentiles fall into
+         uint64_t                p50_ns = 0;
+         uint64_t                p90_ns = 0;
+         uint64_t                p99_ns = 0;
+         /// Calls per bucket, trailing empty buckets are left out
+         std::vector< uint64_t > histogram;
+      };
+
+      struct operation_stats
+      {
+         std::string             name;
+         phase_stats             fee;
+         phase_stats             evaluate;
+         phase_stats             signals;
+      };
+
+      /// Measures the phases of one operation, the signal phase is the sum of the pre and post signals
+      class timer
+      {
+         public:
+            timer( operation_profiler& profiler, int64_t which ) : _profiler( profiler ), _which( which ), _last( std::chrono::steady_clock::now() ) {}
+
+            void lap( phase_type phase )
+            {
+               auto now = std::chrono::steady_clock::now();
+               _elapsed[ phase ] += std::chrono::duration_cast< std::chrono::nanoseconds >( now - _last ).count();
+               _last = now;
+            }
+
+            /// Records the phases, operations which threw are not recorded
+            void finish()
+            {
+               for( uint32_t p = 0; p < phase_count; ++p )
+                  _profiler.record( _which, phase_type( p ), _elapsed[ p ] );
+            }
+
+         private:
+            operation_profiler&                       _profiler;
+            int64_t                                   _which;
+            std::chrono::steady_clock::time_point     _last;
+            std::array< uint64_t, phase_count >       _elapsed = {};
+      };
+
+      operation_profiler();
+
+      void set_enabled( bool enabled ) { _enabled.store( enabled, std::memory_order_relaxed ); }
+      bool enabled()const { return _enabled.load( std::memory_order_relaxed ); }
+
+      void record( int64_t which, phase_type phase, uint64_t ns );
+      void reset();
+
+      /// Stats of the operation types applied since the last reset, sorted by total time spent in them
+      std::vector< operation_stats > get_stats()const;
+
+   private:
+      struct phase_counters
+      {
+         std::atomic< uint64_t > count;
+         std::atomic< uint64_t > total_ns;
+         std::atomic< uint64_t > max_ns;
+         std::atomic< uint64_t > buckets[ bucket_count ];
+      };
+
+      typedef std::array< phase_counters, phase_count > operation_counters;
+
+      std::atomic< bool >                         _enabled;
+      std::unique_ptr< operation_counters[] >     _counters;
+};
+
+} } // sophiatx::chain
+
+FC_REFLECT( sophiatx::chain::operation_profiler::phase_stats, (count)(total_ns)(max_ns)(p50_ns)(p90_ns)(p99_ns)(histogram) )
+FC_REFLECT( sophiatx::chain::operation_profiler::operation_stats, (name)(fee)(evaluate)(signals) )
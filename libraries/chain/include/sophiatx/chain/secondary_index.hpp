@@ -0,0 +1,83 @@
+#pragma once
+
+#include <sophiatx/chain/database/database_interface.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sophiatx { namespace chain {
+
+/**
+ * Ordering of the objects of a core index which only apis read.
+ *
+ * Orderings kept in the multi_index_container are maintained by every change of an object, on the write path, even on
+ * nodes which never read them. A secondary index is owned by the plugin reading it and is not maintained at all: it is
+ * rebuilt from the core index the first time it is read after the head block changed. Changes of the pending
+ * transactions are not reflected until the next block, so the order may be off by the changes of a block.
+ *
+ * Entries hold the ids of the objects, readers look the objects up while they hold the database read lock and skip
+ * the ones which no longer exist.
+ */
+template< typename MultiIndexType, typename KeyType, typename Compare = std::less< KeyType > >
+class secondary_index
+{
+   public:
+      typedef typename MultiIndexType::value_type                 value_type;
+      typedef typename value_type::id_type                       id_type;
+      typedef std::pair< KeyType, id_type >                      entry_type;
+      /// Sorted by key, objects with equal keys by id
+      typedef std::vector< entry_type >                          entries_type;
+      typedef std::function< KeyType( const value_type& ) >      key_extractor_type;
+
+      explicit secondary_index( key_extractor_type key ) : _key( std::move( key ) ) {}
+
+      std::shared_ptr< const entries_type > get( const database_interface& db )
+      {
+         return get( db.get_index< MultiIndexType >(), db.head_block_id() );
+      }
+
+      std::shared_ptr< const entries_type > get( const chainbase::generic_index< MultiIndexType >& idx, const block_id_type& head_block_id )
+      {
+         std::lock_guard< std::mutex > guard( _mutex );
+         if( _entries && _head_block_id == head_block_id )
+            return _entries;
+
+         auto entries = std::make_shared< entries_type >();
+         entries->reserve( idx.indices().size() );
+         for( const auto& o : idx.indices() )
+            entries->emplace_back( _key( o ), o.id );
+
+         std::stable_sort( entries->begin(), entries->end(), entry_compare() );
+
+         _entries = std::move( entries );
+         _head_block_id = head_block_id;
+         ++_rebuilds;
+         return _entries;
+      }
+
+      /// Number of times the entries were built, for benchmarks and tests
+      uint64_t rebuilds()const
+      {
+         std::lock_guard< std::mutex > guard( _mutex );
+         return _rebuilds;
+      }
+
+      struct entry_compare
+      {
+         bool operator()( const entry_type& a, const entry_type& b )const { return Compare()( a.first, b.first ); }
+         bool operator()( const entry_type& a, const KeyType& b )const { return Compare()( a.first, b ); }
+         bool operator()( const KeyType& a, const entry_type& b )const { return Compare()( a, b.first ); }
+      };
+
+   private:
+      key_extractor_type                     _key;
+      mutable std::mutex                     _mutex;
+      std::shared_ptr< const entries_type >  _entries;
+      block_id_type                          _head_block_id;
+      uint64_t                               _rebuilds = 0;
+};
+
+} } // sophiatx::chain
@@ -0,0 +1,41 @@
+#pragma once
+#include <sophiatx/protocol/block.hpp>
+
+namespace sophiatx { namespace chain {
+
+   using namespace sophiatx::protocol;
+
+   namespace detail { class signature_recovery_pool_impl; }
+
+   /* Recovers the signer keys of block transactions and the witness signee on a pool of worker
+    * threads. This is done before the block is applied, outside of the authority checks, so that
+    * the serial part of database::_apply_transaction only has to match the already recovered keys
+    * against the account authorities.
+    *
+    * Recovery failures are not reported. The corresponding entry is left empty and the caller is
+    * expected to fall back to the serial path, which raises the proper exception.
+    */
+   class signature_recovery_pool {
+      public:
+         struct block_keys
+         {
+            /// Recovered witness signee, empty if not requested or recovery failed
+            optional< public_key_type >                           witness_signee;
+            /// Recovered signature keys, one entry per block transaction
+            vector< optional< flat_set< public_key_type > > >     transaction_keys;
+         };
+
+         signature_recovery_pool( uint32_t thread_count );
+         ~signature_recovery_pool();
+
+         uint32_t thread_count()const;
+
+         /// Transaction keys are looked up in and added to cache if it is given
+         block_keys recover( const signed_block& b, const chain_id_type& chain_id, fc::ecc::canonical_signature_type canon_type,
+                             bool recover_witness, bool recover_transactions, signature_key_cache* cache = nullptr );
+
+      private:
+         std::unique_ptr< detail::signature_recovery_pool_impl > my;
+   };
+
+} }
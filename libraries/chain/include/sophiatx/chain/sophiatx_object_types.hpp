@@ -59,7 +59,8 @@ enum object_type
    account_fee_sponsor_object_type,
    application_buying_object_type,
    hybrid_db_property_object_type,
-   account_bandwidth_object_type
+   account_bandwidth_object_type,
+   custom_content_recipient_object_type
 };
 
 class dynamic_global_property_object;
@@ -86,6 +87,7 @@ class account_fee_sponsor_object;
 class application_buying_object;
 class hybrid_db_property_object;
 class account_bandwidth_object;
+class custom_content_recipient_object;
 
 
 typedef oid< dynamic_global_property_object         > dynamic_global_property_id_type;
@@ -112,6 +114,7 @@ typedef oid< account_fee_sponsor_object             > account_fee_sponsor_id_typ
 typedef oid< application_buying_object              > application_buying_id_type;
 typedef oid< hybrid_db_property_object              > hybrid_db_property_object_id_type;
 typedef oid< account_bandwidth_object               > account_bandwidth_object_id_type;
+typedef oid< custom_content_recipient_object        > custom_content_recipient_id_type;
 
 
 } } //sophiatx::chain
@@ -181,6 +184,7 @@ FC_REFLECT_ENUM( sophiatx::chain::object_type,
                  (application_buying_object_type)
                  (hybrid_db_property_object_type)
                  (account_bandwidth_object_type)
+                 (custom_content_recipient_object_type)
                )
 
 FC_REFLECT_TYPENAME( sophiatx::chain::shared_string )
\ No newline at end of file
@@ -0,0 +1,320 @@
+#pragma once
+
+#include <sophiatx/chain/sophiatx_object_types.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <boost/container/deque.hpp>
+
+#include <fstream>
+#include <type_traits>
+
+namespace sophiatx { namespace chain {
+
+/**
+ * Portable snapshot of the chain state.
+ *
+ * A snapshot holds every object of every index registered through add_core_index or add_plugin_index, serialized
+ * with its FC_REFLECT fields, so unlike shared_memory.bin it does not depend on the compiler, the build or the
+ * layout of the multi index containers. The file is a sequence of size prefixed records:
+ *
+ *    snapshot_header
+ *    for every index: snapshot_index_header, followed by one record per object in id order
+ *    sha256 of all records (not a record itself)
+ *
+ * The trailing digest depends only on the state and the head block, so two nodes with the same state export
+ * snapshots with the same digest.
+ */
+struct snapshot_header
+{
+   /// 2: indices are named by the reflected name of their object type
+   /// 3: custom content keeps its payload once per message, recipients are indexed by custom_content_recipient_object
+   static constexpr uint32_t current_version = 3;
+
+   std::string          magic = "SPHXSNAP";
+   uint32_t             version = current_version;
+   chain_id_type        chain_id;
+   uint32_t             head_block_num = 0;
+   block_id_type        head_block_id;
+   fc::time_point_sec   head_block_time;
+   uint32_t             index_count = 0;
+};
+
+struct snapshot_index_header
+{
+   /// Name of the object type as given to FC_REFLECT, which does not depend on the compiler
+   std::string          name;
+   int64_t              next_id = 0;
+   uint64_t             object_count = 0;
+};
+
+namespace detail {
+
+   /// Chain objects and the structs nested in them which are allocated in shared memory are walked field by field
+   template< typename T >
+   struct has_type_id
+   {
+      template< typename U > static std::true_type check( decltype( U::type_id )* );
+      template< typename U > static std::false_type check( ... );
+      static constexpr bool value = decltype( check< T >( nullptr ) )::value;
+   };
+
+   template< typename T >
+   struct has_allocator_type
+   {
+      template< typename U > static std::true_type check( typename U::allocator_type* );
+      template< typename U > static std::false_type check( ... );
+      static constexpr bool value = decltype( check< T >( nullptr ) )::value;
+   };
+
+   /**
+    * Serializes a member of a chain object. Shared memory types which fc::raw cannot unpack in place are handled
+    * here, structs allocated in shared memory are walked field by field and everything else is left to fc::raw.
+    */
+   template< typename T, typename Enable = void >
+   struct snapshot_io
+   {
+      template< typename Stream >
+      static void pack( Stream& s, const T& v ) { fc::raw::pack( s, v ); }
+
+      template< typename Stream >
+      static void unpack( Stream& s, T& v ) { fc::raw::unpack( s, v, uint32_t( 0 ) ); }
+   };
+
+   template< typename Stream, typename Class >
+   struct snapshot_pack_visitor
+   {
+      snapshot_pack_visitor( const Class& _c, Stream& _s ) : c( _c ), s( _s ) {}
+
+      template< typename T, typename C, T( C::*p ) >
+      void operator()( const char* name )const
+      {
+         snapshot_io< T >::pack( s, c.*p );
+      }
+
+      const Class&   c;
+      Stream&        s;
+   };
+
+   template< typename Stream, typename Class >
+   struct snapshot_unpack_visitor
+   {
+      snapshot_unpack_visitor( Class& _c, Stream& _s ) : c( _c ), s( _s ) {}
+
+      template< typename T, typename C, T( C::*p ) >
+      void operator()( const char* name )const
+      { try {
+         snapshot_io< T >::unpack( s, c.*p );
+      } FC_RETHROW_EXCEPTIONS( warn, "Error unpacking field ${field}", ("field", name) ) }
+
+      Class&         c;
+      Stream&        s;
+   };
+
+   template< typename T >
+   struct snapshot_io< T, typename std::enable_if< fc::reflector< T >::is_defined::value && ( has_type_id< T >::value || has_allocator_type< T >::value ) >::type >
+   {
+      template< typename Stream >
+      static void pack( Stream& s, const T& v ) { fc::reflector< T >::visit( snapshot_pack_visitor< Stream, T >( v, s ) ); }
+
+      template< typename Stream >
+      static void unpack( Stream& s, T& v ) { fc::reflector< T >::visit( snapshot_unpack_visitor< Stream, T >( v, s ) ); }
+   };
+
+   template< typename T >
+   struct snapshot_io< chainbase::oid< T > >
+   {
+      template< typename Stream >
+      static void pack( Stream& s, const chainbase::oid< T >& v ) { fc::raw::pack( s, v._id ); }
+
+      template< typename Stream >
+      static void unpack( Stream& s, chainbase::oid< T >& v ) { fc::raw::unpack( s, v._id, uint32_t( 0 ) ); }
+   };
+
+   template<>
+   struct snapshot_io< shared_string >
+   {
+      template< typename Stream >
+      static void pack( Stream& s, const shared_string& v )
+      {
+         fc::raw::pack( s, fc::unsigned_int( v.size() ) );
+         if( v.size() )
+            s.write( v.data(), v.size() );
+      }
+
+      template< typename Stream >
+      static void unpack( Stream& s, shared_string& v )
+      {
+         fc::unsigned_int size;
+         fc::raw::unpack( s, size, uint32_t( 0 ) );
+         v.resize( size.value );
+         if( size.value )
+            s.read( &v[0], size.value );
+      }
+   };
+
+   template< typename T, typename... A >
+   struct snapshot_io< boost::container::deque< T, A... > >
+   {
+      template< typename Stream >
+      static void pack( Stream& s, const boost::container::deque< T, A... >& v )
+      {
+         fc::raw::pack( s, fc::unsigned_int( v.size() ) );
+         for( const auto& item : v )
+            snapshot_io< T >::pack( s, item );
+      }
+
+      template< typename Stream >
+      static void unpack( Stream& s, boost::container::deque< T, A... >& v )
+      {
+         fc::unsigned_int size;
+         fc::raw::unpack( s, size, uint32_t( 0 ) );
+         v.clear();
+         for( uint32_t i = 0; i < size.value; ++i )
+         {
+            T item;
+            snapshot_io< T >::unpack( s, item );
+            v.push_back( std::move( item ) );
+         }
+      }
+   };
+
+}
+
+/**
+ * Writes snapshot records to a file and keeps the digest of everything written. Without a file only the digest
+ * is computed.
+ */
+class snapshot_writer
+{
+   public:
+      explicit snapshot_writer( const fc::path& file = fc::path() );
+
+      template< typename T >
+      void write( const T& v )
+      {
+         fc::datastream< size_t > size_stream;
+         detail::snapshot_io< T >::pack( size_stream, v );
+         _buffer.resize( size_stream.tellp() );
+
+         fc::datastream< char* > ds( _buffer.data(), _buffer.size() );
+         detail::snapshot_io< T >::pack( ds, v );
+         write_record();
+      }
+
+      /// Writes the digest of all records and closes the file
+      fc::sha256 finish();
+
+   private:
+      void write_record();
+
+      std::ofstream           _out;
+      fc::sha256::encoder     _digest;
+      std::vector< char >     _buffer;
+};
+
+class snapshot_reader
+{
+   public:
+      explicit snapshot_reader( const fc::path& file );
+
+      template< typename T >
+      void read( T& v )
+      {
+         read_record();
+         fc::datastream< const char* > ds( _buffer.data(), _buffer.size() );
+         detail::snapshot_io< T >::unpack( ds, v );
+         FC_ASSERT( ds.remaining() == 0, "Snapshot record was not fully read, the snapshot does not match this build" );
+      }
+
+      /// Digests the next record without unpacking it
+      void skip() { read_record(); }
+
+      /// Reads the digest stored after the last record and checks it against the digest of all records read
+      fc::sha256 finish();
+
+   private:
+      void read_record();
+
+      std::ifstream           _in;
+      uint64_t                _file_size = 0;
+      fc::sha256::encoder     _digest;
+      std::vector< char >     _buffer;
+};
+
+/**
+ * Index extension which serializes one index to a snapshot and rebuilds it from one. Registered for every index
+ * added through add_core_index and add_plugin_index.
+ */
+class abstract_snapshot_index : public chainbase::index_extension
+{
+   public:
+      virtual ~abstract_snapshot_index() {}
+
+      virtual std::string name()const = 0;
+      virtual void write( snapshot_writer& w )const = 0;
+      virtual void read( snapshot_reader& r, const snapshot_index_header& header ) = 0;
+};
+
+template< typename MultiIndexType >
+class snapshot_index : public abstract_snapshot_index
+{
+   public:
+      typedef typename MultiIndexType::value_type value_type;
+
+      snapshot_index( chainbase::database& db ) : _db( db ) {}
+
+      virtual std::string name()const override
+      {
+         return fc::get_typename< value_type >::name();
+      }
+
+      virtual void write( snapshot_writer& w )const override
+      {
+         const auto& idx = _db.get_index< MultiIndexType >();
+
+         snapshot_index_header header;
+         header.name = name();
+         header.next_id = idx.next_id()._id;
+         header.object_count = idx.indices().size();
+         w.write( header );
+
+         for( const auto& o : idx.indices() )
+            w.write( o );
+      }
+
+      virtual void read( snapshot_reader& r, const snapshot_index_header& header ) override
+      {
+         auto& idx = _db.get_mutable_index< MultiIndexType >();
+         FC_ASSERT( idx.indices().empty(), "Cannot import a snapshot into a non empty index", ("index", header.name) );
+
+         for( uint64_t i = 0; i < header.object_count; ++i )
+            idx.import( [&]( value_type& o ) { r.read( o ); } );
+
+         idx.set_next_id( header.next_id );
+      }
+
+   private:
+      chainbase::database& _db;
+};
+
+/**
+ * Exports all indices with a snapshot_index extension. Without a file only the digest of the state is computed.
+ * The database has to be read locked.
+ */
+fc::sha256 export_snapshot( const chainbase::database& db, snapshot_header header, const fc::path& file = fc::path() );
+
+/**
+ * Rebuilds all indices with a snapshot_index extension from a snapshot. All of them have to be empty and present
+ * in the snapshot, indices of plugins which are not enabled are skipped. The digest is verified against the
+ * digest stored in the file. The database has to be write locked.
+ */
+snapshot_header import_snapshot( chainbase::database& db, const fc::path& file, const chain_id_type& chain_id );
+
+} } // sophiatx::chain
+
+FC_REFLECT( sophiatx::chain::snapshot_header, (magic)(version)(chain_id)(head_block_num)(head_block_id)(head_block_time)(index_count) )
+FC_REFLECT( sophiatx::chain::snapshot_index_header, (name)(next_id)(object_count) )
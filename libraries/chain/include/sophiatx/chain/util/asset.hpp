@@ -9,15 +9,15 @@ using sophiatx::protocol::price;
 
 inline asset to_sbd( const price& p, const asset& sophiatx )
 {
-   FC_ASSERT( sophiatx.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") );
-   FC_ASSERT( p.quote.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") || p.base.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") );
+   FC_ASSERT( sophiatx.symbol == chain::sophiatx_config::params().symbol );
+   FC_ASSERT( p.quote.symbol == chain::sophiatx_config::params().symbol || p.base.symbol == chain::sophiatx_config::params().symbol );
    return sophiatx * p;
 }
 
 inline asset to_sophiatx( const price& p, const asset& sbd )
 {
    FC_ASSERT( sbd.symbol == SBD1_SYMBOL || sbd.symbol == SBD2_SYMBOL || sbd.symbol == SBD3_SYMBOL || sbd.symbol == SBD4_SYMBOL || sbd.symbol == SBD5_SYMBOL );
-   FC_ASSERT( p.quote.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") || p.base.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") );
+   FC_ASSERT( p.quote.symbol == chain::sophiatx_config::params().symbol || p.base.symbol == chain::sophiatx_config::params().symbol );
    FC_ASSERT( p.quote.symbol == sbd.symbol || p.base.symbol == sbd.symbol);
    return sbd * p;
 }
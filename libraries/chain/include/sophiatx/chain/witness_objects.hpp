@@ -36,7 +36,7 @@ struct shared_chain_properties
     *  fee requires all accounts to have some kind of commitment to the network that includes the
     *  ability to vote and make transactions.
     */
-   asset account_creation_fee = asset( chain::sophiatx_config::get<uint32_t>("SOPHIATX_MIN_ACCOUNT_CREATION_FEE"), chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") );
+   asset account_creation_fee = asset( chain::sophiatx_config::params().min_account_creation_fee, chain::sophiatx_config::params().symbol );
 
    /**
     *  This witnesses vote for the maximum_block_size which is used by the network
@@ -55,7 +55,7 @@ struct shared_chain_properties
 
    template< typename Allocator >
    shared_chain_properties( const Allocator& alloc ) :
-           maximum_block_size(chain::sophiatx_config::get<uint32_t>("SOPHIATX_MIN_BLOCK_SIZE_LIMIT") * 2),
+           maximum_block_size(chain::sophiatx_config::params().min_block_size_limit * 2),
            price_feeds( price_feed_allocator_type( alloc.get_segment_manager() ) ) {}
 
    shared_chain_properties& operator=( const chain_properties& a ){
@@ -199,9 +199,9 @@ struct shared_chain_properties
          template< typename Constructor, typename Allocator >
          witness_schedule_object( Constructor&& c, allocator< Allocator > a ) :
          current_shuffled_witnesses(a.get_segment_manager()),
-         max_voted_witnesses(chain::sophiatx_config::get<uint8_t>("SOPHIATX_MAX_VOTED_WITNESSES_HF0")),
-         max_runner_witnesses(chain::sophiatx_config::get<uint8_t>("SOPHIATX_MAX_RUNNER_WITNESSES_HF0")),
-         hardfork_required_witnesses(chain::sophiatx_config::get<uint8_t>("SOPHIATX_HARDFORK_REQUIRED_WITNESSES"))
+         max_voted_witnesses(static_cast<uint8_t>(chain::sophiatx_config::params().max_voted_witnesses_hf0)),
+         max_runner_witnesses(static_cast<uint8_t>(chain::sophiatx_config::params().max_runner_witnesses_hf0)),
+         hardfork_required_witnesses(static_cast<uint8_t>(chain::sophiatx_config::params().hardfork_required_witnesses))
          {
             c( *this );
          }
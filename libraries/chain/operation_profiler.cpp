@@ -0,0 +1,131 @@
+#include <sophiatx/chain/operation_profiler.hpp>
+
+#include <sophiatx/protocol/operation_util_impl.hpp>
+
+#include <algorithm>
+
+namespace sophiatx { namespace chain {
+
+namespace detail {
+
+   uint32_t bucket_of( uint64_t ns )
+   {
+      uint32_t bucket = ns ? 64 - __builtin_clzll( ns ) : 0;
+      return std::min( bucket, operation_profiler::bucket_count - 1 );
+   }
+
+   std::string operation_name( int64_t which )
+   {
+      static const std::vector< std::string > names = []()
+      {
+         std::vector< std::string > result( operation::count() );
+         for( int64_t i = 0; i < operation::count(); ++i )
+         {
+            operation op;
+            op.set_which( i );
+            op.visit( fc::get_operation_name( result[ i ] ) );
+         }
+         return result;
+      }();
+
+      return names[ which ];
+   }
+
+}
+
+operation_profiler::operation_profiler()
+   : _enabled( false ), _counters( new operation_counters[ operation::count() ] )
+{
+   reset();
+}
+
+void operation_profiler::record( int64_t which, phase_type phase, uint64_t ns )
+{
+   auto& c = _counters[ which ][ phase ];
+   c.count.fetch_add( 1, std::memory_order_relaxed );
+   c.total_ns.fetch_add( ns, std::memory_order_relaxed );
+   c.buckets[ detail::bucket_of( ns ) ].fetch_add( 1, std::memory_order_relaxed );
+
+   uint64_t max = c.max_ns.load( std::memory_order_relaxed );
+   while( ns > max && !c.max_ns.compare_exchange_weak( max, ns, std::memory_order_relaxed ) );
+}
+
+void operation_profiler::reset()
+{
+   for( int64_t i = 0; i < operation::count(); ++i )
+   {
+      for( auto& c : _counters[ i ] )
+      {
+         c.count.store( 0, std::memory_order_relaxed );
+         c.total_ns.store( 0, std::memory_order_relaxed );
+         c.max_ns.store( 0, std::memory_order_relaxed );
+         for( auto& b : c.buckets )
+            b.store( 0, std::memory_order_relaxed );
+      }
+   }
+}
+
+std::vector< operation_profiler::operation_stats > operation_profiler::get_stats()const
+{
+   auto get_phase = []( const phase_counters& c )
+   {
+      phase_stats result;
+      result.total_ns = c.total_ns.load( std::memory_order_relaxed );
+      result.max_ns = c.max_ns.load( std::memory_order_relaxed );
+
+      for( uint32_t i = 0; i < bucket_count; ++i )
+      {
+         result.histogram.push_back( c.buckets[ i ].load( std::memory_order_relaxed ) );
+         result.count += result.histogram.back();
+      }
+
+      while( !result.histogram.empty() && result.histogram.back() == 0 )
+         result.histogram.pop_back();
+
+      // Counted from the histogram so the percentiles are consistent with it while calls are being recorded
+      auto percentile = [&]( uint64_t permille )
+      {
+         uint64_t rank = ( result.count * permille + 999 ) / 1000;
+         uint64_t seen = 0;
+         for( uint32_t i = 0; i < result.histogram.size(); ++i )
+         {
+            seen += result.histogram[ i ];
+            if( seen >= rank && i + 1 < bucket_count )
+               return std::min( uint64_t( 1 ) << i, result.max_ns );
+         }
+         return result.max_ns;
+      };
+
+      if( result.count )
+      {
+         result.p50_ns = percentile( 500 );
+         result.p90_ns = percentile( 900 );
+         result.p99_ns = percentile( 990 );
+      }
+
+      return result;
+   };
+
+   std::vector< operation_stats > result;
+   for( int64_t i = 0; i < operation::count(); ++i )
+   {
+      operation_stats stats;
+      stats.fee = get_phase( _counters[ i ][ fee_phase ] );
+      stats.evaluate = get_phase( _counters[ i ][ evaluate_phase ] );
+      stats.signals = get_phase( _counters[ i ][ signal_phase ] );
+      if( !stats.fee.count && !stats.evaluate.count && !stats.signals.count )
+         continue;
+
+      stats.name = detail::operation_name( i );
+      result.push_back( std::move( stats ) );
+   }
+
+   std::sort( result.begin(), result.end(), []( const operation_stats& a, const operation_stats& b )
+   {
+      return a.fee.total_ns + a.evaluate.total_ns + a.signals.total_ns > b.fee.total_ns + b.evaluate.total_ns + b.signals.total_ns;
+   });
+
+   return result;
+}
+
+} } // sophiatx::chain
@@ -0,0 +1,104 @@
+#include <sophiatx/chain/signature_recovery_pool.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <future>
+
+namespace sophiatx { namespace chain {
+
+   namespace asio = boost::asio;
+
+   namespace detail {
+      class signature_recovery_pool_impl {
+         public:
+            signature_recovery_pool_impl( uint32_t threads ) :
+               thread_count( threads ),
+               work( ios )
+            {
+               for( uint32_t i = 0; i < thread_count; ++i )
+                  thread_pool.create_thread( boost::bind( &asio::io_service::run, &ios ) );
+            }
+
+            ~signature_recovery_pool_impl()
+            {
+               ios.stop();
+               thread_pool.join_all();
+            }
+
+            uint32_t                thread_count;
+            asio::io_service        ios;
+            asio::io_service::work  work;
+            boost::thread_group     thread_pool;
+      };
+   }
+
+   signature_recovery_pool::signature_recovery_pool( uint32_t thread_count )
+   :my( new detail::signature_recovery_pool_impl( thread_count ) )
+   {
+      FC_ASSERT( thread_count > 0, "Signature recovery pool needs at least one thread" );
+   }
+
+   signature_recovery_pool::~signature_recovery_pool() {}
+
+   uint32_t signature_recovery_pool::thread_count()const
+   {
+      return my->thread_count;
+   }
+
+   signature_recovery_pool::block_keys signature_recovery_pool::recover( const signed_block& b, const chain_id_type& chain_id,
+      fc::ecc::canonical_signature_type canon_type, bool recover_witness, bool recover_transactions, signature_key_cache* cache )
+   {
+      block_keys result;
+      std::vector< std::future< void > > tasks;
+
+      if( recover_witness )
+      {
+         auto task = std::make_shared< std::packaged_task< void() > >( [&]()
+         {
+            try
+            {
+               result.witness_signee = public_key_type( b.signee( canon_type ) );
+            }
+            catch( ... ) {}
+         });
+         tasks.push_back( task->get_future() );
+         my->ios.post( [task](){ (*task)(); } );
+      }
+
+      if( recover_transactions && b.transactions.size() )
+      {
+         result.transaction_keys.resize( b.transactions.size() );
+
+         // Split the transactions into one contiguous range per worker, each worker writes only to its own range
+         size_t chunk_size = ( b.transactions.size() + my->thread_count - 1 ) / my->thread_count;
+         for( size_t begin = 0; begin < b.transactions.size(); begin += chunk_size )
+         {
+            size_t end = std::min( begin + chunk_size, b.transactions.size() );
+            auto task = std::make_shared< std::packaged_task< void() > >( [&, begin, end]()
+            {
+               for( size_t i = begin; i < end; ++i )
+               {
+                  try
+                  {
+                     if( cache )
+                        result.transaction_keys[i] = b.transactions[i].get_signature_keys( chain_id, canon_type, *cache );
+                     else
+                        result.transaction_keys[i] = b.transactions[i].get_signature_keys( chain_id, canon_type );
+                  }
+                  catch( ... ) {}
+               }
+            });
+            tasks.push_back( task->get_future() );
+            my->ios.post( [task](){ (*task)(); } );
+         }
+      }
+
+      for( auto& t : tasks )
+         t.wait();
+
+      return result;
+   }
+
+} } // sophiatx::chain
@@ -40,7 +40,7 @@ void witness_update_evaluator::do_apply( const witness_update_operation& o )
             if(o.block_signing_key == public_key_type())
                w.stopped = true;
             w.props = o.props;
-            w.props.account_creation_fee = asset (0, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"));
+            w.props.account_creation_fee = asset (0, chain::sophiatx_config::params().symbol);
             w.props.price_feeds.clear();
       });
       return;
@@ -52,7 +52,7 @@ void witness_update_evaluator::do_apply( const witness_update_operation& o )
 
    if( _db->is_producing() )
    {
-      FC_ASSERT( o.props.maximum_block_size <= chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_BLOCK_SIZE") );
+      FC_ASSERT( o.props.maximum_block_size <= chain::sophiatx_config::params().max_block_size );
    }
 
    const auto& by_witness_name_idx = _db->get_index< witness_index >().indices().get< by_name >();
@@ -72,7 +72,7 @@ void witness_update_evaluator::do_apply( const witness_update_operation& o )
             for(auto r:o.props.price_feeds){
                price new_rate;
                //ensure that base is always in SPHTX
-               if(r.second.base.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"))
+               if(r.second.base.symbol == chain::sophiatx_config::params().symbol)
                   new_rate = r.second;
                else {
                   new_rate.base = r.second.quote;
@@ -118,7 +118,7 @@ void admin_witness_update_evaluator::do_apply( const admin_witness_update_operat
            if(o.block_signing_key == public_key_type())
               w.stopped = true;
            w.props = o.props;
-           w.props.account_creation_fee = asset (0, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"));
+           w.props.account_creation_fee = asset (0, chain::sophiatx_config::params().symbol);
            w.props.price_feeds.clear();
       });
    }
@@ -161,7 +161,7 @@ void witness_set_properties_evaluator::do_apply( const witness_set_properties_op
    if( itr != o.props.end() )
    {
       fc::raw::unpack_from_vector( itr->second, props.maximum_block_size, 0 );
-      FC_ASSERT(props.maximum_block_size <= chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_BLOCK_SIZE"));
+      FC_ASSERT(props.maximum_block_size <= chain::sophiatx_config::params().max_block_size);
       max_block_changed = true;
    }
 
@@ -180,7 +180,7 @@ void witness_set_properties_evaluator::do_apply( const witness_set_properties_op
       for(const auto & rate: exchange_rates){
          price new_rate;
          //ensure that base is always in SPHTX
-         if(rate.base.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"))
+         if(rate.base.symbol == chain::sophiatx_config::params().symbol)
             new_rate = rate;
          else {
             new_rate.base = rate.quote;
@@ -248,7 +248,7 @@ void account_create_evaluator::do_apply( const account_create_operation& o )
    const auto& props = _db->get_dynamic_global_properties();
 
    asset to_pay;
-   if(o.fee.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL")) {
+   if(o.fee.symbol == chain::sophiatx_config::params().symbol) {
       to_pay = o.fee;
    } else {
       to_pay = _db->to_sophiatx(o.fee);
@@ -260,7 +260,7 @@ void account_create_evaluator::do_apply( const account_create_operation& o )
    FC_ASSERT( creator.balance >= to_pay, "Insufficient balance to create account.", ( "creator.balance", creator.balance )( "required", to_pay ) );
 
    const witness_schedule_object& wso = _db->get_witness_schedule_object();
-   asset required_fee = _db->is_private_net() ? asset(0, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL")) : asset( wso.median_props.account_creation_fee.amount, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") );
+   asset required_fee = _db->is_private_net() ? asset(0, chain::sophiatx_config::params().symbol) : asset( wso.median_props.account_creation_fee.amount, chain::sophiatx_config::params().symbol );
    FC_ASSERT( to_pay >= required_fee, "Insufficient Fee: ${f} required, ${p} provided.",
               ("f", required_fee ) ("p", to_pay) );
 
@@ -395,7 +395,7 @@ void escrow_transfer_evaluator::do_apply( const escrow_transfer_operation& o )
       FC_ASSERT( o.escrow_expiration > _db->head_block_time(), "The escrow expiration must be after head block time." );
 
       asset sophiatx_spent = o.sophiatx_amount;
-      if( o.escrow_fee.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") )
+      if( o.escrow_fee.symbol == chain::sophiatx_config::params().symbol )
          sophiatx_spent += o.escrow_fee;
 
 
@@ -565,7 +565,7 @@ void transfer_to_vesting_evaluator::do_apply( const transfer_to_vesting_operatio
    const auto& from_account = _db->get_account(o.from);
    const auto& to_account = o.to.size() ? _db->get_account(o.to) : from_account;
 
-   FC_ASSERT( _db->get_balance( from_account, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL")) >= o.amount, "Account does not have sufficient SOPHIATX for transfer." );
+   FC_ASSERT( _db->get_balance( from_account, chain::sophiatx_config::params().symbol) >= o.amount, "Account does not have sufficient SOPHIATX for transfer." );
 
    if( from_account.id == to_account.id )
       _db->vest( from_account, o.amount.amount );
@@ -683,7 +683,7 @@ void account_witness_vote_evaluator::do_apply( const account_witness_vote_operat
    if( itr == by_account_witness_idx.end() ) {
       FC_ASSERT( o.approve, "Vote doesn't exist, user must indicate a desire to approve witness." );
 
-      FC_ASSERT( voter.witnesses_voted_for < chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_ACCOUNT_WITNESS_VOTES"), "Account has voted for too many witnesses." ); // TODO: Remove after hardfork 2
+      FC_ASSERT( voter.witnesses_voted_for < chain::sophiatx_config::params().max_account_witness_votes, "Account has voted for too many witnesses." ); // TODO: Remove after hardfork 2
 
       _db->create<witness_vote_object>( [&]( witness_vote_object& v ) {
            v.witness = witness.owner;
@@ -710,44 +710,64 @@ void account_witness_vote_evaluator::do_apply( const account_witness_vote_operat
 
 void custom_evaluator::do_apply( const custom_operation& o ){}
 
-void custom_json_evaluator::do_apply( const custom_json_operation& o )
+/**
+ * Stores the document of a custom operation once and adds it to the received documents of each recipient. Documents
+ * without recipients are not stored.
+ */
+template< typename Operation, typename PayloadSetter >
+void store_custom_content( database_interface& d, const Operation& o, PayloadSetter&& set_payload )
 {
-   auto& d = db();
+   if( o.recipients.empty() )
+      return;
 
-    //TODO: move this to plugin
-    const auto& send_idx = d->get_index< custom_content_index >().indices().get< by_sender >();
-    auto send_itr = send_idx.lower_bound( boost::make_tuple( o.sender, o.app_id, uint64_t(-1) ) );
-    uint64_t sender_sequence = 1;
-    if( send_itr != send_idx.end() && send_itr->sender == o.sender && send_itr->app_id == o.app_id )
+   const auto& send_idx = d.get_index< custom_content_index >().indices().get< by_sender >();
+   auto send_itr = send_idx.lower_bound( boost::make_tuple( o.sender, o.app_id, uint64_t(-1) ) );
+   uint64_t sender_sequence = 1;
+   if( send_itr != send_idx.end() && send_itr->sender == o.sender && send_itr->app_id == o.app_id )
       sender_sequence = send_itr->sender_sequence + 1;
 
-    const auto& app_msg_idx = d->get_index< custom_content_index >().indices().get< by_app_id >();
-    auto app_msg_itr = app_msg_idx.lower_bound( boost::make_tuple( o.app_id, uint64_t(-1) ) );
-    uint64_t app_message_sequence = 1;
-    if( app_msg_itr != app_msg_idx.end() && app_msg_itr->app_id == o.app_id )
-       app_message_sequence = app_msg_itr->app_message_sequence + 1;
+   const auto& app_msg_idx = d.get_index< custom_content_index >().indices().get< by_app_id >();
+   auto app_msg_itr = app_msg_idx.lower_bound( boost::make_tuple( o.app_id, uint64_t(-1) ) );
+   uint64_t app_message_sequence = 1;
+   if( app_msg_itr != app_msg_idx.end() && app_msg_itr->app_id == o.app_id )
+      app_message_sequence = app_msg_itr->app_message_sequence + 1;
+
+   const auto& content = d.create<custom_content_object>([ & ](custom_content_object &c) {
+        set_payload( c );
+        c.app_id = o.app_id;
+        c.sender = o.sender;
+        c.all_recipients.insert( c.all_recipients.end(), o.recipients.begin(), o.recipients.end() );
+        c.sender_sequence = sender_sequence;
+        c.app_message_sequence = app_message_sequence;
+        c.received = d.head_block_time();
+   });
 
-    for(const auto&r: o.recipients) {
+   const auto& recv_idx = d.get_index< custom_content_recipient_index >().indices().get< by_recipient >();
+   for(const auto&r: o.recipients) {
       uint64_t receiver_sequence = 1;
-      const auto& recv_idx = d->get_index< custom_content_index >().indices().get< by_recipient >();
       auto recv_itr = recv_idx.lower_bound( boost::make_tuple( r, o.app_id, uint64_t(-1) ) );
       if( recv_itr != recv_idx.end() && recv_itr->recipient == r && recv_itr->app_id == o.app_id )
          receiver_sequence = recv_itr->recipient_sequence + 1;
 
-      d->create<custom_content_object>([ & ](custom_content_object &c) {
-           c.binary = false;
-           from_string( c.json, o.json );
+      d.create<custom_content_recipient_object>([ & ](custom_content_recipient_object &c) {
            c.app_id = o.app_id;
-           c.sender = o.sender;
            c.recipient = r;
-           for( auto o_r: o.recipients)
-              c.all_recipients.push_back(o_r);
-           c.sender_sequence = sender_sequence;
            c.recipient_sequence = receiver_sequence;
-           c.app_message_sequence = app_message_sequence;
-           c.received = d->head_block_time();
+           c.received = content.received;
+           c.content = content.id;
       });
    }
+}
+
+void custom_json_evaluator::do_apply( const custom_json_operation& o )
+{
+   auto& d = db();
+
+   //TODO: move this to plugin
+   store_custom_content( *d, o, [&]( custom_content_object& c ) {
+      c.binary = false;
+      from_string( c.json, o.json );
+   });
 
    std::shared_ptr< custom_operation_interpreter > eval = d->get_custom_json_evaluator( o.app_id );
    if( !eval )
@@ -773,40 +793,10 @@ void custom_binary_evaluator::do_apply( const custom_binary_operation& o )
    auto& d = db();
 
    //TODO: move this to plugin
-   const auto& send_idx = d->get_index< custom_content_index >().indices().get< by_sender >();
-   auto send_itr = send_idx.lower_bound( boost::make_tuple( o.sender, o.app_id, uint64_t(-1) ) );
-   uint64_t sender_sequence = 1;
-   if( send_itr != send_idx.end() && send_itr->sender == o.sender && send_itr->app_id == o.app_id )
-      sender_sequence = send_itr->sender_sequence + 1;
-
-   const auto& app_msg_idx = d->get_index< custom_content_index >().indices().get< by_app_id >();
-   auto app_msg_itr = app_msg_idx.lower_bound( boost::make_tuple( o.app_id, uint64_t(-1) ) );
-   uint64_t app_message_sequence = 1;
-   if( app_msg_itr != app_msg_idx.end() && app_msg_itr->app_id == o.app_id )
-      app_message_sequence = app_msg_itr->app_message_sequence + 1;
-
-   for(const auto&r: o.recipients) {
-      uint64_t receiver_sequence = 1;
-      const auto& recv_idx = d->get_index< custom_content_index >().indices().get< by_recipient >();
-      auto recv_itr = recv_idx.lower_bound( boost::make_tuple( r, o.app_id, uint64_t(-1) ) );
-      if( recv_itr != recv_idx.end() && recv_itr->recipient == r && recv_itr->app_id == o.app_id )
-         receiver_sequence = recv_itr->recipient_sequence + 1;
-
-      d->create<custom_content_object>([ & ](custom_content_object &c) {
-           c.binary = true;
-           for( auto d: o.data)
-              c.data.push_back(d);
-           c.app_id = o.app_id;
-           c.sender = o.sender;
-           c.recipient = r;
-           for( auto o_r: o.recipients)
-              c.all_recipients.push_back(o_r);
-           c.sender_sequence = sender_sequence;
-           c.recipient_sequence = receiver_sequence;
-           c.app_message_sequence = app_message_sequence;
-           c.received = d->head_block_time();
-      });
-   }
+   store_custom_content( *d, o, [&]( custom_content_object& c ) {
+      c.binary = true;
+      c.data.insert( c.data.end(), o.data.begin(), o.data.end() );
+   });
 
    std::shared_ptr< custom_operation_interpreter > eval = d->get_custom_json_evaluator( o.app_id );
    if( !eval )
@@ -833,7 +823,7 @@ void feed_publish_evaluator::do_apply( const feed_publish_operation& o )
    FC_ASSERT(!_db->is_private_net(), "This operation is not available in private nets");
    price new_rate;
    //ensure that base is always in SPHTX
-   if(o.exchange_rate.base.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"))
+   if(o.exchange_rate.base.symbol == chain::sophiatx_config::params().symbol)
       new_rate = o.exchange_rate;
    else {
       new_rate.base = o.exchange_rate.quote;
@@ -1091,16 +1081,16 @@ void transfer_from_promotion_pool_evaluator::do_apply( const transfer_from_promo
    const auto& acnt = _db->get_account( op.transfer_to );
    share_type withdrawn;
 
-   FC_ASSERT(op.amount.amount >0 && op.amount.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"));
+   FC_ASSERT(op.amount.amount >0 && op.amount.symbol == chain::sophiatx_config::params().symbol);
    _db->modify( econ, [&](economic_model_object& eo){
         withdrawn = eo.withdraw_from_promotion_pool(op.amount.amount, _db->head_block_num());
    });
-   _db->adjust_balance(acnt, asset(withdrawn, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL")));
-   _db->adjust_supply(asset(withdrawn, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL")));
+   _db->adjust_balance(acnt, asset(withdrawn, chain::sophiatx_config::params().symbol));
+   _db->adjust_supply(asset(withdrawn, chain::sophiatx_config::params().symbol));
 
    promotion_pool_withdraw_operation wop;
    wop.to_account = op.transfer_to;
-   wop.withdrawn =  asset(withdrawn, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"));
+   wop.withdrawn =  asset(withdrawn, chain::sophiatx_config::params().symbol);
    _db->push_virtual_operation(wop);
 }
 
@@ -0,0 +1,150 @@
+#include <sophiatx/chain/state_snapshot.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <map>
+
+namespace sophiatx { namespace chain {
+
+snapshot_writer::snapshot_writer( const fc::path& file )
+{
+   if( file != fc::path() )
+   {
+      _out.open( file.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+      FC_ASSERT( _out.good(), "Unable to open snapshot file for writing", ("file", file) );
+      _out.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+   }
+}
+
+void snapshot_writer::write_record()
+{
+   _digest.write( _buffer.data(), _buffer.size() );
+
+   if( _out.is_open() )
+   {
+      uint32_t size = _buffer.size();
+      _out.write( (const char*)&size, sizeof( size ) );
+      _out.write( _buffer.data(), _buffer.size() );
+   }
+}
+
+fc::sha256 snapshot_writer::finish()
+{
+   auto digest = _digest.result();
+
+   if( _out.is_open() )
+   {
+      _out.write( digest.data(), digest.data_size() );
+      _out.close();
+   }
+
+   return digest;
+}
+
+snapshot_reader::snapshot_reader( const fc::path& file )
+{
+   FC_ASSERT( fc::exists( file ), "Snapshot file does not exist", ("file", file) );
+   _file_size = fc::file_size( file );
+   _in.open( file.generic_string().c_str(), std::ios::in | std::ios::binary );
+   FC_ASSERT( _in.good(), "Unable to open snapshot file for reading", ("file", file) );
+   _in.exceptions( std::ifstream::failbit | std::ifstream::badbit );
+}
+
+void snapshot_reader::read_record()
+{
+   uint32_t size = 0;
+   _in.read( (char*)&size, sizeof( size ) );
+   FC_ASSERT( uint64_t( _in.tellg() ) + size <= _file_size, "Snapshot record exceeds the end of the file, the file is corrupted" );
+   _buffer.resize( size );
+   _in.read( _buffer.data(), size );
+   _digest.write( _buffer.data(), _buffer.size() );
+}
+
+fc::sha256 snapshot_reader::finish()
+{
+   fc::sha256 stored;
+   _in.read( stored.data(), stored.data_size() );
+
+   auto digest = _digest.result();
+   FC_ASSERT( digest == stored, "Snapshot digest does not match its content, the file is corrupted",
+      ("stored", stored)("computed", digest) );
+   return digest;
+}
+
+fc::sha256 export_snapshot( const chainbase::database& db, snapshot_header header, const fc::path& file )
+{
+   std::vector< std::shared_ptr< abstract_snapshot_index > > indices;
+   db.for_each_index_extension< abstract_snapshot_index >( [&]( std::shared_ptr< abstract_snapshot_index > idx )
+   {
+      indices.push_back( idx );
+   });
+
+   // Registration order depends on the enabled plugins, the digest should not
+   std::sort( indices.begin(), indices.end(), []( const std::shared_ptr< abstract_snapshot_index >& a, const std::shared_ptr< abstract_snapshot_index >& b )
+   {
+      return a->name() < b->name();
+   });
+
+   snapshot_writer w( file );
+   header.index_count = indices.size();
+   w.write( header );
+
+   for( const auto& idx : indices )
+      idx->write( w );
+
+   return w.finish();
+}
+
+snapshot_header import_snapshot( chainbase::database& db, const fc::path& file, const chain_id_type& chain_id )
+{
+   std::map< std::string, std::shared_ptr< abstract_snapshot_index > > indices;
+   db.for_each_index_extension< abstract_snapshot_index >( [&]( std::shared_ptr< abstract_snapshot_index > idx )
+   {
+      indices[ idx->name() ] = idx;
+   });
+
+   snapshot_reader r( file );
+   bool skipped = false;
+
+   snapshot_header header;
+   r.read( header );
+   FC_ASSERT( header.magic == snapshot_header().magic, "File is not a state snapshot", ("file", file) );
+   FC_ASSERT( header.version == snapshot_header::current_version, "Unsupported snapshot version",
+      ("version", header.version)("supported", snapshot_header::current_version) );
+   FC_ASSERT( header.chain_id == chain_id, "Snapshot belongs to a different chain",
+      ("snapshot", header.chain_id)("chain", chain_id) );
+
+   for( uint32_t i = 0; i < header.index_count; ++i )
+   {
+      snapshot_index_header index_header;
+      r.read( index_header );
+
+      auto itr = indices.find( index_header.name );
+      if( itr == indices.end() )
+      {
+         wlog( "Skipping ${n} objects of ${i}, the index is not registered", ("n", index_header.object_count)("i", index_header.name) );
+
+         for( uint64_t o = 0; o < index_header.object_count; ++o )
+            r.skip();
+         skipped = true;
+         continue;
+      }
+
+      itr->second->read( r, index_header );
+      indices.erase( itr );
+   }
+
+   for( const auto& idx : indices )
+      FC_ASSERT( false, "Snapshot does not contain the state of ${i}, it was exported without the plugin owning it",
+         ("i", idx.first) );
+
+   auto digest = r.finish();
+
+   if( !skipped )
+      FC_ASSERT( export_snapshot( db, header ) == digest, "State digest after import does not match the snapshot" );
+
+   return header;
+}
+
+} } // sophiatx::chain
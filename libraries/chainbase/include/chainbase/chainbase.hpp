@@ -185,6 +185,57 @@ namespace chainbase {
          int64_t                      revision = 0;
    };
 
+   /**
+    *  Flat alternative to undo_state used when an index runs with flat undo enabled.
+    *
+    *  All sessions of an index share one append-only log of (operation, id) entries, old values of modified
+    *  and removed objects are appended to a parallel log of values. A session only records the log positions
+    *  it started at, so squash drops the session marker without touching the logs, undo replays the log
+    *  backwards down to the marker and commit trims the front of the logs. Both logs are deques in the segment,
+    *  so appending allocates a new block only once per block of entries instead of a tree node per object.
+    *
+    *  The only deduplication is skipping an entry when the previous entry of the session is for the same object,
+    *  repeated modifications of an object interleaved with others are logged repeatedly. Replaying them backwards
+    *  still restores the oldest value.
+    */
+   template< typename value_type >
+   class undo_log
+   {
+      public:
+         typedef typename value_type::id_type id_type;
+
+         enum operation_type : uint8_t
+         {
+            create_op,
+            modify_op,
+            remove_op
+         };
+
+         struct entry
+         {
+            id_type     id;
+            uint8_t     op = create_op;
+         };
+
+         struct marker
+         {
+            int64_t     revision = 0;
+            size_t      entry_pos = 0;
+            size_t      value_pos = 0;
+            id_type     old_next_id = 0;
+         };
+
+         template<typename T>
+         undo_log( allocator<T> al )
+         :entries( allocator< entry >( al.get_segment_manager() ) ),
+          values( allocator< value_type >( al.get_segment_manager() ) ),
+          markers( allocator< marker >( al.get_segment_manager() ) ){}
+
+         boost::interprocess::deque< entry, allocator< entry > >               entries;
+         boost::interprocess::deque< value_type, allocator< value_type > >     values;
+         boost::interprocess::deque< marker, allocator< marker > >             markers;
+   };
+
    /**
     * The code we want to implement is this:
     *
@@ -229,7 +280,7 @@ namespace chainbase {
          typedef undo_state< value_type >                              undo_state_type;
 
          generic_index( allocator<value_type> a )
-         :_stack(a),_indices( a ),_size_of_value_type( sizeof(typename MultiIndexType::node_type) ),_size_of_this(sizeof(*this)){}
+         :_stack(a),_undo_log(a),_indices( a ),_size_of_value_type( sizeof(typename MultiIndexType::node_type) ),_size_of_this(sizeof(*this)){}
 
          void validate()const {
             if( sizeof(typename MultiIndexType::node_type) != _size_of_value_type || sizeof(*this) != _size_of_this )
@@ -260,6 +311,34 @@ namespace chainbase {
             return *insert_result.first;
          }
 
+         /**
+          * Construct an element keeping the ID set by the constructor, used to rebuild an index from
+          * a copy of its objects. Objects are expected in ID order, so each one is inserted at the end
+          * of the primary index. Objects inserted this way are not part of the undo state.
+          */
+         template<typename Constructor>
+         const value_type& import( Constructor&& c ) {
+            if( enabled() ) BOOST_THROW_EXCEPTION( std::logic_error("cannot import objects while there is an existing undo stack") );
+
+            auto size = _indices.size();
+            auto itr = _indices.emplace_hint( _indices.end(), c, _indices.get_allocator() );
+            if( _indices.size() == size ) {
+               BOOST_THROW_EXCEPTION( std::logic_error("could not import object, most likely a uniqueness constraint was violated") );
+            }
+
+            if( !( itr->id < _next_id ) )
+               _next_id = itr->id._id + 1;
+            return *itr;
+         }
+
+         typename value_type::id_type next_id()const { return _next_id; }
+
+         void set_next_id( typename value_type::id_type id )
+         {
+            if( enabled() ) BOOST_THROW_EXCEPTION( std::logic_error("cannot set next id while there is an existing undo stack") );
+            _next_id = id;
+         }
+
          template<typename Modifier>
          void modify( const value_type& obj, Modifier&& m ) {
             on_modify( obj );
@@ -331,6 +410,16 @@ namespace chainbase {
 
          session start_undo_session()
          {
+            if( _flat_undo ) {
+               typename undo_log< value_type >::marker m;
+               m.revision = ++_revision;
+               m.entry_pos = _undo_log.entries.size();
+               m.value_pos = _undo_log.values.size();
+               m.old_next_id = _next_id;
+               _undo_log.markers.push_back( m );
+               return session( *this, _revision );
+            }
+
             _stack.emplace_back( _indices.get_allocator() );
             _stack.back().old_next_id = _next_id;
             _stack.back().revision = ++_revision;
@@ -347,6 +436,7 @@ namespace chainbase {
           */
          void undo() {
             if( !enabled() ) return;
+            if( _flat_undo ) return undo_flat();
 
             const auto& head = _stack.back();
 
@@ -381,6 +471,7 @@ namespace chainbase {
          void squash()
          {
             if( !enabled() ) return;
+            if( _flat_undo ) return squash_flat();
             if( _stack.size() == 1 ) {
                _stack.pop_front();
                return;
@@ -485,6 +576,7 @@ namespace chainbase {
           */
          void commit( int64_t revision )
          {
+            if( _flat_undo ) return commit_flat( revision );
             while( _stack.size() && _stack[0].revision <= revision )
             {
                _stack.pop_front();
@@ -502,15 +594,118 @@ namespace chainbase {
 
          void set_revision( int64_t revision )
          {
-            if( _stack.size() != 0 ) BOOST_THROW_EXCEPTION( std::logic_error("cannot set revision while there is an existing undo stack") );
+            if( enabled() ) BOOST_THROW_EXCEPTION( std::logic_error("cannot set revision while there is an existing undo stack") );
             _revision = revision;
          }
 
+         /**
+          * Switches between undo_state trees and the flat undo_log. The mode is stored with the index,
+          * it can only be changed while there are no undo sessions.
+          */
+         void set_flat_undo( bool enable )
+         {
+            if( enable == _flat_undo ) return;
+            if( enabled() ) BOOST_THROW_EXCEPTION( std::logic_error("cannot change undo mode while there is an existing undo stack") );
+            _flat_undo = enable;
+         }
+
+         bool flat_undo()const { return _flat_undo; }
+
       private:
-         bool enabled()const { return _stack.size(); }
+         bool enabled()const { return _flat_undo ? _undo_log.markers.size() : _stack.size(); }
+
+         void log_undo( uint8_t op, const value_type& v ) {
+            auto& log = _undo_log;
+
+            // Only the first of consecutive changes of an object is needed to restore it
+            if( op == undo_log< value_type >::modify_op && log.entries.size() > log.markers.back().entry_pos
+                && log.entries.back().id == v.id )
+               return;
+
+            if( op != undo_log< value_type >::create_op )
+               log.values.push_back( v );
+
+            typename undo_log< value_type >::entry e;
+            e.id = v.id;
+            e.op = op;
+            log.entries.push_back( e );
+         }
+
+         void undo_flat() {
+            auto& log = _undo_log;
+            const auto& head = log.markers.back();
+
+            while( log.entries.size() > head.entry_pos ) {
+               const auto& e = log.entries.back();
+
+               switch( e.op ) {
+                  case undo_log< value_type >::create_op:
+                     _indices.erase( _indices.find( e.id ) );
+                     break;
+                  case undo_log< value_type >::modify_op:
+                  {
+                     auto ok = _indices.modify( _indices.find( e.id ), [&]( value_type& v ) {
+                        v = std::move( log.values.back() );
+                     });
+                     if( !ok ) BOOST_THROW_EXCEPTION( std::logic_error( "Could not modify object, most likely a uniqueness constraint was violated" ) );
+                     log.values.pop_back();
+                     break;
+                  }
+                  case undo_log< value_type >::remove_op:
+                  {
+                     bool ok = _indices.emplace( std::move( log.values.back() ) ).second;
+                     if( !ok ) BOOST_THROW_EXCEPTION( std::logic_error( "Could not restore object, most likely a uniqueness constraint was violated" ) );
+                     log.values.pop_back();
+                     break;
+                  }
+               }
+
+               log.entries.pop_back();
+            }
+
+            _next_id = head.old_next_id;
+            log.markers.pop_back();
+            --_revision;
+         }
+
+         void squash_flat() {
+            auto& log = _undo_log;
+            if( log.markers.size() == 1 ) {
+               log.markers.clear();
+               log.entries.clear();
+               log.values.clear();
+               return;
+            }
+
+            // Both sessions are already contiguous in the log, merging them only drops the newer marker
+            log.markers.pop_back();
+            --_revision;
+         }
+
+         void commit_flat( int64_t revision ) {
+            auto& log = _undo_log;
+            while( log.markers.size() && log.markers.front().revision <= revision )
+               log.markers.pop_front();
+
+            if( log.markers.empty() ) {
+               log.entries.clear();
+               log.values.clear();
+               return;
+            }
+
+            size_t entry_pos = log.markers.front().entry_pos;
+            size_t value_pos = log.markers.front().value_pos;
+            log.entries.erase( log.entries.begin(), log.entries.begin() + entry_pos );
+            log.values.erase( log.values.begin(), log.values.begin() + value_pos );
+            for( auto& m : log.markers ) {
+               m.entry_pos -= entry_pos;
+               m.value_pos -= value_pos;
+            }
+         }
 
          void on_modify( const value_type& v ) {
             if( !enabled() ) return;
+            if( _flat_undo ) return log_undo( undo_log< value_type >::modify_op, v );
 
             auto& head = _stack.back();
 
@@ -526,6 +721,7 @@ namespace chainbase {
 
          void on_remove( const value_type& v ) {
             if( !enabled() ) return;
+            if( _flat_undo ) return log_undo( undo_log< value_type >::remove_op, v );
 
             auto& head = _stack.back();
             if( head.new_ids.count(v.id) ) {
@@ -548,12 +744,14 @@ namespace chainbase {
 
          void on_create( const value_type& v ) {
             if( !enabled() ) return;
+            if( _flat_undo ) return log_undo( undo_log< value_type >::create_op, v );
             auto& head = _stack.back();
 
             head.new_ids.insert( v.id );
          }
 
          boost::interprocess::deque< undo_state_type, allocator<undo_state_type> > _stack;
+         undo_log< value_type >                                                    _undo_log;
 
          /**
           *  Each new session increments the revision, a squash will decrement the revision by combining
@@ -566,6 +764,7 @@ namespace chainbase {
          index_type                      _indices;
          uint32_t                        _size_of_value_type = 0;
          uint32_t                        _size_of_this = 0;
+         bool                            _flat_undo = false;
    };
 
    class abstract_session {
@@ -615,6 +814,8 @@ namespace chainbase {
          virtual void    squash()const = 0;
          virtual void    commit( int64_t revision )const = 0;
          virtual void    undo_all()const = 0;
+         virtual void    set_flat_undo( bool enable )const = 0;
+         virtual bool    flat_undo()const = 0;
          virtual uint32_t type_id()const  = 0;
 
          virtual statistic_info get_statistics(bool onlyStaticInfo) const = 0;
@@ -645,6 +846,8 @@ namespace chainbase {
          virtual void     squash()const  override { _base.squash(); }
          virtual void     commit( int64_t revision )const  override { _base.commit(revision); }
          virtual void     undo_all() const override {_base.undo_all(); }
+         virtual void     set_flat_undo( bool enable )const override { _base.set_flat_undo( enable ); }
+         virtual bool     flat_undo()const override { return _base.flat_undo(); }
          virtual uint32_t type_id()const override { return BaseIndex::value_type::type_id; }
 
          virtual statistic_info get_statistics(bool onlyStaticInfo) const override final
@@ -698,6 +901,41 @@ namespace chainbase {
          std::atomic< uint32_t >                                    _current_lock;
    };
 
+   /**
+    * Published in the segment by the process which opened the database read write, so processes which opened it
+    * read only can tell whether a read overlapped a write and whether the file grew. The writer never waits for them.
+    */
+   struct shared_state
+   {
+      /// Incremented when a write lock is taken and again when it is released, odd while a write is in progress
+      std::atomic< uint64_t > write_epoch;
+      std::atomic< uint64_t > file_size;
+   };
+
+   namespace detail
+   {
+      /// Runs a read callback and keeps its result until the read was validated
+      template< typename R >
+      struct read_attempt
+      {
+         template< typename Lambda >
+         read_attempt( Lambda& callback ) : result( callback() ) {}
+
+         R get() { return std::forward< R >( result ); }
+
+         R result;
+      };
+
+      template<>
+      struct read_attempt< void >
+      {
+         template< typename Lambda >
+         read_attempt( Lambda& callback ) { callback(); }
+
+         void get() {}
+      };
+   }
+
    struct lock_exception : public std::exception
    {
       explicit lock_exception() {}
@@ -731,7 +969,19 @@ namespace chainbase {
          };
 
       public:
-         void open( const bfs::path& dir, uint32_t flags = 0, size_t shared_file_size = 0 );
+         enum open_flags
+         {
+            read_write  = 0,
+            /**
+             * Maps the file read only and without the file lock, so a process can serve reads of a database another
+             * process has opened read write. with_read_lock retries reads which overlapped a write of the other
+             * process and remaps the file when the other process grows it. Nothing may be written, and the indices
+             * have to be created by the other process first.
+             */
+            read_only   = 1
+         };
+
+         void open( const bfs::path& dir, uint32_t flags = read_write, size_t shared_file_size = 0 );
          void close();
          void flush();
          void wipe( const bfs::path& dir );
@@ -820,12 +1070,24 @@ namespace chainbase {
              for( const auto& i : _index_list ) i->set_revision( revision );
          }
 
+         /**
+          * Selects the undo representation of all indices added so far, see undo_log. Use get_mutable_index< T >().set_flat_undo()
+          * to select it per index. Fails when an index has undo sessions.
+          */
+         void set_flat_undo( bool enable )
+         {
+             CHAINBASE_REQUIRE_WRITE_LOCK( "set_flat_undo", bool );
+             for( const auto& i : _index_list ) i->set_flat_undo( enable );
+         }
+
 
          template<typename MultiIndexType>
          void add_index()
          {
-            _index_types.push_back( unique_ptr< abstract_index_type >( new index_type_impl< MultiIndexType >() ) );
-            _index_types.back()->add_index( *this );
+            // Only indices which were added are added again by resize and remap
+            unique_ptr< abstract_index_type > type( new index_type_impl< MultiIndexType >() );
+            type->add_index( *this );
+            _index_types.push_back( std::move( type ) );
          }
 
          auto get_segment_manager() -> decltype( ((bip::managed_mapped_file*)nullptr)->get_segment_manager()) {
@@ -842,6 +1104,11 @@ namespace chainbase {
             return _file_size;
          }
 
+         bool is_read_only()const { return _read_only; }
+
+         /// Number of reads of a read only database which overlapped a write of the other process and were retried
+         uint64_t get_retried_reads()const { return _retried_reads; }
+
          template<typename MultiIndexType>
          bool has_index()const
          {
@@ -987,6 +1254,9 @@ namespace chainbase {
          template< typename Lambda >
          auto with_read_lock( Lambda&& callback, uint64_t wait_micro = 1000000 ) -> decltype( (*(Lambda*)nullptr)() )
          {
+            if( _read_only )
+               return with_read_only_lock( callback, wait_micro );
+
             read_lock lock( _rw_manager.current_lock(), bip::defer_lock_type() );
 #ifdef CHAINBASE_CHECK_LOCKING
             BOOST_ATTRIBUTE_UNUSED
@@ -1009,6 +1279,9 @@ namespace chainbase {
          template< typename Lambda >
          auto with_write_lock( Lambda&& callback, uint64_t wait_micro = 1000000 ) -> decltype( (*(Lambda*)nullptr)() )
          {
+            if( _read_only )
+               BOOST_THROW_EXCEPTION( std::logic_error( "cannot write to a read only database" ) );
+
             write_lock lock( _rw_manager.current_lock(), boost::defer_lock_t() );
 #ifdef CHAINBASE_CHECK_LOCKING
             BOOST_ATTRIBUTE_UNUSED
@@ -1029,6 +1302,7 @@ namespace chainbase {
                }
             }
 
+            write_epoch_guard guard( *this );
             return callback();
          }
 
@@ -1053,6 +1327,90 @@ namespace chainbase {
             { return _index_list; }
 
       private:
+         /// The state is looked up on release because a resize under the write lock maps the segment again
+         struct write_epoch_guard
+         {
+            write_epoch_guard( database& db ) : _db( db )
+            {
+               if( _db._shared_state )
+                  _db._shared_state->write_epoch.fetch_add( 1 );
+            }
+
+            ~write_epoch_guard()
+            {
+               if( _db._shared_state )
+                  _db._shared_state->write_epoch.fetch_add( 1 );
+            }
+
+            database& _db;
+         };
+
+         /**
+          * Read lock of a read only database. The read is retried when a write of the other process started before it
+          * finished, it fails once wait_micro passed without a read that did not overlap a write. Nested reads are
+          * validated by the outermost one.
+          */
+         template< typename Lambda >
+         auto with_read_only_lock( Lambda& callback, uint64_t wait_micro ) -> decltype( callback() )
+         {
+            if( _read_only_depth > 0 )
+               return callback();
+
+            int_incrementer depth( _read_only_depth );
+            auto deadline = boost::chrono::steady_clock::now() + boost::chrono::microseconds( wait_micro );
+
+            while( true )
+            {
+               if( _shared_state->file_size.load() > _file_size )
+                  remap();
+
+               read_lock lock( _rw_manager.current_lock() );
+#ifdef CHAINBASE_CHECK_LOCKING
+               BOOST_ATTRIBUTE_UNUSED
+               int_incrementer ii( _read_lock_count );
+#endif
+
+               uint64_t epoch = _shared_state->write_epoch.load();
+               while( epoch & 1 )
+               {
+                  if( wait_micro && boost::chrono::steady_clock::now() > deadline )
+                     BOOST_THROW_EXCEPTION( lock_exception() );
+
+                  boost::this_thread::sleep_for( boost::chrono::microseconds( 100 ) );
+                  epoch = _shared_state->write_epoch.load();
+               }
+
+               // The other process may have grown the file before the epoch was read
+               if( _shared_state->file_size.load() > _file_size )
+                  continue;
+
+               try
+               {
+                  detail::read_attempt< decltype( callback() ) > attempt( callback );
+                  std::atomic_thread_fence( std::memory_order_acquire );
+                  if( _shared_state->write_epoch.load() == epoch )
+                     return attempt.get();
+               }
+               catch( ... )
+               {
+                  // An error of a read which overlapped a write may be caused by the write
+                  std::atomic_thread_fence( std::memory_order_acquire );
+                  if( _shared_state->write_epoch.load() == epoch )
+                     throw;
+               }
+
+               ++_retried_reads;
+               if( wait_micro && boost::chrono::steady_clock::now() > deadline )
+                  BOOST_THROW_EXCEPTION( lock_exception() );
+            }
+         }
+
+         /// Maps the segment read only and finds the state published by the other process
+         void map_read_only( const bfs::path& abs_path );
+
+         /// Maps the grown file of a read only database again
+         void remap();
+
          template<typename MultiIndexType>
          void add_index_helper() {
              const uint16_t type_id = generic_index<MultiIndexType>::value_type::type_id;
@@ -1066,7 +1424,17 @@ namespace chainbase {
              }
 
              index_type* idx_ptr =  nullptr;
-             idx_ptr = _segment->find_or_construct< index_type >( type_name.c_str() )( index_alloc( _segment->get_segment_manager() ) );
+             if( _read_only )
+             {
+                // find locks the segment mutex, which is not writable in a read only mapping
+                idx_ptr = _segment->find_no_lock< index_type >( type_name.c_str() ).first;
+                if( !idx_ptr )
+                   BOOST_THROW_EXCEPTION( std::runtime_error( "unable to find index for " + type_name + " in read only database" ) );
+             }
+             else
+             {
+                idx_ptr = _segment->find_or_construct< index_type >( type_name.c_str() )( index_alloc( _segment->get_segment_manager() ) );
+             }
              idx_ptr->validate();
 
              if( type_id >= _index_map.size() )
@@ -1102,6 +1470,11 @@ namespace chainbase {
 
          int32_t                                                     _undo_session_count = 0;
          size_t                                                      _file_size = 0;
+
+         bool                                                        _read_only = false;
+         shared_state*                                               _shared_state = nullptr;
+         std::atomic< uint64_t >                                     _retried_reads{ 0 };
+         static thread_local int32_t                                 _read_only_depth;
    };
 
    template<typename Object, typename... Args>
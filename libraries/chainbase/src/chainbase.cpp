@@ -36,14 +36,29 @@ namespace chainbase {
       bool                    windows = false;
    };
 
+   thread_local int32_t database::_read_only_depth = 0;
+
    void database::open( const bfs::path& dir, uint32_t flags, size_t shared_file_size )
    {
-      bfs::create_directories( dir );
+      _read_only = flags & read_only;
+      if( !_read_only )
+         bfs::create_directories( dir );
       if( _data_dir != dir ) close();
 
       _data_dir = dir;
       auto abs_path = bfs::absolute( dir / "shared_memory.bin" );
 
+      if( _read_only )
+      {
+         if( !bfs::exists( abs_path ) )
+            BOOST_THROW_EXCEPTION( std::runtime_error( "cannot open a read only database which does not exist" ) );
+
+         map_read_only( abs_path );
+
+         // The file lock belongs to the process writing the database
+         return;
+      }
+
       if( bfs::exists( abs_path ) )
       {
          _file_size = bfs::file_size( abs_path );
@@ -74,6 +89,48 @@ namespace chainbase {
       _flock = bip::file_lock( abs_path.generic_string().c_str() );
       if( !_flock.try_lock() )
          BOOST_THROW_EXCEPTION( std::runtime_error( "could not gain write access to the shared memory file" ) );
+
+      _shared_state = _segment->find_or_construct< shared_state >( "shared_state" )();
+      // A process which crashed while writing leaves the epoch odd
+      _shared_state->write_epoch.store( ( _shared_state->write_epoch.load() + 1 ) & ~uint64_t( 1 ) );
+      _shared_state->file_size.store( _file_size );
+   }
+
+   void database::map_read_only( const bfs::path& abs_path )
+   {
+      _shared_state = nullptr;
+      _segment.reset();
+
+      _file_size = bfs::file_size( abs_path );
+      _segment.reset( new bip::managed_mapped_file( bip::open_read_only,
+                                                    abs_path.generic_string().c_str()
+                                                    ) );
+
+      auto env = _segment->find_no_lock< environment_check >( "environment" );
+      if( !env.first || !( *env.first == environment_check()) ) {
+         BOOST_THROW_EXCEPTION( std::runtime_error( "database created by a different compiler, build, or operating system" ) );
+      }
+
+      _shared_state = _segment->find_no_lock< shared_state >( "shared_state" ).first;
+      if( !_shared_state )
+         BOOST_THROW_EXCEPTION( std::runtime_error( "database was not opened read write by a version which supports read only processes" ) );
+   }
+
+   void database::remap()
+   {
+      write_lock lock( _rw_manager.current_lock() );
+      if( _shared_state->file_size.load() <= _file_size )
+         return;
+
+      map_read_only( bfs::absolute( _data_dir / "shared_memory.bin" ) );
+
+      _index_list.clear();
+      _index_map.clear();
+
+      for( auto& index_type : _index_types )
+      {
+         index_type->add_index( *this );
+      }
    }
 
    void database::flush() {
@@ -85,6 +142,7 @@ namespace chainbase {
 
    void database::close()
    {
+      _shared_state = nullptr;
       _segment.reset();
       _meta.reset();
       _data_dir = bfs::path();
@@ -92,6 +150,7 @@ namespace chainbase {
 
    void database::wipe( const bfs::path& dir )
    {
+      _shared_state = nullptr;
       _segment.reset();
       _meta.reset();
       bfs::remove_all( dir / "shared_memory.bin" );
@@ -106,10 +165,15 @@ namespace chainbase {
       if( _undo_session_count )
          BOOST_THROW_EXCEPTION( std::runtime_error( "Cannot resize shared memory file while undo session is active" ) );
 
+      // Resizing happens under the write lock, readers of other processes have to keep seeing a write in progress
+      uint64_t write_epoch = _shared_state ? _shared_state->write_epoch.load() : 0;
+
+      _shared_state = nullptr;
       _segment.reset();
       _meta.reset();
 
-      open( _data_dir, 0, new_shared_file_size );
+      open( _data_dir, read_write, new_shared_file_size );
+      _shared_state->write_epoch.store( write_epoch );
 
       _index_list.clear();
       _index_map.clear();
@@ -8,6 +8,7 @@
 #include <boost/multi_index/member.hpp>
 
 #include <iostream>
+#include <tuple>
 
 using namespace chainbase;
 using namespace boost::multi_index;
@@ -136,4 +137,166 @@ BOOST_AUTO_TEST_CASE( open_and_create ) {
    }
 }
 
+BOOST_AUTO_TEST_CASE( flat_undo ) {
+   boost::filesystem::path temp_tree = boost::filesystem::unique_path();
+   boost::filesystem::path temp_flat = boost::filesystem::unique_path();
+   try {
+      chainbase::database tree_db;
+      chainbase::database flat_db;
+      tree_db.open( temp_tree, 0, 1024*1024*8 );
+      flat_db.open( temp_flat, 0, 1024*1024*8 );
+      tree_db.add_index< book_index >();
+      flat_db.add_index< book_index >();
+      flat_db.set_flat_undo( true );
+      BOOST_REQUIRE( flat_db.get_index< book_index >().flat_undo() );
+      BOOST_REQUIRE( !tree_db.get_index< book_index >().flat_undo() );
+
+      typedef std::vector< std::tuple< int64_t, int, int > > books;
+      auto contents = []( chainbase::database& db ) {
+         books result;
+         for( const auto& b : db.get_index< book_index >().indices() )
+            result.emplace_back( b.id._id, b.a, b.b );
+         return result;
+      };
+
+      /// Applies a few transactions to a block the way the chain does, pushing each transaction session
+      /// into the block session, squashing and undoing some of them
+      auto apply_block = []( chainbase::database& db, int seed ) {
+         auto block_session = db.start_undo_session();
+         for( int trx = 0; trx < 10; ++trx ) {
+            auto trx_session = db.start_undo_session();
+            const auto& idx = db.get_index< book_index >().indices();
+            int64_t next = seed * 100 + trx;
+
+            db.create< book >( [&]( book& b ) { b.a = next; b.b = trx; } );
+            if( idx.size() > 3 ) {
+               const auto& first = *idx.begin();
+               db.modify( first, [&]( book& b ) { b.a += 1; } );
+               db.modify( first, [&]( book& b ) { b.b += 1; } );
+               const auto& second = *std::next( idx.begin() );
+               db.modify( second, [&]( book& b ) { b.b = next; } );
+               db.modify( first, [&]( book& b ) { b.a += 1; } );
+               if( trx % 3 == 0 )
+                  db.remove( *std::next( idx.begin(), 2 ) );
+            }
+            if( trx % 4 == 0 ) {
+               const auto& created = db.create< book >( [&]( book& b ) { b.a = -next; } );
+               db.modify( created, [&]( book& b ) { b.b = 1; } );
+               db.remove( created );
+            }
+
+            if( trx % 5 == 4 )
+               trx_session.undo();
+            else
+               trx_session.squash();
+         }
+         block_session.push();
+      };
+
+      for( int block = 1; block <= 20; ++block ) {
+         apply_block( tree_db, block );
+         apply_block( flat_db, block );
+         BOOST_REQUIRE( contents( tree_db ) == contents( flat_db ) );
+         BOOST_REQUIRE_EQUAL( tree_db.revision(), flat_db.revision() );
+
+         if( block % 3 == 0 ) {
+            tree_db.undo();
+            flat_db.undo();
+            BOOST_REQUIRE( contents( tree_db ) == contents( flat_db ) );
+         }
+         if( block % 4 == 0 ) {
+            tree_db.commit( tree_db.revision() - 2 );
+            flat_db.commit( flat_db.revision() - 2 );
+         }
+      }
+
+      BOOST_CHECK_THROW( flat_db.set_flat_undo( false ), std::logic_error );
+
+      tree_db.undo_all();
+      flat_db.undo_all();
+      BOOST_REQUIRE( contents( tree_db ) == contents( flat_db ) );
+      BOOST_REQUIRE_EQUAL( tree_db.revision(), flat_db.revision() );
+
+      flat_db.set_flat_undo( false );
+      BOOST_REQUIRE( !flat_db.get_index< book_index >().flat_undo() );
+   } catch ( ... ) {
+      bfs::remove_all( temp_tree );
+      bfs::remove_all( temp_flat );
+      throw;
+   }
+   bfs::remove_all( temp_tree );
+   bfs::remove_all( temp_flat );
+}
+
+BOOST_AUTO_TEST_CASE( read_only_open ) {
+   boost::filesystem::path temp = boost::filesystem::unique_path();
+   try {
+      chainbase::database db;
+      chainbase::database replica;
+      BOOST_CHECK_THROW( replica.open( temp, chainbase::database::read_only ), std::runtime_error ); /// temp does not exist
+
+      db.open( temp, chainbase::database::read_write, 1024*1024*8 );
+      replica.open( temp, chainbase::database::read_only );
+      BOOST_REQUIRE( replica.is_read_only() );
+      BOOST_CHECK_THROW( replica.add_index< book_index >(), std::runtime_error ); /// index was not created by the writer
+
+      db.add_index< book_index >();
+      replica.add_index< book_index >();
+
+      db.with_write_lock( [&]() {
+         db.create< book >( [&]( book& b ) { b.a = 1; b.b = 2; } );
+      });
+
+      auto sum = [&]() {
+         int result = 0;
+         for( const auto& b : replica.get_index< book_index >().indices() )
+            result += b.a + b.b;
+         return result;
+      };
+
+      BOOST_REQUIRE_EQUAL( replica.with_read_lock( [&]() { return sum(); } ), 3 );
+      BOOST_CHECK_THROW( replica.with_write_lock( [](){} ), std::logic_error );
+
+      /// A write does not wait for the reads of the read only process, a read which overlapped it is retried
+      bool first_attempt = true;
+      int result = replica.with_read_lock( [&]() {
+         if( first_attempt ) {
+            first_attempt = false;
+            db.with_write_lock( [&]() {
+               db.create< book >( [&]( book& b ) { b.a = 3; b.b = 4; } );
+            });
+         }
+         return replica.with_read_lock( [&]() { return sum(); } );
+      });
+      BOOST_REQUIRE_EQUAL( result, 10 );
+      BOOST_REQUIRE_EQUAL( replica.get_retried_reads(), 1u );
+
+      /// A read gives up when a write does not finish in time
+      db.with_write_lock( [&]() {
+         BOOST_CHECK_THROW( replica.with_read_lock( [&]() { return sum(); }, 1000 ), chainbase::lock_exception );
+      });
+
+      /// The replica maps the file again once the writer grew it
+      db.with_write_lock( [&]() {
+         db.resize( 1024*1024*16 );
+         db.create< book >( [&]( book& b ) { b.a = 5; b.b = 6; } );
+      });
+      BOOST_REQUIRE_EQUAL( replica.with_read_lock( [&]() { return sum(); } ), 21 );
+      BOOST_REQUIRE_EQUAL( replica.get_max_memory(), 1024u*1024*16 );
+      BOOST_REQUIRE_EQUAL( replica.get_retried_reads(), 1u );
+
+      /// A read which keeps overlapping writes fails once the wait time passed
+      BOOST_CHECK_THROW( replica.with_read_lock( [&]() {
+         db.with_write_lock( [](){} );
+         boost::this_thread::sleep_for( boost::chrono::microseconds( 500 ) );
+         return sum();
+      }, 1000 ), chainbase::lock_exception );
+      BOOST_REQUIRE( replica.get_retried_reads() > 1u );
+   } catch ( ... ) {
+      bfs::remove_all( temp );
+      throw;
+   }
+   bfs::remove_all( temp );
+}
+
 // BOOST_AUTO_TEST_SUITE_END()
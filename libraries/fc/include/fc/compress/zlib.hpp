@@ -1,10 +1,15 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace fc 
 {
 
   std::string zlib_compress(const std::string& in);
+  std::string zlib_decompress(const std::string& in);
+
+  std::vector<char> zlib_compress(const char* in, size_t size);
+  std::vector<char> zlib_decompress(const char* in, size_t size);
 
 } // namespace fc
@@ -22,11 +22,16 @@ namespace fc { namespace http {
       public:
          virtual ~websocket_connection(){}
          virtual void send_message( const std::string& message ) = 0;
+         /// Sends the message in a binary frame
+         virtual void send_binary_message( const std::string& message ) = 0;
          virtual void close( int64_t code, const std::string& reason  ){};
          void on_message( const std::string& message ) { _on_message(message); }
+         /// Binary frames go to the message handler unless a binary message handler is set
+         void on_binary_message( const std::string& message ) { if( _on_binary_message ) _on_binary_message(message); else _on_message(message); }
          std::string on_http( const std::string& message ) { return _on_http(message); }
 
          void on_message_handler( const std::function<void(const std::string&)>& h ) { _on_message = h; }
+         void on_binary_message_handler( const std::function<void(const std::string&)>& h ) { _on_binary_message = h; }
          void on_http_handler( const std::function<std::string(const std::string&)>& h ) { _on_http = h; }
 
          void     set_session_data( std::any d ){ _session_data = std::move(d); }
@@ -36,6 +41,7 @@ namespace fc { namespace http {
       private:
          std::any                                   _session_data;
          std::function<void(const std::string&)>   _on_message;
+         std::function<void(const std::string&)>   _on_binary_message;
          std::function<std::string(const std::string&)> _on_http;
    };
    typedef std::shared_ptr<websocket_connection> websocket_connection_ptr;
@@ -0,0 +1,63 @@
+#pragma once
+#include <fc/network/http/websocket.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/thread/future.hpp>
+
+#include <mutex>
+#include <unordered_map>
+
+namespace fc { namespace rpc {
+
+   /**
+    * A call in a binary websocket frame. The arguments and the result of the method are packed with fc::raw, so both
+    * ends must agree on the reflected layout of the method's types.
+    */
+   struct binary_request
+   {
+      uint64_t            id = 0;
+      std::string         api;
+      std::string         method;
+      std::vector<char>   args;
+   };
+
+   struct binary_response
+   {
+      uint64_t            id = 0;
+      /// 0 for success, otherwise a JSON-RPC error code and message
+      int32_t             code = 0;
+      std::string         message;
+      std::vector<char>   result;
+   };
+
+   /**
+    * Client side of the binary transport, sharing the websocket connection with a websocket_api_connection which
+    * keeps handling the text frames.
+    */
+   class binary_api_connection
+   {
+      public:
+         binary_api_connection( fc::http::websocket_connection& c );
+         ~binary_api_connection();
+
+         std::vector<char> send_call( std::string api_name, std::string method_name, std::vector<char> args );
+
+         template<typename Result, typename Args>
+         Result call( const std::string& api_name, const std::string& method_name, const Args& args )
+         {
+            return fc::raw::unpack_from_vector<Result>( send_call( api_name, method_name, fc::raw::pack_to_vector( args ) ), 0 );
+         }
+
+      protected:
+         void on_message( const std::string& message );
+         void close();
+
+         fc::http::websocket_connection&                                      _connection;
+         std::mutex                                                           _mutex;
+         uint64_t                                                             _next_id = 1;
+         std::unordered_map<uint64_t, fc::promise<binary_response>::ptr>     _awaiting;
+   };
+
+} } // namespace fc::rpc
+
+FC_REFLECT( fc::rpc::binary_request, (id)(api)(method)(args) )
+FC_REFLECT( fc::rpc::binary_response, (id)(code)(message)(result) )
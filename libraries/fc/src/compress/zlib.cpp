@@ -1,4 +1,5 @@
 #include <fc/compress/zlib.hpp>
+#include <fc/exception/exception.hpp>
 
 #include "miniz.c"
 
@@ -12,4 +13,30 @@ namespace fc
     free(compressed_message);
     return result;
   }
+
+  std::string zlib_decompress(const std::string& in)
+  {
+    auto out = zlib_decompress(in.c_str(), in.size());
+    return std::string(out.begin(), out.end());
+  }
+
+  std::vector<char> zlib_compress(const char* in, size_t size)
+  {
+    size_t compressed_length;
+    char* compressed = (char*)tdefl_compress_mem_to_heap(in, size, &compressed_length, TDEFL_WRITE_ZLIB_HEADER | TDEFL_DEFAULT_MAX_PROBES);
+    FC_ASSERT(compressed != nullptr, "zlib compression failed");
+    std::vector<char> result(compressed, compressed + compressed_length);
+    free(compressed);
+    return result;
+  }
+
+  std::vector<char> zlib_decompress(const char* in, size_t size)
+  {
+    size_t decompressed_length;
+    char* decompressed = (char*)tinfl_decompress_mem_to_heap(in, size, &decompressed_length, TINFL_FLAG_PARSE_ZLIB_HEADER);
+    FC_ASSERT(decompressed != nullptr, "zlib decompression failed");
+    std::vector<char> result(decompressed, decompressed + decompressed_length);
+    free(decompressed);
+    return result;
+  }
 }
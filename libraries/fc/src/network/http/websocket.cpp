@@ -166,6 +166,11 @@ namespace fc { namespace http {
                auto ec = _ws_connection->send( message );
                FC_ASSERT( !ec, "websocket send failed: ${msg}", ("msg",ec.message() ) );
             }
+            virtual void send_binary_message( const std::string& message )override
+            {
+               auto ec = _ws_connection->send( message.data(), message.size(), websocketpp::frame::opcode::binary );
+               FC_ASSERT( !ec, "websocket send failed: ${msg}", ("msg",ec.message() ) );
+            }
             virtual void close( int64_t code, const std::string& reason  )override
             {
                _ws_connection->close(code,reason);
@@ -416,9 +421,15 @@ namespace fc { namespace http {
                         wdump((msg->get_payload()));
                         //std::cerr<<"recv: "<<msg->get_payload()<<"\n";
                         auto received = msg->get_payload();
+                        bool binary = msg->get_opcode() == websocketpp::frame::opcode::binary;
                         fc::async( [=](){
                            if( _connection )
-                               _connection->on_message(received);
+                           {
+                              if( binary )
+                                 _connection->on_binary_message(received);
+                              else
+                                 _connection->on_message(received);
+                           }
                         });
                    }).wait();
                 });
@@ -474,7 +485,10 @@ namespace fc { namespace http {
                 _client.set_message_handler( [&]( connection_hdl hdl, message_ptr msg ){
                    _client_thread.async( [&](){
                         wdump((msg->get_payload()));
-                      _connection->on_message( msg->get_payload() );
+                      if( msg->get_opcode() == websocketpp::frame::opcode::binary )
+                         _connection->on_binary_message( msg->get_payload() );
+                      else
+                         _connection->on_message( msg->get_payload() );
                    }).wait();
                 });
                 _client.set_close_handler( [=]( connection_hdl hdl ){
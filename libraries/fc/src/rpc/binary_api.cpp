@@ -0,0 +1,83 @@
+#include <fc/rpc/binary_api.hpp>
+
+namespace fc { namespace rpc {
+
+binary_api_connection::binary_api_connection( fc::http::websocket_connection& c )
+   : _connection(c)
+{
+   _connection.on_binary_message_handler( [this]( const std::string& msg ){ on_message(msg); } );
+   _connection.closed.connect( [this](){ close(); } );
+}
+
+binary_api_connection::~binary_api_connection()
+{
+   close();
+}
+
+std::vector<char> binary_api_connection::send_call(
+   std::string api_name,
+   std::string method_name,
+   std::vector<char> args )
+{
+   binary_request req{ 0, std::move(api_name), std::move(method_name), std::move(args) };
+   fc::promise<binary_response>::ptr reply( new fc::promise<binary_response>("binary_api_connection::send_call") );
+
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      req.id = _next_id++;
+      _awaiting[req.id] = reply;
+   }
+
+   auto packed = fc::raw::pack_to_vector( req );
+   try
+   {
+      _connection.send_binary_message( std::string( packed.data(), packed.size() ) );
+   }
+   catch( ... )
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      _awaiting.erase( req.id );
+      throw;
+   }
+
+   binary_response res = fc::future<binary_response>( reply ).wait();
+   FC_ASSERT( res.code == 0, "${message}", ("message",res.message)("code",res.code)("api",req.api)("method",req.method) );
+   return std::move( res.result );
+}
+
+void binary_api_connection::on_message( const std::string& message )
+{
+   try
+   {
+      auto res = fc::raw::unpack_from_char_array<binary_response>( message.data(), message.size(), 0 );
+
+      fc::promise<binary_response>::ptr reply;
+      {
+         std::lock_guard<std::mutex> guard( _mutex );
+         auto itr = _awaiting.find( res.id );
+         FC_ASSERT( itr != _awaiting.end(), "Unknown Response ID: ${id}", ("id",res.id) );
+         reply = itr->second;
+         _awaiting.erase( itr );
+      }
+
+      reply->set_value( std::move( res ) );
+   }
+   catch ( const fc::exception& e )
+   {
+      wdump((e.to_detail_string()));
+   }
+}
+
+void binary_api_connection::close()
+{
+   std::unordered_map<uint64_t, fc::promise<binary_response>::ptr> awaiting;
+   {
+      std::lock_guard<std::mutex> guard( _mutex );
+      awaiting.swap( _awaiting );
+   }
+
+   for( auto& item : awaiting )
+      item.second->set_exception( fc::exception_ptr(new FC_EXCEPTION( eof_exception, "connection closed" )) );
+}
+
+} } // namespace fc::rpc
@@ -507,7 +507,7 @@ namespace graphene { namespace net
       // to give us some wiggle room)
       return inventory_peer_advertised_to_us.size() >
         GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES * GRAPHENE_NET_MAX_TRX_PER_SECOND * 60 +
-        (GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES + 1) * 60 / sophiatx::protocol::protocol_config::get<uint32_t>("SOPHIATX_BLOCK_INTERVAL");
+        (GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES + 1) * 60 / sophiatx::protocol::protocol_config::params().block_interval;
     }
 
     bool peer_connection::performing_firewall_check() const
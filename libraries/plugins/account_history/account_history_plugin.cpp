@@ -1,4 +1,5 @@
 #include <sophiatx/plugins/account_history/account_history_plugin.hpp>
+#include <sophiatx/plugins/account_history/account_history_store.hpp>
 
 #include <sophiatx/chain/util/impacted.hpp>
 
@@ -6,6 +7,7 @@
 
 #include <sophiatx/chain/operation_notification.hpp>
 #include <sophiatx/chain/history_object.hpp>
+#include <sophiatx/chain/index.hpp>
 
 #include <sophiatx/utilities/plugin_utilities.hpp>
 
@@ -23,6 +25,7 @@ using namespace sophiatx::protocol;
 using chain::database_interface;
 using chain::operation_notification;
 using chain::operation_object;
+using chain::operation_id_type;
 
 namespace detail {
 
@@ -35,20 +38,34 @@ class account_history_plugin_impl
       virtual ~account_history_plugin_impl() {}
 
       void on_operation( const operation_notification& note );
+      void store_operation( const operation_notification& note, const flat_set< account_name_type >& impacted );
+      bool is_tracked( const account_name_type& item )const;
+
+      /// Removes aged entries of the accounts with new entries since the last pass and the operations left unreferenced
+      void prune();
+      bool is_referenced( const operation_object& op )const;
 
       flat_map< account_name_type, account_name_type > _tracked_accounts;
       bool                                             _filter_content = false;
       bool                                             _blacklist = false;
       flat_set< string >                               _op_list;
       bool                                             _prune = true;
+      uint32_t                                         _prune_interval = 1200;
+      uint32_t                                         _keep_count = 30;
+      fc::microseconds                                 _keep_age = fc::days( 30 );
+      uint32_t                                         _sweep_batch = 10000;
       std::shared_ptr<database_interface>              _db;
+      std::shared_ptr<account_history_store>           _store;
       boost::signals2::connection      pre_apply_connection;
+      boost::signals2::connection      pre_apply_block_connection;
+      boost::signals2::connection      applied_block_connection;
+      boost::signals2::connection      prune_connection;
 };
 
 struct operation_visitor
 {
-   operation_visitor( std::shared_ptr<database_interface>& db, const operation_notification& note, const operation_object*& n, account_name_type i, bool prune )
-      :_db(db), _note(note), new_obj(n), item(i), _prune(prune) {}
+   operation_visitor( std::shared_ptr<database_interface>& db, const operation_notification& note, const operation_object*& n, account_name_type i )
+      :_db(db), _note(note), new_obj(n), item(i) {}
 
    typedef void result_type;
 
@@ -56,7 +73,6 @@ struct operation_visitor
    const operation_notification& _note;
    const operation_object*& new_obj;
    account_name_type item;
-   bool _prune;
 
    template<typename Op>
    void operator()( Op&& )const
@@ -93,40 +109,21 @@ struct operation_visitor
          ahist.sequence = sequence;
          ahist.op       = new_obj->id;
       });
+   }
+};
 
-      if( _prune )
-      {
-         // Clean up accounts to last 30 days or 30 items, whichever is more.
-         const auto& seq_idx = _db->get_index< chain::account_history_index, chain::by_account >();
-         auto seq_itr = seq_idx.lower_bound( boost::make_tuple( item, 0 ) );
-         vector< const chain::account_history_object* > to_remove;
-         auto now = _db->head_block_time();
-
-         if( seq_itr == seq_idx.begin() )
-            return;
-
-         --seq_itr;
-
-         while( seq_itr->account == item
-               && sequence - seq_itr->sequence > 30
-               && now - _db->get< chain::operation_object >( seq_itr->op ).timestamp > fc::days(30) )
-         {
-            to_remove.push_back( &(*seq_itr) );
-            --seq_itr;
-         }
+struct operation_type_name_visitor
+{
+   typedef string result_type;
 
-         for( const auto* seq_ptr : to_remove )
-         {
-            _db->remove( *seq_ptr );
-         }
-      }
-   }
+   template< typename T >
+   string operator()( const T& )const { return fc::get_typename< T >::name(); }
 };
 
 struct operation_visitor_filter : operation_visitor
 {
-   operation_visitor_filter( std::shared_ptr<database_interface>& db, const operation_notification& note, const operation_object*& n, account_name_type i, const flat_set< string >& filter, bool p, bool blacklist ):
-      operation_visitor( db, note, n, i, p ), _filter( filter ), _blacklist( blacklist ) {}
+   operation_visitor_filter( std::shared_ptr<database_interface>& db, const operation_notification& note, const operation_object*& n, account_name_type i, const flat_set< string >& filter, bool blacklist ):
+      operation_visitor( db, note, n, i ), _filter( filter ), _blacklist( blacklist ) {}
 
    const flat_set< string >& _filter;
    bool _blacklist;
@@ -147,6 +144,53 @@ struct operation_visitor_filter : operation_visitor
    }
 };
 
+bool account_history_plugin_impl::is_tracked( const account_name_type& item )const
+{
+   auto itr = _tracked_accounts.lower_bound( item );
+
+   /*
+    * The map containing the ranges uses the key as the lower bound and the value as the upper bound.
+    * Because of this, if a value exists with the range (key, value], then calling lower_bound on
+    * the map will return the key of the next pair. Under normal circumstances of those ranges not
+    * intersecting, the value we are looking for will not be present in range that is returned via
+    * lower_bound.
+    *
+    * Consider the following example using ranges ["a","c"], ["g","i"]
+    * If we are looking for "bob", it should be tracked because it is in the lower bound.
+    * However, lower_bound( "bob" ) returns an iterator to ["g","i"]. So we need to decrement the iterator
+    * to get the correct range.
+    *
+    * If we are looking for "g", lower_bound( "g" ) will return ["g","i"], so we need to make sure we don't
+    * decrement.
+    *
+    * If the iterator points to the end, we should check the previous (equivalent to rbegin)
+    *
+    * And finally if the iterator is at the beginning, we should not decrement it for obvious reasons
+    */
+   if( itr != _tracked_accounts.begin() &&
+       ( ( itr != _tracked_accounts.end() && itr->first != item  ) || itr == _tracked_accounts.end() ) )
+   {
+      --itr;
+   }
+
+   return !_tracked_accounts.size() || ( itr != _tracked_accounts.end() && itr->first <= item && item <= itr->second );
+}
+
+void account_history_plugin_impl::store_operation( const operation_notification& note, const flat_set< account_name_type >& impacted )
+{
+   // The filter depends on the type of the operation only
+   if( _filter_content && ( _op_list.find( note.op.visit( operation_type_name_visitor() ) ) != _op_list.end() ) == _blacklist )
+      return;
+
+   vector< account_name_type > accounts;
+   for( const auto& item : impacted )
+      if( is_tracked( item ) )
+         accounts.push_back( item );
+
+   if( accounts.size() )
+      _store->push_operation( note, _db->head_block_time(), std::move( accounts ) );
+}
+
 void account_history_plugin_impl::on_operation( const operation_notification& note )
 {
    flat_set<account_name_type> impacted;
@@ -155,48 +199,157 @@ void account_history_plugin_impl::on_operation( const operation_notification& no
    app::operation_get_impacted_accounts( note.op, impacted );
    impacted.insert(note.fee_payer);
 
-   for( const auto& item : impacted ) {
-      auto itr = _tracked_accounts.lower_bound( item );
-
-      /*
-       * The map containing the ranges uses the key as the lower bound and the value as the upper bound.
-       * Because of this, if a value exists with the range (key, value], then calling lower_bound on
-       * the map will return the key of the next pair. Under normal circumstances of those ranges not
-       * intersecting, the value we are looking for will not be present in range that is returned via
-       * lower_bound.
-       *
-       * Consider the following example using ranges ["a","c"], ["g","i"]
-       * If we are looking for "bob", it should be tracked because it is in the lower bound.
-       * However, lower_bound( "bob" ) returns an iterator to ["g","i"]. So we need to decrement the iterator
-       * to get the correct range.
-       *
-       * If we are looking for "g", lower_bound( "g" ) will return ["g","i"], so we need to make sure we don't
-       * decrement.
-       *
-       * If the iterator points to the end, we should check the previous (equivalent to rbegin)
-       *
-       * And finally if the iterator is at the beginning, we should not decrement it for obvious reasons
-       */
-      if( itr != _tracked_accounts.begin() &&
-          ( ( itr != _tracked_accounts.end() && itr->first != item  ) || itr == _tracked_accounts.end() ) )
-      {
-         --itr;
-      }
+   if( _store )
+   {
+      store_operation( note, impacted );
+      return;
+   }
 
-      if( !_tracked_accounts.size() || (itr != _tracked_accounts.end() && itr->first <= item && item <= itr->second ) )
+   for( const auto& item : impacted ) {
+      if( is_tracked( item ) )
       {
          if(_filter_content)
          {
-            note.op.visit( operation_visitor_filter( _db, note, new_obj, item, _op_list, _prune, _blacklist ) );
+            note.op.visit( operation_visitor_filter( _db, note, new_obj, item, _op_list, _blacklist ) );
          }
          else
          {
-            note.op.visit( operation_visitor( _db, note, new_obj, item, _prune ) );
+            note.op.visit( operation_visitor( _db, note, new_obj, item ) );
+         }
+
+         if( _prune && !_db->find< account_history_prune_account_object, by_account >( item ) )
+         {
+            _db->create< account_history_prune_account_object >( [&]( account_history_prune_account_object& a )
+            {
+               a.account = item;
+            });
          }
       }
    }
 }
 
+bool account_history_plugin_impl::is_referenced( const operation_object& op )const
+{
+   const auto& hist_idx = _db->get_index< chain::account_history_index, chain::by_account >();
+
+   flat_set< account_name_type > impacted;
+   app::operation_get_impacted_accounts( fc::raw::unpack_from_buffer< operation >( op.serialized_op, 0 ), impacted );
+   impacted.insert( op.fee_payer );
+
+   // Entries of an account are removed from the oldest one, so the account still references the operation
+   // as long as its oldest entry is not newer than it
+   for( const auto& account : impacted )
+   {
+      auto oldest = hist_idx.lower_bound( boost::make_tuple( account, 0 ) );
+      if( oldest == hist_idx.begin() )
+         continue;
+
+      --oldest;
+      if( oldest->account == account && !( op.id < oldest->op ) )
+         return true;
+   }
+
+   return false;
+}
+
+void account_history_plugin_impl::prune()
+{
+   auto start = fc::time_point::now();
+   auto now = _db->head_block_time();
+   const auto& hist_idx = _db->get_index< chain::account_history_index, chain::by_account >();
+   const auto& op_idx = _db->get_index< chain::operation_index, chain::by_id >();
+
+   uint64_t entries = 0;
+   uint64_t operations = 0;
+   uint64_t bytes = 0;
+   vector< operation_id_type > candidates;
+
+   const auto* state = _db->find< account_history_prune_state_object >();
+   if( !state )
+      state = &_db->create< account_history_prune_state_object >( []( account_history_prune_state_object& ){} );
+
+   const auto& accounts_idx = _db->get_index< account_history_prune_account_index, by_account >();
+   vector< account_name_type > accounts;
+   accounts.reserve( accounts_idx.size() );
+   for( const auto& a : accounts_idx )
+      accounts.push_back( a.account );
+
+   while( !accounts_idx.empty() )
+      _db->remove( *accounts_idx.begin() );
+
+   for( const auto& account : accounts )
+   {
+      auto latest = hist_idx.lower_bound( boost::make_tuple( account, uint32_t( -1 ) ) );
+      if( latest == hist_idx.end() || latest->account != account )
+         continue;
+      uint32_t last_sequence = latest->sequence;
+
+      // Entries are ordered from the latest to the oldest one, the oldest is right before the next account
+      while( true )
+      {
+         auto oldest = hist_idx.lower_bound( boost::make_tuple( account, 0 ) );
+         if( oldest == hist_idx.begin() )
+            break;
+
+         --oldest;
+         if( oldest->account != account
+               || last_sequence - oldest->sequence < _keep_count
+               || now - _db->get( oldest->op ).timestamp <= _keep_age )
+            break;
+
+         candidates.push_back( oldest->op );
+         _db->remove( *oldest );
+         bytes += sizeof( chain::account_history_object );
+         ++entries;
+      }
+   }
+
+   auto remove_operation = [&]( const operation_object& op )
+   {
+      bytes += sizeof( operation_object ) + op.serialized_op.size();
+      ++operations;
+      _db->remove( op );
+   };
+
+   std::sort( candidates.begin(), candidates.end() );
+   candidates.erase( std::unique( candidates.begin(), candidates.end() ), candidates.end() );
+   for( const auto& id : candidates )
+   {
+      const auto& op = _db->get( id );
+      if( !is_referenced( op ) )
+         remove_operation( op );
+   }
+
+   // Operations orphaned before they were tracked, e.g. by the former inline pruning, are found by a sweep over
+   // the operations older than the retention, a batch at a time
+   auto itr = op_idx.lower_bound( state->sweep_cursor );
+   for( uint32_t checked = 0; itr != op_idx.end() && checked < _sweep_batch && now - itr->timestamp > _keep_age; ++checked )
+   {
+      const auto& op = *itr;
+      ++itr;
+      if( !is_referenced( op ) )
+         remove_operation( op );
+   }
+   auto sweep_cursor = itr == op_idx.end() || now - itr->timestamp <= _keep_age ? operation_id_type() : itr->id;
+
+   auto duration = fc::time_point::now() - start;
+
+   _db->modify( *state, [&]( account_history_prune_state_object& s )
+   {
+      s.sweep_cursor = sweep_cursor;
+      ++s.stats.passes;
+      s.stats.history_entries += entries;
+      s.stats.operations += operations;
+      s.stats.bytes += bytes;
+      s.stats.last_block = _db->head_block_num();
+      s.stats.last_duration_us = duration.count();
+   });
+
+   if( entries || operations )
+      ilog( "Account History: pruned ${e} entries and ${o} operations, ${b} bytes in ${d} us",
+            ("e", entries)("o", operations)("b", bytes)("d", duration.count()) );
+}
+
 } // detail
 
 account_history_plugin::account_history_plugin() {}
@@ -212,6 +365,11 @@ void account_history_plugin::set_program_options(
          ("account-history-whitelist-ops", boost::program_options::value< vector< string > >()->composing(), "Defines a list of operations which will be explicitly logged.")
          ("account-history-blacklist-ops", boost::program_options::value< vector< string > >()->composing(), "Defines a list of operations which will be explicitly ignored.")
          ("history-disable-pruning", boost::program_options::value< bool >()->default_value( false ), "Disables automatic account history trimming" )
+         ("account-history-prune-interval", boost::program_options::value< uint32_t >()->default_value( 1200 ), "Number of blocks between account history trimming passes" )
+         ("account-history-keep-days", boost::program_options::value< uint32_t >()->default_value( 30 ), "Account history entries younger than this are kept" )
+         ("account-history-keep-count", boost::program_options::value< uint32_t >()->default_value( 30 ), "Number of latest account history entries kept for each account regardless of their age, at least 1" )
+         ("account-history-prune-sweep-batch", boost::program_options::value< uint32_t >()->default_value( 10000 ), "Number of old operations checked for remaining references by each trimming pass" )
+         ("account-history-storage", boost::program_options::value< string >()->default_value( "chainbase" ), "Where the account history is kept, chainbase (in the shared memory file) or sqlite (account_history.db next to the block log)" )
          ;
 }
 
@@ -267,13 +425,75 @@ void account_history_plugin::plugin_initialize( const boost::program_options::va
    {
       my->_prune = !options[ "history-disable-pruning" ].as< bool >();
    }
+
+   my->_prune_interval = options.at( "account-history-prune-interval" ).as< uint32_t >();
+   my->_keep_age = fc::days( options.at( "account-history-keep-days" ).as< uint32_t >() );
+   my->_keep_count = options.at( "account-history-keep-count" ).as< uint32_t >();
+   my->_sweep_batch = options.at( "account-history-prune-sweep-batch" ).as< uint32_t >();
+   FC_ASSERT( my->_prune_interval > 0, "account-history-prune-interval must be at least 1" );
+   // The latest entry of an account numbers the next one
+   FC_ASSERT( my->_keep_count > 0, "account-history-keep-count must be at least 1" );
+
+   add_plugin_index< account_history_prune_state_index >( my->_db );
+   add_plugin_index< account_history_prune_account_index >( my->_db );
+
+   auto storage = options.at( "account-history-storage" ).as< string >();
+   if( storage == "sqlite" )
+   {
+#ifdef SOPHIATX_ACCOUNT_HISTORY_STORE
+      auto& chain = appbase::app().get_plugin< sophiatx::plugins::chain::chain_plugin >();
+      fc::create_directories( chain.get_shared_memory_dir() );
+      my->_store = std::make_shared< account_history_store >( chain.get_shared_memory_dir() / "account_history.db" );
+
+      my->pre_apply_block_connection = my->_db->pre_apply_block.connect( 0, [&]( const signed_block& b ){ my->_store->begin_block( b.block_num() ); } );
+      my->applied_block_connection = my->_db->applied_block.connect( 0, [&]( const signed_block& b )
+      {
+         my->_store->end_block( b.block_num(), my->_db->last_non_undoable_block_num() );
+      });
+
+      // Replayed blocks are applied without undo history, so all of them are kept by the state
+      my->_db->on_reindex_start_connect( [&](){ my->_store->truncate( 0 ); } );
+      my->_db->on_reindex_done_connect( [&]( bool, uint32_t ){ my->_store->commit( my->_db->head_block_num() ); } );
+
+      ilog( "Account History: keeping the history in ${f}", ("f", ( chain.get_shared_memory_dir() / "account_history.db" ).generic_string()) );
+#else
+      FC_ASSERT( false, "account-history-storage = sqlite requires a build with SQLite" );
+#endif
+   }
+   else
+   {
+      FC_ASSERT( storage == "chainbase", "Unknown account-history-storage ${s}", ("s", storage) );
+
+      // Pruning runs as part of the block, so its removals are undone together with the block
+      if( my->_prune )
+         my->prune_connection = my->_db->applied_block.connect( [&]( const signed_block& b )
+         {
+            if( b.block_num() % my->_prune_interval == 0 )
+               my->prune();
+         });
+   }
 }
 
-void account_history_plugin::plugin_startup() {}
+void account_history_plugin::plugin_startup()
+{
+   if( !my->_store )
+      return;
+
+   // The state may have been rewound or replaced since the history was written
+   auto head = my->_db->with_read_lock( [&]() { return my->_db->head_block_num(); } );
+   my->_store->truncate( head );
+
+   if( my->_store->last_written_block() < head )
+      wlog( "Account history ends at block ${b}, the chain is at block ${h}. Replay the blockchain to fill the gap.",
+            ("b", my->_store->last_written_block())("h", head) );
+}
 
 void account_history_plugin::plugin_shutdown()
 {
    chain::util::disconnect_signal( my->pre_apply_connection );
+   chain::util::disconnect_signal( my->pre_apply_block_connection );
+   chain::util::disconnect_signal( my->applied_block_connection );
+   chain::util::disconnect_signal( my->prune_connection );
 }
 
 flat_map< account_name_type, account_name_type > account_history_plugin::tracked_accounts() const
@@ -281,4 +501,20 @@ flat_map< account_name_type, account_name_type > account_history_plugin::tracked
    return my->_tracked_accounts;
 }
 
+std::shared_ptr< account_history_store > account_history_plugin::store() const
+{
+   return my->_store;
+}
+
+bool account_history_plugin::prunes_operations() const
+{
+   return my->_prune && !my->_store;
+}
+
+account_history_prune_stats account_history_plugin::get_prune_stats() const
+{
+   const auto* state = my->_db->find< account_history_prune_state_object >();
+   return state ? state->stats : account_history_prune_stats();
+}
+
 } } } // sophiatx::plugins::account_history
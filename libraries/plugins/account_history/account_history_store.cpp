@@ -0,0 +1,381 @@
+#include <sophiatx/plugins/account_history/account_history_store.hpp>
+
+#include <sophiatx/chain/database/database_interface.hpp>
+
+#include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Statement.h>
+#include <SQLiteCpp/Transaction.h>
+
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+namespace sophiatx { namespace plugins { namespace account_history {
+
+namespace detail {
+
+   const char* schema =
+      "CREATE TABLE IF NOT EXISTS properties("
+      "   name TEXT PRIMARY KEY,"
+      "   value INTEGER NOT NULL );"
+      // Operation ids are assigned in the order the operations were applied
+      "CREATE TABLE IF NOT EXISTS operations("
+      "   id INTEGER PRIMARY KEY,"
+      "   block INTEGER NOT NULL,"
+      "   trx_in_block INTEGER NOT NULL,"
+      "   op_in_trx INTEGER NOT NULL,"
+      "   virtual_op INTEGER NOT NULL,"
+      "   trx_id BLOB,"
+      "   timestamp INTEGER NOT NULL,"
+      "   fee_payer TEXT NOT NULL,"
+      "   op BLOB NOT NULL );"
+      "CREATE INDEX IF NOT EXISTS operations_by_block ON operations( block );"
+      "CREATE INDEX IF NOT EXISTS operations_by_trx_id ON operations( trx_id ) WHERE trx_id IS NOT NULL;"
+      "CREATE TABLE IF NOT EXISTS account_history("
+      "   account TEXT NOT NULL,"
+      "   sequence INTEGER NOT NULL,"
+      "   operation INTEGER NOT NULL,"
+      "   PRIMARY KEY( account, sequence ) ) WITHOUT ROWID;";
+
+   /// Columns read by read_operation(), prefixed by the alias of the operations table
+   const char* operation_columns = "o.trx_id, o.block, o.trx_in_block, o.op_in_trx, o.virtual_op, o.timestamp, o.fee_payer, o.op";
+
+   stored_operation read_operation( SQLite::Statement& query, int column )
+   {
+      stored_operation op;
+
+      auto trx_id = query.getColumn( column );
+      if( !trx_id.isNull() )
+      {
+         FC_ASSERT( size_t( trx_id.getBytes() ) == op.trx_id.data_size(), "Corrupted transaction id in account history" );
+         memcpy( op.trx_id.data(), trx_id.getBlob(), op.trx_id.data_size() );
+      }
+
+      op.block = query.getColumn( column + 1 ).getInt64();
+      op.trx_in_block = query.getColumn( column + 2 ).getInt64();
+      op.op_in_trx = query.getColumn( column + 3 ).getInt64();
+      op.virtual_op = query.getColumn( column + 4 ).getInt64();
+      op.timestamp = fc::time_point_sec( query.getColumn( column + 5 ).getInt64() );
+      op.fee_payer = query.getColumn( column + 6 ).getString();
+
+      auto serialized_op = query.getColumn( column + 7 );
+      const char* data = static_cast< const char* >( serialized_op.getBlob() );
+      op.serialized_op.assign( data, data + serialized_op.getBytes() );
+      return op;
+   }
+
+}
+
+account_history_store::account_history_store( const fc::path& file )
+{
+   _db = std::make_unique< SQLite::Database >( file.generic_string(), SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE );
+
+   // Only irreversible blocks are written, after a crash they are written again from the block log
+   _db->exec( "PRAGMA journal_mode = WAL" );
+   _db->exec( "PRAGMA synchronous = NORMAL" );
+   _db->exec( detail::schema );
+
+   SQLite::Statement last_block( *_db, "SELECT value FROM properties WHERE name = 'last_block'" );
+   if( last_block.executeStep() )
+      _last_written_block = last_block.getColumn( 0 ).getInt64();
+
+   _insert_operation = std::make_unique< SQLite::Statement >( *_db,
+      "INSERT INTO operations( block, trx_in_block, op_in_trx, virtual_op, trx_id, timestamp, fee_payer, op ) VALUES( ?, ?, ?, ?, ?, ?, ?, ? )" );
+   _insert_history = std::make_unique< SQLite::Statement >( *_db,
+      "INSERT INTO account_history( account, sequence, operation ) VALUES( ?, ?, ? )" );
+   _select_last_sequence = std::make_unique< SQLite::Statement >( *_db,
+      "SELECT MAX( sequence ) FROM account_history WHERE account = ?" );
+
+   ilog( "Opened account history store ${f} at block ${b}", ("f", file.generic_string())("b", _last_written_block) );
+}
+
+account_history_store::~account_history_store()
+{
+   // Statements have to be finalized before the database is closed
+   _insert_operation.reset();
+   _insert_history.reset();
+   _select_last_sequence.reset();
+}
+
+void account_history_store::begin_block( uint32_t block_num )
+{
+   std::lock_guard< std::mutex > guard( _mutex );
+   _applying_block = true;
+   _current.block_num = block_num;
+   _current.operations.clear();
+}
+
+void account_history_store::push_operation( const chain::operation_notification& note, fc::time_point_sec timestamp,
+                                            std::vector< account_name_type > accounts )
+{
+   std::lock_guard< std::mutex > guard( _mutex );
+
+   // Operations of pending transactions are undone before they get into a block
+   if( !_applying_block || note.block != _current.block_num )
+      return;
+
+   pending_operation pending;
+   pending.op.trx_id = note.trx_id;
+   pending.op.block = note.block;
+   pending.op.trx_in_block = note.trx_in_block;
+   pending.op.op_in_trx = note.op_in_trx;
+   pending.op.virtual_op = note.virtual_op;
+   pending.op.timestamp = timestamp;
+   pending.op.fee_payer = note.fee_payer;
+   pending.op.serialized_op = fc::raw::pack_to_vector( note.op );
+
+   pending.history.reserve( accounts.size() );
+   for( auto& account : accounts )
+      pending.history.emplace_back( std::move( account ), 0 );
+
+   _current.operations.push_back( std::move( pending ) );
+}
+
+void account_history_store::end_block( uint32_t block_num, uint32_t last_irreversible_block )
+{
+   std::lock_guard< std::mutex > guard( _mutex );
+
+   if( !_applying_block || _current.block_num != block_num )
+      return;
+   _applying_block = false;
+
+   if( _pending.size() && _pending.back().block_num >= block_num )
+   {
+      while( _pending.size() && _pending.back().block_num >= block_num )
+         _pending.pop_back();
+      rebuild_last_sequences();
+   }
+
+   // Sequences are assigned only now, once the blocks of a fork have been dropped
+   for( auto& op : _current.operations )
+      for( auto& item : op.history )
+      {
+         item.second = next_sequence( item.first );
+         _last_sequences[ item.first ] = item.second;
+      }
+
+   _pending.push_back( std::move( _current ) );
+   _current = pending_block();
+
+   if( _pending.front().block_num <= last_irreversible_block )
+      write( last_irreversible_block );
+}
+
+void account_history_store::commit( uint32_t block_num )
+{
+   std::lock_guard< std::mutex > guard( _mutex );
+   if( _pending.size() && _pending.front().block_num <= block_num )
+      write( block_num );
+}
+
+void account_history_store::truncate( uint32_t block_num )
+{
+   std::lock_guard< std::mutex > guard( _mutex );
+
+   _applying_block = false;
+   while( _pending.size() && _pending.back().block_num > block_num )
+      _pending.pop_back();
+
+   if( _last_written_block > block_num )
+   {
+      wlog( "Removing account history after block ${b}", ("b", block_num) );
+
+      SQLite::Transaction transaction( *_db );
+
+      SQLite::Statement first_op( *_db, "SELECT MIN( id ) FROM operations WHERE block > ?" );
+      first_op.bind( 1, int64_t( block_num ) );
+      if( first_op.executeStep() && !first_op.getColumn( 0 ).isNull() )
+      {
+         SQLite::Statement remove_history( *_db, "DELETE FROM account_history WHERE operation >= ?" );
+         remove_history.bind( 1, first_op.getColumn( 0 ).getInt64() );
+         remove_history.exec();
+      }
+
+      SQLite::Statement remove_ops( *_db, "DELETE FROM operations WHERE block > ?" );
+      remove_ops.bind( 1, int64_t( block_num ) );
+      remove_ops.exec();
+
+      set_last_written_block( block_num );
+      transaction.commit();
+   }
+
+   rebuild_last_sequences();
+}
+
+uint32_t account_history_store::last_written_block()const
+{
+   std::lock_guard< std::mutex > guard( _mutex );
+   return _last_written_block;
+}
+
+uint32_t account_history_store::next_sequence( const account_name_type& account )
+{
+   auto itr = _last_sequences.find( account );
+   if( itr != _last_sequences.end() )
+      return itr->second + 1;
+
+   _select_last_sequence->bind( 1, std::string( account ) );
+   uint32_t last = 0;
+   if( _select_last_sequence->executeStep() && !_select_last_sequence->getColumn( 0 ).isNull() )
+      last = _select_last_sequence->getColumn( 0 ).getInt64();
+   _select_last_sequence->reset();
+   return last + 1;
+}
+
+void account_history_store::rebuild_last_sequences()
+{
+   _last_sequences.clear();
+   for( const auto& block : _pending )
+      for( const auto& op : block.operations )
+         for( const auto& item : op.history )
+            _last_sequences[ item.first ] = item.second;
+}
+
+void account_history_store::write( uint32_t last_irreversible_block )
+{
+   SQLite::Transaction transaction( *_db );
+
+   // Blocks are dropped from memory only once the transaction is committed
+   size_t blocks = 0;
+   uint32_t written = _last_written_block;
+   for( ; blocks < _pending.size() && _pending[ blocks ].block_num <= last_irreversible_block; ++blocks )
+   {
+      const auto& block = _pending[ blocks ];
+      for( const auto& pending : block.operations )
+      {
+         const auto& op = pending.op;
+         _insert_operation->bind( 1, int64_t( op.block ) );
+         _insert_operation->bind( 2, int64_t( op.trx_in_block ) );
+         _insert_operation->bind( 3, int64_t( op.op_in_trx ) );
+         _insert_operation->bind( 4, int64_t( op.virtual_op ) );
+         if( op.trx_id != transaction_id_type() )
+            _insert_operation->bindNoCopy( 5, op.trx_id.data(), op.trx_id.data_size() );
+         else
+            _insert_operation->bind( 5 );
+         _insert_operation->bind( 6, int64_t( op.timestamp.sec_since_epoch() ) );
+         _insert_operation->bind( 7, std::string( op.fee_payer ) );
+         _insert_operation->bindNoCopy( 8, op.serialized_op.data(), op.serialized_op.size() );
+         _insert_operation->exec();
+         _insert_operation->reset();
+
+         int64_t op_id = _db->getLastInsertRowid();
+         for( const auto& item : pending.history )
+         {
+            _insert_history->bind( 1, std::string( item.first ) );
+            _insert_history->bind( 2, int64_t( item.second ) );
+            _insert_history->bind( 3, op_id );
+            _insert_history->exec();
+            _insert_history->reset();
+         }
+      }
+
+      written = block.block_num;
+   }
+
+   set_last_written_block( written );
+   transaction.commit();
+
+   _pending.erase( _pending.begin(), _pending.begin() + blocks );
+   rebuild_last_sequences();
+}
+
+void account_history_store::set_last_written_block( uint32_t block_num )
+{
+   SQLite::Statement update( *_db, "INSERT OR REPLACE INTO properties( name, value ) VALUES( 'last_block', ? )" );
+   update.bind( 1, int64_t( block_num ) );
+   update.exec();
+   _last_written_block = block_num;
+}
+
+std::vector< stored_operation > account_history_store::get_ops_in_block( uint32_t block_num )const
+{
+   std::lock_guard< std::mutex > guard( _mutex );
+   std::vector< stored_operation > result;
+
+   if( block_num > _last_written_block )
+   {
+      for( const auto& block : _pending )
+         if( block.block_num == block_num )
+            for( const auto& pending : block.operations )
+               result.push_back( pending.op );
+      return result;
+   }
+
+   SQLite::Statement query( *_db, std::string( "SELECT " ) + detail::operation_columns +
+      " FROM operations o WHERE o.block = ? ORDER BY o.id" );
+   query.bind( 1, int64_t( block_num ) );
+   while( query.executeStep() )
+      result.push_back( detail::read_operation( query, 0 ) );
+
+   return result;
+}
+
+std::optional< stored_operation > account_history_store::find_transaction( const transaction_id_type& id )const
+{
+   std::lock_guard< std::mutex > guard( _mutex );
+
+   for( const auto& block : _pending )
+      for( const auto& pending : block.operations )
+         if( pending.op.trx_id == id )
+            return pending.op;
+
+   SQLite::Statement query( *_db, std::string( "SELECT " ) + detail::operation_columns +
+      " FROM operations o WHERE o.trx_id = ? ORDER BY o.id LIMIT 1" );
+   query.bindNoCopy( 1, id.data(), id.data_size() );
+   if( query.executeStep() )
+      return detail::read_operation( query, 0 );
+
+   return std::nullopt;
+}
+
+std::map< uint32_t, stored_operation > account_history_store::get_history_before( const account_name_type& account, int64_t start, uint32_t limit )const
+{
+   std::lock_guard< std::mutex > guard( _mutex );
+   std::map< uint32_t, stored_operation > result;
+   uint32_t last = start < 0 || start > int64_t( uint32_t( -1 ) ) ? uint32_t( -1 ) : uint32_t( start );
+
+   // Reversible blocks hold the latest entries
+   for( auto block = _pending.rbegin(); block != _pending.rend() && result.size() < limit; ++block )
+      for( auto pending = block->operations.rbegin(); pending != block->operations.rend() && result.size() < limit; ++pending )
+         for( const auto& item : pending->history )
+            if( item.first == account && item.second <= last )
+               result[ item.second ] = pending->op;
+
+   if( result.size() >= limit )
+      return result;
+
+   SQLite::Statement query( *_db, std::string( "SELECT h.sequence, " ) + detail::operation_columns +
+      " FROM account_history h JOIN operations o ON o.id = h.operation"
+      " WHERE h.account = ? AND h.sequence <= ? ORDER BY h.sequence DESC LIMIT ?" );
+   query.bind( 1, std::string( account ) );
+   query.bind( 2, int64_t( last ) );
+   query.bind( 3, int64_t( limit - result.size() ) );
+   while( query.executeStep() )
+      result[ query.getColumn( 0 ).getInt64() ] = detail::read_operation( query, 1 );
+
+   return result;
+}
+
+std::map< uint32_t, stored_operation > account_history_store::get_history_after( const account_name_type& account, uint32_t start, uint32_t limit )const
+{
+   std::lock_guard< std::mutex > guard( _mutex );
+   std::map< uint32_t, stored_operation > result;
+
+   SQLite::Statement query( *_db, std::string( "SELECT h.sequence, " ) + detail::operation_columns +
+      " FROM account_history h JOIN operations o ON o.id = h.operation"
+      " WHERE h.account = ? AND h.sequence >= ? ORDER BY h.sequence LIMIT ?" );
+   query.bind( 1, std::string( account ) );
+   query.bind( 2, int64_t( start ) );
+   query.bind( 3, int64_t( limit ) );
+   while( query.executeStep() )
+      result[ query.getColumn( 0 ).getInt64() ] = detail::read_operation( query, 1 );
+
+   for( auto block = _pending.begin(); block != _pending.end() && result.size() < limit; ++block )
+      for( auto pending = block->operations.begin(); pending != block->operations.end() && result.size() < limit; ++pending )
+         for( const auto& item : pending->history )
+            if( item.first == account && item.second >= start )
+               result[ item.second ] = pending->op;
+
+   return result;
+}
+
+} } } // sophiatx::plugins::account_history
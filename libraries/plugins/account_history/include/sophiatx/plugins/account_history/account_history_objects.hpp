@@ -0,0 +1,110 @@
+#pragma once
+#include <sophiatx/chain/sophiatx_object_types.hpp>
+
+#include <boost/multi_index/composite_key.hpp>
+
+namespace sophiatx { namespace plugins { namespace account_history {
+
+using namespace std;
+using namespace sophiatx::chain;
+
+//
+// Plugins should #define their SPACE_ID's so plugins with
+// conflicting SPACE_ID assignments can be compiled into the
+// same binary (by simply re-assigning some of the conflicting #defined
+// SPACE_ID's in a build script).
+//
+// Assignment of SPACE_ID's cannot be done at run-time because
+// various template automagic depends on them being known at compile
+// time.
+//
+#ifndef SOPHIATX_ACCOUNT_HISTORY_SPACE_ID
+#define SOPHIATX_ACCOUNT_HISTORY_SPACE_ID 5
+#endif
+
+enum account_history_object_types
+{
+   account_history_prune_state_object_type   = ( SOPHIATX_ACCOUNT_HISTORY_SPACE_ID << 8 )    ,
+   account_history_prune_account_object_type = ( SOPHIATX_ACCOUNT_HISTORY_SPACE_ID << 8 ) + 1,
+};
+
+/// Totals of the account history trimming passes
+struct account_history_prune_stats
+{
+   uint64_t passes = 0;
+   uint64_t history_entries = 0;
+   uint64_t operations = 0;
+   /// Approximate shared memory released by the removed objects, without the overhead of their indexes
+   uint64_t bytes = 0;
+   uint32_t last_block = 0;
+   uint64_t last_duration_us = 0;
+};
+
+/**
+ * Where the sweep for unreferenced operations continues and the totals of the trimming passes. Passes run as part of
+ * a block, keeping their progress in chainbase undoes it together with the removals when the block is popped.
+ */
+class account_history_prune_state_object : public object< account_history_prune_state_object_type, account_history_prune_state_object >
+{
+   public:
+      template< typename Constructor, typename Allocator >
+      account_history_prune_state_object( Constructor&& c, allocator< Allocator > a )
+      {
+         c( *this );
+      }
+
+      id_type                       id;
+
+      operation_id_type             sweep_cursor;
+      account_history_prune_stats   stats;
+};
+
+/// Account with new history entries since the last trimming pass
+class account_history_prune_account_object : public object< account_history_prune_account_object_type, account_history_prune_account_object >
+{
+   public:
+      template< typename Constructor, typename Allocator >
+      account_history_prune_account_object( Constructor&& c, allocator< Allocator > a )
+      {
+         c( *this );
+      }
+
+      id_type                       id;
+
+      account_name_type             account;
+};
+
+typedef account_history_prune_state_object::id_type account_history_prune_state_id_type;
+typedef account_history_prune_account_object::id_type account_history_prune_account_id_type;
+
+using namespace boost::multi_index;
+
+struct by_account;
+
+typedef multi_index_container<
+   account_history_prune_state_object,
+   indexed_by<
+      ordered_unique< tag< by_id >, member< account_history_prune_state_object, account_history_prune_state_id_type, &account_history_prune_state_object::id > >
+   >,
+   allocator< account_history_prune_state_object >
+> account_history_prune_state_index;
+
+typedef multi_index_container<
+   account_history_prune_account_object,
+   indexed_by<
+      ordered_unique< tag< by_id >, member< account_history_prune_account_object, account_history_prune_account_id_type, &account_history_prune_account_object::id > >,
+      ordered_unique< tag< by_account >, member< account_history_prune_account_object, account_name_type, &account_history_prune_account_object::account > >
+   >,
+   allocator< account_history_prune_account_object >
+> account_history_prune_account_index;
+
+} } } // sophiatx::plugins::account_history
+
+FC_REFLECT( sophiatx::plugins::account_history::account_history_prune_stats,
+   (passes)(history_entries)(operations)(bytes)(last_block)(last_duration_us) )
+
+FC_REFLECT( sophiatx::plugins::account_history::account_history_prune_state_object, (id)(sweep_cursor)(stats) )
+CHAINBASE_SET_INDEX_TYPE( sophiatx::plugins::account_history::account_history_prune_state_object, sophiatx::plugins::account_history::account_history_prune_state_index )
+
+FC_REFLECT( sophiatx::plugins::account_history::account_history_prune_account_object, (id)(account) )
+CHAINBASE_SET_INDEX_TYPE( sophiatx::plugins::account_history::account_history_prune_account_object, sophiatx::plugins::account_history::account_history_prune_account_index )
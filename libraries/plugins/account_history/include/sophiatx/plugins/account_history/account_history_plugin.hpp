@@ -1,5 +1,6 @@
 #pragma once
 #include <sophiatx/plugins/chain/chain_plugin.hpp>
+#include <sophiatx/plugins/account_history/account_history_objects.hpp>
 
 #define SOPHIATX_ACCOUNT_HISTORY_PLUGIN_NAME "account_history"
 
@@ -7,23 +8,11 @@ namespace sophiatx { namespace plugins { namespace account_history {
 
 namespace detail { class account_history_plugin_impl; }
 
+class account_history_store;
+
 using namespace appbase;
 using sophiatx::protocol::account_name_type;
 
-//
-// Plugins should #define their SPACE_ID's so plugins with
-// conflicting SPACE_ID assignments can be compiled into the
-// same binary (by simply re-assigning some of the conflicting #defined
-// SPACE_ID's in a build script).
-//
-// Assignment of SPACE_ID's cannot be done at run-time because
-// various template automagic depends on them being known at compile
-// time.
-//
-#ifndef SOPHIATX_ACCOUNT_HISTORY_SPACE_ID
-#define SOPHIATX_ACCOUNT_HISTORY_SPACE_ID 5
-#endif
-
 /**
  *  This plugin is designed to track a range of operations by account so that one node
  *  doesn't need to hold the full operation history in memory.
@@ -47,9 +36,17 @@ class account_history_plugin : public plugin< account_history_plugin >
 
       flat_map< account_name_type, account_name_type > tracked_accounts()const; /// map start_range to end_range
 
+      /// Store of the history when it is not kept in chainbase, null otherwise
+      std::shared_ptr< account_history_store > store()const;
+
+      /// True when trimming passes remove operations of irreversible blocks from chainbase
+      bool prunes_operations()const;
+
+      /// Totals of the trimming passes applied to the state, the caller holds the read lock
+      account_history_prune_stats get_prune_stats()const;
+
    private:
       std::unique_ptr< detail::account_history_plugin_impl > my;
 };
 
 } } } //sophiatx::plugins::account_history
-
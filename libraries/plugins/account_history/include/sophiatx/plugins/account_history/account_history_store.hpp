@@ -0,0 +1,117 @@
+#pragma once
+
+#include <sophiatx/protocol/types.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace SQLite { class Database; class Statement; }
+
+namespace sophiatx { namespace chain { struct operation_notification; } }
+
+namespace sophiatx { namespace plugins { namespace account_history {
+
+using sophiatx::protocol::account_name_type;
+using sophiatx::protocol::transaction_id_type;
+
+/// Operation as kept by the account history store
+struct stored_operation
+{
+   transaction_id_type  trx_id;
+   uint32_t             block = 0;
+   uint32_t             trx_in_block = 0;
+   uint16_t             op_in_trx = 0;
+   uint64_t             virtual_op = 0;
+   fc::time_point_sec   timestamp;
+   std::vector< char >  serialized_op;
+   account_name_type    fee_payer;
+};
+
+/**
+ * Account history kept in an SQLite database on disk instead of the chainbase shared memory file.
+ *
+ * Operations of a block are collected while it is applied and kept in memory as long as the block is reversible.
+ * Blocks which became irreversible are written to the database in one transaction, so the database never has to be
+ * rewound. A block of a fork replaces the reversible blocks from its number up. Queries merge the written history
+ * with the reversible blocks.
+ *
+ * The store is synchronized with its own mutex, readers do not need the chain database lock.
+ */
+class account_history_store
+{
+   public:
+      explicit account_history_store( const fc::path& file );
+      ~account_history_store();
+
+      /// Starts collecting the operations of a block, operations pushed outside of a block are ignored
+      void begin_block( uint32_t block_num );
+
+      /// Adds an operation of the block being applied to the history of the accounts
+      void push_operation( const chain::operation_notification& note, fc::time_point_sec timestamp,
+                           std::vector< account_name_type > accounts );
+
+      /// Ends the block started by begin_block() and writes all blocks up to last_irreversible_block
+      void end_block( uint32_t block_num, uint32_t last_irreversible_block );
+
+      /// Writes the reversible blocks up to block_num, used when blocks are applied without undo history
+      void commit( uint32_t block_num );
+
+      /// Removes the history of the blocks after block_num
+      void truncate( uint32_t block_num );
+
+      /// Number of the last block written to the database
+      uint32_t last_written_block()const;
+
+      std::vector< stored_operation > get_ops_in_block( uint32_t block_num )const;
+
+      /// First operation of the transaction
+      std::optional< stored_operation > find_transaction( const transaction_id_type& id )const;
+
+      /// Up to limit entries of the account's history with a sequence of at most start, the latest ones if start is negative
+      std::map< uint32_t, stored_operation > get_history_before( const account_name_type& account, int64_t start, uint32_t limit )const;
+
+      /// Up to limit entries of the account's history with a sequence of at least start
+      std::map< uint32_t, stored_operation > get_history_after( const account_name_type& account, uint32_t start, uint32_t limit )const;
+
+   private:
+      struct pending_operation
+      {
+         stored_operation                                            op;
+         /// Accounts whose history the operation is added to, with the operation's sequence in each of them
+         std::vector< std::pair< account_name_type, uint32_t > >    history;
+      };
+
+      struct pending_block
+      {
+         uint32_t                         block_num = 0;
+         std::vector< pending_operation > operations;
+      };
+
+      uint32_t next_sequence( const account_name_type& account );
+      void rebuild_last_sequences();
+      void write( uint32_t last_irreversible_block );
+      void set_last_written_block( uint32_t block_num );
+
+      mutable std::mutex                                 _mutex;
+      std::unique_ptr< SQLite::Database >                _db;
+      std::unique_ptr< SQLite::Statement >               _insert_operation;
+      std::unique_ptr< SQLite::Statement >               _insert_history;
+      std::unique_ptr< SQLite::Statement >               _select_last_sequence;
+      uint32_t                                           _last_written_block = 0;
+
+      bool                                               _applying_block = false;
+      pending_block                                      _current;
+      /// Reversible blocks, in the order they were applied
+      std::deque< pending_block >                        _pending;
+      /// Last sequence of the accounts with operations in reversible blocks
+      std::map< account_name_type, uint32_t >            _last_sequences;
+};
+
+} } } // sophiatx::plugins::account_history
@@ -12,19 +12,38 @@ namespace detail {
 class account_history_api_impl
 {
    public:
-      account_history_api_impl() : _db( appbase::app().get_plugin< sophiatx::plugins::chain::chain_plugin >().db() ) {}
+      account_history_api_impl() :
+         _db( appbase::app().get_plugin< sophiatx::plugins::chain::chain_plugin >().db() ),
+         _store( appbase::app().get_plugin< sophiatx::plugins::account_history::account_history_plugin >().store() ),
+         _pruned( appbase::app().get_plugin< sophiatx::plugins::account_history::account_history_plugin >().prunes_operations() ) {}
 
       DECLARE_API_IMPL(
          (get_ops_in_block)
          (get_transaction)
          (get_account_history)
+         (get_prune_stats)
       )
 
+#ifdef SOPHIATX_ACCOUNT_HISTORY_STORE
+      get_ops_in_block_return get_ops_in_block_from_store( const get_ops_in_block_args& args );
+      get_transaction_return get_transaction_from_store( const get_transaction_args& args );
+      get_account_history_return get_account_history_from_store( const get_account_history_args& args );
+#endif
+
       std::shared_ptr<chain::database_interface> _db;
+      /// Set when the history is not kept in chainbase
+      std::shared_ptr<account_history_store>     _store;
+      /// Set when operations of irreversible blocks are removed from chainbase, their results are not cached then
+      bool                                       _pruned = false;
 };
 
 DEFINE_API_IMPL( account_history_api_impl, get_ops_in_block )
 {
+#ifdef SOPHIATX_ACCOUNT_HISTORY_STORE
+   if( _store )
+      return get_ops_in_block_from_store( args );
+#endif
+
    const auto& idx = _db->get_index< chain::operation_index, chain::by_location >();
    auto itr = idx.lower_bound( args.block_num );
    get_ops_in_block_return result;
@@ -35,6 +54,11 @@ DEFINE_API_IMPL( account_history_api_impl, get_ops_in_block )
          result.ops.push_back( temp );
       ++itr;
    }
+
+   // Operations of irreversible blocks only change when they are pruned
+   if( !_pruned && args.block_num <= _db->last_non_undoable_block_num() )
+      json_rpc::response_cache::admit();
+
    return result;
 }
 
@@ -44,6 +68,11 @@ DEFINE_API_IMPL( account_history_api_impl, get_transaction )
    FC_ASSERT( false, "This node's operator has disabled operation indexing by transaction_id" );
 #else
    FC_ASSERT( args.id != sophiatx::protocol::transaction_id_type(), "Invalid id parameter" );
+#ifdef SOPHIATX_ACCOUNT_HISTORY_STORE
+   if( _store )
+      return get_transaction_from_store( args );
+#endif
+
    const auto& idx = _db->get_index< chain::operation_index, chain::by_transaction_id >();
    auto itr = idx.lower_bound( args.id );
    if( itr != idx.end() && itr->trx_id == args.id )
@@ -54,6 +83,10 @@ DEFINE_API_IMPL( account_history_api_impl, get_transaction )
       get_transaction_return result = blk->transactions[itr->trx_in_block];
       result.block_num       = itr->block;
       result.transaction_num = itr->trx_in_block;
+
+      if( !_pruned && itr->block <= _db->last_non_undoable_block_num() )
+         json_rpc::response_cache::admit();
+
       return result;
    }
    FC_ASSERT( false, "Unknown Transaction ${t}", ("t",args.id) );
@@ -65,6 +98,11 @@ DEFINE_API_IMPL( account_history_api_impl, get_account_history )
    FC_ASSERT( args.limit <= 10000, "limit of ${l} is greater than maxmimum allowed", ("l",args.limit) );
    FC_ASSERT( args.reverse_order || args.start >= args.limit, "start must be greater than limit" );
 
+#ifdef SOPHIATX_ACCOUNT_HISTORY_STORE
+   if( _store )
+      return get_account_history_from_store( args );
+#endif
+
    const auto& idx = _db->get_index< chain::account_history_index, chain::by_account >();
    get_account_history_return result;
 
@@ -106,11 +144,71 @@ DEFINE_API_IMPL( account_history_api_impl, get_account_history )
 
 }
 
+DEFINE_API_IMPL( account_history_api_impl, get_prune_stats )
+{
+   return appbase::app().get_plugin< sophiatx::plugins::account_history::account_history_plugin >().get_prune_stats();
+}
+
+#ifdef SOPHIATX_ACCOUNT_HISTORY_STORE
+get_ops_in_block_return account_history_api_impl::get_ops_in_block_from_store( const get_ops_in_block_args& args )
+{
+   get_ops_in_block_return result;
+   for( const auto& stored : _store->get_ops_in_block( args.block_num ) )
+   {
+      api_operation_object temp = stored;
+      if( !args.only_virtual || is_virtual_operation( temp.op ) )
+         result.ops.push_back( std::move( temp ) );
+   }
+
+   if( args.block_num <= _db->last_non_undoable_block_num() )
+      json_rpc::response_cache::admit();
+
+   return result;
+}
+
+get_transaction_return account_history_api_impl::get_transaction_from_store( const get_transaction_args& args )
+{
+   auto op = _store->find_transaction( args.id );
+   FC_ASSERT( op.has_value(), "Unknown Transaction ${t}", ("t",args.id) );
+
+   auto blk = _db->fetch_block_by_number( op->block );
+   FC_ASSERT( blk.has_value() );
+   FC_ASSERT( blk->transactions.size() > op->trx_in_block );
+   get_transaction_return result = blk->transactions[op->trx_in_block];
+   result.block_num       = op->block;
+   result.transaction_num = op->trx_in_block;
+
+   if( op->block <= _db->last_non_undoable_block_num() )
+      json_rpc::response_cache::admit();
+
+   return result;
+}
+
+get_account_history_return account_history_api_impl::get_account_history_from_store( const get_account_history_args& args )
+{
+   get_account_history_return result;
+
+   // Reverse order pages forward from start, otherwise pages backward from start or from the latest entry
+   auto history = args.reverse_order && args.start >= 0 ?
+      _store->get_history_after( args.account, args.start, args.limit ) :
+      _store->get_history_before( args.account, args.reverse_order ? -1 : args.start, args.limit );
+
+   for( const auto& item : history )
+      result.history.emplace( item.first, item.second );
+
+   return result;
+}
+#endif
+
 } // detail
 
 account_history_api::account_history_api(): my( new detail::account_history_api_impl() )
 {
    JSON_RPC_REGISTER_API( SOPHIATX_ACCOUNT_HISTORY_API_PLUGIN_NAME );
+
+   auto& json_rpc = appbase::app().get_plugin< sophiatx::plugins::json_rpc::json_rpc_plugin >();
+   json_rpc.add_cached_method( SOPHIATX_ACCOUNT_HISTORY_API_PLUGIN_NAME, "get_ops_in_block" );
+   json_rpc.add_cached_method( SOPHIATX_ACCOUNT_HISTORY_API_PLUGIN_NAME, "get_transaction" );
 }
 
 account_history_api::~account_history_api() {}
@@ -119,6 +217,7 @@ DEFINE_READ_APIS( account_history_api,
    (get_ops_in_block)
    (get_transaction)
    (get_account_history)
+   (get_prune_stats)
 )
 
 } } } // sophiatx::plugins::account_history
@@ -17,6 +17,7 @@ class account_history_api
          (get_ops_in_block)
          (get_transaction)
          (get_account_history)
+         (get_prune_stats)
       )
 
    private:
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <sophiatx/plugins/account_history_api/account_history_objects.hpp>
+#include <sophiatx/plugins/account_history/account_history_plugin.hpp>
+#include <sophiatx/plugins/json_rpc/utility.hpp>
 #include <sophiatx/protocol/types.hpp>
 #include <sophiatx/protocol/transaction.hpp>
 
@@ -40,6 +42,11 @@ struct get_account_history_return
 };
 
 
+typedef json_rpc::void_type get_prune_stats_args;
+
+typedef account_history_prune_stats get_prune_stats_return;
+
+
 } } } // sophiatx::plugins::account_history
 
 FC_REFLECT( sophiatx::plugins::account_history::get_ops_in_block_args,
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <sophiatx/chain/history_object.hpp>
+#include <sophiatx/plugins/account_history/account_history_store.hpp>
 #include <sophiatx/protocol/operations.hpp>
 
 namespace sophiatx { namespace plugins { namespace account_history {
@@ -19,6 +20,18 @@ struct api_operation_object
       op = fc::raw::unpack_from_buffer< sophiatx::protocol::operation >( op_obj.serialized_op, 0 );
    }
 
+   api_operation_object( const stored_operation& stored ) :
+      trx_id( stored.trx_id ),
+      block( stored.block ),
+      trx_in_block( stored.trx_in_block ),
+      op_in_trx( stored.op_in_trx ),
+      virtual_op( stored.virtual_op ),
+      timestamp( stored.timestamp ),
+      fee_payer( stored.fee_payer )
+   {
+      op = fc::raw::unpack_from_vector< sophiatx::protocol::operation >( stored.serialized_op, 0 );
+   }
+
    sophiatx::protocol::transaction_id_type trx_id;
    uint32_t                               block = 0;
    uint32_t                               trx_in_block = 0;
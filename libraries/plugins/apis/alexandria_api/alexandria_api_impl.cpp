@@ -1,6 +1,7 @@
 
 #include <sophiatx/plugins/alexandria_api/alexandria_api_impl.hpp>
 #include <sophiatx/plugins/alexandria_api/alexandria_api_objects.hpp>
+#include <sophiatx/plugins/alexandria_api/chain_snapshot.hpp>
 #include <sophiatx/plugins/chain/chain_plugin.hpp>
 #include <sophiatx/utilities/key_conversion.hpp>
 #include <sophiatx/utilities/git_revision.hpp>
@@ -148,22 +149,25 @@ DEFINE_API_IMPL(alexandria_api_impl, info)
 {
    checkApiEnabled(_database_api);
 
-   auto dynamic_props = _database_api->get_dynamic_global_properties( {} );
+   // All parts of the info are read from the same state, each chain object once
+   chain_snapshot snapshot( *_db );
+   const auto& dynamic_props = snapshot.dynamic_global_properties();
+   const auto& schedule = snapshot.witness_schedule();
    fc::mutable_variant_object info_data(fc::variant(dynamic_props).get_object());
 
-   info_data["witness_majority_version"] = std::string( _database_api->get_witness_schedule( {} ).majority_version );
-   info_data["hardfork_version"] = std::string( _database_api->get_hardfork_properties( {} ).current_hardfork_version );
+   info_data["witness_majority_version"] = std::string( schedule.majority_version );
+   info_data["hardfork_version"] = std::string( snapshot.hardfork_properties().current_hardfork_version );
    //info_data["head_block_id"] = dynamic_props.head_block_id;
    info_data["head_block_age"] = fc::get_approximate_relative_time_string(dynamic_props.time,
                                                                        time_point_sec(time_point::now()),
                                                                        " old");
    info_data["participation"] = (100*dynamic_props.recent_slots_filled.popcount()) / 128.0;
-   info_data["median_sbd1_price"] = _database_api->get_current_price_feed( { SBD1_SYMBOL } );
-   info_data["median_sbd2_price"] = _database_api->get_current_price_feed( { SBD2_SYMBOL } );
-   info_data["median_sbd3_price"] = _database_api->get_current_price_feed( { SBD3_SYMBOL } );
-   info_data["median_sbd4_price"] = _database_api->get_current_price_feed( { SBD4_SYMBOL } );
-   info_data["median_sbd5_price"] = _database_api->get_current_price_feed( { SBD5_SYMBOL } );
-   info_data["account_creation_fee"] = _database_api->get_witness_schedule( {} ).median_props.account_creation_fee;
+   info_data["median_sbd1_price"] = snapshot.feed_history( SBD1_SYMBOL ).current_median_history;
+   info_data["median_sbd2_price"] = snapshot.feed_history( SBD2_SYMBOL ).current_median_history;
+   info_data["median_sbd3_price"] = snapshot.feed_history( SBD3_SYMBOL ).current_median_history;
+   info_data["median_sbd4_price"] = snapshot.feed_history( SBD4_SYMBOL ).current_median_history;
+   info_data["median_sbd5_price"] = snapshot.feed_history( SBD5_SYMBOL ).current_median_history;
+   info_data["account_creation_fee"] = schedule.median_props.account_creation_fee;
 
    info_return result;
    result.info = std::move(info_data);
@@ -320,7 +324,7 @@ DEFINE_API_IMPL(alexandria_api_impl, create_account)
    op.active = authority( 1, args.active, 1 );
    op.memo_key = args.memo;
    op.json_metadata = args.json_meta;
-   op.fee = _database_api->get_witness_schedule( {} ).median_props.account_creation_fee * asset( 1, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") );
+   op.fee = chain_snapshot( *_db ).witness_schedule().median_props.account_creation_fee * asset( 1, chain::sophiatx_config::params().symbol );
 
    create_account_return result;
    result.op = std::move(op);
@@ -536,7 +540,7 @@ DEFINE_API_IMPL(alexandria_api_impl, get_accounts) {
    }
 
    get_accounts_return result;
-   result.accounts = accounts;
+   result.accounts = std::move(accounts);
 
    return result;
 }
@@ -764,7 +768,7 @@ DEFINE_API_IMPL(alexandria_api_impl, create_transaction)
      result_type operator()( base_operation& bop){
         if(bop.has_special_fee())
            return;
-        asset req_fee = bop.get_required_fee(chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"));
+        asset req_fee = bop.get_required_fee(chain::sophiatx_config::params().symbol);
         bop.fee = req_fee;
      };
    };
@@ -777,7 +781,7 @@ DEFINE_API_IMPL(alexandria_api_impl, create_transaction)
       tx.operations.push_back(op);
    }
 
-   auto dyn_props = _database_api->get_dynamic_global_properties( {} );
+   const auto& dyn_props = _db->get_dynamic_global_properties();
 
    tx.set_reference_block( dyn_props.head_block_id );
    tx.set_expiration( dyn_props.time + fc::seconds(_tx_expiration_seconds) );
@@ -801,7 +805,7 @@ DEFINE_API_IMPL(alexandria_api_impl, create_simple_transaction)
      result_type operator()( base_operation& bop){
         if(bop.has_special_fee())
            return;
-        asset req_fee = bop.get_required_fee(chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"));
+        asset req_fee = bop.get_required_fee(chain::sophiatx_config::params().symbol);
         bop.fee = req_fee;
      };
    };
@@ -811,7 +815,7 @@ DEFINE_API_IMPL(alexandria_api_impl, create_simple_transaction)
    op.visit(op_v);
    tx.operations.push_back(op);
 
-   auto dyn_props = _database_api->get_dynamic_global_properties( {} );
+   const auto& dyn_props = _db->get_dynamic_global_properties();
 
    tx.set_reference_block( dyn_props.head_block_id );
    tx.set_expiration( dyn_props.time + fc::seconds(_tx_expiration_seconds) );
@@ -1256,7 +1260,7 @@ DEFINE_API_IMPL(alexandria_api_impl, calculate_fee)
    checkApiEnabled(_database_api);
 
    calculate_fee_return result;
-   api_chain_properties props = _database_api->get_witness_schedule( {} ).median_props;
+   api_chain_properties props = chain_snapshot( *_db ).witness_schedule().median_props;
    
    if(args.op.which() == operation::tag<account_create_operation>::value){
       result.fee = props.account_creation_fee;
@@ -1270,7 +1274,7 @@ DEFINE_API_IMPL(alexandria_api_impl, calculate_fee)
       typedef asset result_type;
       result_type operator()(const base_operation& bop){
          if(bop.has_special_fee())
-            return asset(0, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"));
+            return asset(0, chain::sophiatx_config::params().symbol);
          asset req_fee = bop.get_required_fee(symbol);
          FC_ASSERT(symbol == req_fee.symbol, "fee cannot be paid in with symbol ${s}", ("s", bop.fee.symbol));
          return req_fee;
@@ -1280,8 +1284,8 @@ DEFINE_API_IMPL(alexandria_api_impl, calculate_fee)
 
    result.fee = args.op.visit(op_v);
    //check if the symbol has current price feed
-   FC_ASSERT(result.fee.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") ||
-           fiat_to_sphtx( { result.fee } ).sphtx.symbol == chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"),
+   FC_ASSERT(result.fee.symbol == chain::sophiatx_config::params().symbol ||
+           fiat_to_sphtx( { result.fee } ).sphtx.symbol == chain::sophiatx_config::params().symbol,
                    "no current feed for this symbol");
 
    return result;
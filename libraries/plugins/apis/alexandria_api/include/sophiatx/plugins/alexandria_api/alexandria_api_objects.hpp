@@ -304,7 +304,7 @@ struct extended_dynamic_global_properties
 
 struct api_chain_properties
 {
-   api_chain_properties() : maximum_block_size(chain::sophiatx_config::get<uint32_t>("SOPHIATX_MIN_BLOCK_SIZE_LIMIT") * 2){}
+   api_chain_properties() : maximum_block_size(chain::sophiatx_config::params().min_block_size_limit * 2){}
    api_chain_properties( const chain::chain_properties& c ) :
          account_creation_fee( c.account_creation_fee ),
          maximum_block_size( c.maximum_block_size )
@@ -364,9 +364,9 @@ struct api_witness_object
 struct api_witness_schedule_object
 {
    api_witness_schedule_object() :
-           max_voted_witnesses( chain::sophiatx_config::get<uint8_t>("SOPHIATX_MAX_VOTED_WITNESSES_HF0") ),
-           max_runner_witnesses( chain::sophiatx_config::get<uint8_t>("SOPHIATX_MAX_RUNNER_WITNESSES_HF0") ),
-           hardfork_required_witnesses( chain::sophiatx_config::get<uint8_t>("SOPHIATX_HARDFORK_REQUIRED_WITNESSES") ){}
+           max_voted_witnesses( static_cast<uint8_t>(chain::sophiatx_config::params().max_voted_witnesses_hf0) ),
+           max_runner_witnesses( static_cast<uint8_t>(chain::sophiatx_config::params().max_runner_witnesses_hf0) ),
+           hardfork_required_witnesses( static_cast<uint8_t>(chain::sophiatx_config::params().hardfork_required_witnesses) ){}
    api_witness_schedule_object( const database_api::api_witness_schedule_object& w ) :
          id( w.id ),
          current_virtual_time( w.current_virtual_time ),
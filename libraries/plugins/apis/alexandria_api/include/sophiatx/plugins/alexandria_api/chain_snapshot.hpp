@@ -0,0 +1,66 @@
+#pragma once
+
+#include <sophiatx/chain/database/database_interface.hpp>
+#include <sophiatx/chain/global_property_object.hpp>
+#include <sophiatx/chain/hardfork_property_object.hpp>
+#include <sophiatx/chain/witness_objects.hpp>
+#include <sophiatx/chain/sophiatx_objects.hpp>
+
+#include <boost/container/flat_map.hpp>
+
+namespace sophiatx { namespace plugins { namespace alexandria_api {
+
+/**
+ * Chain objects read by one composite api call, each of them is looked up once and referenced afterwards.
+ *
+ * Read methods of facade apis run under the read lock taken by their public wrapper, so the referenced objects are
+ * consistent with each other and stay valid for the whole call. A snapshot must not outlive the call creating it.
+ */
+class chain_snapshot
+{
+   public:
+      explicit chain_snapshot( const chain::database_interface& db ) : _db( db ) {}
+
+      const chain::dynamic_global_property_object& dynamic_global_properties()
+      {
+         if( !_dynamic_global_properties )
+            _dynamic_global_properties = &_db.get_dynamic_global_properties();
+         return *_dynamic_global_properties;
+      }
+
+      const chain::witness_schedule_object& witness_schedule()
+      {
+         if( !_witness_schedule )
+            _witness_schedule = &_db.get< chain::witness_schedule_object >();
+         return *_witness_schedule;
+      }
+
+      const chain::hardfork_property_object& hardfork_properties()
+      {
+         if( !_hardfork_properties )
+            _hardfork_properties = &_db.get_hardfork_property_object();
+         return *_hardfork_properties;
+      }
+
+      const chain::feed_history_object& feed_history( protocol::asset_symbol_type symbol )
+      {
+         auto itr = _feed_histories.find( symbol );
+         if( itr != _feed_histories.end() )
+            return *itr->second;
+
+         const auto& idx = _db.get_index< chain::feed_history_index >().indices().get< chain::by_symbol >();
+         auto feed = idx.find( symbol );
+         FC_ASSERT( feed != idx.end(), "Symbol history not found" );
+         _feed_histories[ symbol ] = &*feed;
+         return *feed;
+      }
+
+   private:
+      const chain::database_interface&                                                             _db;
+      const chain::dynamic_global_property_object*                                                 _dynamic_global_properties = nullptr;
+      const chain::witness_schedule_object*                                                        _witness_schedule = nullptr;
+      const chain::hardfork_property_object*                                                       _hardfork_properties = nullptr;
+      boost::container::flat_map< protocol::asset_symbol_type, const chain::feed_history_object* > _feed_histories;
+};
+
+} } } // sophiatx::plugins::alexandria_api
@@ -2,6 +2,7 @@
 
 #include <sophiatx/plugins/block_api/block_api.hpp>
 #include <sophiatx/plugins/block_api/block_api_plugin.hpp>
+#include <sophiatx/plugins/json_rpc/json_rpc_plugin.hpp>
 
 #include <sophiatx/chain/get_config.hpp>
 
@@ -17,9 +18,11 @@ class block_api_impl
          (get_block_header)
          (get_block)
          (get_average_block_size)
+         (get_block_stats)
       )
 
    std::shared_ptr<chain::database_interface> _db;
+   block_stats::block_stats_plugin&           _block_stats;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -32,12 +35,17 @@ block_api::block_api()
    : my( new block_api_impl() )
 {
    JSON_RPC_REGISTER_API( SOPHIATX_BLOCK_API_PLUGIN_NAME );
+
+   auto& json_rpc = appbase::app().get_plugin< sophiatx::plugins::json_rpc::json_rpc_plugin >();
+   json_rpc.add_cached_method( SOPHIATX_BLOCK_API_PLUGIN_NAME, "get_block_header" );
+   json_rpc.add_cached_method( SOPHIATX_BLOCK_API_PLUGIN_NAME, "get_block" );
 }
 
 block_api::~block_api() {}
 
 block_api_impl::block_api_impl()
-   : _db( appbase::app().get_plugin< sophiatx::plugins::chain::chain_plugin >().db() ) {}
+   : _db( appbase::app().get_plugin< sophiatx::plugins::chain::chain_plugin >().db() ),
+     _block_stats( appbase::app().get_plugin< sophiatx::plugins::block_stats::block_stats_plugin >() ) {}
 
 block_api_impl::~block_api_impl() {}
 
@@ -53,8 +61,14 @@ DEFINE_API_IMPL( block_api_impl, get_block_header )
    auto block = _db->fetch_block_by_number( args.block_num );
 
    if( block )
+   {
       result.header = *block;
 
+      // Irreversible blocks never change
+      if( args.block_num <= _db->last_non_undoable_block_num() )
+         json_rpc::response_cache::admit();
+   }
+
    return result;
 }
 
@@ -64,25 +78,37 @@ DEFINE_API_IMPL( block_api_impl, get_block )
    auto block = _db->fetch_block_by_number( args.block_num );
 
    if( block )
+   {
       result.block = *block;
 
+      if( args.block_num <= _db->last_non_undoable_block_num() )
+         json_rpc::response_cache::admit();
+   }
+
    return result;
 }
 
 DEFINE_API_IMPL( block_api_impl, get_average_block_size )
 {
-   int64_t start = _db->head_block_num();
-   int64_t stop = start > 1000? start - 1000 : 0;
-   uint64_t total_size = 0;
-   for( int64_t i = start; i > stop; i-- )
-      total_size += fc::raw::pack_size( _db->fetch_block_by_number( i ) );
-   return total_size / (start - stop );
+   auto stats = _block_stats.get_stats( 1000 );
+   return stats.blocks ? stats.size / stats.blocks : 0;
+}
+
+DEFINE_API_IMPL( block_api_impl, get_block_stats )
+{
+   FC_ASSERT( args.blocks <= _block_stats.get_history_size(), "Statistics are kept for the last ${n} blocks", ("n", _block_stats.get_history_size()) );
+   return _block_stats.get_stats( args.blocks );
 }
 
 DEFINE_READ_APIS( block_api,
    (get_block_header)
    (get_block)
+)
+
+// Block statistics are maintained by the block_stats plugin under its own lock
+DEFINE_LOCKLESS_APIS( block_api,
    (get_average_block_size)
+   (get_block_stats)
 )
 
 } } } // sophiatx::plugins::block_api
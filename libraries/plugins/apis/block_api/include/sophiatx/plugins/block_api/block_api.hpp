@@ -40,6 +40,13 @@ class block_api
           * @brief Retrieve average size of last 1000 blocks
           */
          (get_average_block_size)
+
+         /**
+          * @brief Retrieve size, transaction, operation and fee totals of the most recent blocks
+          * @param blocks Number of blocks, at most block-stats-history
+          * @return totals of the blocks, empty if no block was applied yet
+          */
+         (get_block_stats)
       )
 
    private:
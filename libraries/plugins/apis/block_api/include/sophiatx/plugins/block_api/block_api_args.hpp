@@ -6,6 +6,7 @@
 #include <sophiatx/protocol/block_header.hpp>
 
 #include <sophiatx/plugins/json_rpc/utility.hpp>
+#include <sophiatx/plugins/block_stats/block_stats_plugin.hpp>
 
 namespace sophiatx { namespace plugins { namespace block_api {
 
@@ -36,6 +37,14 @@ typedef json_rpc::void_type get_average_block_size_args;
 
 typedef uint32_t get_average_block_size_return;
 
+/* get_block_stats */
+struct get_block_stats_args
+{
+   uint32_t blocks = 1200;
+};
+
+typedef block_stats::block_stats get_block_stats_return;
+
 
 } } } // sophiatx::block_api
 
@@ -51,3 +60,6 @@ FC_REFLECT( sophiatx::plugins::block_api::get_block_args,
 FC_REFLECT( sophiatx::plugins::block_api::get_block_return,
    (block) )
 
+FC_REFLECT( sophiatx::plugins::block_api::get_block_stats_args,
+   (blocks) )
+
@@ -1,5 +1,6 @@
 #pragma once
 #include <sophiatx/plugins/chain/chain_plugin.hpp>
+#include <sophiatx/plugins/block_stats/block_stats_plugin.hpp>
 #include <sophiatx/plugins/json_rpc/json_rpc_plugin.hpp>
 
 #include <appbase/application.hpp>
@@ -19,6 +20,7 @@ class block_api_plugin : public plugin< block_api_plugin >
       APPBASE_PLUGIN_REQUIRES(
          (sophiatx::plugins::json_rpc::json_rpc_plugin)
          (sophiatx::plugins::chain::chain_plugin)
+         (sophiatx::plugins::block_stats::block_stats_plugin)
       )
 
       static const std::string& name() { static std::string name = SOPHIATX_BLOCK_API_PLUGIN_NAME; return name; }
@@ -1,6 +1,9 @@
 #include <sophiatx/plugins/chain_api/chain_api_plugin.hpp>
 #include <sophiatx/plugins/chain_api/chain_api.hpp>
 
+#include <sophiatx/chain/database/database.hpp>
+#include <sophiatx/chain/database/hybrid_database.hpp>
+
 namespace sophiatx { namespace plugins { namespace chain {
 
 namespace detail {
@@ -12,7 +15,24 @@ class chain_api_impl
 
       DECLARE_API_IMPL(
          (push_block)
-         (push_transaction) )
+         (push_transaction)
+         (get_operation_profile)
+         (set_operation_profiling)
+         (get_write_queue_stats)
+         (get_sync_stats)
+         (get_signature_key_cache_stats) )
+
+      std::shared_ptr< sophiatx::chain::database > full_db( const char* feature )
+      {
+         auto db = std::dynamic_pointer_cast< sophiatx::chain::database >( _chain.db() );
+         FC_ASSERT( db, "${f} is only available on full nodes", ("f", feature) );
+         return db;
+      }
+
+      sophiatx::chain::operation_profiler& profiler()
+      {
+         return full_db( "Operation profiling" )->get_operation_profiler();
+      }
 
    private:
       chain_plugin& _chain;
@@ -72,6 +92,44 @@ DEFINE_API_IMPL( chain_api_impl, push_transaction )
    return result;
 }
 
+DEFINE_API_IMPL( chain_api_impl, get_operation_profile )
+{
+   get_operation_profile_return result;
+   result.enabled = profiler().enabled();
+   result.operations = profiler().get_stats();
+   return result;
+}
+
+DEFINE_API_IMPL( chain_api_impl, set_operation_profiling )
+{
+   if( args.reset )
+      profiler().reset();
+   profiler().set_enabled( args.enabled );
+   return set_operation_profiling_return();
+}
+
+DEFINE_API_IMPL( chain_api_impl, get_write_queue_stats )
+{
+   return _chain.get_write_queue_stats();
+}
+
+DEFINE_API_IMPL( chain_api_impl, get_sync_stats )
+{
+   auto db = std::dynamic_pointer_cast< sophiatx::chain::hybrid_database >( _chain.db() );
+   FC_ASSERT( db, "Synchronization stats are only available on light nodes" );
+   return db->get_sync_stats();
+}
+
+DEFINE_API_IMPL( chain_api_impl, get_signature_key_cache_stats )
+{
+   get_signature_key_cache_stats_return result;
+   auto stats = full_db( "Signature key cache" )->get_signature_key_cache_stats();
+   result.enabled = stats.has_value();
+   if( stats )
+      result.stats = *stats;
+   return result;
+}
+
 } // detail
 
 chain_api::chain_api(): my( new detail::chain_api_impl() )
@@ -84,6 +142,11 @@ chain_api::~chain_api() {}
 DEFINE_LOCKLESS_APIS( chain_api,
    (push_block)
    (push_transaction)
+   (get_operation_profile)
+   (set_operation_profiling)
+   (get_write_queue_stats)
+   (get_sync_stats)
+   (get_signature_key_cache_stats)
 )
 
 } } } //sophiatx::plugins::chain
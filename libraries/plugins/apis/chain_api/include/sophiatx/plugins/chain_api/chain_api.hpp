@@ -2,11 +2,16 @@
 #include <sophiatx/plugins/json_rpc/utility.hpp>
 
 #include <sophiatx/protocol/types.hpp>
+#include <sophiatx/protocol/signature_key_cache.hpp>
+#include <sophiatx/chain/operation_profiler.hpp>
+#include <sophiatx/chain/database/hybrid_database.hpp>
 
 #include <optional>
 
 namespace sophiatx { namespace plugins { namespace chain {
 
+using json_rpc::void_type;
+
 namespace detail { class chain_api_impl; }
 
 struct push_block_args
@@ -30,6 +35,38 @@ struct push_transaction_return
    optional<string>  error;
 };
 
+typedef void_type get_operation_profile_args;
+
+struct get_operation_profile_return
+{
+   bool                                                        enabled = false;
+   vector< sophiatx::chain::operation_profiler::operation_stats > operations;
+};
+
+struct set_operation_profiling_args
+{
+   bool enabled = false;
+   /// Drops the stats collected so far, e.g. to compare operation costs before and after a hardfork
+   bool reset = false;
+};
+
+typedef void_type set_operation_profiling_return;
+
+typedef void_type get_write_queue_stats_args;
+typedef write_queue_stats get_write_queue_stats_return;
+
+typedef void_type get_sync_stats_args;
+typedef sophiatx::chain::hybrid_sync_stats get_sync_stats_return;
+
+typedef void_type get_signature_key_cache_stats_args;
+
+struct get_signature_key_cache_stats_return
+{
+   /// False if the cache is disabled by signature-key-cache-size = 0
+   bool                                         enabled = false;
+   sophiatx::protocol::signature_key_cache::stats  stats;
+};
+
 
 class chain_api
 {
@@ -39,8 +76,33 @@ class chain_api
 
       DECLARE_API(
          (push_block)
-         (push_transaction) )
-      
+         (push_transaction)
+
+         /**
+          * @brief Get call counts and latency histograms of applied operations per operation type
+          */
+         (get_operation_profile)
+
+         /**
+          * @brief Switch operation profiling on or off and optionally reset the collected stats
+          */
+         (set_operation_profiling)
+
+         /**
+          * @brief Get depth, wait time and write lock hold time metrics of the block and transaction write queue
+          */
+         (get_write_queue_stats)
+
+         /**
+          * @brief Get progress, lag and catch up throughput of a light node following the messages of its app
+          */
+         (get_sync_stats)
+
+         /**
+          * @brief Get hit, miss and eviction counts of the cache of keys recovered from transaction signatures
+          */
+         (get_signature_key_cache_stats) )
+
    private:
       std::unique_ptr< detail::chain_api_impl > my;
 };
@@ -50,3 +112,6 @@ class chain_api
 FC_REFLECT( sophiatx::plugins::chain::push_block_args, (block)(currently_syncing) )
 FC_REFLECT( sophiatx::plugins::chain::push_block_return, (success)(error) )
 FC_REFLECT( sophiatx::plugins::chain::push_transaction_return, (success)(error) )
+FC_REFLECT( sophiatx::plugins::chain::get_operation_profile_return, (enabled)(operations) )
+FC_REFLECT( sophiatx::plugins::chain::set_operation_profiling_args, (enabled)(reset) )
+FC_REFLECT( sophiatx::plugins::chain::get_signature_key_cache_stats_return, (enabled)(stats) )
@@ -19,6 +19,12 @@ public:
    )
 
 
+   /// Documents are stored once, entries of the recipients are resolved to them only when returned
+   const chain::custom_content_object& document( const chain::custom_content_recipient_object& entry )const
+   {
+      return _db->get( entry.content );
+   }
+
    std::shared_ptr<chain::database_interface>  _db;
 };
 
@@ -37,6 +43,8 @@ DEFINE_API_IMPL( custom_api_impl, get_app_custom_messages)
 
    const auto& idx = _db->get_index< chain::custom_content_index, chain::by_app_id >();
    auto itr = idx.lower_bound( boost::make_tuple( args.app_id, args.start ) );
+   if( itr == idx.end() )
+      return get_app_custom_messages_return();
    auto end = idx.upper_bound( boost::make_tuple( args.app_id, std::max( int64_t(0), int64_t(itr->app_message_sequence) - args.limit ) ) );
 
    get_app_custom_messages_return result;
@@ -71,14 +79,14 @@ DEFINE_API_IMPL( custom_api_impl, list_received_documents )
    }else if(args.search_type == "by_recipient"){
       uint64_t start = std::stoull(args.start);
       FC_ASSERT( start >= args.count, "start must be greater than limit" );
-      const auto& idx = _db->get_index< chain::custom_content_index, chain::by_recipient >();
+      const auto& idx = _db->get_index< chain::custom_content_recipient_index, chain::by_recipient >();
       auto itr = idx.lower_bound( boost::make_tuple( args.account_name, args.app_id, start ) );
       auto end = idx.upper_bound( boost::make_tuple( args.account_name, args.app_id, std::max( int64_t(0), int64_t(itr->recipient_sequence) - args.count ) ) );
 
       list_received_documents_return result; result.clear();
       while( itr != end && result.size() < args.count)
       {
-         result[ itr->recipient_sequence ] = *itr;
+         result[ itr->recipient_sequence ] = document( *itr );
          ++itr;
       }
 
@@ -99,14 +107,14 @@ DEFINE_API_IMPL( custom_api_impl, list_received_documents )
       return result;
    }else if(args.search_type == "by_recipient_datetime"){
       fc::time_point_sec start = fc::time_point_sec::from_iso_string(args.start);
-      const auto& idx = _db->get_index< chain::custom_content_index, chain::by_recipient_time >();
+      const auto& idx = _db->get_index< chain::custom_content_recipient_index, chain::by_recipient_time >();
       auto itr = idx.lower_bound( boost::make_tuple( args.account_name, args.app_id, start ) );
       auto end = idx.upper_bound( boost::make_tuple( args.account_name, args.app_id, fc::time_point_sec::min() ) );
 
       list_received_documents_return result; result.clear();
       while( itr != end && result.size() < args.count)
       {
-         result[ itr->recipient_sequence ] = *itr;
+         result[ itr->recipient_sequence ] = document( *itr );
          ++itr;
       }
 
@@ -129,7 +137,7 @@ DEFINE_API_IMPL( custom_api_impl, list_received_documents )
    }else if(args.search_type == "by_recipient_reverse"){
       uint64_t start = std::stoull(args.start);
       //FC_ASSERT( start >= args.count, "start must be greater than limit" );
-      const auto& idx = _db->get_index< chain::custom_content_index, chain::by_recipient >();
+      const auto& idx = _db->get_index< chain::custom_content_recipient_index, chain::by_recipient >();
       auto itr = idx.upper_bound( boost::make_tuple( args.account_name, args.app_id, start ) );
       auto end = idx.lower_bound( boost::make_tuple( args.account_name, args.app_id, int64_t(itr->recipient_sequence) + args.count ) ) ;
 
@@ -137,7 +145,7 @@ DEFINE_API_IMPL( custom_api_impl, list_received_documents )
       while( itr != end && result.size() < args.count)
       {
          --itr;
-         result[ itr->recipient_sequence ] = *itr;
+         result[ itr->recipient_sequence ] = document( *itr );
       }
 
       return result;
@@ -157,7 +165,7 @@ DEFINE_API_IMPL( custom_api_impl, list_received_documents )
       return result;
    }else if(args.search_type == "by_recipient_datetime_reverse") {
       fc::time_point_sec start = fc::time_point_sec::from_iso_string(args.start);
-      const auto &idx = _db->get_index<chain::custom_content_index, chain::by_recipient_time>();
+      const auto &idx = _db->get_index<chain::custom_content_recipient_index, chain::by_recipient_time>();
       auto itr = idx.upper_bound(boost::make_tuple(args.account_name, args.app_id, start ));
       auto end = idx.lower_bound(boost::make_tuple(args.account_name, args.app_id, fc::time_point_sec::max()));
 
@@ -165,7 +173,7 @@ DEFINE_API_IMPL( custom_api_impl, list_received_documents )
       result.clear();
       while( itr != end && result.size() < args.count ) {
          --itr;
-         result[ itr->recipient_sequence ] = *itr;
+         result[ itr->recipient_sequence ] = document( *itr );
       }
       return result;
    }else{
@@ -180,6 +188,8 @@ DEFINE_API_IMPL( custom_api_impl, list_received_documents )
 custom_api::custom_api(): my( new detail::custom_api_impl() )
 {
    JSON_RPC_REGISTER_API( SOPHIATX_CUSTOM_API_PLUGIN_NAME );
+   // Light nodes page through app messages with it during sync
+   JSON_RPC_REGISTER_BINARY_API_METHOD( SOPHIATX_CUSTOM_API_PLUGIN_NAME, get_app_custom_messages );
 }
 
 custom_api::~custom_api() {}
@@ -24,7 +24,8 @@ struct received_object
          sender( obj.sender ),
          app_id( obj.app_id ),
          binary( obj.binary ),
-         received( obj.received)
+         received( obj.received),
+         app_message_sequence( obj.app_message_sequence )
    {
       if(binary)
          data = fc::base64_encode(obj.data.data(), obj.data.size());
@@ -41,7 +42,8 @@ struct received_object
    string            data;
    bool              binary;
    time_point_sec    received;
-
+   /// Position of the message among the messages of its app, without gaps
+   uint64_t          app_message_sequence = 0;
 };
 
 
@@ -91,7 +93,7 @@ private:
 
 
 FC_REFLECT( sophiatx::plugins::custom::received_object,
-            (id)(sender)(recipients)(app_id)(data)(received)(binary) )
+            (id)(sender)(recipients)(app_id)(data)(received)(binary)(app_message_sequence) )
 
 FC_REFLECT( sophiatx::plugins::custom::list_received_documents_args,
             (app_id)(account_name)(search_type)(start)(count) )
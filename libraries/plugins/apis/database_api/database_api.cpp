@@ -6,6 +6,7 @@
 #include <sophiatx/plugins/database_api/database_api_plugin.hpp>
 
 #include <sophiatx/chain/get_config.hpp>
+#include <sophiatx/chain/secondary_index.hpp>
 #include <sophiatx/protocol/exceptions.hpp>
 #include <sophiatx/protocol/transaction_util.hpp>
 
@@ -72,6 +73,10 @@ class database_api_impl
 
 
       std::shared_ptr<database> _db;
+
+      /// Only list_accounts orders accounts by balance, so the core account index does not keep the ordering
+      chain::secondary_index< chain::account_index, share_type > _accounts_by_balance{
+         []( const account_object& a ){ return a.total_balance(); } };
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -333,11 +338,18 @@ DEFINE_API_IMPL( database_api_impl, list_accounts )
       }
       case( by_balance ):
       {
-         iterate_results< chain::account_index, chain::by_balance >(
-               args.start.as< protocol::share_type >(),
-               result.accounts,
-               args.limit,
-               [&]( const account_object& a ){ return api_account_object( a, _db ); }, true );
+         auto accounts = _accounts_by_balance.get( *_db );
+         typedef decltype( _accounts_by_balance )::entry_compare entry_compare;
+
+         // Accounts with a balance of at most start, the richest first
+         auto itr = std::upper_bound( accounts->begin(), accounts->end(), args.start.as< protocol::share_type >(), entry_compare() );
+         while( result.accounts.size() < args.limit && itr != accounts->begin() )
+         {
+            --itr;
+            const auto* account = _db->find< chain::account_object >( itr->second );
+            if( account )
+               result.accounts.push_back( api_account_object( *account, _db ) );
+         }
          break;
       }
       default:
@@ -748,13 +760,13 @@ DEFINE_API_IMPL( database_api_impl, verify_signatures )
 
 DEFINE_API_IMPL( database_api_impl, get_promotion_pool_balance )
 {
-   return asset(_db->get_economic_model().get_available_promotion_pool(_db->head_block_num()), chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"));
+   return asset(_db->get_economic_model().get_available_promotion_pool(_db->head_block_num()), chain::sophiatx_config::params().symbol);
 }
 
 
 DEFINE_API_IMPL( database_api_impl, get_burned_balance )
 {
-   return asset(_db->get_economic_model().burn_pool, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL"));
+   return asset(_db->get_economic_model().burn_pool, chain::sophiatx_config::params().symbol);
 }
 
 DEFINE_LOCKLESS_APIS( database_api, (get_config) )
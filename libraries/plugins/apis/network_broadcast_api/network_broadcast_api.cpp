@@ -45,7 +45,7 @@ namespace detail
    DEFINE_API_IMPL( network_broadcast_api_impl, broadcast_transaction )
    {
       FC_ASSERT( !check_max_block_age( args.max_block_age ) );
-      FC_ASSERT( fc::raw::pack_size(args.trx) <= chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_TRANSACTION_SIZE"), "Transaction size is bigger than SOPHIATX_MAX_TRANSACTION_SIZE" );
+      FC_ASSERT( fc::raw::pack_size(args.trx) <= chain::sophiatx_config::params().max_transaction_size, "Transaction size is bigger than SOPHIATX_MAX_TRANSACTION_SIZE" );
       _chain.accept_transaction( args.trx );
       _p2p.broadcast_transaction( args.trx );
 
@@ -55,7 +55,7 @@ namespace detail
    DEFINE_API_IMPL( network_broadcast_api_impl, broadcast_transaction_synchronous )
    {
       FC_ASSERT( !check_max_block_age( args.max_block_age ) );
-      FC_ASSERT( fc::raw::pack_size(args.trx) <= chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_TRANSACTION_SIZE"), "Transaction size is bigger than SOPHIATX_MAX_TRANSACTION_SIZE" );
+      FC_ASSERT( fc::raw::pack_size(args.trx) <= chain::sophiatx_config::params().max_transaction_size, "Transaction size is bigger than SOPHIATX_MAX_TRANSACTION_SIZE" );
 
       auto txid = args.trx.id();
       boost::promise< broadcast_transaction_synchronous_return > p;
@@ -112,7 +112,7 @@ namespace detail
 
    DEFINE_API_IMPL( network_broadcast_api_impl, broadcast_block )
    {
-      FC_ASSERT( fc::raw::pack_size(args.block) <= chain::sophiatx_config::get<uint32_t>("SOPHIATX_MAX_BLOCK_SIZE"), "Block size is bigger than SOPHIATX_MAX_BLOCK_SIZE" );
+      FC_ASSERT( fc::raw::pack_size(args.block) <= chain::sophiatx_config::params().max_block_size, "Block size is bigger than SOPHIATX_MAX_BLOCK_SIZE" );
       _chain.accept_block( args.block, /*currently syncing*/ false, /*skip*/ chain::database_interface::skip_nothing );
       _p2p.broadcast_block( args.block );
       return broadcast_block_return();
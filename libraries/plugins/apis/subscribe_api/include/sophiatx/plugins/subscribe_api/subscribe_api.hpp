@@ -19,6 +19,7 @@ struct custom_object_subscription_args{
    uint64_t return_id;
    uint32_t app_id;
    string   account_name;
+   /// by_sender, by_recipient or by_app, which follows all documents of the app and ignores account_name
    string   search_type;
    uint64_t start;
 };
@@ -29,9 +30,10 @@ typedef uint64_t custom_object_subscription_return;
 class subscribe_api
 {
 public:
-   subscribe_api();
+   subscribe_api( uint32_t max_queue_size );
    ~subscribe_api();
    void api_startup();
+   void api_shutdown();
 
    DECLARE_API(
    (custom_object_subscription)
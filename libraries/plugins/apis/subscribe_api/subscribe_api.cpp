@@ -5,18 +5,71 @@
 #include <sophiatx/plugins/custom_api/custom_api_plugin.hpp>
 #include <sophiatx/plugins/custom_api/custom_api.hpp>
 
+#include <sophiatx/chain/util/signal.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 
 namespace sophiatx { namespace plugins { namespace subscribe {
 
 namespace detail {
 
-struct custom_content_callback;
+enum subscription_type
+{
+   by_sender_subscription,
+   by_recipient_subscription,
+   /// All documents of an app, in the order of their app message sequence, as followed by light nodes
+   by_app_subscription
+};
+
+/**
+ * Subscriptions are indexed by the documents they follow: the documents an account sent or received in an app, or
+ * all documents of an app, which are keyed with an empty account.
+ * Only subscriptions matching the app, the sender or a recipient of a new document are touched.
+ */
+struct subscription_key
+{
+   uint64_t                   app_id;
+   chain::account_name_type   account;
+   subscription_type          type;
+
+   bool operator < ( const subscription_key& other )const
+   {
+      return std::tie( app_id, account, type ) < std::tie( other.app_id, other.account, other.type );
+   }
+};
+
+struct custom_content_subscription
+{
+   custom_content_subscription( const subscription_key& _key, uint64_t start, const std::function<void(fc::variant&)>& _notify )
+      : key( _key ), last_position( start - 1 ), notify( _notify ) {}
 
+   subscription_key                    key;
+   /// Sequence of the last document queued or delivered
+   uint64_t                            last_position;
+   std::function<void(fc::variant&)>   notify;
+
+   /// Documents waiting to be sent, bounded so a slow connection does not hold up block application
+   std::deque< fc::variant >           queue;
+   /// Set when documents were left out of the queue, the delivery thread then reads them from the database itself
+   bool                                lagging = true;
+   /// Set while the subscription is in the list of the delivery thread
+   bool                                pending = false;
+   bool                                dead = false;
+};
+
+typedef std::shared_ptr< custom_content_subscription > subscription_ptr;
 
 class subscribe_api_impl
 {
 public:
-   subscribe_api_impl() : _db( appbase::app().get_plugin< sophiatx::plugins::chain::chain_plugin >().db() )  {
+   subscribe_api_impl( uint32_t max_queue_size ) :
+      _db( appbase::app().get_plugin< sophiatx::plugins::chain::chain_plugin >().db() ),
+      _max_queue_size( max_queue_size )
+   {
       post_apply_connection = _db->post_apply_operation.connect( 0, [&]( const chain::operation_notification& note ){ on_operation(note); } );
    }
 
@@ -25,98 +78,282 @@ public:
    )
 
    void on_operation( const chain::operation_notification& note );
+   void on_document( const subscription_key& key );
+
+   /// Queues documents following last_position until the queue is full, returns false once none is left
+   bool fill_queue( custom_content_subscription& s );
+
+   void start();
+   void stop();
+   void deliver();
+   void schedule( const subscription_ptr& s );
+   void remove( const subscription_ptr& s );
 
    std::shared_ptr<chain::database_interface>  _db;
    boost::signals2::connection      post_apply_connection;
-   std::vector<custom_content_callback>  _content_subscriptions;
-   plugins::json_rpc::json_rpc_plugin* _json_api;
+   uint32_t                         _max_queue_size;
 
+   std::mutex                       _mutex;
+   std::condition_variable          _cv;
+   std::map< subscription_key, std::vector< subscription_ptr > > _subscriptions;
+   /// Subscriptions with queued documents or lagging behind, handled by the delivery thread in order
+   std::deque< subscription_ptr >   _pending;
+   std::thread                      _delivery_thread;
+   bool                             _running = false;
 };
 
-struct custom_content_callback{
-   uint64_t last_position=0;
-   std::function<void(fc::variant&)> notify;
-   bool invalid = false;
-   subscribe_api_impl& impl;
-   custom_object_subscription_args args;
+bool subscribe_api_impl::fill_queue( custom_content_subscription& s )
+{
+   const auto& content_idx = _db->get_index< chain::custom_content_index >().indices();
 
-   custom_content_callback(const custom_object_subscription_args& _args, subscribe_api_impl& _impl, std::function<void(fc::variant&)>& _notify ):notify(_notify), impl(_impl), args(_args) {
-      FC_ASSERT(_args.start > 0);
-      last_position = _args.start-1;
-   }
+   while( s.queue.size() < _max_queue_size )
+   {
+      uint64_t sequence = s.last_position + 1;
+      const chain::custom_content_object* doc = nullptr;
 
-   void operator ()() {
-      custom::list_received_documents_args cb_args;
-      cb_args.app_id = args.app_id;
-      cb_args.account_name = args.account_name;
-      cb_args.search_type = args.search_type;
-      cb_args.count = 1;
-      cb_args.start = std::to_string(last_position+1);
-      auto vdocs = impl._json_api->call_api_method("custom_api", "list_received_documents", fc::variant(cb_args), [](fc::variant& v, uint64_t i){ FC_UNUSED(v) FC_UNUSED(i)} );
-      if(!vdocs.has_value())
-         return;
-      custom::list_received_documents_return docs;
-      fc::from_variant( *vdocs, docs );
-      while (docs.size()){
-         const auto d_itr = docs.find(last_position+1);
-         if(d_itr==docs.end())
-            return;
-
-         fc::variant v;
-         fc::to_variant(*d_itr,v);
-         notify(v);
-         last_position++;
-         cb_args.start = std::to_string(last_position+1);
-         vdocs = impl._json_api->call_api_method("custom_api", "list_received_documents", fc::variant(cb_args), [](fc::variant& v, uint64_t i){ FC_UNUSED(v) FC_UNUSED(i)} );
-         if(!vdocs.has_value())
-            break;
-         fc::from_variant( *vdocs, docs );
+      if( s.key.type == by_app_subscription )
+      {
+         const auto& idx = content_idx.get< chain::by_app_id >();
+         auto itr = idx.find( boost::make_tuple( s.key.app_id, sequence ) );
+         if( itr != idx.end() )
+            doc = &*itr;
+      }
+      else if( s.key.type == by_sender_subscription )
+      {
+         const auto& idx = content_idx.get< chain::by_sender >();
+         auto itr = idx.find( boost::make_tuple( s.key.account, s.key.app_id, sequence ) );
+         if( itr != idx.end() )
+            doc = &*itr;
+      }
+      else
+      {
+         const auto& idx = _db->get_index< chain::custom_content_recipient_index, chain::by_recipient >();
+         auto itr = idx.find( boost::make_tuple( s.key.account, s.key.app_id, sequence ) );
+         if( itr != idx.end() )
+            doc = &_db->get( itr->content );
       }
+
+      if( !doc )
+         return false;
+
+      fc::variant v;
+      fc::to_variant( custom::received_object( *doc ), v );
+      s.queue.push_back( std::move( v ) );
+      s.last_position = sequence;
    }
-};
+
+   return true;
+}
+
+void subscribe_api_impl::on_document( const subscription_key& key )
+{
+   auto itr = _subscriptions.find( key );
+   if( itr == _subscriptions.end() )
+      return;
+
+   for( const auto& s : itr->second )
+   {
+      if( s->dead || s->lagging )
+         continue;
+
+      if( fill_queue( *s ) )
+         s->lagging = true;
+
+      if( s->queue.size() || s->lagging )
+         schedule( s );
+   }
+}
+
+void subscribe_api_impl::schedule( const subscription_ptr& s )
+{
+   if( s->pending )
+      return;
+
+   s->pending = true;
+   _pending.push_back( s );
+}
 
 void subscribe_api_impl::on_operation( const chain::operation_notification& note ){
    try {
-      if( note.op.which() == sophiatx::protocol::operation::tag<sophiatx::protocol::custom_json_operation>::value ||
-          note.op.which() == sophiatx::protocol::operation::tag<sophiatx::protocol::custom_binary_operation>::value ) {
-
-         auto itr = _content_subscriptions.begin();
-         while(itr!= _content_subscriptions.end() ) {
-            try {
-               if(!itr->invalid)
-                  (*itr)();
-            } catch ( fc::send_error_exception& e ) {
-               itr->invalid = true;
-            }
-            itr++;
-         }
+      const chain::account_name_type* sender = nullptr;
+      const flat_set< chain::account_name_type >* recipients = nullptr;
+      uint64_t app_id = 0;
 
+      if( note.op.which() == sophiatx::protocol::operation::tag<sophiatx::protocol::custom_json_operation>::value ) {
+         const auto& op = note.op.get< sophiatx::protocol::custom_json_operation >();
+         sender = &op.sender;
+         recipients = &op.recipients;
+         app_id = op.app_id;
+      } else if( note.op.which() == sophiatx::protocol::operation::tag<sophiatx::protocol::custom_binary_operation>::value ) {
+         const auto& op = note.op.get< sophiatx::protocol::custom_binary_operation >();
+         sender = &op.sender;
+         recipients = &op.recipients;
+         app_id = op.app_id;
+      } else {
+         return;
       }
+
+      std::lock_guard< std::mutex > guard( _mutex );
+      if( _subscriptions.empty() )
+         return;
+
+      on_document( subscription_key{ app_id, chain::account_name_type(), by_app_subscription } );
+      on_document( subscription_key{ app_id, *sender, by_sender_subscription } );
+      for( const auto& r : *recipients )
+         on_document( subscription_key{ app_id, r, by_recipient_subscription } );
+
+      if( _pending.size() )
+         _cv.notify_one();
    } catch (fc::assert_exception&){}
 }
 
+void subscribe_api_impl::remove( const subscription_ptr& s )
+{
+   auto itr = _subscriptions.find( s->key );
+   if( itr == _subscriptions.end() )
+      return;
+
+   auto& subscriptions = itr->second;
+   subscriptions.erase( std::remove( subscriptions.begin(), subscriptions.end(), s ), subscriptions.end() );
+   if( subscriptions.empty() )
+      _subscriptions.erase( itr );
+}
+
+void subscribe_api_impl::deliver()
+{
+   std::unique_lock< std::mutex > lock( _mutex );
+
+   while( _running )
+   {
+      if( _pending.empty() )
+      {
+         _cv.wait( lock );
+         continue;
+      }
+
+      subscription_ptr s = _pending.front();
+      _pending.pop_front();
+      s->pending = false;
+
+      if( s->dead )
+         continue;
+
+      std::deque< fc::variant > docs;
+      docs.swap( s->queue );
+
+      if( docs.empty() && s->lagging )
+      {
+         // Catch up with the documents which did not fit into the queue, holding the read lock keeps new documents
+         // from being queued in the meantime
+         lock.unlock();
+         _db->with_read_lock( [&]()
+         {
+            std::lock_guard< std::mutex > guard( _mutex );
+            s->lagging = fill_queue( *s );
+            docs.swap( s->queue );
+         });
+         lock.lock();
+      }
+
+      if( s->lagging )
+         schedule( s );
+
+      if( docs.empty() )
+         continue;
+
+      lock.unlock();
+
+      bool dead = false;
+      try
+      {
+         for( auto& d : docs )
+            s->notify( d );
+      }
+      catch( fc::send_error_exception& )
+      {
+         dead = true;
+      }
+      catch( const fc::exception& e )
+      {
+         wlog( "Dropping subscription after failed notification: ${e}", ("e", e.to_string()) );
+         dead = true;
+      }
+
+      lock.lock();
+
+      // Subscriptions of closed connections are removed with the first document sent to them
+      if( dead )
+      {
+         s->dead = true;
+         remove( s );
+      }
+   }
+}
+
+void subscribe_api_impl::start()
+{
+   std::lock_guard< std::mutex > guard( _mutex );
+   if( _running )
+      return;
+
+   _running = true;
+   _delivery_thread = std::thread( [this](){ deliver(); } );
+}
+
+void subscribe_api_impl::stop()
+{
+   chain::util::disconnect_signal( post_apply_connection );
+
+   {
+      std::lock_guard< std::mutex > guard( _mutex );
+      if( !_running )
+         return;
+      _running = false;
+      _cv.notify_all();
+   }
+
+   _delivery_thread.join();
+}
+
 
 DEFINE_API_IMPL( subscribe_api_impl, custom_object_subscription )
 {
-   std::function<void(fc::variant&)> notify = [ notify_callback, args ](fc::variant& v )->void{ notify_callback(v, args.return_id);};
+   FC_ASSERT( args.start > 0 );
+   FC_ASSERT( args.search_type == "by_sender" || args.search_type == "by_recipient" || args.search_type == "by_app",
+              "Subscriptions follow documents by_sender, by_recipient or by_app" );
 
-   custom_content_callback cb(args, *this, notify );
+   std::function<void(fc::variant&)> notify = [ notify_callback, args ](fc::variant& v )->void{ notify_callback(v, args.return_id);};
 
-   cb();
+   subscription_key key{ args.app_id, chain::account_name_type(), by_app_subscription };
+   if( args.search_type != "by_app" )
+   {
+      key.account = args.account_name;
+      key.type = args.search_type == "by_sender" ? by_sender_subscription : by_recipient_subscription;
+   }
+   auto s = std::make_shared< custom_content_subscription >( key, args.start, notify );
 
-   _content_subscriptions.push_back(cb);
+   // Documents already stored are sent by the delivery thread, which starts lagging behind
+   std::lock_guard< std::mutex > guard( _mutex );
+   _subscriptions[ key ].push_back( s );
+   schedule( s );
+   _cv.notify_one();
 
    return args.return_id;
 }
 
 } // namespace detail
 
-subscribe_api::subscribe_api(): my( new detail::subscribe_api_impl() )
+subscribe_api::subscribe_api( uint32_t max_queue_size ): my( new detail::subscribe_api_impl( max_queue_size ) )
 {
    JSON_RPC_REGISTER_API( SOPHIATX_SUBSCRIBE_API_PLUGIN_NAME );
 }
 
 void subscribe_api::api_startup(){
+   my->start();
+}
+
+void subscribe_api::api_shutdown(){
+   my->stop();
 }
 
 subscribe_api::~subscribe_api() {}
@@ -7,17 +7,27 @@ namespace sophiatx { namespace plugins { namespace subscribe {
 subscribe_api_plugin::subscribe_api_plugin() {}
 subscribe_api_plugin::~subscribe_api_plugin() {}
 
-void subscribe_api_plugin::set_program_options( options_description& cli, options_description& cfg ) {}
+void subscribe_api_plugin::set_program_options( options_description& cli, options_description& cfg )
+{
+   cfg.add_options()
+      ("subscribe-queue-size", boost::program_options::value< uint32_t >()->default_value( 1000 ), "Maximum number of documents queued for a subscription, further documents are read from the database once the queue was sent")
+      ;
+}
 
 void subscribe_api_plugin::plugin_initialize( const variables_map& options )
 {
-   api = std::make_shared< subscribe_api >();
+   uint32_t queue_size = options.at( "subscribe-queue-size" ).as< uint32_t >();
+   FC_ASSERT( queue_size > 0, "subscribe-queue-size must be at least 1" );
+   api = std::make_shared< subscribe_api >( queue_size );
 }
 
 void subscribe_api_plugin::plugin_startup()
 {
    api->api_startup();
 }
-void subscribe_api_plugin::plugin_shutdown() {}
+void subscribe_api_plugin::plugin_shutdown()
+{
+   api->api_shutdown();
+}
 
 } } } // namespace
\ No newline at end of file
@@ -0,0 +1,351 @@
+#include <sophiatx/plugins/block_stats/block_stats_plugin.hpp>
+
+#include <sophiatx/chain/database/database_interface.hpp>
+#include <sophiatx/chain/util/signal.hpp>
+
+#include <sophiatx/protocol/operation_util_impl.hpp>
+
+#include <array>
+#include <deque>
+#include <fstream>
+#include <mutex>
+
+namespace sophiatx { namespace plugins { namespace block_stats {
+
+using namespace sophiatx::chain;
+using namespace sophiatx::protocol;
+
+namespace detail {
+
+/// Operation counts are stored in fixed size arrays so the records in the ring file have a fixed size
+const int64_t max_operation_types = 64;
+
+/// Raw statistics of one block as stored in the ring file, slot block_num % history size
+struct block_stats_record
+{
+   uint32_t                                        block_num = 0;
+   uint32_t                                        timestamp = 0;
+   uint32_t                                        size = 0;
+   uint32_t                                        transactions = 0;
+   uint32_t                                        operations = 0;
+   uint32_t                                        reserved = 0;
+   int64_t                                         fees = 0;
+   std::array< uint32_t, max_operation_types >     operation_counts = {};
+};
+
+static_assert( std::is_trivially_copyable< block_stats_record >::value, "block_stats_record is written to disk as is" );
+
+/**
+ * Running totals up to and including block_num. The totals of a range are the difference of the totals at its ends.
+ * Operation counts wrap around, their differences are still exact as long as a range has less than 2^32 operations
+ * of one type.
+ */
+struct block_stats_totals
+{
+   uint32_t                                        block_num = 0;
+   uint32_t                                        timestamp = 0;
+   uint64_t                                        size = 0;
+   uint64_t                                        transactions = 0;
+   uint64_t                                        operations = 0;
+   int64_t                                         fees = 0;
+   std::array< uint32_t, max_operation_types >     operation_counts = {};
+};
+
+const std::vector< std::string >& operation_names()
+{
+   static const std::vector< std::string > names = []()
+   {
+      std::vector< std::string > result( operation::count() );
+      for( int64_t i = 0; i < operation::count(); ++i )
+      {
+         operation op;
+         op.set_which( i );
+         op.visit( fc::get_operation_name( result[ i ] ) );
+      }
+      return result;
+   }();
+
+   return names;
+}
+
+struct operation_fee_visitor
+{
+   typedef int64_t result_type;
+
+   asset_symbol_type symbol;
+
+   int64_t operator()( const base_operation& op )const
+   {
+      if( op.has_special_fee() || op.fee.symbol != symbol )
+         return 0;
+      return op.fee.amount.value;
+   }
+};
+
+class block_stats_plugin_impl
+{
+   public:
+      block_stats_plugin_impl() :
+         _db( appbase::app().get_plugin< sophiatx::plugins::chain::chain_plugin >().db() ) {}
+
+      void on_applied_block( const signed_block& b );
+
+      block_stats_record make_record( const signed_block& b )const;
+      void push( const block_stats_record& record );
+
+      bool open_file();
+      bool read_record( uint32_t block_num, block_stats_record& record );
+      void write_record( const block_stats_record& record );
+      void load();
+
+      block_stats get_stats( uint32_t blocks )const;
+
+      std::shared_ptr< database_interface >  _db;
+      boost::signals2::connection            _on_applied_block_connection;
+      uint32_t                               _history_size = 28800;
+
+      mutable std::mutex                     _mutex;
+      /// Totals before the oldest block in the history followed by the totals at each block of the history
+      std::deque< block_stats_totals >       _totals;
+      fc::path                               _file_name;
+      std::fstream                           _file;
+      bool                                   _file_error = false;
+};
+
+block_stats_record block_stats_plugin_impl::make_record( const signed_block& b )const
+{
+   block_stats_record record;
+   record.block_num = b.block_num();
+   record.timestamp = b.timestamp.sec_since_epoch();
+   record.size = fc::raw::pack_size( b );
+   record.transactions = b.transactions.size();
+
+   operation_fee_visitor fee_visitor{ chain::sophiatx_config::params().symbol };
+   for( const auto& trx : b.transactions )
+   {
+      record.operations += trx.operations.size();
+      for( const auto& op : trx.operations )
+      {
+         ++record.operation_counts[ op.which() ];
+         record.fees += op.visit( fee_visitor );
+      }
+   }
+
+   return record;
+}
+
+void block_stats_plugin_impl::push( const block_stats_record& record )
+{
+   // A block of a fork replaces the blocks from its number up
+   while( _totals.size() && _totals.back().block_num >= record.block_num )
+      _totals.pop_back();
+
+   if( _totals.empty() )
+   {
+      block_stats_totals base;
+      base.block_num = record.block_num - 1;
+      base.timestamp = record.timestamp;
+      _totals.push_back( base );
+   }
+
+   block_stats_totals totals = _totals.back();
+   totals.block_num = record.block_num;
+   totals.timestamp = record.timestamp;
+   totals.size += record.size;
+   totals.transactions += record.transactions;
+   totals.operations += record.operations;
+   totals.fees += record.fees;
+   for( int64_t i = 0; i < max_operation_types; ++i )
+      totals.operation_counts[ i ] += record.operation_counts[ i ];
+
+   _totals.push_back( totals );
+
+   while( _totals.size() > _history_size + 1 )
+      _totals.pop_front();
+}
+
+void block_stats_plugin_impl::on_applied_block( const signed_block& b )
+{
+   block_stats_record record = make_record( b );
+
+   std::lock_guard< std::mutex > guard( _mutex );
+   push( record );
+   write_record( record );
+}
+
+bool block_stats_plugin_impl::open_file()
+{
+   // The file is opened with the first block, once the chain has created its directory
+   if( _file.is_open() || _file_error )
+      return _file.is_open();
+
+   if( !fc::exists( _file_name ) )
+      std::ofstream( _file_name.string(), std::ios::binary );
+
+   _file.open( _file_name.string(), std::ios::in | std::ios::out | std::ios::binary );
+   if( !_file.is_open() )
+   {
+      wlog( "Cannot open block stats file ${f}, statistics are only kept in memory", ("f", _file_name) );
+      _file_error = true;
+   }
+
+   return _file.is_open();
+}
+
+bool block_stats_plugin_impl::read_record( uint32_t block_num, block_stats_record& record )
+{
+   if( !open_file() )
+      return false;
+
+   _file.clear();
+   _file.seekg( uint64_t( block_num % _history_size ) * sizeof( record ) );
+   _file.read( (char*)&record, sizeof( record ) );
+
+   // Slots of other blocks are left over from before the ring wrapped or from a different history size
+   return _file.gcount() == sizeof( record ) && record.block_num == block_num;
+}
+
+void block_stats_plugin_impl::write_record( const block_stats_record& record )
+{
+   if( !open_file() )
+      return;
+
+   _file.clear();
+   _file.seekp( uint64_t( record.block_num % _history_size ) * sizeof( record ) );
+   _file.write( (const char*)&record, sizeof( record ) );
+}
+
+void block_stats_plugin_impl::load()
+{
+   // Blocks applied while the chain was opened, e.g. during a replay, are already in the history
+   uint32_t head = _db->head_block_num();
+   if( _totals.size() && _totals.back().block_num == head )
+      return;
+
+   _totals.clear();
+
+   uint32_t first = head > _history_size ? head - _history_size + 1 : 1;
+   uint32_t missing = 0;
+   for( uint32_t block_num = first; block_num <= head; ++block_num )
+   {
+      block_stats_record record;
+      if( !read_record( block_num, record ) )
+      {
+         auto block = _db->fetch_block_by_number( block_num );
+         if( !block )
+         {
+            // The history starts after the first block we can read
+            _totals.clear();
+            continue;
+         }
+
+         record = make_record( *block );
+         write_record( record );
+         ++missing;
+      }
+
+      push( record );
+   }
+
+   _file.flush();
+   ilog( "Loaded statistics of ${n} blocks, ${m} of them read from the block log", ("n", _totals.size() ? _totals.size() - 1 : 0)("m", missing) );
+}
+
+block_stats block_stats_plugin_impl::get_stats( uint32_t blocks )const
+{
+   block_stats result;
+   result.fees = asset( 0, chain::sophiatx_config::params().symbol );
+
+   std::lock_guard< std::mutex > guard( _mutex );
+
+   if( _totals.size() < 2 || blocks == 0 )
+      return result;
+
+   blocks = std::min< uint32_t >( blocks, _totals.size() - 1 );
+
+   const auto& last = _totals.back();
+   const auto& before = _totals[ _totals.size() - 1 - blocks ];
+   const auto& first = _totals[ _totals.size() - blocks ];
+
+   result.first_block = first.block_num;
+   result.last_block = last.block_num;
+   result.first_block_time = fc::time_point_sec( first.timestamp );
+   result.last_block_time = fc::time_point_sec( last.timestamp );
+   result.blocks = blocks;
+   result.size = last.size - before.size;
+   result.transactions = last.transactions - before.transactions;
+   result.operations = last.operations - before.operations;
+   result.fees.amount = last.fees - before.fees;
+
+   const auto& names = operation_names();
+   for( size_t i = 0; i < names.size(); ++i )
+   {
+      uint32_t count = last.operation_counts[ i ] - before.operation_counts[ i ];
+      if( count )
+         result.operation_counts[ names[ i ] ] = count;
+   }
+
+   return result;
+}
+
+} // detail
+
+block_stats_plugin::block_stats_plugin() {}
+block_stats_plugin::~block_stats_plugin() {}
+
+void block_stats_plugin::set_program_options( options_description& cli, options_description& cfg )
+{
+   cfg.add_options()
+         ("block-stats-history", boost::program_options::value< uint32_t >()->default_value( 28800 ), "Number of most recent blocks whose statistics are kept (default 1 day)")
+         ;
+}
+
+void block_stats_plugin::plugin_initialize( const boost::program_options::variables_map& options )
+{
+   my = std::make_unique< detail::block_stats_plugin_impl >();
+   try
+   {
+      ilog( "Initializing block_stats plugin" );
+      FC_ASSERT( operation::count() <= detail::max_operation_types, "Increase max_operation_types, there are ${n} operation types", ("n", operation::count()) );
+
+      my->_history_size = options.at( "block-stats-history" ).as< uint32_t >();
+      FC_ASSERT( my->_history_size > 0, "block-stats-history must be at least 1" );
+
+      auto& chain = appbase::app().get_plugin< sophiatx::plugins::chain::chain_plugin >();
+      my->_file_name = chain.get_shared_memory_dir() / "block_stats";
+
+      std::shared_ptr< database_interface >& db = chain.db();
+      my->_on_applied_block_connection = db->applied_block.connect( [&]( const signed_block& b ){ my->on_applied_block( b ); } );
+   }
+   FC_CAPTURE_AND_RETHROW()
+}
+
+void block_stats_plugin::plugin_startup()
+{
+   my->_db->with_read_lock( [&]()
+   {
+      std::lock_guard< std::mutex > guard( my->_mutex );
+      my->load();
+   });
+}
+
+void block_stats_plugin::plugin_shutdown()
+{
+   chain::util::disconnect_signal( my->_on_applied_block_connection );
+
+   std::lock_guard< std::mutex > guard( my->_mutex );
+   if( my->_file.is_open() )
+      my->_file.close();
+}
+
+block_stats block_stats_plugin::get_stats( uint32_t blocks )const
+{
+   return my->get_stats( blocks );
+}
+
+uint32_t block_stats_plugin::get_history_size()const
+{
+   return my->_history_size;
+}
+
+} } } // sophiatx::plugins::block_stats
@@ -0,0 +1,67 @@
+#pragma once
+#include <appbase/application.hpp>
+
+#include <sophiatx/plugins/chain/chain_plugin.hpp>
+
+#include <sophiatx/protocol/asset.hpp>
+
+namespace sophiatx { namespace plugins { namespace block_stats {
+
+namespace detail { class block_stats_plugin_impl; }
+
+using namespace appbase;
+
+#define SOPHIATX_BLOCK_STATS_PLUGIN_NAME "block_stats"
+
+/// Totals over a range of the most recent blocks
+struct block_stats
+{
+   uint32_t                         first_block = 0;
+   uint32_t                         last_block = 0;
+   fc::time_point_sec               first_block_time;
+   fc::time_point_sec               last_block_time;
+   uint32_t                         blocks = 0;
+   uint64_t                         size = 0;
+   uint64_t                         transactions = 0;
+   uint64_t                         operations = 0;
+   /// Fees stated by the operations in the core symbol, fees paid in other symbols are converted by the chain at runtime
+   protocol::asset                  fees;
+   std::map< std::string, uint64_t > operation_counts;
+};
+
+/**
+ * Maintains statistics of the most recent blocks as they are applied, so they can be queried without reading the
+ * blocks back from the block log.
+ *
+ * Running totals of the last block-stats-history blocks are kept in memory, which makes the totals of any number of
+ * recent blocks available in constant time. The raw statistics of each block are written to a ring file next to the
+ * block log, so a restart only reads back the blocks which are missing from it.
+ */
+class block_stats_plugin : public appbase::plugin< block_stats_plugin >
+{
+   public:
+      block_stats_plugin();
+      virtual ~block_stats_plugin();
+
+      APPBASE_PLUGIN_REQUIRES( (sophiatx::plugins::chain::chain_plugin) )
+
+      static const std::string& name() { static std::string name = SOPHIATX_BLOCK_STATS_PLUGIN_NAME; return name; }
+
+      virtual void set_program_options( options_description& cli, options_description& cfg ) override;
+      virtual void plugin_initialize( const variables_map& options ) override;
+      virtual void plugin_startup() override;
+      virtual void plugin_shutdown() override;
+
+      /// Totals of the last blocks, at most the number of blocks kept in the history
+      block_stats get_stats( uint32_t blocks )const;
+
+      uint32_t get_history_size()const;
+
+   private:
+      std::unique_ptr< detail::block_stats_plugin_impl > my;
+};
+
+} } } // sophiatx::plugins::block_stats
+
+FC_REFLECT( sophiatx::plugins::block_stats::block_stats,
+   (first_block)(last_block)(first_block_time)(last_block_time)(blocks)(size)(transactions)(operations)(fees)(operation_counts) )
@@ -31,7 +31,7 @@ using sophiatx::chain::block_id_type;
 namespace asio = boost::asio;
 
 
-chain_plugin_full::chain_plugin_full() : write_queue( 64 ) {
+chain_plugin_full::chain_plugin_full() : write_queue( 1024 ) {
    db_ = std::make_shared<database>();
 }
 
@@ -140,64 +140,75 @@ void chain_plugin_full::start_write_processing()
 
         request_promise_visitor prom_visitor;
 
-        /* This loop monitors the write request queue and performs writes to the database. These
+        /* This loop takes write requests from the write queue and performs writes to the database. These
          * can be blocks or pending transactions. Because the caller needs to know the success of
          * the write and any exceptions that are thrown, a write context is passed in the queue
          * to the processing thread which it will use to store the results of the write. It is the
          * caller's responsibility to ensure the pointer to the write context remains valid until
          * the contained promise is complete.
          *
+         * The thread sleeps in pop until a request is pushed, so a request arriving at an idle node
+         * is processed right away. Once the write lock is taken, every request queued in the meantime is
+         * processed under it to minimize lock overhead.
+         *
          * The loop has two modes, sync mode and live mode. In sync mode we want to process writes
-         * as quickly as possible with minimal overhead. The outer loop busy waits on the queue
-         * and the inner loop drains the queue as quickly as possible. We exit sync mode when the
+         * as quickly as possible, the queue is drained without limits. We exit sync mode when the
          * head block is within 1 minute of system time.
          *
          * Live mode needs to balance between processing pending writes and allowing readers access
-         * to the database. It will batch writes together as much as possible to minimize lock
-         * overhead but will willingly give up the write lock after 500ms. The thread then sleeps for
-         * 10ms. This allows time for readers to access the database as well as more writes to come
-         * in. When the node is live the rate at which writes come in is slower and busy waiting is
-         * not an optimal use of system resources when we could give CPU time to read threads.
+         * to the database. A batch gives up the write lock after write_lock_hold_time or after
+         * write_batch_size requests. If requests are still queued at that point, the thread sleeps
+         * for write_lock_yield_time so waiting readers get the lock before the next batch.
          */
-        while( running )
+        while( running && write_queue.pop( cxt ) )
         {
            if( !is_syncing )
               start = fc::time_point::now();
 
-           if( write_queue.pop( cxt ) )
-           {
-              db_->with_write_lock( [&](){
-                   while( true )
+           uint32_t batch_size = 0;
+           bool yield = false;
+           fc::time_point lock_start;
+
+           db_->with_write_lock( [&](){
+                lock_start = fc::time_point::now();
+
+                while( true )
+                {
+                   req_visitor.skip = cxt->skip;
+                   req_visitor.except = &(cxt->except);
+                   cxt->success = cxt->req_ptr.visit( req_visitor );
+                   cxt->prom_ptr.visit( prom_visitor );
+                   ++batch_size;
+
+                   if( is_syncing && start - db_->head_block_time() < fc::minutes(1) )
+                   {
+                      start = fc::time_point::now();
+                      is_syncing = false;
+                   }
+
+                   if( !is_syncing && write_lock_hold_time >= 0 && fc::time_point::now() - start > fc::milliseconds( write_lock_hold_time ) )
+                   {
+                      yield = true;
+                      break;
+                   }
+
+                   if( !is_syncing && write_batch_size > 0 && batch_size >= write_batch_size )
                    {
-                      req_visitor.skip = cxt->skip;
-                      req_visitor.except = &(cxt->except);
-                      cxt->success = cxt->req_ptr.visit( req_visitor );
-                      cxt->prom_ptr.visit( prom_visitor );
-
-                      if( is_syncing && start - db_->head_block_time() < fc::minutes(1) )
-                      {
-                         start = fc::time_point::now();
-                         is_syncing = false;
-                      }
-
-                      if( !is_syncing && write_lock_hold_time >= 0 && fc::time_point::now() - start > fc::milliseconds( write_lock_hold_time ) )
-                      {
-                         break;
-                      }
-
-                      if( !write_queue.pop( cxt ) )
-                      {
-                         break;
-                      }
+                      yield = true;
+                      break;
                    }
-              });
 
-           }
+                   if( !write_queue.try_pop( cxt ) )
+                   {
+                      break;
+                   }
+                }
+           });
+
+           write_queue.record_batch( batch_size, fc::time_point::now() - lock_start, yield );
 
-           if( !is_syncing ) {
-              boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
-           } else
-              boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+           if( yield && write_lock_yield_time > 0 )
+              boost::this_thread::sleep_for( boost::chrono::milliseconds( write_lock_yield_time ) );
         }
    });
 }
@@ -206,12 +217,26 @@ void chain_plugin_full::stop_write_processing()
 {
    running = false;
 
+   // Requests which were not processed before the shutdown fail instead of blocking their callers forever
+   request_promise_visitor prom_visitor;
+   for( auto cxt : write_queue.stop() )
+   {
+      cxt->success = false;
+      cxt->except = fc::exception( FC_LOG_MESSAGE( warn, "Chain plugin is shutting down, write request was not processed." ) );
+      cxt->prom_ptr.visit( prom_visitor );
+   }
+
    if( write_processor_thread )
       write_processor_thread->join();
 
    write_processor_thread.reset();
 }
 
+write_queue_stats chain_plugin_full::get_write_queue_stats()const
+{
+   return write_queue.get_stats();
+}
+
 void chain_plugin_full::set_program_options(options_description& cli, options_description& cfg)
 {
    cfg.add_options()      
@@ -224,12 +249,28 @@ void chain_plugin_full::set_program_options(options_description& cli, options_de
          ("checkpoint,c", bpo::value<vector<string>>()->composing(), "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
          ("flush-state-interval", bpo::value<uint32_t>(),
             "flush shared memory changes to disk every N blocks")
+         ("signature-recovery-threads", bpo::value<uint32_t>()->default_value(0),
+            "Number of threads used to recover transaction and witness signatures of a block before it is applied. 0 recovers them serially during block application.")
+         ("signature-key-cache-size", bpo::value<uint32_t>()->default_value(100000),
+            "Max number of recovered transaction signature keys cached until the transaction expires, so transactions already seen in the mempool are not recovered again when they arrive in a block. 0 disables the cache.")
+         ("operation-profiling", bpo::value<bool>()->default_value(false), "Keep per operation type latency histograms of fee processing, evaluation and plugin signal handlers. Can be switched at runtime through chain_api, the stats are included in benchmark dumps.")
+         ("write-queue-size", bpo::value<uint32_t>()->default_value(1024), "Max number of blocks and transactions waiting for the write thread. Callers block while the queue is full.")
+         ("write-lock-hold-time", bpo::value<int16_t>()->default_value(500), "Max time in ms the write thread holds the write lock for a batch of queued writes once the node is live. -1 holds it until the queue is empty.")
+         ("write-batch-size", bpo::value<uint32_t>()->default_value(0), "Max number of queued writes processed under one write lock once the node is live. 0 is unlimited.")
+         ("write-lock-yield-time", bpo::value<uint32_t>()->default_value(10), "Time in ms the write thread leaves the database to readers after a batch was cut short by write-lock-hold-time or write-batch-size.")
+         ("read-only", bpo::value<bool>()->default_value(false), "Map the shared memory of a node running on the same data directory read only and serve API requests from it without applying blocks. Reads overlapping a write of that node are retried, that node never waits for them. Use a separate config file enabling only the webserver and API plugins.")
+         ("flat-undo-log", bpo::value<bool>()->default_value(false), "Keep undo history of the chain state in flat append-only logs instead of per session trees. Cheaper transaction push, squash and block pop at the cost of logging repeated modifications of an object within a block.")
          ;
    cli.add_options()
          ("replay-blockchain", bpo::bool_switch()->default_value(false), "clear chain database and replay all blocks" )
          ("resync-blockchain", bpo::bool_switch()->default_value(false), "clear chain database and block log" )
          ("stop-replay-at-block", bpo::value<uint32_t>(), "Stop and exit after reaching given block number")
          ("set-benchmark-interval", bpo::value<uint32_t>(), "Print time and memory usage every given number of blocks")
+         ("replay-decode-threads", bpo::value<uint32_t>()->default_value(2), "Number of threads deserializing blocks while replaying. Blocks are read and deserialized ahead of the apply loop. 0 replays on a single thread.")
+         ("replay-queue-size", bpo::value<uint32_t>()->default_value(64), "Max number of 100 block batches read and deserialized ahead of the apply loop while replaying.")
+         ("block-log-chunk-size", bpo::value<uint32_t>()->default_value(0), "Create a new block log in the compressed format with this many blocks per chunk. 0 creates a raw block log. Existing block logs keep their format, use block_log_compress to convert them.")
+         ("snapshot-export", bpo::value<bfs::path>(), "Export the chain state to a portable snapshot file after the database is opened")
+         ("snapshot-import", bpo::value<bfs::path>(), "Clear chain database and build it from a snapshot file instead of replaying. The block log has to contain the head block of the snapshot.")
          ("dump-memory-details", bpo::bool_switch()->default_value(false), "Dump database objects memory usage info. Use set-benchmark-interval to set dump interval.")
          ("check-locks", bpo::bool_switch()->default_value(false), "Check correctness of chainbase locking" )
          ("validate-database-invariants", bpo::bool_switch()->default_value(false), "Validate all supply invariants check out" )
@@ -298,6 +339,8 @@ void chain_plugin_full::plugin_initialize(const variables_map& options) {
 
    genesis             = initial_state();
    chain::sophiatx_config::init(genesis);
+   // Known before startup, plugins keeping their own files next to the shared memory file open them while initializing
+   shared_memory_dir   = app().data_dir() / genesis.compute_chain_id().str() / "blockchain";
 
    replay              = options.at( "replay-blockchain").as<bool>();
    resync              = options.at( "resync-blockchain").as<bool>();
@@ -305,6 +348,18 @@ void chain_plugin_full::plugin_initialize(const variables_map& options) {
       options.count( "stop-replay-at-block" ) ? options.at( "stop-replay-at-block" ).as<uint32_t>() : 0;
    benchmark_interval  =
       options.count( "set-benchmark-interval" ) ? options.at( "set-benchmark-interval" ).as<uint32_t>() : 0;
+   replay_decode_threads = options.at( "replay-decode-threads" ).as<uint32_t>();
+   replay_queue_size   = options.at( "replay-queue-size" ).as<uint32_t>();
+   block_log_chunk_size = options.at( "block-log-chunk-size" ).as<uint32_t>();
+   flat_undo_log = options.at( "flat-undo-log" ).as<bool>();
+   if( options.count( "snapshot-export" ) )
+      snapshot_export = options.at( "snapshot-export" ).as<bfs::path>();
+   if( options.count( "snapshot-import" ) )
+      snapshot_import = options.at( "snapshot-import" ).as<bfs::path>();
+   FC_ASSERT( !( replay && snapshot_import != fc::path() ), "Cannot replay blockchain and import a snapshot at the same time" );
+   read_only = options.at( "read-only" ).as<bool>();
+   FC_ASSERT( !( read_only && ( replay || resync || snapshot_import != fc::path() ) ),
+              "A read only node cannot replay, resync or import a snapshot, the chain database belongs to another node" );
    check_locks         = options.at( "check-locks" ).as< bool >();
    validate_invariants = options.at( "validate-database-invariants" ).as<bool>();
    dump_memory_details = options.at( "dump-memory-details" ).as<bool>();
@@ -314,6 +369,14 @@ void chain_plugin_full::plugin_initialize(const variables_map& options) {
    else
       flush_interval = 10000;
 
+   signature_recovery_threads = options.at( "signature-recovery-threads" ).as<uint32_t>();
+   signature_key_cache_size = options.at( "signature-key-cache-size" ).as<uint32_t>();
+   operation_profiling = options.at( "operation-profiling" ).as<bool>();
+   write_queue.set_capacity( options.at( "write-queue-size" ).as<uint32_t>() );
+   write_lock_hold_time = options.at( "write-lock-hold-time" ).as<int16_t>();
+   write_batch_size = options.at( "write-batch-size" ).as<uint32_t>();
+   write_lock_yield_time = options.at( "write-lock-yield-time" ).as<uint32_t>();
+
    if(options.count("checkpoint"))
    {
       auto cps = options.at("checkpoint").as<vector<string>>();
@@ -334,8 +397,6 @@ void chain_plugin_full::plugin_startup()
 
    chain_id_type chain_id = genesis.compute_chain_id();
 
-   shared_memory_dir = app().data_dir() / chain_id.str() / "blockchain";
-
    // correct directories, TODO can be removed after next HF2
    if( ! genesis.is_private_net && bfs::exists( app().data_dir() / "blockchain" ) ){
       bfs::create_directories ( shared_memory_dir );
@@ -344,7 +405,8 @@ void chain_plugin_full::plugin_startup()
 
    ilog("Starting node with chain id ${i}", ("i", chain_id));
 
-   start_write_processing();
+   if( !read_only )
+      start_write_processing();
 
    if(resync)
    {
@@ -355,6 +417,9 @@ void chain_plugin_full::plugin_startup()
    db_->set_flush_interval( flush_interval );
    db_->add_checkpoints( loaded_checkpoints );
    db_->set_require_locking( check_locks );
+   std::static_pointer_cast<database>(db_)->set_signature_recovery_threads( signature_recovery_threads );
+   std::static_pointer_cast<database>(db_)->set_signature_key_cache_size( signature_key_cache_size );
+   std::static_pointer_cast<database>(db_)->get_operation_profiler().set_enabled( operation_profiling );
 
    bool dump_memory_details_ = dump_memory_details;
    sophiatx::utilities::benchmark_dumper dumper;
@@ -383,8 +448,12 @@ void chain_plugin_full::plugin_startup()
    db_open_args.shared_file_scale_rate = shared_file_scale_rate;
    db_open_args.do_validate_invariants = validate_invariants;
    db_open_args.stop_replay_at = stop_replay_at;
+   db_open_args.replay_decode_threads = replay_decode_threads;
+   db_open_args.replay_queue_size = replay_queue_size;
+   db_open_args.block_log_chunk_size = block_log_chunk_size;
+   db_open_args.flat_undo_log = flat_undo_log;
 
-   auto benchmark_lambda = [&dumper, &get_indexes_memory_details, dump_memory_details_] ( uint32_t current_block_number,
+   auto benchmark_lambda = [this, &dumper, &get_indexes_memory_details, dump_memory_details_] ( uint32_t current_block_number,
       const chainbase::database::abstract_index_cntr_t& abstract_index_cntr )
    {
       if( current_block_number == 0 ) // initial call
@@ -407,17 +476,49 @@ void chain_plugin_full::plugin_startup()
          return;
       }
 
+      sophiatx::utilities::benchmark_dumper::stage_details_cntr_t stage_details;
+      for( const auto& stage : db_->get_replay_stage_stats() )
+         stage_details.emplace_back( std::string( stage.stage ), stage.blocks, stage.busy_us, stage.wait_us );
+
+      sophiatx::utilities::benchmark_dumper::operation_details_cntr_t operation_details;
+      for( const auto& op : std::static_pointer_cast<database>(db_)->get_operation_profiler().get_stats() )
+      {
+         auto add_phase = [&]( const char* phase, const sophiatx::chain::operation_profiler::phase_stats& stats )
+         {
+            if( stats.count )
+               operation_details.emplace_back( std::string( op.name ), std::string( phase ), stats.count, stats.total_ns,
+                  stats.max_ns, stats.p50_ns, stats.p90_ns, stats.p99_ns );
+         };
+         add_phase( "fee", op.fee );
+         add_phase( "evaluate", op.evaluate );
+         add_phase( "signals", op.signals );
+      }
+
       const sophiatx::utilities::benchmark_dumper::measurement& measure =
-         dumper.measure(current_block_number, get_indexes_memory_details);
+         dumper.measure(current_block_number, get_indexes_memory_details, stage_details, operation_details);
       ilog( "Performance report at block ${n}. Elapsed time: ${rt} ms (real), ${ct} ms (cpu). Memory usage: ${cm} (current), ${pm} (peak) kilobytes.",
          ("n", current_block_number)
          ("rt", measure.real_ms)
          ("ct", measure.cpu_ms)
          ("cm", measure.current_mem)
          ("pm", measure.peak_mem) );
+      for( const auto& stage : measure.stage_details_cntr )
+         ilog( "Replay stage ${s}: ${b} blocks, ${bps} blocks/s, ${busy} ms busy, ${wait} ms waiting.",
+            ("s", stage.stage_name)
+            ("b", stage.item_count)
+            ("bps", uint64_t(stage.items_per_second))
+            ("busy", stage.busy_us / 1000)
+            ("wait", stage.wait_us / 1000) );
    };
 
-   if(replay)
+   if( read_only )
+   {
+      ilog("Opening shared memory from ${path} read only", ("path",shared_memory_dir.generic_string()));
+
+      db_open_args.chainbase_flags = chainbase::database::read_only;
+      db_->open( db_open_args, genesis );
+   }
+   else if(replay)
    {
       ilog("Replaying blockchain on user request.");
       uint32_t last_block_number = 0;
@@ -442,6 +543,15 @@ void chain_plugin_full::plugin_startup()
          return;
       }
    }
+   else if( snapshot_import != fc::path() )
+   {
+      ilog("Importing state snapshot on user request, deleting shared memory.");
+      db_->wipe( shared_memory_dir, false );
+
+      // Unlike a failed open, a failed import must not fall back to replaying
+      db_open_args.snapshot_import = snapshot_import;
+      db_->open( db_open_args, genesis );
+   }
    else
    {
       db_open_args.benchmark = sophiatx::chain::database::TBenchmark(dump_memory_details_, benchmark_lambda);
@@ -471,6 +581,14 @@ void chain_plugin_full::plugin_startup()
       }
    }
 
+   if( snapshot_export != fc::path() )
+   {
+      db_->with_read_lock( [&]()
+      {
+         std::static_pointer_cast<database>(db_)->export_snapshot( snapshot_export );
+      });
+   }
+
    ilog( "Started on blockchain with ${n} blocks", ("n", db_->head_block_num()) );
    on_sync();
 }
@@ -492,6 +610,7 @@ bool chain_plugin_full::accept_block( const sophiatx::chain::signed_block& block
            ("p", block.witness) );
    }
 
+   FC_ASSERT( !read_only, "Read only node does not accept blocks" );
    check_time_in_block( block );
 
    boost::promise< void > prom;
@@ -500,7 +619,7 @@ bool chain_plugin_full::accept_block( const sophiatx::chain::signed_block& block
    cxt.skip = currently_syncing? skip | database::skip_validate_invariants : skip;
    cxt.prom_ptr = &prom;
 
-   write_queue.push( &cxt );
+   FC_ASSERT( write_queue.push( &cxt ), "Chain plugin is shutting down, write request was not queued." );
 
    prom.get_future().get();
 
@@ -511,12 +630,14 @@ bool chain_plugin_full::accept_block( const sophiatx::chain::signed_block& block
 
 void chain_plugin_full::accept_transaction( const sophiatx::chain::signed_transaction& trx )
 {
+   FC_ASSERT( !read_only, "Read only node does not accept transactions" );
+
    boost::promise< void > prom;
    write_context cxt;
    cxt.req_ptr = &trx;
    cxt.prom_ptr = &prom;
 
-   write_queue.push( &cxt );
+   FC_ASSERT( write_queue.push( &cxt ), "Chain plugin is shutting down, write request was not queued." );
 
    prom.get_future().get();
 
@@ -537,13 +658,15 @@ void chain_plugin_full::check_time_in_block( const sophiatx::chain::signed_block
 sophiatx::chain::signed_block chain_plugin_full::generate_block( const fc::time_point_sec& when, const account_name_type& witness_owner,
                                                          const fc::ecc::private_key& block_signing_private_key, uint32_t skip )
 {
+   FC_ASSERT( !read_only, "Read only node cannot generate blocks" );
+
    generate_block_request req( when, witness_owner, block_signing_private_key, skip );
    boost::promise< void > prom;
    write_context cxt;
    cxt.req_ptr = &req;
    cxt.prom_ptr = &prom;
 
-   write_queue.push( &cxt );
+   FC_ASSERT( write_queue.push( &cxt ), "Chain plugin is shutting down, write request was not queued." );
 
    prom.get_future().get();
 
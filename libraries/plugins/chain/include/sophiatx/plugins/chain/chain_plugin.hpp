@@ -6,6 +6,7 @@
 
 #include <appbase/application.hpp>
 #include <sophiatx/chain/database/database_interface.hpp>
+#include <sophiatx/plugins/chain/write_request_queue.hpp>
 
 #include <boost/signals2.hpp>
 
@@ -63,6 +64,10 @@ public:
       FC_ASSERT(false, "Not implemented for lite version of chain_plugin");
    }
 
+   virtual write_queue_stats get_write_queue_stats()const {
+      FC_ASSERT(false, "Not implemented for lite version of chain_plugin");
+   }
+
    template< typename MultiIndexType >
    bool has_index() const
    {
@@ -103,6 +108,9 @@ public:
    virtual std::shared_ptr<database_interface>& db() { return db_;}
    virtual const std::shared_ptr<database_interface>& db() const { return db_;}
 
+   /// Directory of the shared memory file and the block log
+   const bfs::path& get_shared_memory_dir()const { return shared_memory_dir; }
+
    // Emitted when the blockchain is syncing/live.
    // This is to synchronize plugins that have the chain plugin as an optional dependency.
    boost::signals2::signal<void()> on_sync;
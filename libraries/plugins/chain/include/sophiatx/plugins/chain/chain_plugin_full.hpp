@@ -6,7 +6,7 @@
 
 #include <fc/thread/future.hpp>
 
-#include <boost/lockfree/queue.hpp>
+#include <sophiatx/plugins/chain/write_request_queue.hpp>
 
 
 namespace sophiatx { namespace plugins { namespace chain {
@@ -66,23 +66,37 @@ public:
 
    int16_t set_write_lock_hold_time( int16_t new_time ) override;
 
+   write_queue_stats get_write_queue_stats()const override;
+
    void start_write_processing();
    void stop_write_processing();
 
 private:
    bool                             replay = false;
+   bool                             read_only = false;
    bool                             check_locks = false;
    bool                             validate_invariants = false;
    bool                             dump_memory_details = false;
    uint32_t                         stop_replay_at = 0;
    uint32_t                         benchmark_interval = 0;
+   uint32_t                         replay_decode_threads = 2;
+   uint32_t                         replay_queue_size = 64;
+   uint32_t                         block_log_chunk_size = 0;
+   bool                             flat_undo_log = false;
+   fc::path                         snapshot_export;
+   fc::path                         snapshot_import;
+   uint32_t                         signature_recovery_threads = 0;
+   uint32_t                         signature_key_cache_size = 100000;
+   bool                             operation_profiling = false;
    genesis_state_type               genesis;
    flat_map<uint32_t,block_id_type> loaded_checkpoints;
 
    int16_t                          write_lock_hold_time=500;
+   uint32_t                         write_batch_size = 0;
+   uint32_t                         write_lock_yield_time = 10;
 
    std::shared_ptr< std::thread >   write_processor_thread;
-   boost::lockfree::queue< write_context* > write_queue;
+   write_request_queue              write_queue;
 };
 
 } } } // sophiatx::plugins::chain
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <fc/time.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <deque>
+
+namespace sophiatx { namespace plugins { namespace chain {
+
+struct write_context;
+
+struct write_queue_stats
+{
+   uint32_t capacity = 0;
+   uint32_t depth = 0;
+   uint32_t max_depth = 0;
+   uint64_t pushed = 0;
+   /// Number of pushes which had to wait for room in a full queue
+   uint64_t full_waits = 0;
+   /// Time requests spent in the queue before the write thread picked them up
+   uint64_t total_wait_us = 0;
+   uint64_t max_wait_us = 0;
+   /// Write lock acquisitions and the number of requests processed under them
+   uint64_t batches = 0;
+   uint64_t batched_requests = 0;
+   uint32_t max_batch_size = 0;
+   /// Batches which released the lock to readers with requests left in the queue
+   uint64_t yields = 0;
+   uint64_t total_lock_hold_us = 0;
+   uint64_t max_lock_hold_us = 0;
+};
+
+/**
+ * Bounded queue of write requests between the threads calling accept_block, accept_transaction and generate_block
+ * and the write thread of chain_plugin_full.
+ *
+ * The write thread blocks in pop until a request arrives instead of polling, and producers block in push while the
+ * queue is full, so bursts are back pressured instead of growing the queue without bound.
+ */
+class write_request_queue
+{
+   public:
+      explicit write_request_queue( uint32_t capacity );
+
+      void set_capacity( uint32_t capacity );
+
+      /// Blocks while the queue is full, returns false if the queue was stopped
+      bool push( write_context* cxt );
+
+      /// Blocks until a request arrives, returns false once the queue is stopped
+      bool pop( write_context*& cxt );
+
+      /// Returns false if the queue is empty
+      bool try_pop( write_context*& cxt );
+
+      /// Wakes all waiting threads, push and pop fail from now on. Requests still queued are returned.
+      std::deque< write_context* > stop();
+
+      void record_batch( uint32_t size, const fc::microseconds& lock_hold, bool yielded );
+
+      write_queue_stats get_stats()const;
+
+   private:
+      bool pop_locked( write_context*& cxt );
+
+      struct entry
+      {
+         write_context*    cxt;
+         fc::time_point    pushed;
+      };
+
+      std::deque< entry >           _queue;
+      uint32_t                      _capacity;
+      bool                          _stopped = false;
+      write_queue_stats             _stats;
+      mutable boost::mutex          _mtx;
+      boost::condition_variable     _not_empty;
+      boost::condition_variable     _not_full;
+};
+
+} } } // sophiatx::plugins::chain
+
+FC_REFLECT( sophiatx::plugins::chain::write_queue_stats,
+            (capacity)(depth)(max_depth)(pushed)(full_waits)(total_wait_us)(max_wait_us)
+            (batches)(batched_requests)(max_batch_size)(yields)(total_lock_hold_us)(max_lock_hold_us) )
@@ -0,0 +1,117 @@
+#include <sophiatx/plugins/chain/write_request_queue.hpp>
+
+#include <fc/exception/exception.hpp>
+
+namespace sophiatx { namespace plugins { namespace chain {
+
+write_request_queue::write_request_queue( uint32_t capacity ) : _capacity( capacity )
+{
+   FC_ASSERT( capacity > 0, "Write queue needs room for at least one request" );
+}
+
+void write_request_queue::set_capacity( uint32_t capacity )
+{
+   FC_ASSERT( capacity > 0, "Write queue needs room for at least one request" );
+
+   boost::mutex::scoped_lock lock( _mtx );
+   _capacity = capacity;
+   _not_full.notify_all();
+}
+
+bool write_request_queue::push( write_context* cxt )
+{
+   boost::mutex::scoped_lock lock( _mtx );
+
+   if( _queue.size() >= _capacity && !_stopped )
+   {
+      ++_stats.full_waits;
+      _not_full.wait( lock, [&]() { return _queue.size() < _capacity || _stopped; } );
+   }
+
+   if( _stopped )
+      return false;
+
+   _queue.push_back( entry{ cxt, fc::time_point::now() } );
+   ++_stats.pushed;
+   _stats.max_depth = std::max( _stats.max_depth, uint32_t( _queue.size() ) );
+
+   _not_empty.notify_one();
+   return true;
+}
+
+bool write_request_queue::pop( write_context*& cxt )
+{
+   boost::mutex::scoped_lock lock( _mtx );
+   _not_empty.wait( lock, [&]() { return !_queue.empty() || _stopped; } );
+
+   if( _stopped )
+      return false;
+
+   return pop_locked( cxt );
+}
+
+bool write_request_queue::try_pop( write_context*& cxt )
+{
+   boost::mutex::scoped_lock lock( _mtx );
+
+   if( _stopped || _queue.empty() )
+      return false;
+
+   return pop_locked( cxt );
+}
+
+bool write_request_queue::pop_locked( write_context*& cxt )
+{
+   const auto& e = _queue.front();
+   cxt = e.cxt;
+
+   uint64_t wait_us = ( fc::time_point::now() - e.pushed ).count();
+   _stats.total_wait_us += wait_us;
+   _stats.max_wait_us = std::max( _stats.max_wait_us, wait_us );
+
+   _queue.pop_front();
+   _not_full.notify_one();
+   return true;
+}
+
+std::deque< write_context* > write_request_queue::stop()
+{
+   boost::mutex::scoped_lock lock( _mtx );
+   _stopped = true;
+
+   std::deque< write_context* > remaining;
+   for( const auto& e : _queue )
+      remaining.push_back( e.cxt );
+   _queue.clear();
+
+   _not_empty.notify_all();
+   _not_full.notify_all();
+   return remaining;
+}
+
+void write_request_queue::record_batch( uint32_t size, const fc::microseconds& lock_hold, bool yielded )
+{
+   boost::mutex::scoped_lock lock( _mtx );
+
+   ++_stats.batches;
+   _stats.batched_requests += size;
+   _stats.max_batch_size = std::max( _stats.max_batch_size, size );
+   if( yielded )
+      ++_stats.yields;
+
+   uint64_t hold_us = lock_hold.count();
+   _stats.total_lock_hold_us += hold_us;
+   _stats.max_lock_hold_us = std::max( _stats.max_lock_hold_us, hold_us );
+}
+
+write_queue_stats write_request_queue::get_stats()const
+{
+   boost::mutex::scoped_lock lock( _mtx );
+
+   auto result = _stats;
+   result.capacity = _capacity;
+   result.depth = _queue.size();
+   return result;
+}
+
+} } } // sophiatx::plugins::chain
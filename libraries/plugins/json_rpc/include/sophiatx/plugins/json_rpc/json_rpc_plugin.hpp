@@ -1,9 +1,13 @@
 #pragma once
 
 #include <appbase/application.hpp>
+#include <sophiatx/plugins/json_rpc/json_writer.hpp>
+#include <sophiatx/plugins/json_rpc/response_cache.hpp>
+#include <sophiatx/plugins/json_rpc/method_stats.hpp>
 #include <atomic>
 
 #include <fc/variant.hpp>
+#include <fc/io/raw.hpp>
 #include <fc/io/json.hpp>
 #include <fc/reflect/variant.hpp>
 #include <fc/exception/exception.hpp>
@@ -44,6 +48,16 @@
    for_each_api( vtor );                                                                        \
 }
 
+/**
+ * @brief Makes a method of an API registered with JSON_RPC_REGISTER_API
+ * callable over the binary websocket transport.
+ *
+ * Arguments and result of the method must be packable with fc::raw.
+ */
+#define JSON_RPC_REGISTER_BINARY_API_METHOD( API_NAME, METHOD )                                 \
+   sophiatx::plugins::json_rpc::detail::register_binary_api_method( API_NAME, BOOST_PP_STRINGIZE( METHOD ), \
+      *this, &std::remove_pointer< decltype( this ) >::type::METHOD );
+
 #define JSON_RPC_PARSE_ERROR        (-32700)
 #define JSON_RPC_INVALID_REQUEST    (-32600)
 #define JSON_RPC_METHOD_NOT_FOUND   (-32601)
@@ -53,6 +67,7 @@
 #define JSON_RPC_NO_PARAMS          (-32001)
 #define JSON_RPC_PARSE_PARAMS_ERROR (-32002)
 #define JSON_RPC_ERROR_DURING_CALL  (-32003)
+#define JSON_RPC_SERVER_BUSY        (-32004)
 
 namespace sophiatx { namespace plugins { namespace json_rpc {
 
@@ -66,6 +81,23 @@ using namespace appbase;
  */
 typedef std::function< fc::variant(const fc::variant&, const std::function<void( fc::variant&, uint64_t )>&, bool) > api_method;
 
+/**
+ * @brief Internal type used to bind api methods
+ * to names, writing the result as JSON.
+ *
+ * Used for JSON-RPC requests, the result is written
+ * without being converted to a variant.
+ */
+typedef std::function< void(const fc::variant&, const std::function<void( fc::variant&, uint64_t )>&, bool, json_writer&) > api_json_method;
+
+/**
+ * @brief Internal type used to bind api methods
+ * to names for the binary websocket transport.
+ *
+ * Arguments and result are packed with fc::raw.
+ */
+typedef std::function< std::vector< char >(const std::vector< char >&) > api_binary_method;
+
 /**
  * @brief An API, containing APIs and Methods
  *
@@ -75,6 +107,20 @@ typedef std::function< fc::variant(const fc::variant&, const std::function<void(
  */
 typedef std::map< string, api_method > api_description;
 
+/**
+ * @brief Runs a task on another thread, used to
+ * evaluate the requests of a batch in parallel.
+ * The task may be dropped, the thread evaluating
+ * the batch then evaluates its requests itself.
+ */
+typedef std::function< void( const std::function< void() >& ) > batch_executor;
+
+/**
+ * @brief Calls the function under a read lock of the
+ * chain state, used for rpc-batch-single-lock.
+ */
+typedef std::function< void( const std::function< void() >& ) > batch_read_lock;
+
 struct api_method_signature
 {
    fc::variant args;
@@ -103,6 +149,29 @@ class json_rpc_plugin : public appbase::plugin< json_rpc_plugin >
 
       std::optional< fc::variant > call_api_method(const string& api_name, const string& method_name, const fc::variant& func_args, const std::function<void( fc::variant&, uint64_t )>& notify_callback) const;
       void add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig );
+      void add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_json_method& json_api, const api_method_signature& sig );
+
+      /**
+       * Results of the method are looked up in the response cache. A result is only stored when the method called
+       * response_cache::admit() while computing it, which it must only do when the result can never change.
+       */
+      void add_cached_method( const string& api_name, const string& method_name );
+      response_cache_stats get_cache_stats()const;
+
+      rpc_stats get_stats()const;
+      /// Appends the per method counters in the Prometheus text format
+      void write_metrics( string& out )const;
+
+      void add_binary_api_method( const string& api_name, const string& method_name, const api_binary_method& api );
+
+      /// Evaluates a packed fc::rpc::binary_request, returns the packed fc::rpc::binary_response
+      string call_binary( const string& message );
+      /// Packed error response to a binary request which is not evaluated
+      string binary_error( const string& message, int32_t code, const string& error_message )const;
+
+      /// The webserver passes its thread pool, without an executor batches are evaluated serially
+      void set_batch_executor( const batch_executor& executor );
+      void set_batch_read_lock( const batch_read_lock& read_lock );
 
       string call( const string& body, bool& is_error);
       string call( const string& message, std::function<void(const string& )> callback);
@@ -142,6 +211,10 @@ namespace detail {
                {
                   return fc::variant( (plugin.*method)( args.as< Args >(), notify_callback, lock ) );
                },
+               [&plugin,method]( const fc::variant& args, const std::function<void( fc::variant&, uint64_t )>& notify_callback, bool lock, json_writer& w )
+               {
+                  w.write( (plugin.*method)( args.as< Args >(), notify_callback, lock ) );
+               },
                api_method_signature{ fc::variant( Args() ), fc::variant( Ret() ) } );
          }
 
@@ -150,6 +223,17 @@ namespace detail {
          sophiatx::plugins::json_rpc::json_rpc_plugin& _json_rpc_plugin;
    };
 
+   template< typename Plugin, typename Args, typename Ret >
+   void register_binary_api_method( const std::string& api_name, const std::string& method_name, Plugin& plugin,
+      Ret (Plugin::*method)( const Args&, const std::function<void( fc::variant&, uint64_t )>&, bool ) )
+   {
+      appbase::app().get_plugin< sophiatx::plugins::json_rpc::json_rpc_plugin >().add_binary_api_method( api_name, method_name,
+         [&plugin,method]( const std::vector< char >& args ) -> std::vector< char >
+         {
+            return fc::raw::pack_to_vector( (plugin.*method)( fc::raw::unpack_from_vector< Args >( args, 0 ), []( fc::variant&, uint64_t ){}, true ) );
+         } );
+   }
+
    class register_api_subscribe_method_visitor
    {
    public:
@@ -171,6 +255,10 @@ namespace detail {
                                            {
                                                  return fc::variant( (plugin.*method)( args.as< Args >(), notify_callback, lock ) );
                                            },
+                                           [&plugin,method]( const fc::variant& args, const std::function<void( fc::variant&, uint64_t )>& notify_callback, bool lock, json_writer& w )
+                                           {
+                                                 w.write( (plugin.*method)( args.as< Args >(), notify_callback, lock ) );
+                                           },
                                            api_method_signature{ fc::variant( Args() ), fc::variant( Ret() ) } );
       }
 
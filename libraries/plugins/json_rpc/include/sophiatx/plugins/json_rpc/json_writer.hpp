@@ -0,0 +1,277 @@
+#pragma once
+
+#include <fc/variant.hpp>
+#include <fc/variant_object.hpp>
+#include <fc/container/flat.hpp>
+#include <fc/reflect/variant.hpp>
+
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace sophiatx { namespace plugins { namespace json_rpc {
+
+class json_writer;
+
+namespace detail {
+
+   namespace to_variant_probe
+   {
+      struct generic_tag {};
+
+      /// Ties with the generic fc::to_variant of reflected types, so the call is ambiguous unless T has its own overload
+      template< typename T >
+      generic_tag to_variant( const T&, fc::variant& );
+
+      template< typename T, typename Enable = void >
+      struct has_custom_to_variant : std::false_type {};
+
+      template< typename T >
+      struct has_custom_to_variant< T, decltype( to_variant( std::declval< const T& >(), std::declval< fc::variant& >() ) ) > : std::true_type {};
+   }
+
+   /**
+    * Writes a value of type T as JSON. Types without a specialization, and reflected types with their own to_variant
+    * overload, are converted to an fc::variant first so their output does not change.
+    */
+   template< typename T, typename Enable = void >
+   struct json_serializer
+   {
+      static void write( json_writer& w, const T& v );
+   };
+
+}
+
+/**
+ * Writes values as JSON straight into a string, without building an fc::variant tree first.
+ *
+ * Reflected structs and enums, containers, optionals and primitives are walked directly. The output is the same as
+ * fc::json::to_string( fc::variant( v ) ): fields in declaration order, empty optional fields left out and integers
+ * above 2^32 and doubles written as strings. The string is appended to, so one buffer can be reused for many
+ * responses.
+ */
+class json_writer
+{
+   public:
+      explicit json_writer( std::string& out ) : _out( out ) {}
+
+      template< typename T >
+      void write( const T& v ) { detail::json_serializer< T >::write( *this, v ); }
+
+      void write( const fc::variant& v );
+
+      void write_raw( char c ) { _out.push_back( c ); }
+      void write_raw( const char* s, size_t size ) { _out.append( s, size ); }
+      void write_raw( const std::string& s ) { _out.append( s ); }
+
+      template< size_t N >
+      void write_raw( const char (&s)[ N ] ) { _out.append( s, N - 1 ); }
+
+      void write_null() { write_raw( "null" ); }
+      void write_bool( bool b ) { b ? write_raw( "true" ) : write_raw( "false" ); }
+      void write_int( int64_t i );
+      void write_uint( uint64_t i );
+      void write_string( const char* s, size_t size );
+      void write_string( const std::string& s ) { write_string( s.data(), s.size() ); }
+
+      /// Writes "key":
+      void write_key( const char* key ) { write_string( key, strlen( key ) ); write_raw( ':' ); }
+
+      template< typename Iterator >
+      void write_array( Iterator begin, Iterator end )
+      {
+         write_raw( '[' );
+         for( auto itr = begin; itr != end; ++itr )
+         {
+            if( itr != begin )
+               write_raw( ',' );
+            write( *itr );
+         }
+         write_raw( ']' );
+      }
+
+      std::string& buffer() { return _out; }
+
+   private:
+      std::string& _out;
+};
+
+namespace detail {
+
+   template< typename T, typename Enable >
+   void json_serializer< T, Enable >::write( json_writer& w, const T& v )
+   {
+      w.write( fc::variant( v ) );
+   }
+
+   template<>
+   struct json_serializer< bool >
+   {
+      static void write( json_writer& w, bool v ) { w.write_bool( v ); }
+   };
+
+   template< typename T >
+   struct json_serializer< T, typename std::enable_if< std::is_integral< T >::value && !std::is_same< T, bool >::value && !std::is_same< T, char >::value >::type >
+   {
+      static void write( json_writer& w, T v )
+      {
+         if( std::is_signed< T >::value )
+            w.write_int( int64_t( v ) );
+         else
+            w.write_uint( uint64_t( v ) );
+      }
+   };
+
+   template<>
+   struct json_serializer< std::string >
+   {
+      static void write( json_writer& w, const std::string& v ) { w.write_string( v ); }
+   };
+
+   template< typename T >
+   struct json_serializer< std::optional< T > >
+   {
+      static void write( json_writer& w, const std::optional< T >& v )
+      {
+         if( v )
+            w.write( *v );
+         else
+            w.write_null();
+      }
+   };
+
+   template< typename A, typename B >
+   struct json_serializer< std::pair< A, B > >
+   {
+      static void write( json_writer& w, const std::pair< A, B >& v )
+      {
+         w.write_raw( '[' );
+         w.write( v.first );
+         w.write_raw( ',' );
+         w.write( v.second );
+         w.write_raw( ']' );
+      }
+   };
+
+   /// Sequences and maps are arrays, maps as arrays of [key,value] pairs
+   template< typename Container >
+   struct json_array_serializer
+   {
+      static void write( json_writer& w, const Container& v ) { w.write_array( v.begin(), v.end() ); }
+   };
+
+   /// std::vector< char > is written as hex by fc
+   template< typename T, typename A >
+   struct json_serializer< std::vector< T, A >, typename std::enable_if< !std::is_same< T, char >::value >::type >
+      : json_array_serializer< std::vector< T, A > > {};
+
+   template< typename T, typename A >
+   struct json_serializer< std::deque< T, A > > : json_array_serializer< std::deque< T, A > > {};
+
+   template< typename T, typename C, typename A >
+   struct json_serializer< std::set< T, C, A > > : json_array_serializer< std::set< T, C, A > > {};
+
+   template< typename T, typename... A >
+   struct json_serializer< boost::container::flat_set< T, A... > > : json_array_serializer< boost::container::flat_set< T, A... > > {};
+
+   /// Maps with string keys are objects in fc
+   template< typename K, typename V, typename C, typename A >
+   struct json_serializer< std::map< K, V, C, A >, typename std::enable_if< !std::is_same< K, std::string >::value >::type >
+      : json_array_serializer< std::map< K, V, C, A > > {};
+
+   template< typename K, typename V, typename C, typename A >
+   struct json_serializer< std::multimap< K, V, C, A > > : json_array_serializer< std::multimap< K, V, C, A > > {};
+
+   template< typename K, typename... A >
+   struct json_serializer< boost::container::flat_map< K, A... > > : json_array_serializer< boost::container::flat_map< K, A... > > {};
+
+   template< typename Class >
+   struct json_object_visitor
+   {
+      json_object_visitor( json_writer& _w, const Class& _c ) : w( _w ), c( _c ) {}
+
+      template< typename Member, class C, Member (C::*member) >
+      void operator()( const char* name )const
+      {
+         add( name, c.*member );
+      }
+
+      template< typename M >
+      void add( const char* name, const std::optional< M >& v )const
+      {
+         if( v )
+            add( name, *v );
+      }
+
+      template< typename M >
+      void add( const char* name, const M& v )const
+      {
+         if( !first )
+            w.write_raw( ',' );
+         first = false;
+         w.write_key( name );
+         w.write( v );
+      }
+
+      json_writer&   w;
+      const Class&   c;
+      mutable bool   first = true;
+   };
+
+   template< typename T >
+   struct json_serializer< T, typename std::enable_if< fc::reflector< T >::is_defined::value && !fc::reflector< T >::is_enum::value
+      && !to_variant_probe::has_custom_to_variant< T >::value >::type >
+   {
+      static void write( json_writer& w, const T& v )
+      {
+         w.write_raw( '{' );
+         fc::reflector< T >::visit( json_object_visitor< T >( w, v ) );
+         w.write_raw( '}' );
+      }
+   };
+
+   template< typename T >
+   struct json_serializer< T, typename std::enable_if< fc::reflector< T >::is_defined::value && fc::reflector< T >::is_enum::value
+      && !to_variant_probe::has_custom_to_variant< T >::value >::type >
+   {
+      static void write( json_writer& w, const T& v ) { w.write_string( fc::reflector< T >::to_std_string( v ) ); }
+   };
+
+}
+
+inline void json_writer::write_int( int64_t i )
+{
+   // Same as fc::json, which writes integers above 2^32 as strings
+   char buf[ 24 ];
+   char* end = std::to_chars( buf, buf + sizeof( buf ), i ).ptr;
+   if( i > 0xffffffff )
+   {
+      write_raw( '"' );
+      write_raw( buf, end - buf );
+      write_raw( '"' );
+   }
+   else
+      write_raw( buf, end - buf );
+}
+
+inline void json_writer::write_uint( uint64_t i )
+{
+   char buf[ 24 ];
+   char* end = std::to_chars( buf, buf + sizeof( buf ), i ).ptr;
+   if( i > 0xffffffff )
+   {
+      write_raw( '"' );
+      write_raw( buf, end - buf );
+      write_raw( '"' );
+   }
+   else
+      write_raw( buf, end - buf );
+}
+
+} } } // sophiatx::plugins::json_rpc
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <fc/time.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sophiatx { namespace plugins { namespace json_rpc {
+
+struct latency_stats
+{
+   uint64_t count = 0;
+   uint64_t total_us = 0;
+   uint64_t max_us = 0;
+   uint64_t p50_us = 0;
+   uint64_t p90_us = 0;
+   uint64_t p99_us = 0;
+};
+
+/**
+ * Histogram of latencies in microseconds with power of 2 buckets. Bucket i holds latencies up to 2^i - 1 us, the last
+ * bucket holds everything longer. Not synchronized, owners guard it with their own mutex.
+ */
+class latency_histogram
+{
+   public:
+      static const uint32_t bucket_count = 32;
+
+      void record( uint64_t us );
+      latency_stats get()const;
+
+      static uint64_t upper_bound( uint32_t bucket ) { return bucket ? ( uint64_t( 1 ) << bucket ) - 1 : 0; }
+      uint64_t bucket( uint32_t i )const { return _buckets[ i ]; }
+      uint64_t count()const { return _count; }
+      uint64_t total_us()const { return _total_us; }
+
+   private:
+      std::array< uint64_t, bucket_count > _buckets = {};
+      uint64_t _count = 0;
+      uint64_t _total_us = 0;
+      uint64_t _max_us = 0;
+};
+
+struct api_method_stats
+{
+   /// api.method
+   std::string    method;
+   uint64_t       calls = 0;
+   uint64_t       errors = 0;
+   uint64_t       in_flight = 0;
+   /// Whole call, including the wait for the read lock
+   latency_stats  latency;
+   latency_stats  lock_wait;
+   latency_stats  execution;
+};
+
+struct slow_query
+{
+   std::string          method;
+   /// Arguments of the call, cut to a few hundred characters
+   std::string          params;
+   fc::time_point_sec   time;
+   uint64_t             duration_us = 0;
+   uint64_t             lock_wait_us = 0;
+   bool                 error = false;
+};
+
+struct rpc_stats
+{
+   std::vector< api_method_stats >  methods;
+   /// Latest sampled slow queries, oldest first
+   std::vector< slow_query >        slow_queries;
+   /// Calls slower than the threshold, sampled or not
+   uint64_t                         slow_query_count = 0;
+};
+
+/**
+ * Per method counters of the JSON-RPC calls.
+ *
+ * Calls slower than the slow query threshold are counted, and every sample_rate-th of them is logged and kept in a
+ * bounded list. Api methods report the time spent waiting for the database read lock with add_lock_wait(), so it
+ * can be split from the time spent executing the method.
+ */
+class method_stats_collector
+{
+   private:
+      struct entry
+      {
+         mutable std::mutex         mutex;
+         std::atomic< uint64_t >    in_flight{ 0 };
+         uint64_t                   errors = 0;
+         latency_histogram          latency;
+         latency_histogram          lock_wait;
+         latency_histogram          execution;
+      };
+
+   public:
+      struct call
+      {
+         entry*         e = nullptr;
+         std::string    method;
+         fc::time_point start;
+         uint64_t       lock_wait_before = 0;
+         uint64_t       duration_us = 0;
+         uint64_t       lock_wait_us = 0;
+      };
+
+      void set_slow_query_threshold( uint64_t us ) { _slow_query_threshold_us = us; }
+      void set_slow_query_sample_rate( uint32_t rate ) { _slow_query_sample_rate = std::max< uint32_t >( rate, 1 ); }
+      void set_slow_query_log_size( uint32_t size ) { _slow_query_log_size = size; }
+
+      /// Called by api methods with the time they waited for a lock, accumulated per thread
+      static void add_lock_wait( uint64_t us );
+
+      /// Starts timing a call of api.method on this thread
+      call begin( const std::string& method );
+
+      /// Records a call started with begin(), params are only written out when the call is a sampled slow query
+      template< typename ParamsWriter >
+      void end( call& c, bool error, ParamsWriter&& write_params )
+      {
+         if( finish( c, error ) )
+            log_slow_query( c, error, write_params() );
+      }
+
+      rpc_stats get_stats()const;
+
+      /// Appends the counters in the Prometheus text exposition format
+      void write_metrics( std::string& out )const;
+
+   private:
+      entry& get_entry( const std::string& method );
+
+      /// Returns true when the call is a sampled slow query
+      bool finish( call& c, bool error );
+      void log_slow_query( const call& c, bool error, std::string params );
+
+      /// 0 disables the slow query log
+      uint64_t                            _slow_query_threshold_us = 0;
+      uint32_t                            _slow_query_sample_rate = 1;
+      uint32_t                            _slow_query_log_size = 100;
+
+      mutable std::mutex                  _mutex;
+      /// Entries are never removed, so references to them stay valid
+      std::map< std::string, entry >      _entries;
+      std::deque< slow_query >            _slow_queries;
+      uint64_t                            _slow_query_count = 0;
+};
+
+} } } // sophiatx::plugins::json_rpc
+
+FC_REFLECT( sophiatx::plugins::json_rpc::latency_stats, (count)(total_us)(max_us)(p50_us)(p90_us)(p99_us) )
+FC_REFLECT( sophiatx::plugins::json_rpc::api_method_stats, (method)(calls)(errors)(in_flight)(latency)(lock_wait)(execution) )
+FC_REFLECT( sophiatx::plugins::json_rpc::slow_query, (method)(params)(time)(duration_us)(lock_wait_us)(error) )
+FC_REFLECT( sophiatx::plugins::json_rpc::rpc_stats, (methods)(slow_queries)(slow_query_count) )
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <fc/variant.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace sophiatx { namespace plugins { namespace json_rpc {
+
+struct response_cache_stats
+{
+   uint64_t entries = 0;
+   uint64_t size = 0;
+   uint64_t max_size = 0;
+   uint64_t hits = 0;
+   uint64_t misses = 0;
+   uint64_t admitted = 0;
+   uint64_t evicted = 0;
+};
+
+/**
+ * Least recently used cache of serialized JSON-RPC results, bounded by the memory taken by the keys and results.
+ *
+ * Only results of methods added with json_rpc_plugin::add_cached_method are looked up, and a result is only stored
+ * when the method called admit() while computing it. Methods admit results which can never change, such as results
+ * which only depend on irreversible blocks, so cached entries never have to be invalidated.
+ */
+class response_cache
+{
+   public:
+      explicit response_cache( uint64_t max_size ) : _max_size( max_size ) {}
+
+      /// Marks the result being computed on this thread as immutable
+      static void admit();
+
+      /// Clears the mark of this thread before a cached method is called
+      static void reset_admission();
+      static bool admitted();
+
+      /// Key of a call, the args are written with sorted object keys so equal requests share an entry
+      static std::string make_key( const std::string& api, const std::string& method, const fc::variant& args );
+
+      std::shared_ptr< const std::string > get( const std::string& key );
+      void put( const std::string& key, std::string result );
+
+      response_cache_stats get_stats()const;
+
+   private:
+      struct entry
+      {
+         std::string                            key;
+         std::shared_ptr< const std::string >   result;
+      };
+
+      /// Keys and results plus a rough estimate of the list and map nodes
+      static uint64_t entry_size( const entry& e ) { return e.key.size() + e.result->size() + 128; }
+
+      mutable std::mutex                                                   _mutex;
+      std::list< entry >                                                   _lru;
+      std::unordered_map< std::string, std::list< entry >::iterator >      _index;
+      uint64_t                                                             _size = 0;
+      uint64_t                                                             _max_size;
+
+      uint64_t                                                             _hits = 0;
+      uint64_t                                                             _misses = 0;
+      uint64_t                                                             _admitted = 0;
+      uint64_t                                                             _evicted = 0;
+};
+
+} } } // sophiatx::plugins::json_rpc
+
+FC_REFLECT( sophiatx::plugins::json_rpc::response_cache_stats, (entries)(size)(max_size)(hits)(misses)(admitted)(evicted) )
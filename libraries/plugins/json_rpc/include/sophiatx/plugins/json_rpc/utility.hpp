@@ -1,5 +1,7 @@
 #pragma once
 
+#include <sophiatx/plugins/json_rpc/method_stats.hpp>
+
 #include <type_traits>
 
 #include <fc/reflect/reflect.hpp>
@@ -47,7 +49,10 @@ BOOST_PP_CAT( method, _return ) class :: method ( const BOOST_PP_CAT( method, _a
 {                                                                                                        \
    if( lock )                                                                                            \
    {                                                                                                     \
-      return my->_db->with_read_lock( [&args, notify_callback, this](){ return my->method( args, notify_callback ); });                     \
+      auto lock_start = fc::time_point::now();                                                           \
+      return my->_db->with_read_lock( [&args, notify_callback, lock_start, this](){                      \
+         sophiatx::plugins::json_rpc::method_stats_collector::add_lock_wait( ( fc::time_point::now() - lock_start ).count() ); \
+         return my->method( args, notify_callback ); });                                                 \
    }                                                                                                     \
    else                                                                                                  \
    {                                                                                                     \
@@ -60,7 +65,10 @@ BOOST_PP_CAT( method, _return ) class :: method ( const BOOST_PP_CAT( method, _a
 {                                                                                                        \
    if( lock )                                                                                            \
    {                                                                                                     \
-      return my->_db->with_write_lock( [&args, notify_callback, this](){ return my->method( args, notify_callback ); });                    \
+      auto lock_start = fc::time_point::now();                                                           \
+      return my->_db->with_write_lock( [&args, notify_callback, lock_start, this](){                     \
+         sophiatx::plugins::json_rpc::method_stats_collector::add_lock_wait( ( fc::time_point::now() - lock_start ).count() ); \
+         return my->method( args, notify_callback ); });                                                 \
    }                                                                                                     \
    else                                                                                                  \
    {                                                                                                     \
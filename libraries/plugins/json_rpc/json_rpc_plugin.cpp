@@ -1,5 +1,6 @@
 #include <sophiatx/plugins/json_rpc/json_rpc_plugin.hpp>
 #include <sophiatx/plugins/json_rpc/utility.hpp>
+#include <sophiatx/plugins/json_rpc/response_cache.hpp>
 
 #include <sophiatx/remote_db/remote_db.hpp>
 
@@ -8,9 +9,13 @@
 #include <fc/exception/exception.hpp>
 #include <fc/macros.hpp>
 #include <fc/io/fstream.hpp>
+#include <fc/rpc/binary_api.hpp>
 
 #include <chainbase/chainbase.hpp>
 
+#include <condition_variable>
+#include <mutex>
+
 namespace sophiatx { namespace plugins { namespace json_rpc {
 
 namespace detail
@@ -36,8 +41,78 @@ namespace detail
       std::optional< fc::variant >      result;
       std::optional< json_rpc_error >   error;
       fc::variant                      id;
+
+      /// JSON of the result written by the api method, used instead of result when not empty
+      std::string                      result_json;
    };
 
+   void write_response( json_writer& w, const json_rpc_response& response )
+   {
+      // Same layout as fc::json::to_string( response )
+      w.write_raw( "{\"jsonrpc\":" );
+      w.write_string( response.jsonrpc );
+      if( response.result_json.size() )
+      {
+         w.write_raw( ",\"result\":" );
+         w.write_raw( response.result_json );
+      }
+      else if( response.result )
+      {
+         w.write_raw( ",\"result\":" );
+         w.write( *response.result );
+      }
+      if( response.error )
+      {
+         w.write_raw( ",\"error\":{\"code\":" );
+         w.write_int( response.error->code );
+         w.write_raw( ",\"message\":" );
+         w.write_string( response.error->message );
+         if( response.error->data )
+         {
+            w.write_raw( ",\"data\":" );
+            w.write( *response.error->data );
+         }
+         w.write_raw( '}' );
+      }
+      w.write_raw( ",\"id\":" );
+      w.write( response.id );
+      w.write_raw( '}' );
+   }
+
+   /// Responses are written to a buffer kept by the thread, so its capacity is reused by the next request
+   std::string& response_buffer()
+   {
+      thread_local std::string buffer;
+      // Do not keep the memory of an exceptionally large response
+      if( buffer.capacity() > 16 * 1024 * 1024 )
+         std::string().swap( buffer );
+      buffer.clear();
+      return buffer;
+   }
+
+   std::string to_json( const json_rpc_response& response )
+   {
+      std::string& buffer = response_buffer();
+      json_writer w( buffer );
+      write_response( w, response );
+      return buffer;
+   }
+
+   std::string to_json( const vector< json_rpc_response >& responses )
+   {
+      std::string& buffer = response_buffer();
+      json_writer w( buffer );
+      w.write_raw( '[' );
+      for( size_t i = 0; i < responses.size(); ++i )
+      {
+         if( i )
+            w.write_raw( ',' );
+         write_response( w, responses[ i ] );
+      }
+      w.write_raw( ']' );
+      return buffer;
+   }
+
    typedef void_type             get_methods_args;
    typedef vector< string >      get_methods_return;
 
@@ -48,6 +123,15 @@ namespace detail
 
    typedef api_method_signature  get_signature_return;
 
+   typedef void_type             get_cache_stats_args;
+   typedef response_cache_stats  get_cache_stats_return;
+
+   typedef void_type             get_binary_methods_args;
+   typedef vector< string >      get_binary_methods_return;
+
+   typedef void_type             get_stats_args;
+   typedef rpc_stats             get_stats_return;
+
    class json_rpc_logger
    {
    public:
@@ -113,6 +197,8 @@ namespace detail
 
          if (error)
             fc::json::save_to_file(response.error, file);
+         else if (response.result_json.size())
+            fc::json::save_to_file(fc::json::from_string(response.result_json), file);
          else
             fc::json::save_to_file(response.result, file);
       }
@@ -133,15 +219,22 @@ namespace detail
          ~json_rpc_plugin_impl();
 
          void add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig );
+         void add_api_json_method( const string& api_name, const string& method_name, const api_json_method& json_api );
+         string call_binary( const string& message );
 
 
          api_method* find_api_method( const std::string& api, const std::string& method );
          void process_params( string method, const fc::variant_object& request, std::string& api_name,
                string& method_name ,fc::variant& func_args);
          std::optional< fc::variant > call_api_method(const string& api_name, const string& method_name, const fc::variant& func_args, const std::function<void( fc::variant&, uint64_t )>& notify_callback, bool lock = true);
+         void write_api_method_result(const string& api_name, const string& method_name, const fc::variant& func_args, const std::function<void( fc::variant&, uint64_t )>& notify_callback, std::string& out, bool lock = true);
+         void write_api_method_json(const string& api_name, const string& method_name, const fc::variant& func_args, const std::function<void( fc::variant&, uint64_t )>& notify_callback, json_writer& w, bool lock);
          void rpc_id( const fc::variant_object& request, json_rpc_response& response );
-         void rpc_jsonrpc( const fc::variant_object& request, json_rpc_response& response, std::function<void(string)> callback );
-         json_rpc_response rpc( const fc::variant& message, std::function<void(string)> callback );
+         void rpc_jsonrpc( const fc::variant_object& request, json_rpc_response& response, std::function<void(string)> callback, bool lock = true );
+         /// Name the calls are counted under, unknown methods share one entry so requests cannot add entries at will
+         string stats_method_name( const string& api_name, const string& method_name )const;
+         json_rpc_response rpc( const fc::variant& message, std::function<void(string)> callback, bool lock = true );
+         vector< json_rpc_response > rpc_batch( const vector< fc::variant >& messages, std::function<void(string)> callback );
          void initialize();
 
          void log(const fc::variant_object& request, json_rpc_response& response, const std::string& api, const std::string& method)
@@ -159,12 +252,26 @@ namespace detail
 
          DECLARE_API(
             (get_methods)
-            (get_signature) )
+            (get_signature)
+            (get_cache_stats)
+            (get_binary_methods)
+            (get_stats) )
 
          map< string, api_description >                     _registered_apis;
+         map< string, map< string, api_json_method > >      _registered_json_apis;
+         map< string, map< string, api_binary_method > >    _registered_binary_apis;
          vector< string >                                   _methods;
+         std::set< string >                                 _cached_methods;
+         std::unique_ptr< response_cache >                  _response_cache;
          map< string, map< string, api_method_signature > > _method_sigs;
          std::unique_ptr< json_rpc_logger >                 _logger;
+         method_stats_collector                             _method_stats;
+
+         uint32_t                                           _batch_max_size = 1000;
+         uint32_t                                           _batch_concurrency = 4;
+         bool                                               _batch_single_lock = false;
+         batch_executor                                     _batch_executor;
+         batch_read_lock                                    _batch_read_lock;
    };
 
    json_rpc_plugin_impl::json_rpc_plugin_impl() {}
@@ -180,6 +287,11 @@ namespace detail
       _methods.push_back( canonical_name.str() );
    }
 
+   void json_rpc_plugin_impl::add_api_json_method( const string& api_name, const string& method_name, const api_json_method& json_api )
+   {
+      _registered_json_apis[ api_name ][ method_name ] = json_api;
+   }
+
 
    void json_rpc_plugin_impl::initialize()
    {
@@ -210,6 +322,90 @@ namespace detail
       return method_itr->second;
    }
 
+   get_cache_stats_return json_rpc_plugin_impl::get_cache_stats( const get_cache_stats_args& args, const std::function<void( fc::variant&, uint64_t )>& notify_callback, bool lock )
+   {
+      FC_UNUSED( lock )
+      FC_UNUSED( notify_callback )
+      return _response_cache ? _response_cache->get_stats() : get_cache_stats_return();
+   }
+
+   get_binary_methods_return json_rpc_plugin_impl::get_binary_methods( const get_binary_methods_args& args, const std::function<void( fc::variant&, uint64_t )>& notify_callback, bool lock )
+   {
+      FC_UNUSED( lock )
+      FC_UNUSED( notify_callback )
+      get_binary_methods_return result;
+      for( const auto& api : _registered_binary_apis )
+         for( const auto& method : api.second )
+            result.push_back( api.first + "." + method.first );
+      return result;
+   }
+
+   get_stats_return json_rpc_plugin_impl::get_stats( const get_stats_args& args, const std::function<void( fc::variant&, uint64_t )>& notify_callback, bool lock )
+   {
+      FC_UNUSED( lock )
+      FC_UNUSED( notify_callback )
+      return _method_stats.get_stats();
+   }
+
+   string json_rpc_plugin_impl::stats_method_name( const string& api_name, const string& method_name )const
+   {
+      auto api_itr = _registered_apis.find( api_name );
+      if( api_itr != _registered_apis.end() && api_itr->second.count( method_name ) )
+         return api_name + '.' + method_name;
+      return "unknown";
+   }
+
+   string json_rpc_plugin_impl::call_binary( const string& message )
+   {
+      fc::rpc::binary_response response;
+      fc::rpc::binary_request request;
+
+      try
+      {
+         request = fc::raw::unpack_from_char_array< fc::rpc::binary_request >( message.data(), message.size(), 0 );
+         response.id = request.id;
+      }
+      catch( fc::exception& e )
+      {
+         response.code = JSON_RPC_PARSE_ERROR;
+         response.message = e.to_string();
+      }
+
+      if( response.code == 0 )
+      {
+         auto api_itr = _registered_binary_apis.find( request.api );
+         auto method_itr = api_itr != _registered_binary_apis.end() ? api_itr->second.find( request.method ) : decltype( api_itr->second.end() )();
+
+         if( api_itr == _registered_binary_apis.end() || method_itr == api_itr->second.end() )
+         {
+            response.code = JSON_RPC_METHOD_NOT_FOUND;
+            response.message = "Method " + request.api + "." + request.method + " is not available in binary frames";
+         }
+         else
+         {
+            auto call = _method_stats.begin( request.api + '.' + request.method );
+            try
+            {
+               response.result = method_itr->second( request.args );
+            }
+            catch( fc::exception& e )
+            {
+               response.code = JSON_RPC_ERROR_DURING_CALL;
+               response.message = e.to_string();
+            }
+            catch( std::exception& e )
+            {
+               response.code = JSON_RPC_ERROR_DURING_CALL;
+               response.message = e.what();
+            }
+            _method_stats.end( call, response.code != 0, [&]() { return "binary, " + std::to_string( request.args.size() ) + " bytes"; } );
+         }
+      }
+
+      auto packed = fc::raw::pack_to_vector( response );
+      return string( packed.data(), packed.size() );
+   }
+
    api_method* json_rpc_plugin_impl::find_api_method( const std::string& api, const std::string& method )
    {
       auto api_itr = _registered_apis.find( api );
@@ -283,7 +479,56 @@ void json_rpc_plugin_impl::process_params( string method, const fc::variant_obje
       }
    }
 
-   void json_rpc_plugin_impl::rpc_jsonrpc( const fc::variant_object& request, json_rpc_response& response, std::function<void(string)> callback )
+   void json_rpc_plugin_impl::write_api_method_result(const string &api_name, const string &method_name, const fc::variant &func_args, const std::function<void( fc::variant&, uint64_t )>& notify_callback, std::string& out, bool lock) {
+      json_writer w( out );
+      size_t size = out.size();
+
+      std::string cache_key;
+      bool cached = _response_cache && _cached_methods.count( api_name + '.' + method_name );
+      if( cached )
+      {
+         cache_key = response_cache::make_key( api_name, method_name, func_args );
+         if( auto result = _response_cache->get( cache_key ) )
+         {
+            out.append( *result );
+            return;
+         }
+
+         response_cache::reset_admission();
+      }
+
+      try
+      {
+         write_api_method_json( api_name, method_name, func_args, notify_callback, w, lock );
+      }
+      catch( ... )
+      {
+         // Do not leave a partially written result behind
+         out.resize( size );
+         throw;
+      }
+
+      if( cached && response_cache::admitted() )
+         _response_cache->put( cache_key, out.substr( size ) );
+   }
+
+   void json_rpc_plugin_impl::write_api_method_json(const string &api_name, const string &method_name, const fc::variant &func_args, const std::function<void( fc::variant&, uint64_t )>& notify_callback, json_writer& w, bool lock) {
+      auto api_itr = _registered_json_apis.find( api_name );
+      if( api_itr != _registered_json_apis.end() )
+      {
+         auto method_itr = api_itr->second.find( method_name );
+         if( method_itr != api_itr->second.end() )
+         {
+            method_itr->second( func_args, notify_callback, lock, w );
+            return;
+         }
+      }
+
+      // Remote apis and methods added without a JSON writer go through the variant
+      w.write( *call_api_method( api_name, method_name, func_args, notify_callback, lock ) );
+   }
+
+   void json_rpc_plugin_impl::rpc_jsonrpc( const fc::variant_object& request, json_rpc_response& response, std::function<void(string)> callback, bool lock )
    {
       string api_name;
       string method_name;
@@ -310,9 +555,12 @@ void json_rpc_plugin_impl::process_params( string method, const fc::variant_obje
                      response.error = json_rpc_error( JSON_RPC_PARSE_PARAMS_ERROR, e.to_string(), fc::variant( *(e.dynamic_copy_exception()) ) );
                   }
 
-                  try
+                  if(!response.error.has_value())
                   {
-                     if(!response.error.has_value())
+                     auto write_params = [&func_args]() { return fc::json::to_string( func_args ); };
+                     auto call = _method_stats.begin( stats_method_name( api_name, method_name ) );
+
+                     try
                      {
                         std::function<void( fc::variant&, uint64_t )> notify = [callback](fc::variant& notify_message, uint64_t notify_id)->void
                         {
@@ -327,16 +575,23 @@ void json_rpc_plugin_impl::process_params( string method, const fc::variant_obje
                                 throw e;
                              }
                         };
-                        response.result = call_api_method(api_name, method_name, func_args, notify);
+                        write_api_method_result(api_name, method_name, func_args, notify, response.result_json, lock);
                      }
-                  }
-                  catch( chainbase::lock_exception& e )
-                  {
-                     response.error = json_rpc_error( JSON_RPC_ERROR_DURING_CALL, e.what() );
-                  }
-                  catch( fc::assert_exception& e )
-                  {
-                     response.error = json_rpc_error( JSON_RPC_ERROR_DURING_CALL, e.to_string(), fc::variant( *(e.dynamic_copy_exception()) ) );
+                     catch( chainbase::lock_exception& e )
+                     {
+                        response.error = json_rpc_error( JSON_RPC_ERROR_DURING_CALL, e.what() );
+                     }
+                     catch( fc::assert_exception& e )
+                     {
+                        response.error = json_rpc_error( JSON_RPC_ERROR_DURING_CALL, e.to_string(), fc::variant( *(e.dynamic_copy_exception()) ) );
+                     }
+                     catch( ... )
+                     {
+                        _method_stats.end( call, true, write_params );
+                        throw;
+                     }
+
+                     _method_stats.end( call, response.error.has_value(), write_params );
                   }
                }
                else
@@ -362,7 +617,7 @@ void json_rpc_plugin_impl::process_params( string method, const fc::variant_obje
       log(request, response, api_name, method_name);
    }
 
-   json_rpc_response json_rpc_plugin_impl::rpc( const fc::variant& message, std::function<void(string)> callback )
+   json_rpc_response json_rpc_plugin_impl::rpc( const fc::variant& message, std::function<void(string)> callback, bool lock )
    {
       json_rpc_response response;
 
@@ -378,7 +633,7 @@ void json_rpc_plugin_impl::process_params( string method, const fc::variant_obje
          try
          {
             if( !response.error.has_value() )
-               rpc_jsonrpc( request, response, callback );
+               rpc_jsonrpc( request, response, callback, lock );
          }
          catch( fc::exception& e )
          {
@@ -417,12 +672,87 @@ void json_rpc_plugin_impl::process_params( string method, const fc::variant_obje
       return response;
    }
 
+   vector< json_rpc_response > json_rpc_plugin_impl::rpc_batch( const vector< fc::variant >& messages, std::function<void(string)> callback )
+   {
+      vector< json_rpc_response > responses( messages.size() );
+
+      auto evaluate = [&]( bool lock )
+      {
+         size_t count = messages.size();
+         if( !_batch_executor || _batch_concurrency <= 1 || count == 1 )
+         {
+            for( size_t i = 0; i < count; ++i )
+               responses[ i ] = rpc( messages[ i ], callback, lock );
+            return;
+         }
+
+         /*
+          * Requests are claimed one at a time by this thread and by tasks posted to the executor. A task which starts
+          * after all requests were claimed returns without touching the batch, so this thread only waits for requests
+          * being evaluated, never for a task queued behind busy threads.
+          */
+         struct batch_state
+         {
+            std::atomic< size_t >      next{ 0 };
+            size_t                     done = 0;
+            std::mutex                 mutex;
+            std::condition_variable    cv;
+         };
+
+         auto state = std::make_shared< batch_state >();
+         auto work = [this, state, count, &messages, &responses, &callback, lock]()
+         {
+            for( size_t i = state->next++; i < count; i = state->next++ )
+            {
+               responses[ i ] = rpc( messages[ i ], callback, lock );
+
+               std::lock_guard< std::mutex > guard( state->mutex );
+               if( ++state->done == count )
+                  state->cv.notify_all();
+            }
+         };
+
+         for( size_t i = 1; i < std::min< size_t >( _batch_concurrency, count ); ++i )
+            _batch_executor( work );
+
+         work();
+
+         std::unique_lock< std::mutex > guard( state->mutex );
+         state->cv.wait( guard, [&]() { return state->done == count; } );
+      };
+
+      if( _batch_single_lock && _batch_read_lock )
+      {
+         try
+         {
+            // Requests run without taking the lock themselves, the lock held here covers the threads evaluating them
+            _batch_read_lock( [&]() { evaluate( false ); } );
+         }
+         catch( chainbase::lock_exception& e )
+         {
+            for( size_t i = 0; i < messages.size(); ++i )
+            {
+               responses[ i ] = json_rpc_response();
+               if( messages[ i ].is_object() )
+                  rpc_id( messages[ i ].get_object(), responses[ i ] );
+               responses[ i ].error = json_rpc_error( JSON_RPC_ERROR_DURING_CALL, e.what() );
+            }
+         }
+      }
+      else
+      {
+         evaluate( true );
+      }
+
+      return responses;
+   }
 
 }
 
 using detail::json_rpc_error;
 using detail::json_rpc_response;
 using detail::json_rpc_logger;
+using detail::to_json;
 
 json_rpc_plugin::json_rpc_plugin() : my( new detail::json_rpc_plugin_impl() ) {}
 json_rpc_plugin::~json_rpc_plugin() {}
@@ -431,6 +761,13 @@ void json_rpc_plugin::set_program_options( options_description& , options_descri
 {
    cfg.add_options()
       ("log-json-rpc", bpo::value< string >(), "json-rpc log directory name.")
+      ("rpc-batch-max-size", bpo::value< uint32_t >()->default_value( 1000 ), "Maximum number of requests in a batch, 0 for no limit.")
+      ("rpc-batch-concurrency", bpo::value< uint32_t >()->default_value( 4 ), "Number of requests of a batch evaluated in parallel on the webserver threads.")
+      ("rpc-batch-single-lock", bpo::value< bool >()->default_value( false ), "Evaluate all requests of a batch under one read lock, so their results share the same head block.")
+      ("rpc-response-cache-size", bpo::value< uint64_t >()->default_value( 64 ), "Size in MiB of the cache of responses to queries of irreversible data, 0 to disable.")
+      ("rpc-slow-query-threshold", bpo::value< uint32_t >()->default_value( 1000 ), "API calls taking longer than this many milliseconds are slow queries, 0 to disable the slow query log.")
+      ("rpc-slow-query-sample-rate", bpo::value< uint32_t >()->default_value( 1 ), "Log one of this many slow queries.")
+      ("rpc-slow-query-log-size", bpo::value< uint32_t >()->default_value( 100 ), "Number of latest logged slow queries returned by jsonrpc.get_stats.")
       ;
 }
 
@@ -438,6 +775,18 @@ void json_rpc_plugin::plugin_initialize( const variables_map& options )
 {
    my->initialize();
 
+   my->_batch_max_size = options.at( "rpc-batch-max-size" ).as< uint32_t >();
+   my->_batch_concurrency = options.at( "rpc-batch-concurrency" ).as< uint32_t >();
+   my->_batch_single_lock = options.at( "rpc-batch-single-lock" ).as< bool >();
+
+   uint64_t cache_size = options.at( "rpc-response-cache-size" ).as< uint64_t >();
+   if( cache_size )
+      my->_response_cache.reset( new response_cache( cache_size * 1024 * 1024 ) );
+
+   my->_method_stats.set_slow_query_threshold( uint64_t( options.at( "rpc-slow-query-threshold" ).as< uint32_t >() ) * 1000 );
+   my->_method_stats.set_slow_query_sample_rate( options.at( "rpc-slow-query-sample-rate" ).as< uint32_t >() );
+   my->_method_stats.set_slow_query_log_size( options.at( "rpc-slow-query-log-size" ).as< uint32_t >() );
+
    if( options.count( "log-json-rpc" ) )
    {
       auto dir_name = options.at( "log-json-rpc" ).as< string >();
@@ -458,11 +807,71 @@ void json_rpc_plugin::plugin_startup()
 
 void json_rpc_plugin::plugin_shutdown() {}
 
+void json_rpc_plugin::set_batch_executor( const batch_executor& executor )
+{
+   my->_batch_executor = executor;
+}
+
+void json_rpc_plugin::set_batch_read_lock( const batch_read_lock& read_lock )
+{
+   my->_batch_read_lock = read_lock;
+}
+
 void json_rpc_plugin::add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_method_signature& sig )
 {
    my->add_api_method( api_name, method_name, api, sig );
 }
 
+void json_rpc_plugin::add_api_method( const string& api_name, const string& method_name, const api_method& api, const api_json_method& json_api, const api_method_signature& sig )
+{
+   my->add_api_method( api_name, method_name, api, sig );
+   my->add_api_json_method( api_name, method_name, json_api );
+}
+
+void json_rpc_plugin::add_cached_method( const string& api_name, const string& method_name )
+{
+   my->_cached_methods.insert( api_name + '.' + method_name );
+}
+
+void json_rpc_plugin::add_binary_api_method( const string& api_name, const string& method_name, const api_binary_method& api )
+{
+   my->_registered_binary_apis[ api_name ][ method_name ] = api;
+}
+
+string json_rpc_plugin::call_binary( const string& message )
+{
+   return my->call_binary( message );
+}
+
+string json_rpc_plugin::binary_error( const string& message, int32_t code, const string& error_message )const
+{
+   fc::rpc::binary_response response;
+   response.code = code;
+   response.message = error_message;
+
+   // The id leads the request
+   if( message.size() >= sizeof( response.id ) )
+      memcpy( &response.id, message.data(), sizeof( response.id ) );
+
+   auto packed = fc::raw::pack_to_vector( response );
+   return string( packed.data(), packed.size() );
+}
+
+response_cache_stats json_rpc_plugin::get_cache_stats()const
+{
+   return my->_response_cache ? my->_response_cache->get_stats() : response_cache_stats();
+}
+
+rpc_stats json_rpc_plugin::get_stats()const
+{
+   return my->_method_stats.get_stats();
+}
+
+void json_rpc_plugin::write_metrics( string& out )const
+{
+   my->_method_stats.write_metrics( out );
+}
+
 string json_rpc_plugin::call( const string& message, bool& is_error)
 {
    is_error = false;
@@ -475,20 +884,24 @@ string json_rpc_plugin::call( const string& message, bool& is_error)
          vector< fc::variant > messages = v.as< vector< fc::variant > >();
          vector< json_rpc_response > responses;
 
-         if( messages.size() )
+         if( my->_batch_max_size && messages.size() > my->_batch_max_size )
+         {
+            json_rpc_response response;
+            response.error = json_rpc_error( JSON_RPC_SERVER_ERROR, "Batch is too large", fc::variant( my->_batch_max_size ) );
+            is_error = true;
+            return to_json( response );
+         }
+         else if( messages.size() )
          {
-            responses.reserve( messages.size() );
+            responses = my->rpc_batch( messages, [](string s){} );
 
-            for( auto& m : messages ){
-               auto response = my->rpc( m, [](string s){} );
+            for( const auto& response : responses ){
                if(response.error) {
                   is_error = true;
                }
-               responses.push_back( std::move(response) );
             }
 
-
-            return fc::json::to_string( responses );
+            return to_json( responses );
          }
          else
          {
@@ -496,7 +909,7 @@ string json_rpc_plugin::call( const string& message, bool& is_error)
             json_rpc_response response;
             response.error = json_rpc_error( JSON_RPC_SERVER_ERROR, "Array is invalid" );
             is_error = true;
-            return fc::json::to_string( response );
+            return to_json( response );
          }
       }
       else
@@ -505,7 +918,7 @@ string json_rpc_plugin::call( const string& message, bool& is_error)
          if(response.error) {
             is_error = true;
          }
-         return fc::json::to_string( response );
+         return to_json( response );
       }
    }
    catch( fc::exception& e )
@@ -513,7 +926,7 @@ string json_rpc_plugin::call( const string& message, bool& is_error)
       json_rpc_response response;
       response.error = json_rpc_error( JSON_RPC_SERVER_ERROR, e.to_string(), fc::variant( *(e.dynamic_copy_exception()) ) );
       is_error = true;
-      return fc::json::to_string( response );
+      return to_json( response );
    }
    catch( ... )
    {
@@ -521,7 +934,7 @@ string json_rpc_plugin::call( const string& message, bool& is_error)
       response.error = json_rpc_error( JSON_RPC_SERVER_ERROR, "Unknown exception", fc::variant(
          fc::unhandled_exception( FC_LOG_MESSAGE( warn, "Unknown Exception" ), std::current_exception() ).to_detail_string() ) );
       is_error = true;
-      return fc::json::to_string( response );
+      return to_json( response );
    }
 
 }
@@ -538,40 +951,43 @@ string json_rpc_plugin::call( const string& message, std::function<void(const st
          vector< fc::variant > messages = v.as< vector< fc::variant > >();
          vector< json_rpc_response > responses;
 
-         if( messages.size() )
+         if( my->_batch_max_size && messages.size() > my->_batch_max_size )
          {
-            responses.reserve( messages.size() );
-
-            for( auto& m : messages )
-               responses.push_back( my->rpc( m, callback ) );
+            json_rpc_response response;
+            response.error = json_rpc_error( JSON_RPC_SERVER_ERROR, "Batch is too large", fc::variant( my->_batch_max_size ) );
+            return to_json( response );
+         }
+         else if( messages.size() )
+         {
+            responses = my->rpc_batch( messages, callback );
 
-            return fc::json::to_string( responses );
+            return to_json( responses );
          }
          else
          {
             //For example: message == "[]"
             json_rpc_response response;
             response.error = json_rpc_error( JSON_RPC_SERVER_ERROR, "Array is invalid" );
-            return fc::json::to_string( response );
+            return to_json( response );
          }
       }
       else
       {
-         return fc::json::to_string( my->rpc( v, callback ) );
+         return to_json( my->rpc( v, callback ) );
       }
    }
    catch( fc::exception& e )
    {
       json_rpc_response response;
       response.error = json_rpc_error( JSON_RPC_SERVER_ERROR, e.to_string(), fc::variant( *(e.dynamic_copy_exception()) ) );
-      return fc::json::to_string( response );
+      return to_json( response );
    }
    catch( ... )
    {
       json_rpc_response response;
       response.error = json_rpc_error( JSON_RPC_SERVER_ERROR, "Unknown exception", fc::variant(
             fc::unhandled_exception( FC_LOG_MESSAGE( warn, "Unknown Exception" ), std::current_exception() ).to_detail_string() ) );
-      return fc::json::to_string( response );
+      return to_json( response );
    }
 
 }
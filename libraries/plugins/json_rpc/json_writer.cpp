@@ -0,0 +1,95 @@
+#include <sophiatx/plugins/json_rpc/json_writer.hpp>
+
+namespace sophiatx { namespace plugins { namespace json_rpc {
+
+void json_writer::write( const fc::variant& v )
+{
+   switch( v.get_type() )
+   {
+      case fc::variant::null_type:
+         write_null();
+         return;
+      case fc::variant::int64_type:
+         write_int( v.as_int64() );
+         return;
+      case fc::variant::uint64_type:
+         write_uint( v.as_uint64() );
+         return;
+      case fc::variant::double_type:
+         write_raw( '"' );
+         write_raw( v.as_string() );
+         write_raw( '"' );
+         return;
+      case fc::variant::bool_type:
+         write_bool( v.as_bool() );
+         return;
+      case fc::variant::string_type:
+         write_string( v.get_string() );
+         return;
+      case fc::variant::blob_type:
+         write_string( v.as_string() );
+         return;
+      case fc::variant::array_type:
+      {
+         const auto& a = v.get_array();
+         write_array( a.begin(), a.end() );
+         return;
+      }
+      case fc::variant::object_type:
+      {
+         const auto& o = v.get_object();
+         write_raw( '{' );
+         for( auto itr = o.begin(); itr != o.end(); ++itr )
+         {
+            if( itr != o.begin() )
+               write_raw( ',' );
+            write_string( itr->key() );
+            write_raw( ':' );
+            write( itr->value() );
+         }
+         write_raw( '}' );
+         return;
+      }
+   }
+}
+
+void json_writer::write_string( const char* s, size_t size )
+{
+   // Escapes the same characters as fc::json, everything else is copied as is
+   static const char hex[] = "0123456789abcdef";
+
+   _out.reserve( _out.size() + size + 2 );
+   _out.push_back( '"' );
+
+   const char* end = s + size;
+   const char* plain = s;
+   for( const char* c = s; c != end; ++c )
+   {
+      unsigned char ch = *c;
+      if( ch >= 0x20 && ch != '"' && ch != '\\' )
+         continue;
+
+      _out.append( plain, c - plain );
+      plain = c + 1;
+
+      switch( ch )
+      {
+         case '\b': _out.append( "\\b", 2 ); break;
+         case '\f': _out.append( "\\f", 2 ); break;
+         case '\n': _out.append( "\\n", 2 ); break;
+         case '\r': _out.append( "\\r", 2 ); break;
+         case '\t': _out.append( "\\t", 2 ); break;
+         case '\\': _out.append( "\\\\", 2 ); break;
+         case '"':  _out.append( "\\\"", 2 ); break;
+         default:
+            _out.append( "\\u00", 4 );
+            _out.push_back( hex[ ch >> 4 ] );
+            _out.push_back( hex[ ch & 0xf ] );
+      }
+   }
+
+   _out.append( plain, end - plain );
+   _out.push_back( '"' );
+}
+
+} } } // sophiatx::plugins::json_rpc
@@ -0,0 +1,230 @@
+#include <sophiatx/plugins/json_rpc/method_stats.hpp>
+
+#include <fc/log/logger.hpp>
+
+namespace sophiatx { namespace plugins { namespace json_rpc {
+
+namespace detail {
+
+   thread_local uint64_t lock_wait_us = 0;
+
+   uint32_t latency_bucket( uint64_t us )
+   {
+      uint32_t bucket = 0;
+      while( us && bucket + 1 < latency_histogram::bucket_count )
+      {
+         us >>= 1;
+         ++bucket;
+      }
+      return bucket;
+   }
+
+   std::string seconds( uint64_t us )
+   {
+      return std::to_string( us / 1000000 ) + "." + std::to_string( 1000000 + us % 1000000 ).substr( 1 );
+   }
+
+   void write_histogram( std::string& out, const char* name, const std::string& method, const latency_histogram& h )
+   {
+      uint32_t last = 0;
+      for( uint32_t i = 0; i < latency_histogram::bucket_count; ++i )
+         if( h.bucket( i ) )
+            last = i;
+
+      // Buckets after the last used one add nothing but the +Inf bucket
+      uint64_t cumulative = 0;
+      for( uint32_t i = 0; i <= last && i + 1 < latency_histogram::bucket_count; ++i )
+      {
+         cumulative += h.bucket( i );
+         out.append( name ).append( "_bucket{method=\"" ).append( method ).append( "\",le=\"" )
+            .append( seconds( latency_histogram::upper_bound( i ) ) ).append( "\"} " ).append( std::to_string( cumulative ) ).append( 1, '\n' );
+      }
+      out.append( name ).append( "_bucket{method=\"" ).append( method ).append( "\",le=\"+Inf\"} " ).append( std::to_string( h.count() ) ).append( 1, '\n' );
+      out.append( name ).append( "_sum{method=\"" ).append( method ).append( "\"} " ).append( seconds( h.total_us() ) ).append( 1, '\n' );
+      out.append( name ).append( "_count{method=\"" ).append( method ).append( "\"} " ).append( std::to_string( h.count() ) ).append( 1, '\n' );
+   }
+
+}
+
+void latency_histogram::record( uint64_t us )
+{
+   ++_buckets[ detail::latency_bucket( us ) ];
+   ++_count;
+   _total_us += us;
+   _max_us = std::max( _max_us, us );
+}
+
+latency_stats latency_histogram::get()const
+{
+   latency_stats stats;
+   stats.count = _count;
+   stats.total_us = _total_us;
+   stats.max_us = _max_us;
+
+   if( !_count )
+      return stats;
+
+   // Percentiles are the upper bounds of their buckets, which are powers of 2
+   auto percentile = [&]( uint64_t permille )
+   {
+      uint64_t rank = ( _count * permille + 999 ) / 1000;
+      uint64_t seen = 0;
+      for( uint32_t i = 0; i < bucket_count; ++i )
+      {
+         seen += _buckets[ i ];
+         if( seen >= rank )
+            return std::min< uint64_t >( upper_bound( i ), _max_us );
+      }
+      return _max_us;
+   };
+
+   stats.p50_us = percentile( 500 );
+   stats.p90_us = percentile( 900 );
+   stats.p99_us = percentile( 990 );
+   return stats;
+}
+
+void method_stats_collector::add_lock_wait( uint64_t us )
+{
+   detail::lock_wait_us += us;
+}
+
+method_stats_collector::entry& method_stats_collector::get_entry( const std::string& method )
+{
+   std::lock_guard< std::mutex > guard( _mutex );
+   return _entries[ method ];
+}
+
+method_stats_collector::call method_stats_collector::begin( const std::string& method )
+{
+   call c;
+   c.e = &get_entry( method );
+   c.method = method;
+   c.lock_wait_before = detail::lock_wait_us;
+   c.start = fc::time_point::now();
+   ++c.e->in_flight;
+   return c;
+}
+
+bool method_stats_collector::finish( call& c, bool error )
+{
+   c.duration_us = std::max< int64_t >( ( fc::time_point::now() - c.start ).count(), 0 );
+   // Batches may run a call under a lock taken before it started, then the call reports no wait
+   c.lock_wait_us = std::min( detail::lock_wait_us - c.lock_wait_before, c.duration_us );
+   --c.e->in_flight;
+
+   {
+      std::lock_guard< std::mutex > guard( c.e->mutex );
+      if( error )
+         ++c.e->errors;
+      c.e->latency.record( c.duration_us );
+      c.e->lock_wait.record( c.lock_wait_us );
+      c.e->execution.record( c.duration_us - c.lock_wait_us );
+   }
+
+   if( !_slow_query_threshold_us || c.duration_us < _slow_query_threshold_us )
+      return false;
+
+   std::lock_guard< std::mutex > guard( _mutex );
+   return _slow_query_count++ % _slow_query_sample_rate == 0;
+}
+
+void method_stats_collector::log_slow_query( const call& c, bool error, std::string params )
+{
+   if( params.size() > 512 )
+   {
+      params.resize( 512 );
+      params.append( "..." );
+   }
+
+   wlog( "Slow API call ${m} took ${d} us, ${l} us waiting for the lock: ${p}",
+         ("m", c.method)("d", c.duration_us)("l", c.lock_wait_us)("p", params) );
+
+   slow_query q;
+   q.method = c.method;
+   q.params = std::move( params );
+   q.time = fc::time_point_sec( fc::time_point::now() );
+   q.duration_us = c.duration_us;
+   q.lock_wait_us = c.lock_wait_us;
+   q.error = error;
+
+   std::lock_guard< std::mutex > guard( _mutex );
+   _slow_queries.push_back( std::move( q ) );
+   while( _slow_queries.size() > _slow_query_log_size )
+      _slow_queries.pop_front();
+}
+
+rpc_stats method_stats_collector::get_stats()const
+{
+   rpc_stats stats;
+
+   std::lock_guard< std::mutex > guard( _mutex );
+   stats.methods.reserve( _entries.size() );
+   for( const auto& item : _entries )
+   {
+      api_method_stats m;
+      m.method = item.first;
+      m.in_flight = item.second.in_flight.load();
+
+      std::lock_guard< std::mutex > entry_guard( item.second.mutex );
+      m.calls = item.second.latency.count();
+      m.errors = item.second.errors;
+      m.latency = item.second.latency.get();
+      m.lock_wait = item.second.lock_wait.get();
+      m.execution = item.second.execution.get();
+      stats.methods.push_back( std::move( m ) );
+   }
+
+   stats.slow_queries.assign( _slow_queries.begin(), _slow_queries.end() );
+   stats.slow_query_count = _slow_query_count;
+   return stats;
+}
+
+void method_stats_collector::write_metrics( std::string& out )const
+{
+   struct snapshot
+   {
+      uint64_t             in_flight;
+      uint64_t             errors;
+      latency_histogram    latency;
+      latency_histogram    lock_wait;
+   };
+
+   std::map< std::string, snapshot > methods;
+   uint64_t slow_query_count;
+
+   {
+      std::lock_guard< std::mutex > guard( _mutex );
+      for( const auto& item : _entries )
+      {
+         std::lock_guard< std::mutex > entry_guard( item.second.mutex );
+         methods[ item.first ] = snapshot{ item.second.in_flight.load(), item.second.errors, item.second.latency, item.second.lock_wait };
+      }
+      slow_query_count = _slow_query_count;
+   }
+
+   out.append( "# HELP sophiatx_rpc_calls_total JSON-RPC calls by method.\n# TYPE sophiatx_rpc_calls_total counter\n" );
+   for( const auto& m : methods )
+      out.append( "sophiatx_rpc_calls_total{method=\"" ).append( m.first ).append( "\"} " ).append( std::to_string( m.second.latency.count() ) ).append( 1, '\n' );
+
+   out.append( "# HELP sophiatx_rpc_errors_total JSON-RPC calls which returned an error.\n# TYPE sophiatx_rpc_errors_total counter\n" );
+   for( const auto& m : methods )
+      out.append( "sophiatx_rpc_errors_total{method=\"" ).append( m.first ).append( "\"} " ).append( std::to_string( m.second.errors ) ).append( 1, '\n' );
+
+   out.append( "# HELP sophiatx_rpc_in_flight JSON-RPC calls being evaluated.\n# TYPE sophiatx_rpc_in_flight gauge\n" );
+   for( const auto& m : methods )
+      out.append( "sophiatx_rpc_in_flight{method=\"" ).append( m.first ).append( "\"} " ).append( std::to_string( m.second.in_flight ) ).append( 1, '\n' );
+
+   out.append( "# HELP sophiatx_rpc_duration_seconds Duration of JSON-RPC calls.\n# TYPE sophiatx_rpc_duration_seconds histogram\n" );
+   for( const auto& m : methods )
+      detail::write_histogram( out, "sophiatx_rpc_duration_seconds", m.first, m.second.latency );
+
+   out.append( "# HELP sophiatx_rpc_lock_wait_seconds Time JSON-RPC calls waited for the database read lock.\n# TYPE sophiatx_rpc_lock_wait_seconds histogram\n" );
+   for( const auto& m : methods )
+      detail::write_histogram( out, "sophiatx_rpc_lock_wait_seconds", m.first, m.second.lock_wait );
+
+   out.append( "# HELP sophiatx_rpc_slow_queries_total JSON-RPC calls slower than the slow query threshold.\n# TYPE sophiatx_rpc_slow_queries_total counter\n" );
+   out.append( "sophiatx_rpc_slow_queries_total " ).append( std::to_string( slow_query_count ) ).append( 1, '\n' );
+}
+
+} } } // sophiatx::plugins::json_rpc
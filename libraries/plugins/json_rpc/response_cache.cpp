@@ -0,0 +1,142 @@
+#include <sophiatx/plugins/json_rpc/response_cache.hpp>
+#include <sophiatx/plugins/json_rpc/json_writer.hpp>
+
+#include <algorithm>
+
+namespace sophiatx { namespace plugins { namespace json_rpc {
+
+namespace detail {
+
+   thread_local bool response_admitted = false;
+
+   void write_canonical( json_writer& w, const fc::variant& v )
+   {
+      if( v.is_object() )
+      {
+         const auto& o = v.get_object();
+         std::vector< const fc::variant_object::entry* > entries;
+         entries.reserve( o.size() );
+         for( const auto& e : o )
+            entries.push_back( &e );
+
+         std::sort( entries.begin(), entries.end(), []( const fc::variant_object::entry* a, const fc::variant_object::entry* b )
+         {
+            return a->key() < b->key();
+         });
+
+         w.write_raw( '{' );
+         for( size_t i = 0; i < entries.size(); ++i )
+         {
+            if( i )
+               w.write_raw( ',' );
+            w.write_string( entries[ i ]->key() );
+            w.write_raw( ':' );
+            write_canonical( w, entries[ i ]->value() );
+         }
+         w.write_raw( '}' );
+      }
+      else if( v.is_array() )
+      {
+         const auto& a = v.get_array();
+         w.write_raw( '[' );
+         for( size_t i = 0; i < a.size(); ++i )
+         {
+            if( i )
+               w.write_raw( ',' );
+            write_canonical( w, a[ i ] );
+         }
+         w.write_raw( ']' );
+      }
+      else
+      {
+         w.write( v );
+      }
+   }
+
+}
+
+void response_cache::admit()
+{
+   detail::response_admitted = true;
+}
+
+void response_cache::reset_admission()
+{
+   detail::response_admitted = false;
+}
+
+bool response_cache::admitted()
+{
+   return detail::response_admitted;
+}
+
+std::string response_cache::make_key( const std::string& api, const std::string& method, const fc::variant& args )
+{
+   std::string key;
+   key.reserve( api.size() + method.size() + 64 );
+   key.append( api ).append( 1, '.' ).append( method ).append( 1, ':' );
+
+   json_writer w( key );
+   detail::write_canonical( w, args );
+   return key;
+}
+
+std::shared_ptr< const std::string > response_cache::get( const std::string& key )
+{
+   std::lock_guard< std::mutex > guard( _mutex );
+
+   auto itr = _index.find( key );
+   if( itr == _index.end() )
+   {
+      ++_misses;
+      return std::shared_ptr< const std::string >();
+   }
+
+   ++_hits;
+   _lru.splice( _lru.begin(), _lru, itr->second );
+   return itr->second->result;
+}
+
+void response_cache::put( const std::string& key, std::string result )
+{
+   entry e{ key, std::make_shared< const std::string >( std::move( result ) ) };
+   uint64_t size = entry_size( e );
+   if( size > _max_size )
+      return;
+
+   std::lock_guard< std::mutex > guard( _mutex );
+
+   // Another thread may have computed the same result meanwhile
+   if( _index.count( key ) )
+      return;
+
+   while( _size + size > _max_size && !_lru.empty() )
+   {
+      _size -= entry_size( _lru.back() );
+      _index.erase( _lru.back().key );
+      _lru.pop_back();
+      ++_evicted;
+   }
+
+   _lru.push_front( std::move( e ) );
+   _index[ key ] = _lru.begin();
+   _size += size;
+   ++_admitted;
+}
+
+response_cache_stats response_cache::get_stats()const
+{
+   std::lock_guard< std::mutex > guard( _mutex );
+
+   response_cache_stats stats;
+   stats.entries = _lru.size();
+   stats.size = _size;
+   stats.max_size = _max_size;
+   stats.hits = _hits;
+   stats.misses = _misses;
+   stats.admitted = _admitted;
+   stats.evicted = _evicted;
+   return stats;
+}
+
+} } } // sophiatx::plugins::json_rpc
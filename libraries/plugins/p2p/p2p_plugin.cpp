@@ -517,7 +517,7 @@ void p2p_plugin::plugin_initialize(const boost::program_options::variables_map&
    }
 #if !defined (IS_TEST_NET)
    else {
-       if(!sophiatx::chain::sophiatx_config::get<bool>("IS_PRIVATE_NET")) {
+       if(!sophiatx::chain::sophiatx_config::params().is_private_net) {
            for(int i=1; i<=6; i++){
                string seednode = string("seednode")+std::to_string(i)+string(".sophiatx.com:60000");
                seeds.push_back(seednode);
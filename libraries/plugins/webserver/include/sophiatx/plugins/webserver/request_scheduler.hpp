@@ -0,0 +1,122 @@
+#pragma once
+
+#include <sophiatx/plugins/json_rpc/method_stats.hpp>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace sophiatx { namespace plugins { namespace webserver {
+
+enum request_lane
+{
+   priority_lane,
+   normal_lane,
+   lane_count
+};
+
+using json_rpc::latency_stats;
+using json_rpc::latency_histogram;
+
+struct lane_stats
+{
+   uint64_t       queued = 0;
+   uint64_t       accepted = 0;
+   uint64_t       rejected = 0;
+   uint64_t       completed = 0;
+   /// Time from admission until a thread picks the request up
+   latency_stats  wait;
+   /// Time spent evaluating the request
+   latency_stats  service;
+};
+
+struct request_scheduler_stats
+{
+   lane_stats     priority;
+   lane_stats     normal;
+   /// Requests rejected because their connection had too many requests in flight
+   uint64_t       rejected_connection_limit = 0;
+};
+
+/**
+ * Admission control in front of the webserver thread pool.
+ *
+ * Requests are queued in two lanes, transaction and block broadcasts in the priority lane and everything else in the
+ * normal lane. Each request posts one runner to the thread pool, and a runner evaluates the oldest request of the
+ * priority lane if there is one, so broadcasts overtake queued reads. A request is rejected right away when its lane
+ * is full or when its connection already has too many requests in flight.
+ */
+class request_scheduler
+{
+   public:
+      typedef std::function< void( const std::function< void() >& ) > executor;
+
+      enum submit_result
+      {
+         accepted,
+         queue_full,
+         connection_limit
+      };
+
+      request_scheduler( const executor& post, uint32_t max_priority_queue, uint32_t max_normal_queue, uint32_t max_in_flight_per_connection );
+
+      void set_priority_methods( const std::set< std::string >& methods ) { _priority_methods = methods; }
+
+      /// Lane of a method given as api.method
+      request_lane classify( const std::string& method )const;
+
+      /// Tasks without a connection, such as the parts of a batch, are not counted against the connection limit
+      submit_result submit( request_lane lane, const void* connection, std::function< void() > task );
+
+      request_scheduler_stats get_stats()const;
+
+      /**
+       * Method as api.method and id as JSON text of a request, found without parsing the whole body.
+       * Returns false for batches and for bodies which are not a JSON object. The id is null unless the request has
+       * a string, number or null id.
+       */
+      static bool scan_request( const std::string& body, std::string& method, std::string& id );
+
+   private:
+      struct request
+      {
+         std::function< void() >   task;
+         const void*               connection;
+         int64_t                   enqueued_us;
+      };
+
+      struct lane
+      {
+         std::deque< request >     queue;
+         uint32_t                  max_queue;
+         uint64_t                  accepted = 0;
+         uint64_t                  rejected = 0;
+         uint64_t                  completed = 0;
+         latency_histogram         wait;
+         latency_histogram         service;
+
+         lane_stats get()const;
+      };
+
+      void run_next();
+
+      executor                               _post;
+      uint32_t                               _max_in_flight_per_connection;
+      std::set< std::string >                _priority_methods;
+
+      mutable std::mutex                     _mutex;
+      std::array< lane, lane_count >         _lanes;
+      std::map< const void*, uint32_t >      _in_flight;
+      uint64_t                               _rejected_connection_limit = 0;
+};
+
+} } } // sophiatx::plugins::webserver
+
+FC_REFLECT( sophiatx::plugins::webserver::lane_stats, (queued)(accepted)(rejected)(completed)(wait)(service) )
+FC_REFLECT( sophiatx::plugins::webserver::request_scheduler_stats, (priority)(normal)(rejected_connection_limit) )
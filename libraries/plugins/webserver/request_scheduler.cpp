@@ -0,0 +1,302 @@
+#include <sophiatx/plugins/webserver/request_scheduler.hpp>
+
+#include <fc/log/logger.hpp>
+#include <fc/time.hpp>
+
+#include <cctype>
+
+namespace sophiatx { namespace plugins { namespace webserver {
+
+namespace detail {
+
+   /// Minimal reader of a JSON text, it only finds where values end
+   class json_scanner
+   {
+      public:
+         json_scanner( const std::string& text ) : _text( text ) {}
+
+         size_t pos()const { return _pos; }
+         void seek( size_t pos ) { _pos = pos; }
+
+         void skip_whitespace()
+         {
+            while( _pos < _text.size() && ( _text[ _pos ] == ' ' || _text[ _pos ] == '\t' || _text[ _pos ] == '\n' || _text[ _pos ] == '\r' ) )
+               ++_pos;
+         }
+
+         bool consume( char c )
+         {
+            skip_whitespace();
+            if( _pos >= _text.size() || _text[ _pos ] != c )
+               return false;
+            ++_pos;
+            return true;
+         }
+
+         bool peek( char c )
+         {
+            skip_whitespace();
+            return _pos < _text.size() && _text[ _pos ] == c;
+         }
+
+         bool read_string( std::string& out )
+         {
+            if( !consume( '"' ) )
+               return false;
+
+            out.clear();
+            while( _pos < _text.size() )
+            {
+               char c = _text[ _pos++ ];
+               if( c == '"' )
+                  return true;
+               if( c == '\\' )
+               {
+                  // Escapes do not occur in api and method names, they are kept as they are
+                  if( _pos >= _text.size() )
+                     return false;
+                  out.push_back( c );
+                  c = _text[ _pos++ ];
+               }
+               out.push_back( c );
+            }
+
+            return false;
+         }
+
+         bool skip_value()
+         {
+            skip_whitespace();
+            if( _pos >= _text.size() )
+               return false;
+
+            char c = _text[ _pos ];
+            if( c == '"' )
+            {
+               std::string s;
+               return read_string( s );
+            }
+
+            if( c == '{' || c == '[' )
+            {
+               uint32_t depth = 0;
+               while( _pos < _text.size() )
+               {
+                  c = _text[ _pos ];
+                  if( c == '"' )
+                  {
+                     std::string s;
+                     if( !read_string( s ) )
+                        return false;
+                     continue;
+                  }
+
+                  ++_pos;
+                  if( c == '{' || c == '[' )
+                     ++depth;
+                  else if( ( c == '}' || c == ']' ) && --depth == 0 )
+                     return true;
+               }
+               return false;
+            }
+
+            size_t start = _pos;
+            while( _pos < _text.size() && _text[ _pos ] != ',' && _text[ _pos ] != '}' && _text[ _pos ] != ']'
+                   && _text[ _pos ] != ' ' && _text[ _pos ] != '\t' && _text[ _pos ] != '\n' && _text[ _pos ] != '\r' )
+               ++_pos;
+            return _pos > start;
+         }
+
+      private:
+         const std::string&   _text;
+         size_t               _pos = 0;
+   };
+
+   /// Whether a value the scanner skipped is a string, a number or null, so it can be copied into a response
+   bool is_id( const std::string& text, size_t start, size_t end )
+   {
+      if( start >= end )
+         return false;
+      if( text[ start ] == '"' )
+         return true;
+      if( text.compare( start, end - start, "null" ) == 0 )
+         return true;
+
+      for( size_t i = start; i < end; ++i )
+         if( !std::isdigit( static_cast< unsigned char >( text[ i ] ) ) && text[ i ] != '-' && text[ i ] != '+'
+             && text[ i ] != '.' && text[ i ] != 'e' && text[ i ] != 'E' )
+            return false;
+      return true;
+   }
+
+}
+
+bool request_scheduler::scan_request( const std::string& body, std::string& method, std::string& id )
+{
+   method.clear();
+   id = "null";
+
+   detail::json_scanner s( body );
+   if( !s.consume( '{' ) )
+      return false;
+
+   size_t params = std::string::npos;
+
+   if( !s.peek( '}' ) )
+   {
+      do
+      {
+         std::string key;
+         if( !s.read_string( key ) || !s.consume( ':' ) )
+            return false;
+
+         s.skip_whitespace();
+         size_t start = s.pos();
+
+         if( key == "method" && s.peek( '"' ) )
+         {
+            if( !s.read_string( method ) )
+               return false;
+            continue;
+         }
+
+         if( !s.skip_value() )
+            return false;
+
+         if( key == "id" && detail::is_id( body, start, s.pos() ) )
+            id = body.substr( start, s.pos() - start );
+         else if( key == "params" )
+            params = start;
+      }
+      while( s.consume( ',' ) );
+   }
+
+   if( !s.consume( '}' ) )
+      return false;
+
+   // call has the api and the method as its first parameters
+   if( method == "call" && params != std::string::npos )
+   {
+      s.seek( params );
+      std::string api_name, method_name;
+      if( s.consume( '[' ) && s.read_string( api_name ) && s.consume( ',' ) && s.read_string( method_name ) )
+         method = api_name + "." + method_name;
+   }
+
+   return true;
+}
+
+lane_stats request_scheduler::lane::get()const
+{
+   lane_stats stats;
+   stats.queued = queue.size();
+   stats.accepted = accepted;
+   stats.rejected = rejected;
+   stats.completed = completed;
+   stats.wait = wait.get();
+   stats.service = service.get();
+   return stats;
+}
+
+request_scheduler::request_scheduler( const executor& post, uint32_t max_priority_queue, uint32_t max_normal_queue, uint32_t max_in_flight_per_connection ) :
+   _post( post ),
+   _max_in_flight_per_connection( max_in_flight_per_connection )
+{
+   _lanes[ priority_lane ].max_queue = max_priority_queue;
+   _lanes[ normal_lane ].max_queue = max_normal_queue;
+}
+
+request_lane request_scheduler::classify( const std::string& method )const
+{
+   return _priority_methods.count( method ) ? priority_lane : normal_lane;
+}
+
+request_scheduler::submit_result request_scheduler::submit( request_lane l, const void* connection, std::function< void() > task )
+{
+   {
+      std::lock_guard< std::mutex > guard( _mutex );
+      auto& lane = _lanes[ l ];
+
+      if( lane.queue.size() >= lane.max_queue )
+      {
+         ++lane.rejected;
+         return queue_full;
+      }
+
+      if( connection )
+      {
+         auto& in_flight = _in_flight[ connection ];
+         if( _max_in_flight_per_connection && in_flight >= _max_in_flight_per_connection )
+         {
+            ++_rejected_connection_limit;
+            return connection_limit;
+         }
+
+         ++in_flight;
+      }
+
+      ++lane.accepted;
+      lane.queue.push_back( request{ std::move( task ), connection, fc::time_point::now().time_since_epoch().count() } );
+   }
+
+   _post( [this](){ run_next(); } );
+   return accepted;
+}
+
+void request_scheduler::run_next()
+{
+   request r;
+   request_lane l;
+
+   {
+      std::lock_guard< std::mutex > guard( _mutex );
+
+      // Every queued request has posted a runner, the runner takes the most urgent request rather than its own
+      if( _lanes[ priority_lane ].queue.size() )
+         l = priority_lane;
+      else if( _lanes[ normal_lane ].queue.size() )
+         l = normal_lane;
+      else
+         return;
+
+      auto& lane = _lanes[ l ];
+      r = std::move( lane.queue.front() );
+      lane.queue.pop_front();
+   }
+
+   int64_t start = fc::time_point::now().time_since_epoch().count();
+
+   try
+   {
+      r.task();
+   }
+   catch( ... )
+   {
+      elog( "Unhandled exception in webserver request" );
+   }
+
+   int64_t end = fc::time_point::now().time_since_epoch().count();
+
+   std::lock_guard< std::mutex > guard( _mutex );
+   auto& lane = _lanes[ l ];
+   ++lane.completed;
+   lane.wait.record( std::max< int64_t >( start - r.enqueued_us, 0 ) );
+   lane.service.record( std::max< int64_t >( end - start, 0 ) );
+
+   auto itr = _in_flight.find( r.connection );
+   if( itr != _in_flight.end() && --itr->second == 0 )
+      _in_flight.erase( itr );
+}
+
+request_scheduler_stats request_scheduler::get_stats()const
+{
+   std::lock_guard< std::mutex > guard( _mutex );
+
+   request_scheduler_stats stats;
+   stats.priority = _lanes[ priority_lane ].get();
+   stats.normal = _lanes[ normal_lane ].get();
+   stats.rejected_connection_limit = _rejected_connection_limit;
+   return stats;
+}
+
+} } } // sophiatx::plugins::webserver
@@ -1,4 +1,5 @@
 #include <sophiatx/plugins/webserver/webserver_plugin.hpp>
+#include <sophiatx/plugins/webserver/request_scheduler.hpp>
 
 #include <sophiatx/plugins/chain/chain_plugin.hpp>
 
@@ -41,6 +42,14 @@ using websocketpp::connection_hdl;
 
 typedef uint32_t thread_pool_size_t;
 
+/// Broadcasts evaluated ahead of queued reads unless webserver-priority-method is set
+const std::vector< string > default_priority_methods = {
+   "network_broadcast_api.broadcast_transaction",
+   "network_broadcast_api.broadcast_transaction_synchronous",
+   "network_broadcast_api.broadcast_block",
+   "alexandria_api.broadcast_transaction"
+};
+
 namespace detail {
 
    template<class T>
@@ -138,8 +147,15 @@ class webserver_plugin_impl
       void handle_http_message(typename T::connection_ptr con);
 
       void handle_ws_message( websocket_server_type::connection_ptr con, detail::websocket_server_type::message_ptr );
+      void handle_ws_binary_message( websocket_server_type::connection_ptr con, detail::websocket_server_type::message_ptr );
       void send_ws_notice( websocket_server_type::connection_ptr con, const string& message );
 
+      /// Prometheus text of the json_rpc method counters and of the request lanes
+      string metrics()const;
+
+      /// Queues a request in the lane of its method, returns the error response if it is rejected
+      optional< string > schedule( const string& body, const void* connection, std::function< void() > task );
+
       ssl_context_ptr on_tls_init(websocketpp::connection_hdl hdl);
 
       shared_ptr< std::thread >  http_thread;
@@ -147,6 +163,7 @@ class webserver_plugin_impl
       optional< tcp::endpoint >  http_endpoint;
       websocket_server_type      http_server;
       string                     http_cors;
+      string                     metrics_path;
 
       shared_ptr< std::thread >  https_thread;
       asio::io_service           https_ios;
@@ -163,6 +180,7 @@ class webserver_plugin_impl
       boost::thread_group        thread_pool;
       asio::io_service           thread_pool_ios;
       asio::io_service::work     thread_pool_work;
+      std::unique_ptr< request_scheduler > scheduler;
 
       plugins::json_rpc::json_rpc_plugin* api;
       boost::signals2::connection         chain_sync_con;
@@ -356,11 +374,65 @@ ssl_context_ptr webserver_plugin_impl::on_tls_init(websocketpp::connection_hdl h
    return ctx;
 }
 
+optional< string > webserver_plugin_impl::schedule( const string& body, const void* connection, std::function< void() > task )
+{
+   string method;
+   string id = "null";
+   request_lane lane = request_scheduler::scan_request( body, method, id ) ? scheduler->classify( method ) : normal_lane;
+
+   auto result = scheduler->submit( lane, connection, std::move( task ) );
+   if( result == request_scheduler::accepted )
+      return optional< string >();
+
+   string message = result == request_scheduler::queue_full ?
+      "Server is busy, try again later" : "Too many requests in flight on this connection";
+
+   return "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":" + std::to_string( JSON_RPC_SERVER_BUSY ) +
+          ",\"message\":\"" + message + "\"},\"id\":" + id + "}";
+}
+
+string webserver_plugin_impl::metrics()const
+{
+   string out;
+   api->write_metrics( out );
+
+   auto stats = scheduler->get_stats();
+   auto write_lane = [&]( const char* name, const char* lane, uint64_t value )
+   {
+      out.append( name ).append( "{lane=\"" ).append( lane ).append( "\"} " ).append( std::to_string( value ) ).append( 1, '\n' );
+   };
+
+   out.append( "# HELP sophiatx_webserver_queued Requests waiting for a thread.\n# TYPE sophiatx_webserver_queued gauge\n" );
+   write_lane( "sophiatx_webserver_queued", "priority", stats.priority.queued );
+   write_lane( "sophiatx_webserver_queued", "normal", stats.normal.queued );
+   out.append( "# HELP sophiatx_webserver_accepted_total Requests admitted to a lane.\n# TYPE sophiatx_webserver_accepted_total counter\n" );
+   write_lane( "sophiatx_webserver_accepted_total", "priority", stats.priority.accepted );
+   write_lane( "sophiatx_webserver_accepted_total", "normal", stats.normal.accepted );
+   out.append( "# HELP sophiatx_webserver_rejected_total Requests rejected because their lane was full.\n# TYPE sophiatx_webserver_rejected_total counter\n" );
+   write_lane( "sophiatx_webserver_rejected_total", "priority", stats.priority.rejected );
+   write_lane( "sophiatx_webserver_rejected_total", "normal", stats.normal.rejected );
+   out.append( "# HELP sophiatx_webserver_connection_limit_rejected_total Requests rejected because their connection had too many in flight.\n"
+               "# TYPE sophiatx_webserver_connection_limit_rejected_total counter\n" );
+   out.append( "sophiatx_webserver_connection_limit_rejected_total " ).append( std::to_string( stats.rejected_connection_limit ) ).append( 1, '\n' );
+
+   return out;
+}
+
 template<class T>
 void webserver_plugin_impl::handle_http_message(typename T::connection_ptr con) {
+   // Metrics are cheap to collect, they are served right away so scrapes work also when the queues are full
+   if( metrics_path.size() && con->get_request().get_method() == "GET" && con->get_resource() == metrics_path )
+   {
+      con->append_header( "Content-Type", "text/plain; version=0.0.4" );
+      con->set_body( metrics() );
+      con->set_status( websocketpp::http::status_code::ok );
+      return;
+   }
+
    con->defer_http_response();
 
-   thread_pool_ios.post( [con, this]()
+   const auto& request_body = con->get_request_body();
+   auto rejected = schedule( request_body, con.get(), [con, this]()
    {
       auto body = con->get_request_body();
 
@@ -407,19 +479,34 @@ void webserver_plugin_impl::handle_http_message(typename T::connection_ptr con)
 
       con->send_http_response();
    });
+
+   if( rejected )
+   {
+      if(!http_cors.empty())
+         con->append_header("Access-Control-Allow-Origin", http_cors);
+
+      con->set_body( *rejected );
+      con->set_status( websocketpp::http::status_code::service_unavailable );
+      con->send_http_response();
+   }
 }
 
 void webserver_plugin_impl::send_ws_notice( websocket_server_type::connection_ptr con, const string& message )
 {
+   // Closed connections are reported to the caller, so it can delete the callback association
+   if( con->get_state() != websocketpp::session::state::open )
+   {
+      fc::send_error_exception e;
+      throw e;
+   }
+
    try{
       thread_pool_ios.post( [con, message]() {
          try{
             con->send(message);
          }catch( ... )
          {
-            fc::send_error_exception e;
-            throw e;
-            //we shall notify the caller and delete the callback association
+            // The connection closed meanwhile, the next notice reports it
          }
       });
    }catch(...){
@@ -430,7 +517,14 @@ void webserver_plugin_impl::send_ws_notice( websocket_server_type::connection_pt
 
 void webserver_plugin_impl::handle_ws_message( websocket_server_type::connection_ptr con, detail::websocket_server_type::message_ptr msg )
 {
-   thread_pool_ios.post( [con, msg, this]()
+   if( msg->get_opcode() == websocketpp::frame::opcode::binary )
+   {
+      handle_ws_binary_message( con, msg );
+      return;
+   }
+
+   const string& payload = msg->get_opcode() == websocketpp::frame::opcode::text ? msg->get_payload() : string();
+   auto rejected = schedule( payload, con.get(), [con, msg, this]()
    {
       try
       {
@@ -462,6 +556,49 @@ void webserver_plugin_impl::handle_ws_message( websocket_server_type::connection
          }
       }
    });
+
+   if( rejected )
+   {
+      try
+      {
+         con->send( *rejected );
+      }
+      catch( ... )
+      {
+         // The connection closed meanwhile
+      }
+   }
+}
+
+void webserver_plugin_impl::handle_ws_binary_message( websocket_server_type::connection_ptr con, detail::websocket_server_type::message_ptr msg )
+{
+   // Binary calls carry no JSON method to classify, they always use the normal lane
+   auto result = scheduler->submit( normal_lane, con.get(), [con, msg, this]()
+   {
+      try
+      {
+         con->send( api->call_binary( msg->get_payload() ), websocketpp::frame::opcode::binary );
+      }
+      catch( ... )
+      {
+         // The connection closed meanwhile, call_binary reports errors in the response
+      }
+   });
+
+   if( result != request_scheduler::accepted )
+   {
+      string message = result == request_scheduler::queue_full ?
+         "Server is busy, try again later" : "Too many requests in flight on this connection";
+
+      try
+      {
+         con->send( api->binary_error( msg->get_payload(), JSON_RPC_SERVER_BUSY, message ), websocketpp::frame::opcode::binary );
+      }
+      catch( ... )
+      {
+         // The connection closed meanwhile
+      }
+   }
 }
 
 } // detail
@@ -478,7 +615,12 @@ void webserver_plugin::set_program_options( options_description&, options_descri
       ("https-certificate-chain-file", bpo::value< string >(), "File with certificate chain to present on https connections. Required for https.")
       ("https-private-key-file", bpo::value< string >(), "File with https private key in PEM format. Required for https.")
       ("http-cors", bpo::value<string>()->default_value("*"), "Access-Control-Allow-Origin response header")
-      ("webserver-thread-pool-size", bpo::value<thread_pool_size_t>()->default_value(16), "Number of threads used to handle queries. Default: 16.");
+      ("webserver-thread-pool-size", bpo::value<thread_pool_size_t>()->default_value(16), "Number of threads used to handle queries. Default: 16.")
+      ("webserver-priority-method", bpo::value< std::vector< string > >()->composing(), "Method evaluated ahead of queued requests, as api.method. Can be specified multiple times. Default: transaction and block broadcasts.")
+      ("webserver-priority-queue-size", bpo::value< uint32_t >()->default_value(1000), "Number of priority requests waiting for a thread before new ones are rejected. Default: 1000.")
+      ("webserver-queue-size", bpo::value< uint32_t >()->default_value(10000), "Number of other requests waiting for a thread before new ones are rejected. Default: 10000.")
+      ("webserver-max-in-flight-per-connection", bpo::value< uint32_t >()->default_value(64), "Number of requests a connection can have queued or evaluated at once, 0 for no limit. Default: 64.")
+      ("webserver-metrics-path", bpo::value< string >()->default_value("/metrics"), "HTTP path serving API call metrics in the Prometheus text format on GET, empty to disable. Default: /metrics.");
 }
 
 void webserver_plugin::plugin_initialize( const variables_map& options )
@@ -488,6 +630,27 @@ void webserver_plugin::plugin_initialize( const variables_map& options )
    ilog("configured with ${tps} thread pool size", ("tps", thread_pool_size));
    my.reset(new detail::webserver_plugin_impl(thread_pool_size));
 
+   my->scheduler.reset( new request_scheduler(
+      [this]( const std::function< void() >& task ) { my->thread_pool_ios.post( task ); },
+      options.at( "webserver-priority-queue-size" ).as< uint32_t >(),
+      options.at( "webserver-queue-size" ).as< uint32_t >(),
+      options.at( "webserver-max-in-flight-per-connection" ).as< uint32_t >() ) );
+
+   std::vector< string > priority_methods = detail::default_priority_methods;
+   if( options.count( "webserver-priority-method" ) )
+      priority_methods = options.at( "webserver-priority-method" ).as< std::vector< string > >();
+   my->scheduler->set_priority_methods( std::set< string >( priority_methods.begin(), priority_methods.end() ) );
+
+   my->metrics_path = options.at( "webserver-metrics-path" ).as< string >();
+
+   auto& rpc = appbase::app().get_plugin< plugins::json_rpc::json_rpc_plugin >();
+   rpc.add_api_method( "webserver", "get_stats",
+      [this]( const fc::variant&, const std::function< void( fc::variant&, uint64_t ) >&, bool ) -> fc::variant
+      {
+         return fc::variant( my->scheduler->get_stats() );
+      },
+      plugins::json_rpc::api_method_signature{ fc::variant( plugins::json_rpc::void_type() ), fc::variant( request_scheduler_stats() ) } );
+
    if( options.count( "webserver-ws-endpoint" ) )
    {
       auto ws_endpoint = options.at( "webserver-ws-endpoint" ).as< string >();
@@ -535,7 +698,21 @@ void webserver_plugin::plugin_startup()
    my->api = appbase::app().find_plugin< plugins::json_rpc::json_rpc_plugin >();
    FC_ASSERT( my->api != nullptr, "Could not find API Register Plugin" );
 
+   // Parts of a batch queue behind other requests, the thread evaluating the batch also does the parts which were rejected
+   my->api->set_batch_executor( [this]( const std::function< void() >& task )
+   {
+      my->scheduler->submit( normal_lane, nullptr, task );
+   });
+
    plugins::chain::chain_plugin* chain = appbase::app().find_plugin< plugins::chain::chain_plugin >();
+   if( chain != nullptr )
+   {
+      my->api->set_batch_read_lock( [chain]( const std::function< void() >& callback )
+      {
+         chain->db()->with_read_lock( [&]() { callback(); } );
+      });
+   }
+
    if( chain != nullptr && chain->get_state() != appbase::abstract_plugin::started )
    {
       ilog( "Waiting for chain plugin to start" );
@@ -20,16 +20,16 @@ namespace sophiatx { namespace protocol {
       virtual bool has_special_fee()const{return false;};
       virtual asset get_required_fee(asset_symbol_type in_symbol)const{
          if(in_symbol == SBD1_SYMBOL )//USD
-            return protocol_config::get<asset>("BASE_FEE_SBD1");
+            return protocol_config::params().base_fee_sbd1;
          if(in_symbol == SBD2_SYMBOL )//EUR
-            return protocol_config::get<asset>("BASE_FEE_SBD2");
+            return protocol_config::params().base_fee_sbd2;
          if(in_symbol == SBD3_SYMBOL ) //CHF
-            return protocol_config::get<asset>("BASE_FEE_SBD3");
+            return protocol_config::params().base_fee_sbd3;
          if(in_symbol == SBD4_SYMBOL ) //CNY
-            return protocol_config::get<asset>("BASE_FEE_SBD4");
+            return protocol_config::params().base_fee_sbd4;
          if(in_symbol == SBD5_SYMBOL ) //GBP
-            return protocol_config::get<asset>("BASE_FEE_SBD5");
-         return protocol_config::get<asset>("BASE_FEE");
+            return protocol_config::params().base_fee_sbd5;
+         return protocol_config::params().base_fee;
       };
 
       virtual bool is_virtual()const { return false; }
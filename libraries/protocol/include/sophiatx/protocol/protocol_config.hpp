@@ -12,6 +12,24 @@
 
 namespace sophiatx { namespace protocol {
 
+/**
+ * Typed copy of the protocol_config values, filled once by protocol_config::init.
+ * Use protocol_config::params() on hot paths instead of the string keyed get<T>().
+ */
+struct protocol_params {
+    asset_symbol_type symbol;
+    uint32_t          block_interval = 0;
+    uint32_t          min_block_size_limit = 0;
+    uint32_t          max_block_size = 0;
+    uint32_t          min_account_creation_fee = 0;
+    asset             base_fee;
+    asset             base_fee_sbd1;
+    asset             base_fee_sbd2;
+    asset             base_fee_sbd3;
+    asset             base_fee_sbd4;
+    asset             base_fee_sbd5;
+};
+
 class protocol_config {
 public:
     inline static void init(const fc::mutable_variant_object& conf)
@@ -82,6 +100,24 @@ public:
         } catch (...) {
             instance().config_["BASE_FEE_SBD5"] = BASE_FEE_SBD5;
         }
+
+        auto& p = instance().params_;
+        fc::from_variant(instance().config_["SOPHIATX_SYMBOL"], p.symbol);
+        fc::from_variant(instance().config_["SOPHIATX_BLOCK_INTERVAL"], p.block_interval);
+        fc::from_variant(instance().config_["SOPHIATX_MIN_BLOCK_SIZE_LIMIT"], p.min_block_size_limit);
+        fc::from_variant(instance().config_["SOPHIATX_MAX_BLOCK_SIZE"], p.max_block_size);
+        fc::from_variant(instance().config_["SOPHIATX_MIN_ACCOUNT_CREATION_FEE"], p.min_account_creation_fee);
+        fc::from_variant(instance().config_["BASE_FEE"], p.base_fee);
+        fc::from_variant(instance().config_["BASE_FEE_SBD1"], p.base_fee_sbd1);
+        fc::from_variant(instance().config_["BASE_FEE_SBD2"], p.base_fee_sbd2);
+        fc::from_variant(instance().config_["BASE_FEE_SBD3"], p.base_fee_sbd3);
+        fc::from_variant(instance().config_["BASE_FEE_SBD4"], p.base_fee_sbd4);
+        fc::from_variant(instance().config_["BASE_FEE_SBD5"], p.base_fee_sbd5);
+    }
+
+    inline static const protocol_params& params() {
+        FC_ASSERT(instance().config_loaded_, "protocol_config is not initialized!");
+        return instance().params_;
     }
 
     template<typename T>
@@ -103,6 +139,7 @@ private:
 
     bool config_loaded_;
     fc::mutable_variant_object config_;
+    protocol_params params_;
 };
 
 } } // sophiatx::protocol
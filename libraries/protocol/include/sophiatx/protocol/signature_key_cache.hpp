@@ -0,0 +1,54 @@
+#pragma once
+
+#include <sophiatx/protocol/types.hpp>
+
+#include <fc/time.hpp>
+
+namespace sophiatx { namespace protocol {
+
+namespace detail { class signature_key_cache_impl; }
+
+/**
+ * Bounded cache of public keys recovered from transaction signatures, keyed by the signature digest,
+ * the signature and the canonical signature type it was checked with.
+ *
+ * A transaction is usually recovered when it enters the mempool and then again when it arrives in a block,
+ * when pending transactions are reapplied after a block or fork switch and when a block is generated.
+ * The cache lets all but the first recovery be a lookup. Entries are evicted once the transaction they came from
+ * expires, and the oldest entries are evicted when the cache is full.
+ *
+ * The cache is safe to use from multiple threads.
+ */
+class signature_key_cache
+{
+   public:
+      struct stats
+      {
+         uint64_t hits = 0;
+         uint64_t misses = 0;
+         uint64_t evicted = 0;
+         uint64_t expired = 0;
+         uint64_t size = 0;
+         uint64_t max_size = 0;
+      };
+
+      explicit signature_key_cache( size_t max_size );
+      ~signature_key_cache();
+
+      optional< public_key_type > get( const digest_type& digest, const signature_type& sig, fc::ecc::canonical_signature_type canon_type );
+      void put( const digest_type& digest, const signature_type& sig, fc::ecc::canonical_signature_type canon_type,
+                const public_key_type& key, fc::time_point_sec expiration );
+
+      /// Removes entries of transactions which expired before now
+      void remove_expired( fc::time_point_sec now );
+      void clear();
+
+      stats get_stats()const;
+
+   private:
+      std::unique_ptr< detail::signature_key_cache_impl > my;
+};
+
+} } // sophiatx::protocol
+
+FC_REFLECT( sophiatx::protocol::signature_key_cache::stats, (hits)(misses)(evicted)(expired)(size)(max_size) )
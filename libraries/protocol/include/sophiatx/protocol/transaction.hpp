@@ -1,6 +1,7 @@
 #pragma once
 #include <sophiatx/protocol/operations.hpp>
 #include <sophiatx/protocol/sign_state.hpp>
+#include <sophiatx/protocol/signature_key_cache.hpp>
 #include <sophiatx/protocol/types.hpp>
 
 #include <numeric>
@@ -77,6 +78,17 @@ namespace sophiatx { namespace protocol {
          canonical_signature_type canon_type/* = fc::ecc::fc_canonical*/
          )const;
 
+      /**
+       * Same as above, but checks the authorities against already recovered signature keys
+       * (see get_signature_keys) instead of recovering them from the signatures again.
+       */
+      void verify_authority(
+         const flat_set<public_key_type>& signature_keys,
+         const authority_getter& get_active,
+         const authority_getter& get_owner,
+         uint32_t max_recursion/* = STEEM_MAX_SIG_CHECK_DEPTH*/
+         )const;
+
       set<public_key_type> minimize_required_signatures(
          const chain_id_type& chain_id,
          const flat_set<public_key_type>& available_keys,
@@ -89,6 +101,13 @@ namespace sophiatx { namespace protocol {
       flat_set<public_key_type> get_signature_keys( const chain_id_type& chain_id,
             canonical_signature_type/* = fc::ecc::fc_canonical*/  )const;
 
+      /**
+       * Same as above, but looks the keys up in the cache first. Newly recovered keys are added to the cache
+       * until the transaction expires.
+       */
+      flat_set<public_key_type> get_signature_keys( const chain_id_type& chain_id,
+            canonical_signature_type canon_type, signature_key_cache& cache )const;
+
       vector<signature_type> signatures;
 
       digest_type merkle_digest()const;
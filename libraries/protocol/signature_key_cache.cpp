@@ -0,0 +1,139 @@
+#include <sophiatx/protocol/signature_key_cache.hpp>
+
+#include <fc/crypto/city.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace sophiatx { namespace protocol {
+
+namespace detail {
+
+   using namespace boost::multi_index;
+
+   struct cache_key
+   {
+      digest_type    digest;
+      signature_type sig;
+      uint8_t        canon_type;
+
+      bool operator == ( const cache_key& other )const
+      {
+         return canon_type == other.canon_type && sig == other.sig && digest == other.digest;
+      }
+   };
+
+   struct cache_key_hash
+   {
+      size_t operator()( const cache_key& k )const
+      {
+         // Signatures are unique enough, the digest is compared on collision
+         return fc::city_hash_size_t( (const char*)k.sig.data, sizeof( k.sig.data ) );
+      }
+   };
+
+   struct cache_entry
+   {
+      cache_key            key;
+      public_key_type      public_key;
+      fc::time_point_sec   expiration;
+   };
+
+   struct by_key;
+   struct by_expiration;
+   struct by_age;
+
+   typedef multi_index_container<
+      cache_entry,
+      indexed_by<
+         hashed_unique< tag< by_key >, member< cache_entry, cache_key, &cache_entry::key >, cache_key_hash >,
+         ordered_non_unique< tag< by_expiration >, member< cache_entry, fc::time_point_sec, &cache_entry::expiration > >,
+         sequenced< tag< by_age > >
+      >
+   > cache_entry_index;
+
+   class signature_key_cache_impl
+   {
+      public:
+         signature_key_cache_impl( size_t size ) : max_size( size ) {}
+
+         const size_t               max_size;
+         cache_entry_index          entries;
+         signature_key_cache::stats stats;
+         mutable boost::mutex       mtx;
+   };
+
+}
+
+signature_key_cache::signature_key_cache( size_t max_size )
+   : my( new detail::signature_key_cache_impl( max_size ) )
+{
+   FC_ASSERT( max_size > 0, "Signature key cache needs room for at least one key" );
+}
+
+signature_key_cache::~signature_key_cache() {}
+
+optional< public_key_type > signature_key_cache::get( const digest_type& digest, const signature_type& sig, fc::ecc::canonical_signature_type canon_type )
+{
+   boost::mutex::scoped_lock lock( my->mtx );
+
+   const auto& idx = my->entries.get< detail::by_key >();
+   auto itr = idx.find( detail::cache_key{ digest, sig, uint8_t( canon_type ) } );
+   if( itr == idx.end() )
+   {
+      ++my->stats.misses;
+      return optional< public_key_type >();
+   }
+
+   ++my->stats.hits;
+   return itr->public_key;
+}
+
+void signature_key_cache::put( const digest_type& digest, const signature_type& sig, fc::ecc::canonical_signature_type canon_type,
+   const public_key_type& key, fc::time_point_sec expiration )
+{
+   boost::mutex::scoped_lock lock( my->mtx );
+
+   auto& age_idx = my->entries.get< detail::by_age >();
+   auto result = age_idx.push_back( detail::cache_entry{ detail::cache_key{ digest, sig, uint8_t( canon_type ) }, key, expiration } );
+   if( !result.second )
+      return;
+
+   while( my->entries.size() > my->max_size )
+   {
+      age_idx.pop_front();
+      ++my->stats.evicted;
+   }
+}
+
+void signature_key_cache::remove_expired( fc::time_point_sec now )
+{
+   boost::mutex::scoped_lock lock( my->mtx );
+
+   auto& idx = my->entries.get< detail::by_expiration >();
+   auto end = idx.lower_bound( now );
+   my->stats.expired += std::distance( idx.begin(), end );
+   idx.erase( idx.begin(), end );
+}
+
+void signature_key_cache::clear()
+{
+   boost::mutex::scoped_lock lock( my->mtx );
+   my->entries.clear();
+}
+
+signature_key_cache::stats signature_key_cache::get_stats()const
+{
+   boost::mutex::scoped_lock lock( my->mtx );
+
+   auto result = my->stats;
+   result.size = my->entries.size();
+   result.max_size = my->max_size;
+   return result;
+}
+
+} } // sophiatx::protocol
@@ -123,6 +123,28 @@ flat_set<public_key_type> signed_transaction::get_signature_keys( const chain_id
    return result;
 } FC_CAPTURE_AND_RETHROW() }
 
+flat_set<public_key_type> signed_transaction::get_signature_keys( const chain_id_type& chain_id,
+      canonical_signature_type canon_type, signature_key_cache& cache )const
+{ try {
+   auto d = sig_digest( chain_id );
+   flat_set<public_key_type> result;
+   for( const auto&  sig : signatures )
+   {
+      auto key = cache.get( d, sig, canon_type );
+      if( !key.has_value() )
+      {
+         key = public_key_type( fc::ecc::public_key::recover_key( sig, d, canon_type ) );
+         cache.put( d, sig, canon_type, *key, expiration );
+      }
+
+      SOPHIATX_ASSERT(
+         result.insert( *key ).second,
+         tx_duplicate_sig,
+         "Duplicate Signature detected" );
+   }
+   return result;
+} FC_CAPTURE_AND_RETHROW() }
+
 
 
 set<public_key_type> signed_transaction::get_required_signatures(
@@ -200,4 +222,13 @@ void signed_transaction::verify_authority(
    sophiatx::protocol::verify_authority( operations, get_signature_keys( chain_id, canon_type ), get_active, get_owner, max_recursion );
 } FC_CAPTURE_AND_RETHROW( (*this) ) }
 
+void signed_transaction::verify_authority(
+   const flat_set<public_key_type>& signature_keys,
+   const authority_getter& get_active,
+   const authority_getter& get_owner,
+   uint32_t max_recursion )const
+{ try {
+   sophiatx::protocol::verify_authority( operations, signature_keys, get_active, get_owner, max_recursion );
+} FC_CAPTURE_AND_RETHROW( (*this) ) }
+
 } } // sophiatx::protocol
@@ -5,8 +5,10 @@
 #include <fc/variant.hpp>
 #include <fc/variant_object.hpp>
 #include <fc/rpc/websocket_api.hpp>
+#include <fc/rpc/binary_api.hpp>
 #include <fc/network/http/websocket.hpp>
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -22,6 +24,7 @@ struct received_object {
    std::string data;
    bool binary;
    fc::time_point_sec received;
+   uint64_t app_message_sequence = 0;
 };
 
 struct get_app_custom_messages_args {
@@ -40,11 +43,13 @@ public:
       FC_ASSERT(!instance().remote_db_loaded_, "remote_db already initialized!");
       instance().connnection_ = instance().ws_client_.connect(endpoint);
       instance().api_connection_ = std::make_shared<fc::rpc::websocket_api_connection>(*instance().connnection_);
+      instance().binary_connection_ = std::make_shared<fc::rpc::binary_api_connection>(*instance().connnection_);
       instance().closed_connection_ = (instance().connnection_->closed.connect([ = ] {
            elog("Server has disconnected us.");
            instance().remote_db_loaded_ = false;
       }));
       instance().remote_db_loaded_ = true;
+      instance().negotiate_binary_methods();
    }
 
    inline static fc::variant remote_call(const std::string &api, const std::string call, const fc::variant &args) {
@@ -55,12 +60,36 @@ public:
    inline static std::map<uint64_t, received_object>
    get_app_custom_messages(const get_app_custom_messages_args &args) {
       FC_ASSERT(instance().remote_db_loaded_, "remote_db is not initialized!");
+      if( instance().binary_methods_.count("custom_api.get_app_custom_messages") )
+         return instance().binary_connection_->call<std::map<uint64_t, received_object>>("custom_api", "get_app_custom_messages", args);
+
       auto ret = instance().api_connection_->send_call("custom_api", "get_app_custom_messages", true, {fc::variant(args)});
       std::map<uint64_t, received_object> out;
       fc::from_variant(ret, out);
       return out;
    }
 
+   /**
+    * Asks the full node to push the messages of an app from sequence start on. Messages are passed to on_message
+    * in the order of their app_message_sequence, on the thread of the connection. Callers check the sequence for
+    * gaps, there is no way to cancel the subscription other than ignoring its messages.
+    * Returns false if the full node does not serve the subscription, callers then keep polling.
+    */
+   inline static bool subscribe_app_custom_messages(uint64_t app_id, uint64_t start,
+                                                    const std::function<void(received_object)> &on_message) {
+      FC_ASSERT(instance().remote_db_loaded_, "remote_db is not initialized!");
+      try {
+         auto callback_id = instance().api_connection_->register_callback(on_message);
+         fc::mutable_variant_object args;
+         args("return_id", callback_id)("app_id", app_id)("account_name", "")("search_type", "by_app")("start", start);
+         instance().api_connection_->send_call("subscribe_api", "custom_object_subscription", true, {fc::variant(args)});
+         return true;
+      } catch( const fc::exception& e ) {
+         wlog("Remote node does not serve app message subscriptions, polling: ${e}", ("e", e.to_string()));
+         return false;
+      }
+   }
+
    remote_db(remote_db const &) = delete;
 
    void operator=(remote_db const &) = delete;
@@ -69,6 +98,22 @@ private:
    remote_db() : remote_db_loaded_(false), connnection_(nullptr) {}
    ~remote_db() {}
 
+   /**
+    * Methods the full node serves in binary frames are called with fc::raw packed arguments and results,
+    * everything else stays JSON. Nodes without the binary transport leave the set empty.
+    */
+   inline void negotiate_binary_methods() {
+      binary_methods_.clear();
+      try {
+         auto ret = api_connection_->send_call("jsonrpc", "get_binary_methods", true, {fc::variant_object()});
+         std::vector<std::string> methods;
+         fc::from_variant(ret, methods);
+         binary_methods_.insert(methods.begin(), methods.end());
+      } catch( const fc::exception& e ) {
+         wlog("Remote node does not support binary calls, using JSON: ${e}", ("e", e.to_string()));
+      }
+   }
+
    inline static remote_db &instance() {
       static remote_db instance;
       return instance;
@@ -78,13 +123,15 @@ private:
    fc::http::websocket_client ws_client_;
    fc::http::websocket_connection_ptr connnection_;
    std::shared_ptr<fc::rpc::websocket_api_connection> api_connection_;
+   std::shared_ptr<fc::rpc::binary_api_connection> binary_connection_;
+   std::set<std::string> binary_methods_;
    boost::signals2::scoped_connection closed_connection_;
 };
 
 }
 }
 
-FC_REFLECT(sophiatx::remote::received_object, (id)(sender)(recipients)(app_id)(data)(received)(binary))
+FC_REFLECT(sophiatx::remote::received_object, (id)(sender)(recipients)(app_id)(data)(received)(binary)(app_message_sequence))
 FC_REFLECT(sophiatx::remote::get_app_custom_messages_args, (app_id)(start)(limit))
 
 #endif //SOPHIATX_REMOTE_DB_HPP
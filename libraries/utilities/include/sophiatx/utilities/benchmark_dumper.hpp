@@ -58,6 +58,53 @@ public:
 
    typedef std::vector<database_object_sizeof_t> database_object_sizeof_cntr_t;
 
+   /// Cumulative progress of one stage of a multi-stage processing (e.g. replay pipeline)
+   struct stage_details_t
+   {
+      stage_details_t() {}
+      stage_details_t(std::string&& name, uint64_t items, uint64_t busy, uint64_t wait)
+         : stage_name(name), item_count(items), busy_us(busy), wait_us(wait)
+      {
+         if( busy_us > 0 )
+            items_per_second = double(item_count) * 1000000 / busy_us;
+      }
+
+      std::string    stage_name;
+      uint64_t       item_count = 0;
+      uint64_t       busy_us = 0;
+      uint64_t       wait_us = 0;
+      /// Throughput of the stage while it was busy
+      double         items_per_second = 0;
+   };
+
+   typedef std::vector<stage_details_t> stage_details_cntr_t;
+
+   /// Cumulative latency of one phase of applying one operation type
+   struct operation_details_t
+   {
+      operation_details_t() {}
+      operation_details_t(std::string&& name, std::string&& ph, uint64_t count, uint64_t total, uint64_t max,
+         uint64_t p50, uint64_t p90, uint64_t p99)
+         : operation_name(name), phase(ph), call_count(count), total_ns(total), max_ns(max),
+           p50_ns(p50), p90_ns(p90), p99_ns(p99)
+      {
+         if( call_count > 0 )
+            avg_ns = total_ns / call_count;
+      }
+
+      std::string    operation_name;
+      std::string    phase;
+      uint64_t       call_count = 0;
+      uint64_t       total_ns = 0;
+      uint64_t       avg_ns = 0;
+      uint64_t       max_ns = 0;
+      uint64_t       p50_ns = 0;
+      uint64_t       p90_ns = 0;
+      uint64_t       p99_ns = 0;
+   };
+
+   typedef std::vector<operation_details_t> operation_details_cntr_t;
+
    class measurement
    {
    public:
@@ -77,6 +124,8 @@ public:
       uint64_t current_mem = 0;
       uint64_t peak_mem = 0;
       index_memory_details_cntr_t index_memory_details_cntr;
+      stage_details_cntr_t        stage_details_cntr;
+      operation_details_cntr_t    operation_details_cntr;
    };
 
    typedef std::vector<measurement> TMeasurements;
@@ -106,7 +155,9 @@ public:
       get_database_objects_sizeofs(_all_data.database_object_sizeofs);
    }
 
-   const measurement& measure(uint32_t block_number, get_indexes_memory_details_t get_indexes_memory_details)
+   const measurement& measure(uint32_t block_number, get_indexes_memory_details_t get_indexes_memory_details,
+                              const stage_details_cntr_t& stage_details = stage_details_cntr_t(),
+                              const operation_details_cntr_t& operation_details = operation_details_cntr_t())
    {
       uint64_t current_virtual = 0;
       uint64_t peak_virtual = 0;
@@ -122,6 +173,8 @@ public:
                 current_virtual,
                 peak_virtual );
       get_indexes_memory_details(data.index_memory_details_cntr, true);
+      data.stage_details_cntr = stage_details;
+      data.operation_details_cntr = operation_details;
       _all_data.measurements.push_back( data );
    
       _last_sys_time = current_sys_time;
@@ -133,6 +186,8 @@ public:
          int((_last_cpu_time - _init_cpu_time) * 1000 / CLOCKS_PER_SEC),
          current_virtual,
          peak_virtual );
+      _all_data.total_measurement.stage_details_cntr = stage_details;
+      _all_data.total_measurement.operation_details_cntr = operation_details;
 
       dump(false, get_indexes_memory_details);
    
@@ -202,8 +257,14 @@ FC_REFLECT( sophiatx::utilities::benchmark_dumper::index_memory_details_t,
 FC_REFLECT( sophiatx::utilities::benchmark_dumper::database_object_sizeof_t,
             (object_name)(object_size) )
 
+FC_REFLECT( sophiatx::utilities::benchmark_dumper::stage_details_t,
+            (stage_name)(item_count)(busy_us)(wait_us)(items_per_second) )
+
+FC_REFLECT( sophiatx::utilities::benchmark_dumper::operation_details_t,
+            (operation_name)(phase)(call_count)(total_ns)(avg_ns)(max_ns)(p50_ns)(p90_ns)(p99_ns) )
+
 FC_REFLECT( sophiatx::utilities::benchmark_dumper::measurement,
-            (block_number)(real_ms)(cpu_ms)(current_mem)(peak_mem)(index_memory_details_cntr) )
+            (block_number)(real_ms)(cpu_ms)(current_mem)(peak_mem)(index_memory_details_cntr)(stage_details_cntr)(operation_details_cntr) )
 
 FC_REFLECT( sophiatx::utilities::benchmark_dumper::TAllData,
             (database_object_sizeofs)(measurements)(total_measurement) )
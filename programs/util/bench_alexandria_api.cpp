@@ -0,0 +1,152 @@
+#include <appbase/application.hpp>
+
+#include <sophiatx/chain/database/database.hpp>
+#include <sophiatx/chain/witness_objects.hpp>
+#include <sophiatx/chain/account_object.hpp>
+
+#include <sophiatx/plugins/chain/chain_plugin_full.hpp>
+#include <sophiatx/plugins/account_history/account_history_plugin.hpp>
+#include <sophiatx/plugins/account_history_api/account_history_api_plugin.hpp>
+#include <sophiatx/plugins/account_history_api/account_history_api.hpp>
+#include <sophiatx/plugins/database_api/database_api_plugin.hpp>
+#include <sophiatx/plugins/database_api/database_api.hpp>
+#include <sophiatx/plugins/debug_node/debug_node_plugin.hpp>
+#include <sophiatx/plugins/json_rpc/json_rpc_plugin.hpp>
+#include <sophiatx/plugins/alexandria_api/alexandria_api.hpp>
+#include <sophiatx/plugins/alexandria_api/alexandria_api_plugin.hpp>
+
+#include <sophiatx/utilities/key_conversion.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+#include <fc/log/logger.hpp>
+
+#include <iostream>
+
+using namespace sophiatx::chain;
+using namespace sophiatx::protocol;
+using namespace sophiatx::plugins;
+
+/**
+ * Compares alexandria_api.info read through a chain_snapshot with composing it from database_api calls, as it was
+ * before, and times get_account and get_account_history. The chain is a test net genesis with the given number of
+ * blocks, each of which adds a producer reward to the history of the init miner.
+ *
+ * usage: bench_alexandria_api [calls] [blocks]
+ */
+
+template< typename Lambda >
+static int64_t timed( uint32_t calls, Lambda&& f )
+{
+   auto start = fc::time_point::now();
+   for( uint32_t i = 0; i < calls; ++i )
+      f();
+   return ( fc::time_point::now() - start ).count() / calls;
+}
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      uint32_t calls = argc > 1 ? std::stoul( argv[1] ) : 1000;
+      uint32_t blocks = argc > 2 ? std::stoul( argv[2] ) : 1000;
+
+      fc::Logger::init( "sophiatx", "error" );
+      fc::temp_directory temp_dir( "." );
+
+      appbase::app().register_plugin< sophiatx::plugins::chain::chain_plugin_full >();
+      appbase::app().register_plugin< account_history::account_history_plugin >();
+      auto& debug_plugin = appbase::app().register_plugin< debug_node::debug_node_plugin >();
+      appbase::app().register_plugin< json_rpc::json_rpc_plugin >();
+      appbase::app().register_plugin< database_api::database_api_plugin >();
+      appbase::app().register_plugin< account_history::account_history_api_plugin >();
+      appbase::app().register_plugin< alexandria_api::alexandria_api_plugin >();
+
+      char* plugin_argv[] = { argv[0] };
+      appbase::app().initialize<
+         sophiatx::plugins::chain::chain_plugin_full,
+         account_history::account_history_plugin,
+         debug_node::debug_node_plugin,
+         json_rpc::json_rpc_plugin,
+         database_api::database_api_plugin,
+         account_history::account_history_api_plugin,
+         alexandria_api::alexandria_api_plugin
+         >( 1, plugin_argv );
+      debug_plugin.logging = false;
+
+      auto db = std::static_pointer_cast< database >( appbase::app().get_plugin< sophiatx::plugins::chain::chain_plugin >().db() );
+      db->_log_hardforks = false;
+
+      genesis_state_type genesis;
+      genesis.genesis_time = fc::time_point::now();
+
+      database_interface::open_args args;
+      args.shared_mem_dir = temp_dir.path();
+      args.shared_file_size = 1024ull * 1024 * 512;
+      db->open( args, genesis );
+
+      appbase::app().get_plugin< alexandria_api::alexandria_api_plugin >().plugin_startup();
+
+      auto key = fc::ecc::private_key::regenerate( fc::sha256::hash( std::string( "bench_alexandria_api" ) ) );
+      db->modify( db->get_witness( SOPHIATX_INIT_MINER_NAME ), [&]( witness_object& w )
+      {
+         w.signing_key = key.get_public_key();
+      });
+      db->set_hardfork( SOPHIATX_BLOCKCHAIN_VERSION.get_minor() );
+
+      uint32_t skip = database_interface::skip_undo_history_check | database_interface::skip_authority_check;
+      debug_plugin.debug_generate_blocks( sophiatx::utilities::key_to_wif( key ), blocks, skip, 0 );
+
+      auto& db_api = *appbase::app().get_plugin< database_api::database_api_plugin >().api;
+      auto& alexandria = *appbase::app().get_plugin< alexandria_api::alexandria_api_plugin >().api;
+      auto no_notify = []( fc::variant&, uint64_t ) {};
+
+      // How alexandria_api.info was composed from database_api calls before it read a chain_snapshot
+      auto legacy_info = [&]()
+      {
+         return db->with_read_lock( [&]()
+         {
+            auto dynamic_props = db_api.get_dynamic_global_properties( {} );
+            fc::mutable_variant_object info_data( fc::variant( dynamic_props ).get_object() );
+            info_data[ "witness_majority_version" ] = std::string( db_api.get_witness_schedule( {} ).majority_version );
+            info_data[ "hardfork_version" ] = std::string( db_api.get_hardfork_properties( {} ).current_hardfork_version );
+            info_data[ "head_block_age" ] = fc::get_approximate_relative_time_string( dynamic_props.time, fc::time_point_sec( fc::time_point::now() ), " old" );
+            info_data[ "participation" ] = ( 100 * dynamic_props.recent_slots_filled.popcount() ) / 128.0;
+            info_data[ "median_sbd1_price" ] = db_api.get_current_price_feed( { SBD1_SYMBOL } );
+            info_data[ "median_sbd2_price" ] = db_api.get_current_price_feed( { SBD2_SYMBOL } );
+            info_data[ "median_sbd3_price" ] = db_api.get_current_price_feed( { SBD3_SYMBOL } );
+            info_data[ "median_sbd4_price" ] = db_api.get_current_price_feed( { SBD4_SYMBOL } );
+            info_data[ "median_sbd5_price" ] = db_api.get_current_price_feed( { SBD5_SYMBOL } );
+            info_data[ "account_creation_fee" ] = db_api.get_witness_schedule( {} ).median_props.account_creation_fee;
+            return fc::variant( info_data );
+         });
+      };
+
+      auto& history_api = *appbase::app().get_plugin< account_history::account_history_api_plugin >().api;
+      auto latest = history_api.get_account_history( { SOPHIATX_INIT_MINER_NAME, -1, 1, true } ).history;
+      FC_ASSERT( latest.size(), "the init miner has no history" );
+      uint32_t last = latest.rbegin()->first;
+      uint32_t history_limit = std::min< uint32_t >( last + 1, 100 );
+      alexandria_api::get_account_history_args history_args{ SOPHIATX_INIT_MINER_NAME, last, history_limit };
+
+      int64_t legacy_us = timed( calls, [&]() { legacy_info(); } );
+      int64_t snapshot_us = timed( calls, [&]() { alexandria.info( {}, no_notify, true ); } );
+      int64_t account_us = timed( calls, [&]() { alexandria.get_account( { SOPHIATX_INIT_MINER_NAME }, no_notify, true ); } );
+      int64_t history_us = timed( calls, [&]() { alexandria.get_account_history( history_args, no_notify, true ); } );
+
+      std::cout << "info through database_api: " << legacy_us << " us per call\n"
+                << "info with the chain_snapshot: " << snapshot_us << " us per call\n"
+                << "get_account: " << account_us << " us per call\n"
+                << "get_account_history of " << history_limit << " entries: " << history_us << " us per call\n";
+
+      db->close();
+      appbase::reset();
+      return 0;
+   }
+   catch( const fc::exception& e )
+   {
+      std::cerr << e.to_detail_string() << "\n";
+   }
+
+   return 1;
+}
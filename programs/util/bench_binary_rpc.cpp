@@ -0,0 +1,111 @@
+#include <sophiatx/plugins/custom_api/custom_api.hpp>
+#include <sophiatx/remote_db/remote_db.hpp>
+
+#include <fc/rpc/binary_api.hpp>
+#include <fc/io/json.hpp>
+#include <fc/time.hpp>
+#include <fc/log/logger.hpp>
+
+#include <iostream>
+
+/**
+ * Compares the JSON and the binary websocket transport on custom_api.get_app_custom_messages pages, the bulk of the
+ * traffic of a light node syncing from a full node. Both the full node side (encoding the response) and the light
+ * node side (decoding it into remote::received_object) are measured, the network itself is not.
+ *
+ * usage: bench_binary_rpc [messages per page] [message size] [pages]
+ */
+
+using sophiatx::plugins::custom::get_app_custom_messages_return;
+typedef sophiatx::remote::get_app_custom_messages_return remote_page;
+
+static get_app_custom_messages_return make_page( uint32_t messages, uint32_t message_size )
+{
+   get_app_custom_messages_return result;
+   for( uint32_t i = 0; i < messages; ++i )
+   {
+      auto& msg = result[ i ];
+      msg.id = i;
+      msg.sender = "account" + std::to_string( i % 100 );
+      msg.recipients = { "account" + std::to_string( ( i + 1 ) % 100 ) };
+      msg.app_id = 42;
+      msg.data = "{\"message\":\"" + std::string( message_size, 'x' ) + "\",\"index\":" + std::to_string( i ) + "}";
+      msg.binary = false;
+      msg.received = fc::time_point_sec( 1500000000 + i * 3 );
+   }
+   return result;
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      uint32_t messages = argc > 1 ? std::stoul( argv[1] ) : 1000;
+      uint32_t message_size = argc > 2 ? std::stoul( argv[2] ) : 256;
+      uint32_t pages = argc > 3 ? std::stoul( argv[3] ) : 100;
+
+      auto page = make_page( messages, message_size );
+
+      std::cout << "Transferring " << pages << " pages of " << messages << " messages\n";
+
+      auto measure = [&]( const char* path, auto&& encode, auto&& decode )
+      {
+         size_t bytes = 0;
+         int64_t encode_us = 0;
+         int64_t decode_us = 0;
+         remote_page decoded;
+
+         for( uint32_t i = 0; i < pages; ++i )
+         {
+            auto start = fc::time_point::now();
+            std::string frame = encode();
+            auto encoded = fc::time_point::now();
+            decoded = decode( frame );
+            encode_us += ( encoded - start ).count();
+            decode_us += ( fc::time_point::now() - encoded ).count();
+            bytes += frame.size();
+         }
+
+         FC_ASSERT( decoded.size() == page.size() && decoded.rbegin()->second.data == page.rbegin()->second.data,
+                    "${p} transport changed the page", ("p",path) );
+
+         std::cout << "   " << path << ": " << bytes / pages << " bytes per page, "
+                   << "encode " << encode_us / pages << " us, decode " << decode_us / pages << " us, "
+                   << bytes / std::max< int64_t >( encode_us + decode_us, 1 ) << " MB/s\n";
+      };
+
+      measure( "json", [&]()
+      {
+         fc::mutable_variant_object response;
+         response( "jsonrpc", "2.0" )( "result", page )( "id", 1 );
+         return fc::json::to_string( fc::variant( response ) );
+      },
+      []( const std::string& frame )
+      {
+         remote_page out;
+         fc::from_variant( fc::json::from_string( frame )[ "result" ], out );
+         return out;
+      });
+
+      measure( "binary", [&]()
+      {
+         fc::rpc::binary_response response;
+         response.id = 1;
+         response.result = fc::raw::pack_to_vector( page );
+         auto packed = fc::raw::pack_to_vector( response );
+         return std::string( packed.data(), packed.size() );
+      },
+      []( const std::string& frame )
+      {
+         auto response = fc::raw::unpack_from_char_array< fc::rpc::binary_response >( frame.data(), frame.size(), 0 );
+         return fc::raw::unpack_from_vector< remote_page >( response.result, 0 );
+      });
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,147 @@
+#include <sophiatx/chain/block_log.hpp>
+#include <sophiatx/protocol/block.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+#include <fc/log/logger.hpp>
+
+#include <boost/thread/mutex.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+
+using namespace sophiatx::chain;
+using namespace sophiatx::protocol;
+
+/**
+ * Measures concurrent read_block_by_num throughput of the memory mapped block_log against a reader
+ * that works the way block_log did before: one mutex guarding one fstream per file, seeking and
+ * unpacking straight from the stream.
+ *
+ * usage: bench_block_log_reads [blocks] [threads] [reads per thread] [transactions per block]
+ */
+
+class stream_block_reader
+{
+   public:
+      stream_block_reader( const fc::path& file ) :
+         block_stream( file.generic_string().c_str(), std::ios::in | std::ios::binary ),
+         index_stream( ( file.generic_string() + ".index" ).c_str(), std::ios::in | std::ios::binary )
+      {
+         block_stream.exceptions( std::fstream::failbit | std::fstream::badbit );
+         index_stream.exceptions( std::fstream::failbit | std::fstream::badbit );
+      }
+
+      std::optional< signed_block > read_block_by_num( uint32_t block_num )
+      {
+         boost::mutex::scoped_lock lock( mtx );
+
+         uint64_t pos;
+         index_stream.seekg( sizeof( uint64_t ) * ( block_num - 1 ) );
+         index_stream.read( (char*)&pos, sizeof( pos ) );
+
+         std::optional< signed_block > b = signed_block();
+         block_stream.seekg( pos );
+         fc::raw::unpack( block_stream, *b, 0 );
+         return b;
+      }
+
+   private:
+      boost::mutex   mtx;
+      std::fstream   block_stream;
+      std::fstream   index_stream;
+};
+
+template< typename Read >
+static void run( const char* name, uint32_t blocks, uint32_t threads, uint32_t reads_per_thread, Read&& read )
+{
+   std::atomic< uint64_t > errors( 0 );
+   std::vector< std::thread > workers;
+
+   auto start = fc::time_point::now();
+   for( uint32_t t = 0; t < threads; ++t )
+   {
+      workers.emplace_back( [&, t]()
+      {
+         std::mt19937 rng( t );
+         std::uniform_int_distribution< uint32_t > dist( 1, blocks );
+         for( uint32_t i = 0; i < reads_per_thread; ++i )
+         {
+            uint32_t num = dist( rng );
+            auto b = read( num );
+            if( !b.has_value() || b->block_num() != num )
+               ++errors;
+         }
+      });
+   }
+   for( auto& w : workers )
+      w.join();
+   auto elapsed = fc::time_point::now() - start;
+
+   uint64_t total = uint64_t( threads ) * reads_per_thread;
+   std::cout << name << ": " << total << " reads in " << elapsed.count() / 1000 << " ms, "
+             << ( elapsed.count() ? total * 1000000 / elapsed.count() : 0 ) << " blocks/s"
+             << ( errors.load() ? " (" + std::to_string( errors.load() ) + " errors)" : std::string() ) << "\n";
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      uint32_t blocks = argc > 1 ? std::stoul( argv[1] ) : 20000;
+      uint32_t threads = argc > 2 ? std::stoul( argv[2] ) : std::max( 1u, std::thread::hardware_concurrency() );
+      uint32_t reads_per_thread = argc > 3 ? std::stoul( argv[3] ) : 50000;
+      uint32_t transactions = argc > 4 ? std::stoul( argv[4] ) : 10;
+
+      fc::temp_directory temp_dir( "." );
+      fc::path log_file = temp_dir.path() / "block_log";
+
+      {
+         block_log log;
+         log.open( log_file );
+
+         signed_block b;
+         for( uint32_t i = 0; i < blocks; ++i )
+         {
+            b.previous = i ? b.id() : block_id_type();
+            b.witness = "initminer";
+            b.timestamp = fc::time_point_sec( 1530000000 + i * 3 );
+            b.transactions.resize( transactions );
+            for( auto& trx : b.transactions )
+            {
+               trx.ref_block_num = i;
+               trx.signatures.resize( 1 );
+            }
+            log.append( b );
+         }
+         log.flush();
+      }
+
+      std::cout << "Reading " << blocks << " blocks with " << transactions << " transactions each from "
+                << threads << " threads\n";
+
+      {
+         stream_block_reader reader( log_file );
+         run( "stream + mutex", blocks, threads, reads_per_thread,
+            [&]( uint32_t num ) { return reader.read_block_by_num( num ); } );
+      }
+
+      {
+         block_log log;
+         log.open( log_file );
+         run( "mmap", blocks, threads, reads_per_thread,
+            [&]( uint32_t num ) { return log.read_block_by_num( num ); } );
+      }
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
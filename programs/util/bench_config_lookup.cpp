@@ -0,0 +1,113 @@
+#include <sophiatx/chain/get_config.hpp>
+#include <sophiatx/chain/genesis_state.hpp>
+
+#include <fc/time.hpp>
+#include <fc/log/logger.hpp>
+
+#include <iostream>
+
+using namespace sophiatx::chain;
+using sophiatx::protocol::asset_symbol_type;
+
+/**
+ * Compares the per block cost of reading the chain configuration through the string keyed
+ * sophiatx_config::get<T>() with the typed sophiatx_config::params() snapshot.
+ *
+ * One simulated block reads the values touched by block production and application
+ * (block size, interval, witness schedule, irreversibility, interests, supply checks) plus
+ * the per transaction lookups (transaction size, symbol, bandwidth limits) for every transaction.
+ */
+
+struct lookup_result
+{
+   uint64_t checksum = 0;
+};
+
+static void block_lookups_by_name( uint32_t transactions, lookup_result& r )
+{
+   r.checksum += sophiatx_config::get<uint32_t>( "SOPHIATX_MAX_BLOCK_SIZE" );
+   r.checksum += sophiatx_config::get<uint32_t>( "SOPHIATX_BLOCK_INTERVAL" );
+   r.checksum += sophiatx_config::get<uint32_t>( "SOPHIATX_MAX_WITNESSES" );
+   r.checksum += sophiatx_config::get<uint32_t>( "SOPHIATX_START_MINER_VOTING_BLOCK" );
+   r.checksum += sophiatx_config::get<uint32_t>( "SOPHIATX_BLOCKS_PER_HOUR" );
+   r.checksum += sophiatx_config::get<uint32_t>( "SOPHIATX_BLOCKS_PER_DAY" );
+   r.checksum += sophiatx_config::get<uint32_t>( "SOPHIATX_INTEREST_DELAY" );
+   r.checksum += sophiatx_config::get<uint32_t>( "SOPHIATX_COINBASE_BLOCKS" );
+   r.checksum += sophiatx_config::get<int64_t>( "SOPHIATX_MINING_POOL_PERCENTAGE" );
+   r.checksum += sophiatx_config::get<int64_t>( "SOPHIATX_TOTAL_SUPPLY" );
+   r.checksum += sophiatx_config::get<asset_symbol_type>( "SOPHIATX_SYMBOL" ).value;
+
+   for( uint32_t i = 0; i < transactions; ++i )
+   {
+      r.checksum += sophiatx_config::get<uint32_t>( "SOPHIATX_MAX_TRANSACTION_SIZE" );
+      r.checksum += sophiatx_config::get<asset_symbol_type>( "SOPHIATX_SYMBOL" ).value;
+      r.checksum += sophiatx_config::get<uint32_t>( "SOPHIATX_LIMIT_BANDWIDTH_BLOCKS" );
+      r.checksum += sophiatx_config::get<uint32_t>( "SOPHIATX_MAX_ALLOWED_BANDWIDTH" );
+      r.checksum += sophiatx_config::get<uint32_t>( "SOPHIATX_MAX_ALLOWED_OPS_COUNT" );
+   }
+}
+
+static void block_lookups_typed( uint32_t transactions, lookup_result& r )
+{
+   const auto& p = sophiatx_config::params();
+   r.checksum += p.max_block_size;
+   r.checksum += p.block_interval;
+   r.checksum += p.max_witnesses;
+   r.checksum += p.start_miner_voting_block;
+   r.checksum += p.blocks_per_hour;
+   r.checksum += p.blocks_per_day;
+   r.checksum += p.interest_delay;
+   r.checksum += p.coinbase_blocks;
+   r.checksum += p.mining_pool_percentage;
+   r.checksum += p.total_supply;
+   r.checksum += p.symbol.value;
+
+   for( uint32_t i = 0; i < transactions; ++i )
+   {
+      // Every access goes through params() as the call sites in database.cpp do
+      r.checksum += sophiatx_config::params().max_transaction_size;
+      r.checksum += sophiatx_config::params().symbol.value;
+      r.checksum += sophiatx_config::params().limit_bandwidth_blocks;
+      r.checksum += sophiatx_config::params().max_allowed_bandwidth;
+      r.checksum += sophiatx_config::params().max_allowed_ops_count;
+   }
+}
+
+template< typename Lookup >
+static double run( const char* name, uint32_t blocks, uint32_t transactions, Lookup&& lookup )
+{
+   lookup_result r;
+   auto start = fc::time_point::now();
+   for( uint32_t b = 0; b < blocks; ++b )
+      lookup( transactions, r );
+   auto elapsed = fc::time_point::now() - start;
+
+   double ns_per_block = double( elapsed.count() ) * 1000 / blocks;
+   std::cout << name << ": " << blocks << " blocks in " << elapsed.count() / 1000 << " ms, "
+             << ns_per_block << " ns per block (checksum " << r.checksum << ")\n";
+   return ns_per_block;
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      uint32_t blocks = argc > 1 ? std::stoul( argv[1] ) : 100000;
+      uint32_t transactions = argc > 2 ? std::stoul( argv[2] ) : 50;
+
+      genesis_state_type genesis;
+      sophiatx_config::init( genesis );
+
+      std::cout << "Simulating " << blocks << " blocks with " << transactions << " transactions each\n";
+      double by_name = run( "get<T>(name)", blocks, transactions, block_lookups_by_name );
+      double typed = run( "params()", blocks, transactions, block_lookups_typed );
+      std::cout << "speedup: " << ( typed > 0 ? by_name / typed : 0 ) << "x\n";
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,135 @@
+#include <sophiatx/chain/account_object.hpp>
+
+#include <sophiatx/plugins/account_history_api/account_history_api.hpp>
+#include <sophiatx/plugins/custom_api/custom_api.hpp>
+#include <sophiatx/plugins/json_rpc/json_writer.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/time.hpp>
+#include <fc/log/logger.hpp>
+
+#include <atomic>
+#include <iostream>
+#include <new>
+
+using namespace sophiatx::protocol;
+using sophiatx::plugins::json_rpc::json_writer;
+
+/**
+ * Compares writing JSON-RPC results through fc::variant, as json_rpc did before, with the json_writer on the two
+ * largest kinds of responses: account history and received documents.
+ *
+ * usage: bench_json_writer [entries per response] [document size] [responses]
+ */
+
+static std::atomic< uint64_t > allocations( 0 );
+
+void* operator new( size_t size )
+{
+   allocations.fetch_add( 1, std::memory_order_relaxed );
+   if( void* p = malloc( size ) )
+      return p;
+   throw std::bad_alloc();
+}
+
+void operator delete( void* p ) noexcept { free( p ); }
+void operator delete( void* p, size_t ) noexcept { free( p ); }
+
+static sophiatx::plugins::account_history::get_account_history_return make_history( uint32_t entries )
+{
+   sophiatx::plugins::account_history::get_account_history_return result;
+   for( uint32_t i = 0; i < entries; ++i )
+   {
+      transfer_operation op;
+      op.from = "account" + std::to_string( i % 100 );
+      op.to = "account" + std::to_string( ( i + 1 ) % 100 );
+      op.amount.amount = 1000 + i;
+      op.memo = "payment " + std::to_string( i );
+
+      auto& entry = result.history[ i ];
+      entry.trx_id = transaction_id_type::hash( (const char*)&i, sizeof( i ) );
+      entry.block = 1000000 + i / 10;
+      entry.trx_in_block = i % 10;
+      entry.timestamp = fc::time_point_sec( 1500000000 + i * 3 );
+      entry.op = op;
+      entry.fee_payer = op.from;
+   }
+   return result;
+}
+
+static sophiatx::plugins::custom::list_received_documents_return make_documents( uint32_t entries, uint32_t document_size )
+{
+   sophiatx::plugins::custom::list_received_documents_return result;
+   for( uint32_t i = 0; i < entries; ++i )
+   {
+      auto& doc = result[ i ];
+      doc.id = i;
+      doc.sender = "account" + std::to_string( i % 100 );
+      doc.recipients = { "account" + std::to_string( ( i + 1 ) % 100 ), "account" + std::to_string( ( i + 2 ) % 100 ) };
+      doc.app_id = 42;
+      doc.data = "{\"document\":\"" + std::string( document_size, 'x' ) + "\",\"index\":" + std::to_string( i ) + "}";
+      doc.binary = false;
+      doc.received = fc::time_point_sec( 1500000000 + i * 3 );
+   }
+   return result;
+}
+
+template< typename Result >
+static void run( const char* name, const Result& result, uint32_t responses )
+{
+   auto measure = [&]( const char* path, auto&& write )
+   {
+      size_t bytes = 0;
+      uint64_t start_allocations = allocations.load();
+      auto start = fc::time_point::now();
+
+      for( uint32_t i = 0; i < responses; ++i )
+         bytes += write();
+
+      int64_t us = std::max< int64_t >( ( fc::time_point::now() - start ).count(), 1 );
+      uint64_t allocs = allocations.load() - start_allocations;
+      std::cout << "   " << path << ": " << bytes / responses << " bytes, "
+                << bytes / us << " MB/s, "
+                << allocs / responses << " allocations per response\n";
+   };
+
+   std::cout << name << ":\n";
+
+   measure( "fc::variant", [&]()
+   {
+      return fc::json::to_string( fc::variant( result ) ).size();
+   });
+
+   std::string buffer;
+   measure( "json_writer", [&]()
+   {
+      buffer.clear();
+      json_writer w( buffer );
+      w.write( result );
+      return buffer.size();
+   });
+
+   FC_ASSERT( buffer == fc::json::to_string( fc::variant( result ) ), "json_writer output differs from fc::json" );
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      uint32_t entries = argc > 1 ? std::stoul( argv[1] ) : 1000;
+      uint32_t document_size = argc > 2 ? std::stoul( argv[2] ) : 1024;
+      uint32_t responses = argc > 3 ? std::stoul( argv[3] ) : 100;
+
+      std::cout << "Writing " << responses << " responses of " << entries << " entries\n";
+
+      run( "account_history_api.get_account_history", make_history( entries ), responses );
+      run( "custom_api.list_received_documents", make_documents( entries, document_size ), responses );
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,170 @@
+#include <sophiatx/chain/account_object.hpp>
+#include <sophiatx/chain/secondary_index.hpp>
+#include <sophiatx/chain/genesis_state.hpp>
+#include <sophiatx/chain/get_config.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+#include <fc/log/logger.hpp>
+
+#include <iostream>
+#include <random>
+
+using namespace sophiatx::chain;
+using namespace sophiatx::protocol;
+
+/**
+ * Compares applying blocks to the account index with the by_balance ordering it used to keep for
+ * database_api.list_accounts, and without it. Without the ordering, list_accounts builds it with a secondary_index,
+ * which is measured as well with one call per block, the worst case of a node serving the api.
+ *
+ * Every block modifies two accounts for each transfer, every interest_interval-th block modifies all of the accounts
+ * as process_interests does.
+ *
+ * usage: bench_secondary_index [blocks] [transfers per block] [accounts] [interest interval]
+ */
+
+struct by_balance;
+
+typedef multi_index_container<
+   account_object,
+   indexed_by<
+      ordered_unique< tag< by_id >,
+         member< account_object, account_id_type, &account_object::id > >,
+      ordered_unique< tag< by_name >,
+         member< account_object, account_name_type, &account_object::name > >,
+      ordered_unique< tag< by_proxy >,
+         composite_key< account_object,
+            member< account_object, account_name_type, &account_object::proxy >,
+            member< account_object, account_name_type, &account_object::name >
+         >
+      >,
+      ordered_non_unique< tag< by_balance >,
+         const_mem_fun< account_object, share_type, &account_object::total_balance > >,
+      ordered_unique< tag< by_next_vesting_withdrawal >,
+         composite_key< account_object,
+            member< account_object, fc::time_point_sec, &account_object::next_vesting_withdrawal >,
+            member< account_object, account_name_type, &account_object::name >
+         >
+      >
+   >,
+   allocator< account_object >
+> account_index_with_balance;
+
+struct bench_params
+{
+   uint32_t blocks = 0;
+   uint32_t transfers = 0;
+   uint32_t accounts = 0;
+   uint32_t interest_interval = 0;
+};
+
+struct bench_result
+{
+   int64_t apply_us = 0;
+   int64_t query_us = 0;
+   uint64_t rebuilds = 0;
+};
+
+/// Indices are constructed in the segment directly, the database maps account_object to a single index type
+template< typename IndexType >
+static bench_result run( const bench_params& p, bool query )
+{
+   fc::temp_directory temp_dir( "." );
+   chainbase::database db;
+   db.open( temp_dir.path(), 0, 1024ull * 1024 * 1024 );
+
+   auto segment = db.get_segment_manager();
+   auto& idx = *segment->construct< chainbase::generic_index< IndexType > >( boost::interprocess::anonymous_instance )(
+      allocator< account_object >( segment ) );
+
+   for( uint32_t i = 0; i < p.accounts; ++i )
+      idx.emplace( [&]( account_object& a )
+      {
+         a.name = "account" + std::to_string( i );
+         a.balance.amount = 1000000 + i;
+      });
+
+   secondary_index< IndexType, share_type > by_balance_index( []( const account_object& a ){ return a.total_balance(); } );
+
+   std::mt19937 rng( 1 );
+   std::uniform_int_distribution< int64_t > account_dist( 0, p.accounts - 1 );
+
+   bench_result result;
+   for( uint32_t b = 1; b <= p.blocks; ++b )
+   {
+      auto start = fc::time_point::now();
+      auto session = idx.start_undo_session();
+
+      for( uint32_t t = 0; t < p.transfers; ++t )
+      {
+         const auto& from = idx.get( account_id_type( account_dist( rng ) ) );
+         const auto& to = idx.get( account_id_type( account_dist( rng ) ) );
+         idx.modify( from, [&]( account_object& a ) { a.balance.amount -= 101; } );
+         idx.modify( to, [&]( account_object& a ) { a.balance.amount += 100; } );
+      }
+
+      if( p.interest_interval && b % p.interest_interval == 0 )
+         for( const auto& a : idx.indices() )
+            idx.modify( a, [&]( account_object& acc ) { acc.balance.amount += acc.balance.amount / 1000; } );
+
+      session.push();
+      if( idx.revision() > 21 )
+         idx.commit( idx.revision() - 21 );
+      result.apply_us += ( fc::time_point::now() - start ).count();
+
+      if( query )
+      {
+         start = fc::time_point::now();
+         block_id_type head_block_id;
+         head_block_id._hash[0] = b;
+         auto entries = by_balance_index.get( idx, head_block_id );
+         FC_ASSERT( entries->size() == p.accounts );
+         result.query_us += ( fc::time_point::now() - start ).count();
+      }
+   }
+
+   result.rebuilds = by_balance_index.rebuilds();
+   idx.undo_all();
+   segment->destroy_ptr( &idx );
+   db.close();
+   return result;
+}
+
+static void print( const char* name, const bench_result& r, const bench_params& p, bool query )
+{
+   std::cout << name << ":\n"
+             << "   apply block:      " << ( p.blocks ? r.apply_us / p.blocks : 0 ) << " us per block\n";
+   if( query )
+      std::cout << "   list_accounts:    " << ( p.blocks ? r.query_us / p.blocks : 0 ) << " us per block, "
+                << r.rebuilds << " rebuilds\n";
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      bench_params p;
+      p.blocks = argc > 1 ? std::stoul( argv[1] ) : 2000;
+      p.transfers = argc > 2 ? std::stoul( argv[2] ) : 500;
+      p.accounts = argc > 3 ? std::stoul( argv[3] ) : 100000;
+      p.interest_interval = argc > 4 ? std::stoul( argv[4] ) : 100;
+
+      genesis_state_type genesis;
+      sophiatx_config::init( genesis );
+
+      std::cout << "Applying " << p.blocks << " blocks with " << p.transfers << " transfers each over "
+                << p.accounts << " accounts, interests every " << p.interest_interval << " blocks\n";
+
+      print( "by_balance in the account index", run< account_index_with_balance >( p, false ), p, false );
+      print( "without by_balance", run< account_index >( p, false ), p, false );
+      print( "secondary_index read every block", run< account_index >( p, true ), p, true );
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
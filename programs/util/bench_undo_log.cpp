@@ -0,0 +1,154 @@
+#include <sophiatx/chain/account_object.hpp>
+#include <sophiatx/chain/transaction_object.hpp>
+#include <sophiatx/chain/genesis_state.hpp>
+#include <sophiatx/chain/get_config.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+#include <fc/log/logger.hpp>
+
+#include <iostream>
+#include <random>
+
+using namespace sophiatx::chain;
+using namespace sophiatx::protocol;
+
+/**
+ * Compares the undo_state trees of chainbase::generic_index with the flat undo_log on the session patterns
+ * of the chain:
+ *
+ * push transaction - every transaction runs in its own session squashed into the pending block session
+ * apply block      - the pending session is undone, the block is applied the same way in a block session
+ *                    which is pushed and committed once the block becomes irreversible
+ * pop block        - the last pushed block session is undone, as on a fork switch
+ *
+ * Every transaction creates a transaction_object and modifies two accounts, the sender twice.
+ *
+ * usage: bench_undo_log [blocks] [transactions per block] [accounts] [irreversible distance]
+ */
+
+struct bench_result
+{
+   int64_t push_us = 0;
+   int64_t apply_us = 0;
+   int64_t pop_us = 0;
+   size_t  max_undo_memory = 0;
+};
+
+static bench_result run( bool flat_undo, uint32_t blocks, uint32_t transactions, uint32_t accounts, uint32_t irreversible_distance )
+{
+   fc::temp_directory temp_dir( "." );
+   chainbase::database db;
+   db.open( temp_dir.path(), 0, 1024ull * 1024 * 1024 );
+   db.add_index< account_index >();
+   db.add_index< transaction_index >();
+
+   for( uint32_t i = 0; i < accounts; ++i )
+      db.create< account_object >( [&]( account_object& a )
+      {
+         a.name = "account" + std::to_string( i );
+         a.balance.amount = 1000000;
+      });
+
+   db.set_flat_undo( flat_undo );
+   size_t base_free = db.get_free_memory();
+
+   std::mt19937 rng( 1 );
+   std::uniform_int_distribution< int64_t > account_dist( 0, accounts - 1 );
+   std::vector< char > packed_trx( 200 );
+   uint64_t trx_num = 0;
+
+   auto apply_transactions = [&]()
+   {
+      for( uint32_t t = 0; t < transactions; ++t )
+      {
+         auto session = db.start_undo_session();
+         ++trx_num;
+         db.create< transaction_object >( [&]( transaction_object& trx )
+         {
+            trx.trx_id = transaction_id_type::hash( (const char*)&trx_num, sizeof( trx_num ) );
+            trx.packed_trx.assign( packed_trx.begin(), packed_trx.end() );
+            trx.expiration = fc::time_point_sec( trx_num );
+         });
+
+         const auto& from = db.get< account_object >( account_id_type( account_dist( rng ) ) );
+         const auto& to = db.get< account_object >( account_id_type( account_dist( rng ) ) );
+         db.modify( from, [&]( account_object& a ) { a.balance.amount -= 2; } );
+         db.modify( to, [&]( account_object& a ) { a.balance.amount += 1; } );
+         db.modify( from, [&]( account_object& a ) { a.balance.amount += 1; } );
+         session.squash();
+      }
+   };
+
+   bench_result result;
+   for( uint32_t b = 0; b < blocks; ++b )
+   {
+      auto start = fc::time_point::now();
+      {
+         auto pending = db.start_undo_session();
+         apply_transactions();
+         result.push_us += ( fc::time_point::now() - start ).count();
+
+         start = fc::time_point::now();
+         pending.undo();
+      }
+
+      auto block = db.start_undo_session();
+      apply_transactions();
+      block.push();
+      if( db.revision() > irreversible_distance )
+         db.commit( db.revision() - irreversible_distance );
+      result.apply_us += ( fc::time_point::now() - start ).count();
+
+      result.max_undo_memory = std::max( result.max_undo_memory, base_free - db.get_free_memory() );
+
+      // Switch to a fork every tenth block, the popped block is applied again on the next iteration
+      if( b % 10 == 9 )
+      {
+         start = fc::time_point::now();
+         db.undo();
+         result.pop_us += ( fc::time_point::now() - start ).count();
+      }
+   }
+
+   db.undo_all();
+   db.close();
+   return result;
+}
+
+static void print( const char* name, const bench_result& r, uint32_t blocks, uint32_t transactions )
+{
+   uint64_t trxs = uint64_t( blocks ) * transactions;
+   std::cout << name << ":\n"
+             << "   push transaction: " << ( trxs ? r.push_us * 1000 / int64_t( trxs ) : 0 ) << " ns per transaction\n"
+             << "   apply block:      " << ( blocks ? r.apply_us / blocks : 0 ) << " us per block\n"
+             << "   pop block:        " << ( blocks >= 10 ? r.pop_us / ( blocks / 10 ) : 0 ) << " us per block\n"
+             << "   max segment used: " << r.max_undo_memory / 1024 << " KiB\n";
+}
+
+int main( int argc, char** argv, char** envp )
+{
+   try
+   {
+      uint32_t blocks = argc > 1 ? std::stoul( argv[1] ) : 2000;
+      uint32_t transactions = argc > 2 ? std::stoul( argv[2] ) : 500;
+      uint32_t accounts = argc > 3 ? std::stoul( argv[3] ) : 10000;
+      uint32_t irreversible_distance = argc > 4 ? std::stoul( argv[4] ) : 21;
+
+      genesis_state_type genesis;
+      sophiatx_config::init( genesis );
+
+      std::cout << "Applying " << blocks << " blocks with " << transactions << " transactions each over "
+                << accounts << " accounts, " << irreversible_distance << " reversible blocks\n";
+
+      print( "undo_state", run( false, blocks, transactions, accounts, irreversible_distance ), blocks, transactions );
+      print( "undo_log", run( true, blocks, transactions, accounts, irreversible_distance ), blocks, transactions );
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,93 @@
+#include <sophiatx/chain/block_log.hpp>
+#include <sophiatx/chain/compressed_block_log.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+#include <fc/log/logger.hpp>
+
+#include <iostream>
+
+using namespace sophiatx::chain;
+
+/**
+ * Offline converter between the raw and the compressed block log format.
+ *
+ * usage: block_log_compress <input block_log> <output block_log> [blocks per chunk]
+ *
+ * The input format is detected automatically. The output is written in the compressed format with the given
+ * number of blocks per chunk, 0 writes a raw block log. The output file must not exist.
+ */
+
+int main( int argc, char** argv, char** envp )
+{
+   if( argc < 3 )
+   {
+      std::cerr << "usage: " << argv[0] << " <input block_log> <output block_log> [blocks per chunk]\n"
+                << "   blocks per chunk defaults to " << compressed_block_log::default_blocks_per_chunk << ", 0 writes a raw block log\n";
+      return 1;
+   }
+
+   try
+   {
+      fc::path input_file( argv[1] );
+      fc::path output_file( argv[2] );
+      uint32_t blocks_per_chunk = argc > 3 ? std::stoul( argv[3] ) : compressed_block_log::default_blocks_per_chunk;
+
+      FC_ASSERT( fc::exists( input_file ), "Input block log does not exist.", ("file", input_file) );
+      FC_ASSERT( !fc::exists( output_file ), "Output block log already exists.", ("file", output_file) );
+
+      block_log input;
+      input.open( input_file );
+      FC_ASSERT( input.head().has_value(), "Input block log is empty." );
+      uint32_t head_num = input.head()->block_num();
+
+      block_log output;
+      output.open( output_file, blocks_per_chunk );
+
+      std::cout << "Converting " << head_num << " blocks from " << ( compressed_block_log::is_compressed( input_file ) ? "compressed" : "raw" )
+                << " to " << ( blocks_per_chunk ? "compressed" : "raw" ) << " block log\n";
+
+      const uint32_t batch_size = 1000;
+      auto start = fc::time_point::now();
+      for( uint32_t first = 1; first <= head_num; first += batch_size )
+      {
+         uint32_t count = std::min( batch_size, head_num - first + 1 );
+         for( const auto& raw : input.read_raw_blocks( first, count ) )
+            output.append( fc::raw::unpack_from_vector< signed_block >( raw, 0 ) );
+
+         if( ( first + count - 1 ) % 100000 < batch_size )
+            std::cout << "   " << first + count - 1 << " of " << head_num << "\n";
+      }
+      output.flush();
+
+      FC_ASSERT( output.head().has_value() && output.head()->id() == input.head()->id(), "Head of converted block log does not match the input." );
+      output.close();
+      input.close();
+
+      auto total_size = []( const fc::path& file )
+      {
+         uint64_t size = 0;
+         for( const auto& suffix : { "", ".index", ".tail" } )
+         {
+            fc::path p( file.generic_string() + suffix );
+            if( fc::exists( p ) )
+               size += fc::file_size( p );
+         }
+         return size;
+      };
+
+      uint64_t input_size = total_size( input_file );
+      uint64_t output_size = total_size( output_file );
+      std::cout << "Done in " << double( ( fc::time_point::now() - start ).count() ) / 1000000.0 << " sec, "
+                << input_size << " bytes -> " << output_size << " bytes ("
+                << ( input_size ? double( output_size ) * 100 / input_size : 0 ) << "%)\n";
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
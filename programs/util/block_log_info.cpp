@@ -0,0 +1,110 @@
+#include <sophiatx/chain/block_log.hpp>
+#include <sophiatx/chain/compressed_block_log.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/io/json.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/log/logger.hpp>
+
+#include <iostream>
+
+using namespace sophiatx::chain;
+
+/**
+ * Prints the format, size and head of a block log and optionally verifies it.
+ *
+ * usage: block_log_info <block_log> [--verify]
+ *
+ * Verification reads every block through the block number index and checks that block numbers are continuous
+ * and every block links to the previous one. Works on both the raw and the compressed format. The log is opened
+ * read only, so it can be inspected while a node is writing to it.
+ */
+
+int main( int argc, char** argv, char** envp )
+{
+   if( argc < 2 )
+   {
+      std::cerr << "usage: " << argv[0] << " <block_log> [--verify]\n";
+      return 1;
+   }
+
+   try
+   {
+      fc::path file( argv[1] );
+      bool verify = argc > 2 && std::string( argv[2] ) == "--verify";
+      FC_ASSERT( fc::exists( file ), "Block log does not exist.", ("file", file) );
+
+      bool compressed = compressed_block_log::is_compressed( file );
+      std::cout << "format:           " << ( compressed ? "compressed" : "raw" ) << "\n";
+
+      uint64_t disk_size = 0;
+      for( const auto& suffix : { "", ".index", ".tail" } )
+      {
+         fc::path p( file.generic_string() + suffix );
+         if( fc::exists( p ) )
+         {
+            std::cout << "size " << p.filename().generic_string() << ": " << fc::file_size( p ) << "\n";
+            disk_size += fc::file_size( p );
+         }
+      }
+
+      if( compressed )
+      {
+         compressed_block_log clog;
+         clog.open_read_only( file );
+         std::cout << "blocks per chunk: " << clog.blocks_per_chunk() << "\n"
+                   << "chunks:           " << clog.chunk_count() << "\n"
+                   << "tail blocks:      " << clog.head_block_num() - clog.chunk_count() * clog.blocks_per_chunk() << "\n";
+      }
+
+      block_log log;
+      log.open_read_only( file );
+      if( !log.head().has_value() )
+      {
+         std::cout << "head:             empty\n";
+         return 0;
+      }
+
+      const auto& head = *log.head();
+      uint32_t head_num = head.block_num();
+      std::cout << "head block:       " << head_num << "\n"
+                << "head id:          " << std::string( head.id() ) << "\n"
+                << "head time:        " << head.timestamp.to_iso_string() << "\n";
+
+      if( !verify )
+         return 0;
+
+      const uint32_t batch_size = 1000;
+      uint64_t raw_size = 0;
+      block_id_type previous_id;
+      for( uint32_t first = 1; first <= head_num; first += batch_size )
+      {
+         uint32_t count = std::min( batch_size, head_num - first + 1 );
+         auto raw = log.read_raw_blocks( first, count );
+         FC_ASSERT( raw.size() == count, "Unexpected number of blocks read.", ("first", first)("count", count)("read", raw.size()) );
+
+         for( uint32_t i = 0; i < count; ++i )
+         {
+            auto b = fc::raw::unpack_from_vector< signed_block >( raw[i], 0 );
+            FC_ASSERT( b.block_num() == first + i, "Unexpected block number.", ("block_num", b.block_num())("expected", first + i) );
+            FC_ASSERT( b.previous == previous_id, "Block does not link to the previous block.", ("block_num", b.block_num()) );
+            previous_id = b.id();
+            raw_size += raw[i].size();
+         }
+      }
+
+      FC_ASSERT( previous_id == head.id(), "Last block does not match the head block." );
+      FC_ASSERT( log.read_block_by_num( head_num )->id() == head.id(), "Head block read by number does not match the head block." );
+
+      std::cout << "verified:         " << head_num << " blocks\n"
+                << "packed blocks:    " << raw_size << " bytes\n"
+                << "disk / packed:    " << ( raw_size ? double( disk_size ) * 100 / raw_size : 0 ) << "%\n";
+   }
+   catch ( const fc::exception& e )
+   {
+      edump( ( e.to_detail_string() ) );
+      return 1;
+   }
+
+   return 0;
+}
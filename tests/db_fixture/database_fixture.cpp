@@ -10,6 +10,7 @@
 #include <sophiatx/plugins/chain/chain_plugin_full.hpp>
 #include <sophiatx/plugins/webserver/webserver_plugin.hpp>
 
+#include <sophiatx/plugins/account_history_api/account_history_api_plugin.hpp>
 #include <sophiatx/plugins/alexandria_api/alexandria_api_plugin.hpp>
 
 #include <fc/crypto/digest.hpp>
@@ -35,11 +36,18 @@ namespace sophiatx { namespace chain {
 using std::cout;
 using std::cerr;
 
-clean_database_fixture::clean_database_fixture()
+clean_database_fixture::clean_database_fixture( const std::vector< std::string >& options )
 {
    try {
-   int argc = boost::unit_test::framework::master_test_suite().argc;
-   char** argv = boost::unit_test::framework::master_test_suite().argv;
+   std::vector< std::string > args( boost::unit_test::framework::master_test_suite().argv,
+                                    boost::unit_test::framework::master_test_suite().argv + boost::unit_test::framework::master_test_suite().argc );
+   args.insert( args.end(), options.begin(), options.end() );
+   std::vector< char* > arg_ptrs;
+   for( auto& arg : args )
+      arg_ptrs.push_back( &arg[0] );
+
+   int argc = arg_ptrs.size();
+   char** argv = arg_ptrs.data();
    for( int i=1; i<argc; i++ )
    {
       const std::string arg = argv[i];
@@ -551,6 +559,26 @@ void database_fixture::transfer(
    } FC_CAPTURE_AND_RETHROW( (from)(to)(amount) )
 }
 
+void database_fixture::push_signed_transfers( uint32_t count )
+{
+   try
+   {
+      for( uint32_t i = 0; i < count; ++i )
+      {
+         signed_transaction tx;
+         transfer_operation t;
+         t.from = SOPHIATX_INIT_MINER_NAME;
+         t.to = AN("initminer1");
+         t.fee = ASSET( "0.100000 SPHTX" );
+         t.amount = asset( 1 + i, chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL") );
+         tx.operations.push_back( t );
+         tx.set_expiration( db->head_block_time() + SOPHIATX_MAX_TIME_UNTIL_EXPIRATION );
+         sign( tx, init_account_priv_key );
+         db->push_transaction( tx, 0 );
+      }
+   } FC_CAPTURE_AND_RETHROW( (count) )
+}
+
 void database_fixture::vest( const string& account_name, const share_type& amount )
 {
 
@@ -709,6 +737,7 @@ json_rpc_database_fixture::json_rpc_database_fixture()
    rpc_plugin = &appbase::app().register_plugin< sophiatx::plugins::json_rpc::json_rpc_plugin >();
    appbase::app().register_plugin< sophiatx::plugins::block_api::block_api_plugin >();
    appbase::app().register_plugin< sophiatx::plugins::database_api::database_api_plugin >();
+   appbase::app().register_plugin< sophiatx::plugins::account_history::account_history_api_plugin >();
    appbase::app().register_plugin< sophiatx::plugins::alexandria_api::alexandria_api_plugin >();
    appbase::app().load_config(argc, argv);
 
@@ -722,6 +751,7 @@ json_rpc_database_fixture::json_rpc_database_fixture()
       sophiatx::plugins::json_rpc::json_rpc_plugin,
       sophiatx::plugins::block_api::block_api_plugin,
       sophiatx::plugins::database_api::database_api_plugin,
+      sophiatx::plugins::account_history::account_history_api_plugin,
       sophiatx::plugins::alexandria_api::alexandria_api_plugin
       >( argc, argv );
    appbase::app().load_config(argc, argv);
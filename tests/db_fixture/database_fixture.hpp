@@ -229,6 +229,8 @@ struct database_fixture {
    void fund( const string& account_name, const share_type& amount = 500000 );
    void fund( const string& account_name, const asset& amount );
    void transfer( const string& from, const string& to, const asset& amount );
+   /// Pushes count signed transfers of increasing amounts from the init miner to initminer1 to the pending state
+   void push_signed_transfers( uint32_t count );
    void convert( const string& account_name, const asset& amount );
    void vest( const string& from, const share_type& amount );
    void vest( const string& account, const asset& amount );
@@ -246,7 +248,8 @@ struct database_fixture {
 
 struct clean_database_fixture : public database_fixture
 {
-   clean_database_fixture();
+   /// options are added to the command line of the test, e.g. "--account-history-storage=sqlite"
+   clean_database_fixture( const std::vector< std::string >& options = {} );
    virtual ~clean_database_fixture();
 
    void resize_shared_mem( uint64_t size );
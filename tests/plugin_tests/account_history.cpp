@@ -0,0 +1,192 @@
+#include <boost/test/unit_test.hpp>
+
+#include <sophiatx/protocol/sophiatx_operations.hpp>
+#include <sophiatx/plugins/account_history/account_history_plugin.hpp>
+#include <sophiatx/plugins/account_history/account_history_store.hpp>
+#include <sophiatx/utilities/tempdir.hpp>
+
+#include "../db_fixture/database_fixture.hpp"
+
+using namespace sophiatx::chain;
+using namespace sophiatx::protocol;
+
+#ifdef SOPHIATX_ACCOUNT_HISTORY_STORE
+
+using sophiatx::plugins::account_history::account_history_plugin;
+using sophiatx::plugins::account_history::account_history_store;
+
+namespace {
+
+/// Data directory of the node, the account history store is kept in it
+struct history_data_dir
+{
+   fc::temp_directory dir{ sophiatx::utilities::temp_directory_path() };
+};
+
+/// Node keeping the account history in the SQLite store
+struct sqlite_history_fixture : history_data_dir, clean_database_fixture
+{
+   sqlite_history_fixture()
+      : clean_database_fixture( { "--data-dir=" + dir.path().generic_string(), "--account-history-storage=sqlite" } ) {}
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE( account_history_tests )
+
+BOOST_AUTO_TEST_CASE( history_store )
+{
+   try
+   {
+      fc::temp_directory dir( sophiatx::utilities::temp_directory_path() );
+      auto file = dir.path() / "account_history.db";
+
+      transfer_operation transfer;
+      transfer.from = "alice";
+      transfer.to = "bob";
+      transfer.amount = asset( 100, sophiatx_config::get< asset_symbol_type >( "SOPHIATX_SYMBOL" ) );
+
+      auto push = [&]( account_history_store& store, uint32_t block, const transaction_id_type& trx_id, std::vector< account_name_type > accounts )
+      {
+         operation op = transfer;
+         operation_notification note( op );
+         note.block = block;
+         note.trx_id = trx_id;
+         note.fee_payer = "alice";
+         store.push_operation( note, fc::time_point_sec( 1500000000 + block * 3 ), std::move( accounts ) );
+      };
+
+      transaction_id_type trx_1 = fc::ripemd160::hash( std::string( "trx 1" ) );
+      transaction_id_type trx_2 = fc::ripemd160::hash( std::string( "trx 2" ) );
+
+      {
+         account_history_store store( file );
+
+         store.begin_block( 1 );
+         push( store, 1, trx_1, { "alice", "bob" } );
+         store.end_block( 1, 0 );
+
+         store.begin_block( 2 );
+         push( store, 2, trx_2, { "alice" } );
+         store.end_block( 2, 0 );
+
+         // Operations of pending transactions are not part of any block
+         push( store, 2, trx_2, { "alice" } );
+
+         BOOST_REQUIRE_EQUAL( store.last_written_block(), 0u );
+         BOOST_REQUIRE_EQUAL( store.get_history_before( "alice", -1, 10 ).size(), 2u );
+         BOOST_REQUIRE_EQUAL( store.get_ops_in_block( 2 ).size(), 1u );
+
+         // A fork replaces block 2
+         store.begin_block( 2 );
+         push( store, 2, trx_2, { "bob" } );
+         store.end_block( 2, 0 );
+
+         auto alice = store.get_history_before( "alice", -1, 10 );
+         BOOST_REQUIRE_EQUAL( alice.size(), 1u );
+         BOOST_REQUIRE( alice.begin()->second.trx_id == trx_1 );
+
+         auto bob = store.get_history_before( "bob", -1, 10 );
+         BOOST_REQUIRE_EQUAL( bob.size(), 2u );
+         BOOST_REQUIRE_EQUAL( bob.rbegin()->first, 2u );
+         BOOST_REQUIRE_EQUAL( bob.rbegin()->second.block, 2u );
+
+         // Block 3 makes blocks 1 and 2 irreversible
+         store.begin_block( 3 );
+         store.end_block( 3, 2 );
+         BOOST_REQUIRE_EQUAL( store.last_written_block(), 2u );
+
+         bob = store.get_history_before( "bob", -1, 10 );
+         BOOST_REQUIRE_EQUAL( bob.size(), 2u );
+         BOOST_REQUIRE_EQUAL( bob.begin()->second.block, 1u );
+         BOOST_REQUIRE_EQUAL( store.get_history_before( "bob", 1, 10 ).size(), 1u );
+         BOOST_REQUIRE_EQUAL( store.get_history_after( "bob", 2, 10 ).begin()->first, 2u );
+
+         auto op = fc::raw::unpack_from_vector< operation >( bob.begin()->second.serialized_op, 0 );
+         BOOST_REQUIRE( op.get< transfer_operation >().to == account_name_type( "bob" ) );
+         BOOST_REQUIRE_EQUAL( bob.begin()->second.timestamp.sec_since_epoch(), 1500000003u );
+
+         auto trx = store.find_transaction( trx_2 );
+         BOOST_REQUIRE( trx.has_value() );
+         BOOST_REQUIRE_EQUAL( trx->block, 2u );
+         BOOST_REQUIRE( !store.find_transaction( fc::ripemd160::hash( std::string( "trx 3" ) ) ).has_value() );
+
+         // Sequences continue from the written history
+         store.begin_block( 4 );
+         push( store, 4, trx_1, { "bob" } );
+         store.end_block( 4, 2 );
+         BOOST_REQUIRE_EQUAL( store.get_history_before( "bob", -1, 1 ).begin()->first, 3u );
+         BOOST_REQUIRE_EQUAL( store.get_history_after( "bob", 2, 10 ).size(), 2u );
+      }
+
+      {
+         // Reversible blocks are not kept, the state is rewound to the last irreversible block as well
+         account_history_store store( file );
+         BOOST_REQUIRE_EQUAL( store.last_written_block(), 2u );
+         BOOST_REQUIRE_EQUAL( store.get_history_before( "bob", -1, 10 ).size(), 2u );
+
+         store.truncate( 1 );
+         BOOST_REQUIRE_EQUAL( store.last_written_block(), 1u );
+         BOOST_REQUIRE_EQUAL( store.get_history_before( "bob", -1, 10 ).size(), 1u );
+         BOOST_REQUIRE( store.get_ops_in_block( 2 ).empty() );
+         BOOST_REQUIRE( !store.find_transaction( trx_2 ).has_value() );
+      }
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( sqlite_storage, sqlite_history_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob) )
+      generate_block();
+
+      auto& plugin = appbase::app().get_plugin< account_history_plugin >();
+      auto store = plugin.store();
+      BOOST_REQUIRE( store );
+
+      auto symbol = sophiatx_config::get< asset_symbol_type >( "SOPHIATX_SYMBOL" );
+      auto last_block = [&]( const std::string& account ) -> uint32_t
+      {
+         auto history = store->get_history_before( AN( account ), -1, 1 );
+         return history.empty() ? 0 : history.rbegin()->second.block;
+      };
+
+      BOOST_TEST_MESSAGE( "--- Operations of applied blocks are added to the store" );
+      transfer( SOPHIATX_INIT_MINER_NAME, AN("alice"), asset( 1000, symbol ) );
+      generate_block();
+      uint32_t block = db->head_block_num();
+      BOOST_REQUIRE( db->last_non_undoable_block_num() < block );
+      BOOST_REQUIRE_EQUAL( last_block( "alice" ), block );
+      BOOST_REQUIRE( !store->get_ops_in_block( block ).empty() );
+
+      BOOST_TEST_MESSAGE( "--- A fork replaces the history of the block it switched" );
+      db->pop_block();
+      transfer( SOPHIATX_INIT_MINER_NAME, AN("bob"), asset( 1000, symbol ) );
+      generate_block();
+      BOOST_REQUIRE_EQUAL( db->head_block_num(), block );
+      BOOST_REQUIRE( last_block( "alice" ) < block );
+      BOOST_REQUIRE_EQUAL( last_block( "bob" ), block );
+
+      BOOST_TEST_MESSAGE( "--- History written past the state is removed at startup" );
+      transfer( SOPHIATX_INIT_MINER_NAME, AN("alice"), asset( 2000, symbol ) );
+      generate_block();
+      BOOST_REQUIRE_EQUAL( last_block( "alice" ), block + 1 );
+      store->commit( db->head_block_num() );
+      BOOST_REQUIRE_EQUAL( store->last_written_block(), block + 1 );
+
+      db->pop_block();
+      db->pop_block();
+      plugin.plugin_startup();
+      BOOST_REQUIRE_EQUAL( store->last_written_block(), block - 1 );
+      BOOST_REQUIRE( last_block( "alice" ) < block );
+      BOOST_REQUIRE( last_block( "bob" ) < block );
+      BOOST_REQUIRE( store->get_ops_in_block( block ).empty() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
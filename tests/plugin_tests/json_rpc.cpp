@@ -3,6 +3,15 @@
 #include <sophiatx/chain/account_object.hpp>
 #include <sophiatx/protocol/sophiatx_operations.hpp>
 #include <sophiatx/plugins/json_rpc/json_rpc_plugin.hpp>
+#include <sophiatx/plugins/json_rpc/json_writer.hpp>
+#include <sophiatx/plugins/alexandria_api/alexandria_api.hpp>
+#include <sophiatx/plugins/alexandria_api/alexandria_api_plugin.hpp>
+#include <sophiatx/plugins/database_api/database_api.hpp>
+#include <sophiatx/plugins/account_history/account_history_plugin.hpp>
+#include <sophiatx/plugins/account_history_api/account_history_api_plugin.hpp>
+#include <sophiatx/plugins/account_history_api/account_history_api.hpp>
+
+#include <fc/rpc/binary_api.hpp>
 
 #include "../db_fixture/database_fixture.hpp"
 
@@ -310,4 +319,421 @@ BOOST_AUTO_TEST_CASE( semantics_validation )
    FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( json_writer_output )
+{
+   try
+   {
+      using sophiatx::plugins::json_rpc::json_writer;
+
+      generate_block();
+
+      auto check = []( const auto& v )
+      {
+         std::string out;
+         json_writer w( out );
+         w.write( v );
+         BOOST_REQUIRE_EQUAL( out, fc::json::to_string( fc::variant( v ) ) );
+      };
+
+      check( db->get_account( SOPHIATX_INIT_MINER_NAME ) );
+      check( *db->fetch_block_by_number( 1 ) );
+      check( db->fetch_block_by_number( 1000 ) );
+
+      std::map< uint32_t, signed_block > blocks;
+      blocks[ 1 ] = *db->fetch_block_by_number( 1 );
+      check( blocks );
+
+      std::vector< std::pair< std::string, int64_t > > values = { { "a\"b\\c\n\x01\x1f\xc3\xa9", -1 }, { "", 5000000000ll } };
+      check( values );
+      check( std::vector< char >{ 'a', 1 } );
+
+      // Results of registered methods are written by the json_writer
+      std::string request = "{\"jsonrpc\":\"2.0\", \"method\":\"database_api.get_dynamic_global_properties\", \"id\":1}";
+      make_positive_request( request );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( batch_requests )
+{
+   try
+   {
+      auto& rpc = appbase::app().get_plugin< sophiatx::plugins::json_rpc::json_rpc_plugin >();
+      rpc.set_batch_executor( []( const std::function< void() >& task ) { std::thread( task ).detach(); } );
+
+      generate_blocks( 5 );
+
+      std::string request = "[";
+      for( uint32_t i = 0; i < 40; ++i )
+      {
+         if( i )
+            request += ",";
+         request += "{\"jsonrpc\":\"2.0\", \"method\":\"block_api.get_block\", \"params\":{\"block_num\":" + std::to_string( i % 6 ) + "}, \"id\":" + std::to_string( i ) + "}";
+      }
+      request += "]";
+
+      bool is_error = false;
+      auto responses = fc::json::from_string( rpc.call( request, is_error ) ).get_array();
+      BOOST_REQUIRE( !is_error );
+      BOOST_REQUIRE_EQUAL( responses.size(), 40u );
+
+      // Responses are in the order of the requests however the requests were spread over threads
+      for( uint32_t i = 0; i < 40; ++i )
+      {
+         BOOST_REQUIRE_EQUAL( responses[ i ][ "id" ].as_int64(), i );
+         BOOST_REQUIRE( responses[ i ].get_object().contains( "result" ) );
+      }
+
+      request = "[";
+      for( uint32_t i = 0; i < 1001; ++i )
+         request += std::string( i ? "," : "" ) + "{\"jsonrpc\":\"2.0\", \"method\":\"database_api.get_dynamic_global_properties\", \"id\":1}";
+      request += "]";
+
+      auto response = fc::json::from_string( rpc.call( request, is_error ) );
+      BOOST_REQUIRE( is_error );
+      BOOST_REQUIRE_EQUAL( response[ "error" ][ "code" ].as_int64(), JSON_RPC_SERVER_ERROR );
+
+      rpc.set_batch_executor( sophiatx::plugins::json_rpc::batch_executor() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( response_cache )
+{
+   try
+   {
+      auto& rpc = appbase::app().get_plugin< sophiatx::plugins::json_rpc::json_rpc_plugin >();
+
+      generate_blocks( 5 );
+      uint32_t irreversible = db->get_dynamic_global_properties().last_irreversible_block_num;
+      BOOST_REQUIRE( irreversible > 0 );
+
+      auto get_block = [&]( const std::string& params )
+      {
+         bool is_error = false;
+         auto response = rpc.call( "{\"jsonrpc\":\"2.0\", \"method\":\"block_api.get_block\", \"params\":" + params + ", \"id\":1}", is_error );
+         BOOST_REQUIRE( !is_error );
+         return fc::json::from_string( response )[ "result" ];
+      };
+
+      auto before = rpc.get_cache_stats();
+      BOOST_REQUIRE( before.max_size > 0 );
+
+      std::string params = "{\"block_num\":" + std::to_string( irreversible ) + "}";
+      auto first = get_block( params );
+      auto after_miss = rpc.get_cache_stats();
+      BOOST_REQUIRE_EQUAL( after_miss.admitted, before.admitted + 1 );
+
+      // Repeated calls are served from the cache, also with differently ordered or formatted args
+      auto second = get_block( params );
+      auto third = get_block( "{ \"block_num\" : " + std::to_string( irreversible ) + " }" );
+      auto after_hits = rpc.get_cache_stats();
+      BOOST_REQUIRE_EQUAL( after_hits.hits, after_miss.hits + 2 );
+      BOOST_REQUIRE_EQUAL( after_hits.admitted, after_miss.admitted );
+      BOOST_REQUIRE_EQUAL( fc::json::to_string( first ), fc::json::to_string( second ) );
+      BOOST_REQUIRE_EQUAL( fc::json::to_string( first ), fc::json::to_string( third ) );
+      BOOST_REQUIRE_EQUAL( first[ "block" ][ "block_id" ].as_string(), db->fetch_block_by_number( irreversible )->id().str() );
+
+      // Blocks which do not exist yet are not cached
+      get_block( "{\"block_num\":" + std::to_string( db->head_block_num() + 10 ) + "}" );
+      BOOST_REQUIRE_EQUAL( rpc.get_cache_stats().admitted, after_hits.admitted );
+
+      bool is_error = false;
+      auto stats = fc::json::from_string( rpc.call( "{\"jsonrpc\":\"2.0\", \"method\":\"jsonrpc.get_cache_stats\", \"id\":1}", is_error ) );
+      BOOST_REQUIRE( !is_error );
+      BOOST_REQUIRE_EQUAL( stats[ "result" ][ "entries" ].as_uint64(), rpc.get_cache_stats().entries );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( response_cache_pruned_history )
+{
+   try
+   {
+      auto& rpc = appbase::app().get_plugin< sophiatx::plugins::json_rpc::json_rpc_plugin >();
+      BOOST_REQUIRE( appbase::app().get_plugin< sophiatx::plugins::account_history::account_history_plugin >().prunes_operations() );
+
+      auto call = [&]( const std::string& method, const std::string& params, bool& is_error )
+      {
+         is_error = false;
+         auto response = rpc.call( "{\"jsonrpc\":\"2.0\", \"method\":\"" + method + "\", \"params\":" + params + ", \"id\":1}", is_error );
+         return fc::json::from_string( response );
+      };
+
+      ACTORS( (alice)(bob) )
+      fund( AN("alice"), 100000000 );
+      generate_block();
+
+      auto amount = asset( 10, sophiatx_config::get< asset_symbol_type >( "SOPHIATX_SYMBOL" ) );
+      for( int i = 0; i < 40; ++i )
+         transfer( AN("alice"), AN("bob"), amount );
+      generate_block();
+      uint32_t block = db->head_block_num();
+      auto trx_id = db->fetch_block_by_number( block )->transactions.front().id();
+      generate_blocks( 5 );
+      BOOST_REQUIRE( block <= db->last_non_undoable_block_num() );
+
+      bool is_error = false;
+      std::string ops_params = "{\"block_num\":" + std::to_string( block ) + ",\"only_virtual\":false}";
+      std::string trx_params = "{\"id\":\"" + trx_id.str() + "\"}";
+      auto before = rpc.get_cache_stats();
+      auto ops = call( "account_history_api.get_ops_in_block", ops_params, is_error );
+      BOOST_REQUIRE( !is_error );
+      BOOST_REQUIRE( ops[ "result" ][ "ops" ].get_array().size() >= 40 );
+      call( "account_history_api.get_transaction", trx_params, is_error );
+      BOOST_REQUIRE( !is_error );
+
+      BOOST_TEST_MESSAGE( "--- Operations of irreversible blocks are not cached while they can be pruned" );
+      BOOST_REQUIRE_EQUAL( rpc.get_cache_stats().admitted, before.admitted );
+
+      generate_blocks( db->head_block_time() + fc::days( 31 ), true );
+      transfer( AN("alice"), AN("bob"), amount );
+      generate_block();
+      generate_blocks( 1200 - db->head_block_num() % 1200 );
+
+      BOOST_TEST_MESSAGE( "--- Calls after the trimming pass see the pruned operations" );
+      const auto& location_idx = db->get_index< operation_index, by_location >();
+      size_t remaining = 0;
+      for( auto itr = location_idx.lower_bound( block ); itr != location_idx.end() && itr->block == block; ++itr )
+         ++remaining;
+      BOOST_REQUIRE( remaining < ops[ "result" ][ "ops" ].get_array().size() );
+
+      auto pruned = call( "account_history_api.get_ops_in_block", ops_params, is_error );
+      BOOST_REQUIRE( !is_error );
+      BOOST_REQUIRE_EQUAL( pruned[ "result" ][ "ops" ].get_array().size(), remaining );
+
+      const auto& trx_idx = db->get_index< operation_index, by_transaction_id >();
+      auto trx_itr = trx_idx.lower_bound( trx_id );
+      call( "account_history_api.get_transaction", trx_params, is_error );
+      BOOST_REQUIRE_EQUAL( is_error, trx_itr == trx_idx.end() || trx_itr->trx_id != trx_id );
+      BOOST_REQUIRE_EQUAL( rpc.get_cache_stats().admitted, before.admitted );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( binary_calls )
+{
+   try
+   {
+      auto& rpc = appbase::app().get_plugin< sophiatx::plugins::json_rpc::json_rpc_plugin >();
+
+      rpc.add_binary_api_method( "test_api", "get_blocks", [&]( const std::vector< char >& args ) -> std::vector< char >
+      {
+         auto nums = fc::raw::unpack_from_vector< std::vector< uint32_t > >( args, 0 );
+         std::map< uint32_t, signed_block > blocks;
+         for( auto num : nums )
+            blocks[ num ] = *db->fetch_block_by_number( num );
+         return fc::raw::pack_to_vector( blocks );
+      });
+
+      auto call = [&]( const fc::rpc::binary_request& request )
+      {
+         auto packed = fc::raw::pack_to_vector( request );
+         auto response = rpc.call_binary( std::string( packed.data(), packed.size() ) );
+         return fc::raw::unpack_from_char_array< fc::rpc::binary_response >( response.data(), response.size(), 0 );
+      };
+
+      generate_blocks( 2 );
+
+      auto response = call( { 7, "test_api", "get_blocks", fc::raw::pack_to_vector( std::vector< uint32_t >{ 1, 2 } ) } );
+      BOOST_REQUIRE_EQUAL( response.id, 7 );
+      BOOST_REQUIRE_EQUAL( response.code, 0 );
+      auto blocks = fc::raw::unpack_from_vector< std::map< uint32_t, signed_block > >( response.result, 0 );
+      BOOST_REQUIRE_EQUAL( blocks.size(), 2 );
+      BOOST_REQUIRE( blocks[ 2 ].id() == db->fetch_block_by_number( 2 )->id() );
+
+      response = call( { 8, "test_api", "get_block", {} } );
+      BOOST_REQUIRE_EQUAL( response.id, 8 );
+      BOOST_REQUIRE_EQUAL( response.code, JSON_RPC_METHOD_NOT_FOUND );
+
+      // Only registered binary methods are served, other api methods stay JSON
+      response = call( { 9, "database_api", "get_dynamic_global_properties", {} } );
+      BOOST_REQUIRE_EQUAL( response.code, JSON_RPC_METHOD_NOT_FOUND );
+
+      response = call( { 10, "test_api", "get_blocks", { 'x' } } );
+      BOOST_REQUIRE_EQUAL( response.id, 10 );
+      BOOST_REQUIRE_EQUAL( response.code, JSON_RPC_ERROR_DURING_CALL );
+
+      auto garbage = rpc.call_binary( "x" );
+      BOOST_REQUIRE_EQUAL( fc::raw::unpack_from_char_array< fc::rpc::binary_response >( garbage.data(), garbage.size(), 0 ).code, JSON_RPC_PARSE_ERROR );
+
+      bool is_error = false;
+      auto methods = fc::json::from_string( rpc.call( "{\"jsonrpc\":\"2.0\", \"method\":\"jsonrpc.get_binary_methods\", \"id\":1}", is_error ) );
+      BOOST_REQUIRE( !is_error );
+      BOOST_REQUIRE( methods[ "result" ].as< std::vector< std::string > >() == std::vector< std::string >{ "test_api.get_blocks" } );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( method_stats )
+{
+   try
+   {
+      auto& rpc = appbase::app().get_plugin< sophiatx::plugins::json_rpc::json_rpc_plugin >();
+
+      auto find = []( const sophiatx::plugins::json_rpc::rpc_stats& stats, const std::string& method )
+      {
+         for( const auto& m : stats.methods )
+            if( m.method == method )
+               return m;
+         return sophiatx::plugins::json_rpc::api_method_stats();
+      };
+
+      auto before = find( rpc.get_stats(), "database_api.get_dynamic_global_properties" );
+
+      bool is_error = false;
+      for( int i = 0; i < 3; ++i )
+         rpc.call( "{\"jsonrpc\":\"2.0\", \"method\":\"database_api.get_dynamic_global_properties\", \"id\":1}", is_error );
+      rpc.call( "{\"jsonrpc\":\"2.0\", \"method\":\"database_api.find_accounts\", \"params\":{\"accounts\":7}, \"id\":1}", is_error );
+      rpc.call( "{\"jsonrpc\":\"2.0\", \"method\":\"no_api.no_method\", \"id\":1}", is_error );
+
+      auto stats = rpc.get_stats();
+      auto after = find( stats, "database_api.get_dynamic_global_properties" );
+      BOOST_REQUIRE_EQUAL( after.calls, before.calls + 3 );
+      BOOST_REQUIRE_EQUAL( after.errors, before.errors );
+      BOOST_REQUIRE_EQUAL( after.in_flight, 0 );
+      BOOST_REQUIRE_EQUAL( after.lock_wait.count, after.calls );
+      BOOST_REQUIRE( after.lock_wait.total_us + after.execution.total_us <= after.latency.total_us );
+
+      BOOST_REQUIRE( find( stats, "database_api.find_accounts" ).errors > 0 );
+      // Requested names which are not registered do not get their own counters
+      BOOST_REQUIRE( find( stats, "unknown" ).calls > 0 );
+      BOOST_REQUIRE_EQUAL( find( stats, "no_api.no_method" ).calls, 0 );
+
+      auto reply = fc::json::from_string( rpc.call( "{\"jsonrpc\":\"2.0\", \"method\":\"jsonrpc.get_stats\", \"id\":1}", is_error ) );
+      BOOST_REQUIRE( !is_error );
+      BOOST_REQUIRE( reply[ "result" ][ "methods" ].get_array().size() >= stats.methods.size() );
+
+      std::string metrics;
+      rpc.write_metrics( metrics );
+      BOOST_REQUIRE( metrics.find( "sophiatx_rpc_calls_total{method=\"database_api.get_dynamic_global_properties\"}" ) != std::string::npos );
+      BOOST_REQUIRE( metrics.find( "sophiatx_rpc_duration_seconds_bucket{method=\"database_api.get_dynamic_global_properties\",le=\"+Inf\"}" ) != std::string::npos );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( alexandria_composite_calls )
+{
+   try
+   {
+      auto& rpc = appbase::app().get_plugin< sophiatx::plugins::json_rpc::json_rpc_plugin >();
+      auto& database_api = *appbase::app().get_plugin< sophiatx::plugins::database_api::database_api_plugin >().api;
+      auto& account_history_api = *appbase::app().get_plugin< sophiatx::plugins::account_history::account_history_api_plugin >().api;
+
+      generate_blocks( 2 );
+
+      auto call = [&]( const std::string& method, const std::string& params )
+      {
+         bool is_error = false;
+         auto response = rpc.call( "{\"jsonrpc\":\"2.0\", \"method\":\"" + method + "\", \"params\":" + params + ", \"id\":1}", is_error );
+         BOOST_REQUIRE( !is_error );
+         return fc::json::from_string( response )[ "result" ];
+      };
+
+      // How alexandria_api.info was composed from database_api calls before it read a chain_snapshot
+      auto legacy_info = [&]()
+      {
+         return db->with_read_lock( [&]()
+         {
+            auto dynamic_props = database_api.get_dynamic_global_properties( {} );
+            fc::mutable_variant_object info_data( fc::variant( dynamic_props ).get_object() );
+            info_data[ "witness_majority_version" ] = std::string( database_api.get_witness_schedule( {} ).majority_version );
+            info_data[ "hardfork_version" ] = std::string( database_api.get_hardfork_properties( {} ).current_hardfork_version );
+            info_data[ "head_block_age" ] = fc::get_approximate_relative_time_string( dynamic_props.time, fc::time_point_sec( fc::time_point::now() ), " old" );
+            info_data[ "participation" ] = ( 100 * dynamic_props.recent_slots_filled.popcount() ) / 128.0;
+            info_data[ "median_sbd1_price" ] = database_api.get_current_price_feed( { SBD1_SYMBOL } );
+            info_data[ "median_sbd2_price" ] = database_api.get_current_price_feed( { SBD2_SYMBOL } );
+            info_data[ "median_sbd3_price" ] = database_api.get_current_price_feed( { SBD3_SYMBOL } );
+            info_data[ "median_sbd4_price" ] = database_api.get_current_price_feed( { SBD4_SYMBOL } );
+            info_data[ "median_sbd5_price" ] = database_api.get_current_price_feed( { SBD5_SYMBOL } );
+            info_data[ "account_creation_fee" ] = database_api.get_witness_schedule( {} ).median_props.account_creation_fee;
+            return fc::variant( info_data );
+         });
+      };
+
+      BOOST_TEST_MESSAGE( "Verify that info reads the same values as the database_api calls" );
+      auto info = call( "alexandria_api.info", "{}" )[ "info" ];
+      auto legacy = legacy_info();
+      BOOST_REQUIRE_EQUAL( info.get_object().size(), legacy.get_object().size() );
+      for( const auto& field : legacy.get_object() )
+         if( field.key() != "head_block_age" )
+            BOOST_REQUIRE_EQUAL( fc::json::to_string( info[ field.key().c_str() ] ), fc::json::to_string( field.value() ) );
+
+      auto account = call( "alexandria_api.get_account", "{\"account_name\":\"" SOPHIATX_INIT_MINER_NAME "\"}" );
+      BOOST_REQUIRE_EQUAL( account[ "account" ].get_array().size(), 1 );
+
+      BOOST_TEST_MESSAGE( "Verify that get_account_history converts the entries of account_history_api" );
+      push_signed_transfers( 5 );
+      generate_block();
+
+      auto latest = account_history_api.get_account_history( { "initminer1", -1, 1, true } ).history;
+      BOOST_REQUIRE_EQUAL( latest.size(), 1u );
+      uint32_t last = latest.rbegin()->first;
+
+      auto expected = account_history_api.get_account_history( { "initminer1", last, 3, true } ).history;
+      auto history = call( "alexandria_api.get_account_history", "{\"account\":\"initminer1\",\"start\":" + std::to_string( last ) + ",\"limit\":3}" )[ "account_history" ];
+      BOOST_REQUIRE_EQUAL( expected.size(), 3u );
+      BOOST_REQUIRE_EQUAL( history.get_array().size(), expected.size() );
+
+      for( const auto& entry : history.get_array() )
+      {
+         uint32_t sequence = entry.get_array()[ 0 ].as< uint32_t >();
+         const auto& op = entry.get_array()[ 1 ];
+         BOOST_REQUIRE( expected.count( sequence ) );
+         BOOST_REQUIRE_EQUAL( op[ "trx_id" ].as_string(), expected[ sequence ].trx_id.str() );
+         BOOST_REQUIRE_EQUAL( op[ "block" ].as< uint32_t >(), expected[ sequence ].block );
+      }
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( block_stats )
+{
+   try
+   {
+      auto& rpc = appbase::app().get_plugin< sophiatx::plugins::json_rpc::json_rpc_plugin >();
+
+      ACTORS( (alice) )
+      generate_blocks( 5 );
+
+      auto call = [&]( const std::string& method, const std::string& params )
+      {
+         bool is_error = false;
+         auto response = rpc.call( "{\"jsonrpc\":\"2.0\", \"method\":\"block_api." + method + "\", \"params\":" + params + ", \"id\":1}", is_error );
+         BOOST_REQUIRE( !is_error );
+         return fc::json::from_string( response )[ "result" ];
+      };
+
+      uint32_t head = db->head_block_num();
+      uint64_t size = 0;
+      uint64_t transactions = 0;
+      uint64_t total_size = 0;
+      for( uint32_t i = 1; i <= head; ++i )
+      {
+         auto block = *db->fetch_block_by_number( i );
+         total_size += fc::raw::pack_size( block );
+         if( i + 6 > head )
+         {
+            size += fc::raw::pack_size( block );
+            transactions += block.transactions.size();
+         }
+      }
+
+      auto stats = call( "get_block_stats", "{\"blocks\":6}" );
+      BOOST_REQUIRE_EQUAL( stats[ "blocks" ].as_uint64(), 6u );
+      BOOST_REQUIRE_EQUAL( stats[ "first_block" ].as_uint64(), head - 5 );
+      BOOST_REQUIRE_EQUAL( stats[ "last_block" ].as_uint64(), head );
+      BOOST_REQUIRE_EQUAL( stats[ "size" ].as_uint64(), size );
+      BOOST_REQUIRE_EQUAL( stats[ "transactions" ].as_uint64(), transactions );
+      BOOST_REQUIRE( stats[ "operation_counts" ][ "account_create_operation" ].as_uint64() >= 1 );
+
+      BOOST_REQUIRE_EQUAL( call( "get_average_block_size", "{}" ).as_uint64(), total_size / head );
+
+      bool is_error = false;
+      rpc.call( "{\"jsonrpc\":\"2.0\", \"method\":\"block_api.get_block_stats\", \"params\":{\"blocks\":1000000}, \"id\":1}", is_error );
+      BOOST_REQUIRE( is_error );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
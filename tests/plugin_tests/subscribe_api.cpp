@@ -0,0 +1,288 @@
+#include <boost/test/unit_test.hpp>
+
+#include <sophiatx/protocol/sophiatx_operations.hpp>
+#include <sophiatx/plugins/subscribe_api/subscribe_api.hpp>
+#include <sophiatx/plugins/custom_api/custom_api.hpp>
+
+#include <boost/scope_exit.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include "../db_fixture/database_fixture.hpp"
+
+using namespace sophiatx::chain;
+using namespace sophiatx::protocol;
+using sophiatx::plugins::subscribe::subscribe_api;
+using sophiatx::plugins::subscribe::custom_object_subscription_args;
+
+namespace {
+
+/// Collects the documents sent to a subscription, in the order they were sent
+struct received_documents
+{
+   void add( fc::variant& v )
+   {
+      std::lock_guard< std::mutex > guard( mutex );
+      sophiatx::plugins::custom::received_object doc;
+      fc::from_variant( v, doc );
+      data.push_back( doc.data );
+      sequences.push_back( doc.app_message_sequence );
+      cv.notify_all();
+   }
+
+   /// Waits until count documents arrived, returns the documents received so far
+   std::vector< std::string > wait_for( size_t count )
+   {
+      std::unique_lock< std::mutex > lock( mutex );
+      cv.wait_for( lock, std::chrono::seconds( 5 ), [&]() { return data.size() >= count; } );
+      return data;
+   }
+
+   std::mutex                 mutex;
+   std::condition_variable    cv;
+   std::vector< std::string > data;
+   std::vector< uint64_t >    sequences;
+};
+
+std::string document( uint32_t n )
+{
+   return "{\"n\":" + std::to_string( n ) + "}";
+}
+
+std::vector< std::string > documents( uint32_t first, uint32_t last )
+{
+   std::vector< std::string > result;
+   for( uint32_t n = first; n <= last; ++n )
+      result.push_back( document( n ) );
+   return result;
+}
+
+}
+
+BOOST_FIXTURE_TEST_SUITE( subscribe_api_tests, json_rpc_database_fixture )
+
+BOOST_AUTO_TEST_CASE( ordered_delivery )
+{
+   try
+   {
+      ACTORS( (alice)(bob) )
+      fund( AN("alice"), 10000000 );
+
+      subscribe_api api( 1000 );
+      api.api_startup();
+      BOOST_SCOPE_EXIT( &api ) { api.api_shutdown(); } BOOST_SCOPE_EXIT_END
+
+      auto symbol = sophiatx_config::get< asset_symbol_type >( "SOPHIATX_SYMBOL" );
+      uint32_t sent = 0;
+      auto push_documents = [&]( uint32_t count )
+      {
+         signed_transaction tx;
+         tx.set_expiration( db->head_block_time() + SOPHIATX_MAX_TIME_UNTIL_EXPIRATION );
+         for( uint32_t i = 0; i < count; ++i )
+         {
+            custom_json_operation op;
+            op.sender = AN("alice");
+            op.recipients = { AN("bob") };
+            op.app_id = 1;
+            op.json = document( ++sent );
+            op.fee = op.get_required_fee( symbol );
+            tx.operations.push_back( op );
+         }
+         sign( tx, alice_private_key );
+         db->with_write_lock( [&]() { db->push_transaction( tx, 0 ); } );
+      };
+
+      BOOST_TEST_MESSAGE( "--- Documents stored before the subscription are sent first, then new ones in order" );
+      push_documents( 3 );
+
+      received_documents by_sender;
+      received_documents by_recipient;
+      api.custom_object_subscription( { 1, 1, "alice", "by_sender", 1 }, [&]( fc::variant& v, uint64_t ) { by_sender.add( v ); } );
+      api.custom_object_subscription( { 2, 1, "bob", "by_recipient", 2 }, [&]( fc::variant& v, uint64_t ) { by_recipient.add( v ); } );
+      BOOST_REQUIRE( by_sender.wait_for( 3 ) == documents( 1, 3 ) );
+
+      for( uint32_t i = 0; i < 5; ++i )
+         push_documents( 2 );
+
+      BOOST_REQUIRE( by_sender.wait_for( 13 ) == documents( 1, 13 ) );
+      BOOST_REQUIRE( by_recipient.wait_for( 12 ) == documents( 2, 13 ) );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( by_app )
+{
+   try
+   {
+      ACTORS( (alice)(bob) )
+      fund( AN("alice"), 10000000 );
+      fund( AN("bob"), 10000000 );
+
+      subscribe_api api( 1000 );
+      api.api_startup();
+      BOOST_SCOPE_EXIT( &api ) { api.api_shutdown(); } BOOST_SCOPE_EXIT_END
+
+      auto symbol = sophiatx_config::get< asset_symbol_type >( "SOPHIATX_SYMBOL" );
+      uint32_t sent = 0;
+      auto push_document = [&]( const std::string& sender, const fc::ecc::private_key& key, uint64_t app_id )
+      {
+         custom_json_operation op;
+         op.sender = AN( sender );
+         op.app_id = app_id;
+         op.json = document( ++sent );
+         op.fee = op.get_required_fee( symbol );
+
+         signed_transaction tx;
+         tx.set_expiration( db->head_block_time() + SOPHIATX_MAX_TIME_UNTIL_EXPIRATION );
+         tx.operations.push_back( op );
+         sign( tx, key );
+         db->with_write_lock( [&]() { db->push_transaction( tx, 0 ); } );
+      };
+
+      BOOST_TEST_MESSAGE( "--- Documents of the app from any sender, starting at the app message sequence" );
+      push_document( "alice", alice_private_key, 1 );
+      push_document( "alice", alice_private_key, 1 );
+      push_document( "bob", bob_private_key, 2 );
+      push_document( "bob", bob_private_key, 1 );
+
+      received_documents received;
+      api.custom_object_subscription( { 1, 1, "", "by_app", 2 }, [&]( fc::variant& v, uint64_t ) { received.add( v ); } );
+      BOOST_REQUIRE( received.wait_for( 2 ) == std::vector< std::string >( { document( 2 ), document( 4 ) } ) );
+
+      push_document( "bob", bob_private_key, 1 );
+      push_document( "alice", alice_private_key, 2 );
+      push_document( "alice", alice_private_key, 1 );
+      BOOST_REQUIRE( received.wait_for( 4 ) == std::vector< std::string >( { document( 2 ), document( 4 ), document( 5 ), document( 7 ) } ) );
+
+      BOOST_TEST_MESSAGE( "--- Documents carry their app message sequence, light nodes check it for gaps" );
+      std::lock_guard< std::mutex > guard( received.mutex );
+      BOOST_REQUIRE( received.sequences == std::vector< uint64_t >( { 2, 3, 4, 5 } ) );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( queue_overflow_catch_up )
+{
+   try
+   {
+      ACTORS( (alice) )
+      fund( AN("alice"), 10000000 );
+
+      subscribe_api api( 2 );
+      api.api_startup();
+      BOOST_SCOPE_EXIT( &api ) { api.api_shutdown(); } BOOST_SCOPE_EXIT_END
+
+      auto symbol = sophiatx_config::get< asset_symbol_type >( "SOPHIATX_SYMBOL" );
+      uint32_t sent = 0;
+      auto push_document = [&]()
+      {
+         custom_json_operation op;
+         op.sender = AN("alice");
+         op.app_id = 1;
+         op.json = document( ++sent );
+         op.fee = op.get_required_fee( symbol );
+
+         signed_transaction tx;
+         tx.set_expiration( db->head_block_time() + SOPHIATX_MAX_TIME_UNTIL_EXPIRATION );
+         tx.operations.push_back( op );
+         sign( tx, alice_private_key );
+         db->with_write_lock( [&]() { db->push_transaction( tx, 0 ); } );
+      };
+
+      // The first notification blocks the delivery thread until released, as a slow connection would
+      std::mutex mutex;
+      std::condition_variable cv;
+      bool blocked = false;
+      bool released = false;
+      received_documents received;
+      api.custom_object_subscription( { 1, 1, "alice", "by_sender", 1 }, [&]( fc::variant& v, uint64_t )
+      {
+         {
+            std::unique_lock< std::mutex > lock( mutex );
+            if( !blocked )
+            {
+               blocked = true;
+               cv.notify_all();
+               cv.wait_for( lock, std::chrono::seconds( 5 ), [&]() { return released; } );
+            }
+         }
+         received.add( v );
+      });
+
+      push_document();
+      {
+         std::unique_lock< std::mutex > lock( mutex );
+         BOOST_REQUIRE( cv.wait_for( lock, std::chrono::seconds( 5 ), [&]() { return blocked; } ) );
+      }
+
+      BOOST_TEST_MESSAGE( "--- Documents which do not fit into the queue are read from the database once it was sent" );
+      for( uint32_t i = 0; i < 20; ++i )
+         push_document();
+
+      {
+         std::lock_guard< std::mutex > guard( mutex );
+         released = true;
+         cv.notify_all();
+      }
+
+      BOOST_REQUIRE( received.wait_for( 21 ) == documents( 1, 21 ) );
+
+      push_document();
+      BOOST_REQUIRE( received.wait_for( 22 ) == documents( 1, 22 ) );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( remove_after_failed_send )
+{
+   try
+   {
+      ACTORS( (alice) )
+      fund( AN("alice"), 10000000 );
+
+      subscribe_api api( 1000 );
+      api.api_startup();
+      BOOST_SCOPE_EXIT( &api ) { api.api_shutdown(); } BOOST_SCOPE_EXIT_END
+
+      auto symbol = sophiatx_config::get< asset_symbol_type >( "SOPHIATX_SYMBOL" );
+      uint32_t sent = 0;
+      auto push_document = [&]()
+      {
+         custom_json_operation op;
+         op.sender = AN("alice");
+         op.app_id = 1;
+         op.json = document( ++sent );
+         op.fee = op.get_required_fee( symbol );
+
+         signed_transaction tx;
+         tx.set_expiration( db->head_block_time() + SOPHIATX_MAX_TIME_UNTIL_EXPIRATION );
+         tx.operations.push_back( op );
+         sign( tx, alice_private_key );
+         db->with_write_lock( [&]() { db->push_transaction( tx, 0 ); } );
+      };
+
+      received_documents closed;
+      received_documents open;
+      api.custom_object_subscription( { 1, 1, "alice", "by_sender", 1 }, [&]( fc::variant& v, uint64_t )
+      {
+         closed.add( v );
+         FC_THROW_EXCEPTION( fc::send_error_exception, "connection closed" );
+      });
+      api.custom_object_subscription( { 2, 1, "alice", "by_sender", 1 }, [&]( fc::variant& v, uint64_t ) { open.add( v ); } );
+
+      push_document();
+      BOOST_REQUIRE( open.wait_for( 1 ).size() == 1 );
+      BOOST_REQUIRE( closed.wait_for( 1 ).size() == 1 );
+
+      BOOST_TEST_MESSAGE( "--- The subscription is removed with the failed send and gets no further documents" );
+      push_document();
+      push_document();
+      BOOST_REQUIRE( open.wait_for( 3 ) == documents( 1, 3 ) );
+      BOOST_REQUIRE( closed.wait_for( 1 ) == documents( 1, 1 ) );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
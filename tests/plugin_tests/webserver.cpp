@@ -0,0 +1,103 @@
+#include <boost/test/unit_test.hpp>
+
+#include <sophiatx/plugins/webserver/request_scheduler.hpp>
+
+using namespace sophiatx::plugins::webserver;
+
+BOOST_AUTO_TEST_SUITE( webserver )
+
+BOOST_AUTO_TEST_CASE( scan_request )
+{
+   std::string method;
+   std::string id;
+
+   BOOST_TEST_MESSAGE( "--- Method and id of a request" );
+   BOOST_REQUIRE( request_scheduler::scan_request( "{\"jsonrpc\":\"2.0\",\"method\":\"network_broadcast_api.broadcast_transaction\",\"params\":{\"trx\":{\"id\":[1,\"}\"]}},\"id\":7}", method, id ) );
+   BOOST_REQUIRE_EQUAL( method, "network_broadcast_api.broadcast_transaction" );
+   BOOST_REQUIRE_EQUAL( id, "7" );
+
+   BOOST_REQUIRE( request_scheduler::scan_request( " { \"id\" : \"a,b\" , \"method\" : \"database_api.get_config\" } ", method, id ) );
+   BOOST_REQUIRE_EQUAL( method, "database_api.get_config" );
+   BOOST_REQUIRE_EQUAL( id, "\"a,b\"" );
+
+   BOOST_TEST_MESSAGE( "--- call takes the api and the method from its parameters" );
+   BOOST_REQUIRE( request_scheduler::scan_request( "{\"method\":\"call\",\"params\":[\"alexandria_api\",\"broadcast_transaction\",{}],\"id\":-1}", method, id ) );
+   BOOST_REQUIRE_EQUAL( method, "alexandria_api.broadcast_transaction" );
+   BOOST_REQUIRE_EQUAL( id, "-1" );
+
+   BOOST_TEST_MESSAGE( "--- Requests without an id or with an id which is not a string, number or null answer with a null id" );
+   BOOST_REQUIRE( request_scheduler::scan_request( "{\"method\":\"database_api.get_config\"}", method, id ) );
+   BOOST_REQUIRE_EQUAL( id, "null" );
+   BOOST_REQUIRE( request_scheduler::scan_request( "{\"method\":\"database_api.get_config\",\"id\":{\"a\":1}}", method, id ) );
+   BOOST_REQUIRE_EQUAL( id, "null" );
+   BOOST_REQUIRE( request_scheduler::scan_request( "{\"method\":\"database_api.get_config\",\"id\":a\"b}", method, id ) );
+   BOOST_REQUIRE_EQUAL( id, "null" );
+
+   BOOST_TEST_MESSAGE( "--- Batches and bodies which are not a JSON object are not scanned" );
+   id = "1";
+   BOOST_REQUIRE( !request_scheduler::scan_request( "[{\"method\":\"database_api.get_config\",\"id\":1}]", method, id ) );
+   BOOST_REQUIRE_EQUAL( id, "null" );
+   BOOST_REQUIRE( !request_scheduler::scan_request( "", method, id ) );
+   BOOST_REQUIRE_EQUAL( id, "null" );
+   BOOST_REQUIRE( !request_scheduler::scan_request( std::string( "\x01\x02\x03", 3 ), method, id ) );
+   BOOST_REQUIRE_EQUAL( id, "null" );
+   BOOST_REQUIRE( !request_scheduler::scan_request( "{\"method\":\"database_api.get_config\",\"id\":1", method, id ) );
+   BOOST_REQUIRE( !request_scheduler::scan_request( "{\"method\" \"database_api.get_config\"}", method, id ) );
+}
+
+BOOST_AUTO_TEST_CASE( lanes )
+{
+   std::vector< std::function< void() > > runners;
+   request_scheduler scheduler( [&]( const std::function< void() >& task ) { runners.push_back( task ); }, 2, 3, 2 );
+   scheduler.set_priority_methods( { "network_broadcast_api.broadcast_transaction", "network_broadcast_api.broadcast_block" } );
+
+   BOOST_TEST_MESSAGE( "--- Broadcasts use the priority lane, everything else the normal lane" );
+   BOOST_REQUIRE( scheduler.classify( "network_broadcast_api.broadcast_transaction" ) == priority_lane );
+   BOOST_REQUIRE( scheduler.classify( "network_broadcast_api.broadcast_block" ) == priority_lane );
+   BOOST_REQUIRE( scheduler.classify( "database_api.get_config" ) == normal_lane );
+   BOOST_REQUIRE( scheduler.classify( "" ) == normal_lane );
+
+   BOOST_TEST_MESSAGE( "--- Runners take priority requests first" );
+   std::vector< std::string > order;
+   int a, b, c;
+   BOOST_REQUIRE( scheduler.submit( normal_lane, &a, [&]() { order.push_back( "read 1" ); } ) == request_scheduler::accepted );
+   BOOST_REQUIRE( scheduler.submit( normal_lane, &b, [&]() { order.push_back( "read 2" ); } ) == request_scheduler::accepted );
+   BOOST_REQUIRE( scheduler.submit( priority_lane, &c, [&]() { order.push_back( "broadcast" ); } ) == request_scheduler::accepted );
+   BOOST_REQUIRE_EQUAL( runners.size(), 3u );
+
+   auto stats = scheduler.get_stats();
+   BOOST_REQUIRE_EQUAL( stats.priority.queued, 1u );
+   BOOST_REQUIRE_EQUAL( stats.normal.queued, 2u );
+
+   for( auto& r : runners )
+      r();
+   runners.clear();
+   BOOST_REQUIRE( order == std::vector< std::string >( { "broadcast", "read 1", "read 2" } ) );
+
+   stats = scheduler.get_stats();
+   BOOST_REQUIRE_EQUAL( stats.priority.completed, 1u );
+   BOOST_REQUIRE_EQUAL( stats.normal.completed, 2u );
+
+   BOOST_TEST_MESSAGE( "--- A full lane rejects requests, the other lane still accepts them" );
+   BOOST_REQUIRE( scheduler.submit( priority_lane, &a, [](){} ) == request_scheduler::accepted );
+   BOOST_REQUIRE( scheduler.submit( priority_lane, &b, [](){} ) == request_scheduler::accepted );
+   BOOST_REQUIRE( scheduler.submit( priority_lane, &c, [](){} ) == request_scheduler::queue_full );
+   BOOST_REQUIRE( scheduler.submit( normal_lane, &c, [](){} ) == request_scheduler::accepted );
+   BOOST_REQUIRE_EQUAL( scheduler.get_stats().priority.rejected, 1u );
+
+   BOOST_TEST_MESSAGE( "--- A connection is limited to its requests in flight, tasks without a connection are not" );
+   BOOST_REQUIRE( scheduler.submit( normal_lane, &a, [](){} ) == request_scheduler::accepted );
+   BOOST_REQUIRE( scheduler.submit( normal_lane, &a, [](){} ) == request_scheduler::connection_limit );
+   BOOST_REQUIRE( scheduler.submit( normal_lane, nullptr, [](){} ) == request_scheduler::accepted );
+   BOOST_REQUIRE_EQUAL( scheduler.get_stats().rejected_connection_limit, 1u );
+
+   for( auto& r : runners )
+      r();
+   runners.clear();
+
+   BOOST_REQUIRE( scheduler.submit( normal_lane, &a, [](){} ) == request_scheduler::accepted );
+   stats = scheduler.get_stats();
+   BOOST_REQUIRE_EQUAL( stats.priority.queued + stats.normal.queued, 1u );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -27,6 +27,7 @@
 #include <sophiatx/protocol/exceptions.hpp>
 
 #include <sophiatx/chain/database/database.hpp>
+#include <sophiatx/chain/compressed_block_log.hpp>
 #include <sophiatx/chain/sophiatx_objects.hpp>
 #include <sophiatx/chain/history_object.hpp>
 
@@ -37,6 +38,11 @@
 
 #include <fc/crypto/digest.hpp>
 
+#include <atomic>
+#include <fstream>
+#include <numeric>
+#include <thread>
+
 #include "../db_fixture/database_fixture.hpp"
 
 using namespace sophiatx;
@@ -126,6 +132,66 @@ BOOST_AUTO_TEST_CASE( generate_empty_blocks )
    }
 }
 
+BOOST_AUTO_TEST_CASE( pipelined_reindex )
+{
+   try {
+      fc::temp_directory data_dir( sophiatx::utilities::temp_directory_path() );
+      fc::ecc::private_key init_account_priv_key = *(sophiatx::utilities::wif_to_key("5JPwY3bwFgfsGtxMeLkLqXzUrQDMAsqSyAZDnMBkg7PDDRhQgaV"));
+      genesis_state_type gen;
+      gen.genesis_time = fc::time_point_sec(1530644400);
+
+      block_id_type head_id;
+      uint32_t head_num = 0;
+      {
+         auto db = std::make_shared<database>();
+         db->_log_hardforks = false;
+         open_test_database( db, data_dir.path() );
+         for( uint32_t i = 0; i < 450; ++i )
+            db->generate_block(db->get_slot_time(1), db->get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+         head_num = db->get_dynamic_global_properties().last_irreversible_block_num;
+         head_id = db->get_block_id_for_num( head_num );
+         db->close();
+      }
+
+      for( uint32_t decode_threads : { 0, 1, 3 } )
+      {
+         BOOST_TEST_MESSAGE( "Reindexing with " << decode_threads << " decode threads" );
+         auto db = std::make_shared<database>();
+         db->_log_hardforks = false;
+         database_interface::open_args args;
+         args.shared_mem_dir = data_dir.path();
+         args.shared_file_size = TEST_SHARED_MEM_SIZE;
+         args.replay_decode_threads = decode_threads;
+         args.replay_queue_size = 2;
+
+         BOOST_CHECK_EQUAL( db->reindex( args, gen ), head_num );
+         BOOST_CHECK_EQUAL( db->head_block_num(), head_num );
+         BOOST_CHECK( db->head_block_id() == head_id );
+
+         const auto& stages = db->get_replay_stage_stats();
+         BOOST_REQUIRE_EQUAL( stages.size(), decode_threads ? 3u : 1u );
+         for( const auto& stage : stages )
+            BOOST_CHECK_EQUAL( stage.blocks, head_num );
+         db->close();
+      }
+
+      BOOST_TEST_MESSAGE( "Stopping replay in the middle of the pipeline" );
+      auto db = std::make_shared<database>();
+      db->_log_hardforks = false;
+      database_interface::open_args args;
+      args.shared_mem_dir = data_dir.path();
+      args.shared_file_size = TEST_SHARED_MEM_SIZE;
+      args.replay_decode_threads = 2;
+      args.stop_replay_at = 150;
+      BOOST_CHECK_EQUAL( db->reindex( args, gen ), 150u );
+      BOOST_CHECK_EQUAL( db->head_block_num(), 150u );
+      db->close();
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( undo_block )
 {
    try {
@@ -730,6 +796,488 @@ BOOST_FIXTURE_TEST_CASE( skip_block, clean_database_fixture )
    FC_LOG_AND_RETHROW();
 }
 
+BOOST_FIXTURE_TEST_CASE( parallel_signature_recovery, clean_database_fixture )
+{
+   try
+   {
+      const uint32_t trx_count = 200;
+      generate_block();
+
+      BOOST_TEST_MESSAGE( "Filling pending state with signed transactions" );
+      push_signed_transfers( trx_count );
+
+      auto b = db->generate_block( db->get_slot_time( 1 ), db->get_scheduled_witness( 1 ), init_account_priv_key, database::skip_nothing );
+      BOOST_REQUIRE_EQUAL( b.transactions.size(), trx_count );
+
+      auto push_timed = [&]( uint32_t threads ) -> int64_t
+      {
+         db->pop_block();
+         db->clear_pending();
+         db->set_signature_recovery_threads( threads );
+
+         auto start = fc::time_point::now();
+         db->push_block( b, database::skip_nothing );
+         auto elapsed = ( fc::time_point::now() - start ).count();
+
+         BOOST_REQUIRE( db->head_block_id() == b.id() );
+         return elapsed;
+      };
+
+      BOOST_TEST_MESSAGE( "Comparing block apply latency with serial and parallel signature recovery" );
+      int64_t serial = push_timed( 0 );
+      int64_t parallel = push_timed( 4 );
+      BOOST_TEST_MESSAGE( "Block with " << trx_count << " transactions applied in " << serial << " us serially, "
+                          << parallel << " us with 4 recovery threads" );
+
+      BOOST_TEST_MESSAGE( "Verify that a bad signature is still rejected with the recovery pool enabled" );
+      db->pop_block();
+      db->clear_pending();
+      auto bad = b;
+      bad.transactions.front().signatures.front() = generate_private_key( "bogus" ).sign_compact(
+         bad.transactions.front().sig_digest( db->get_chain_id() ), fc::ecc::bip_0062 );
+      bad.transaction_merkle_root = bad.calculate_merkle_root();
+      bad.sign( init_account_priv_key, fc::ecc::bip_0062 );
+      SOPHIATX_REQUIRE_THROW( db->push_block( bad, database::skip_nothing ), fc::exception );
+
+      db->set_signature_recovery_threads( 0 );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( signature_key_cache_test, clean_database_fixture )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "Testing cache lookup, eviction and expiration" );
+      {
+         signature_key_cache cache( 2 );
+         auto key = generate_private_key( "cache" );
+         auto make_sig = [&]( const std::string& s ) { return key.sign_compact( fc::sha256::hash( s ), fc::ecc::bip_0062 ); };
+         fc::time_point_sec now( SOPHIATX_GENESIS_TIME );
+
+         BOOST_REQUIRE( !cache.get( fc::sha256::hash( "a" ), make_sig( "a" ), fc::ecc::bip_0062 ).has_value() );
+         cache.put( fc::sha256::hash( "a" ), make_sig( "a" ), fc::ecc::bip_0062, key.get_public_key(), now + 10 );
+         BOOST_REQUIRE( *cache.get( fc::sha256::hash( "a" ), make_sig( "a" ), fc::ecc::bip_0062 ) == public_key_type( key.get_public_key() ) );
+         BOOST_REQUIRE( !cache.get( fc::sha256::hash( "a" ), make_sig( "a" ), fc::ecc::fc_canonical ).has_value() );
+
+         cache.put( fc::sha256::hash( "b" ), make_sig( "b" ), fc::ecc::bip_0062, key.get_public_key(), now + 20 );
+         cache.put( fc::sha256::hash( "c" ), make_sig( "c" ), fc::ecc::bip_0062, key.get_public_key(), now + 30 );
+         BOOST_REQUIRE( !cache.get( fc::sha256::hash( "a" ), make_sig( "a" ), fc::ecc::bip_0062 ).has_value() );
+         BOOST_REQUIRE( cache.get( fc::sha256::hash( "b" ), make_sig( "b" ), fc::ecc::bip_0062 ).has_value() );
+
+         cache.remove_expired( now + 25 );
+         BOOST_REQUIRE( !cache.get( fc::sha256::hash( "b" ), make_sig( "b" ), fc::ecc::bip_0062 ).has_value() );
+         BOOST_REQUIRE( cache.get( fc::sha256::hash( "c" ), make_sig( "c" ), fc::ecc::bip_0062 ).has_value() );
+
+         auto stats = cache.get_stats();
+         BOOST_REQUIRE_EQUAL( stats.hits, 3u );
+         BOOST_REQUIRE_EQUAL( stats.misses, 4u );
+         BOOST_REQUIRE_EQUAL( stats.evicted, 1u );
+         BOOST_REQUIRE_EQUAL( stats.expired, 1u );
+         BOOST_REQUIRE_EQUAL( stats.size, 1u );
+      }
+
+      BOOST_TEST_MESSAGE( "Testing that keys recovered in the mempool are reused when the block is applied" );
+      db->set_signature_key_cache_size( 1000 );
+      generate_block();
+
+      const uint32_t trx_count = 20;
+      push_signed_transfers( trx_count );
+
+      auto after_mempool = *db->get_signature_key_cache_stats();
+      BOOST_REQUIRE_EQUAL( after_mempool.size, trx_count );
+
+      auto b = db->generate_block( db->get_slot_time( 1 ), db->get_scheduled_witness( 1 ), init_account_priv_key, database::skip_nothing );
+      BOOST_REQUIRE_EQUAL( b.transactions.size(), trx_count );
+      db->pop_block();
+      db->clear_pending();
+      db->push_block( b, database::skip_nothing );
+      BOOST_REQUIRE( db->head_block_id() == b.id() );
+
+      auto after_block = *db->get_signature_key_cache_stats();
+      BOOST_REQUIRE_EQUAL( after_block.misses, after_mempool.misses );
+      BOOST_REQUIRE( after_block.hits >= after_mempool.hits + trx_count );
+
+      db->set_signature_key_cache_size( 0 );
+      BOOST_REQUIRE( !db->get_signature_key_cache_stats().has_value() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( operation_profiler_test, clean_database_fixture )
+{
+   try
+   {
+      auto& profiler = db->get_operation_profiler();
+      BOOST_REQUIRE( !profiler.enabled() );
+
+      BOOST_TEST_MESSAGE( "Testing that nothing is recorded while profiling is disabled" );
+      push_signed_transfers( 5 );
+      generate_block();
+      BOOST_REQUIRE( profiler.get_stats().empty() );
+
+      BOOST_TEST_MESSAGE( "Testing that every phase of applied operations is recorded" );
+      profiler.set_enabled( true );
+      const uint32_t trx_count = 10;
+      push_signed_transfers( trx_count );
+      generate_block();
+
+      auto stats = profiler.get_stats();
+      auto transfer = std::find_if( stats.begin(), stats.end(), []( const operation_profiler::operation_stats& s ) { return s.name == "transfer"; } );
+      BOOST_REQUIRE( transfer != stats.end() );
+      BOOST_REQUIRE( transfer->evaluate.count >= trx_count );
+      BOOST_REQUIRE_EQUAL( transfer->fee.count, transfer->evaluate.count );
+      BOOST_REQUIRE_EQUAL( transfer->signals.count, transfer->evaluate.count );
+
+      for( const auto* phase : { &transfer->fee, &transfer->evaluate, &transfer->signals } )
+      {
+         BOOST_REQUIRE_EQUAL( std::accumulate( phase->histogram.begin(), phase->histogram.end(), uint64_t( 0 ) ), phase->count );
+         BOOST_REQUIRE( phase->max_ns <= phase->total_ns );
+         BOOST_REQUIRE( phase->p50_ns <= phase->p90_ns && phase->p90_ns <= phase->p99_ns && phase->p99_ns <= phase->max_ns );
+      }
+
+      BOOST_TEST_MESSAGE( "Testing disable and reset" );
+      profiler.set_enabled( false );
+      push_signed_transfers( 5 );
+      generate_block();
+      auto disabled_stats = profiler.get_stats();
+      auto disabled_transfer = std::find_if( disabled_stats.begin(), disabled_stats.end(), []( const operation_profiler::operation_stats& s ) { return s.name == "transfer"; } );
+      BOOST_REQUIRE( disabled_transfer != disabled_stats.end() );
+      BOOST_REQUIRE_EQUAL( disabled_transfer->evaluate.count, transfer->evaluate.count );
+
+      profiler.reset();
+      BOOST_REQUIRE( profiler.get_stats().empty() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( write_request_queue_test )
+{
+   try
+   {
+      using sophiatx::plugins::chain::write_context;
+      using sophiatx::plugins::chain::write_request_queue;
+
+      write_request_queue queue( 2 );
+      write_context requests[4];
+      write_context* cxt = nullptr;
+
+      BOOST_TEST_MESSAGE( "Testing that a full queue blocks producers until the write thread makes room" );
+      BOOST_REQUIRE( !queue.try_pop( cxt ) );
+      BOOST_REQUIRE( queue.push( &requests[0] ) );
+      BOOST_REQUIRE( queue.push( &requests[1] ) );
+
+      std::atomic< bool > pushed( false );
+      std::thread producer( [&]()
+      {
+         BOOST_REQUIRE( queue.push( &requests[2] ) );
+         pushed = true;
+      });
+
+      std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+      BOOST_REQUIRE( !pushed );
+
+      BOOST_REQUIRE( queue.pop( cxt ) );
+      BOOST_REQUIRE( cxt == &requests[0] );
+      producer.join();
+      BOOST_REQUIRE( pushed );
+
+      BOOST_REQUIRE( queue.try_pop( cxt ) );
+      BOOST_REQUIRE( cxt == &requests[1] );
+      queue.record_batch( 2, fc::milliseconds( 3 ), true );
+
+      auto stats = queue.get_stats();
+      BOOST_REQUIRE_EQUAL( stats.capacity, 2u );
+      BOOST_REQUIRE_EQUAL( stats.depth, 1u );
+      BOOST_REQUIRE_EQUAL( stats.max_depth, 2u );
+      BOOST_REQUIRE_EQUAL( stats.pushed, 3u );
+      BOOST_REQUIRE_EQUAL( stats.full_waits, 1u );
+      BOOST_REQUIRE_EQUAL( stats.batches, 1u );
+      BOOST_REQUIRE_EQUAL( stats.max_batch_size, 2u );
+      BOOST_REQUIRE_EQUAL( stats.yields, 1u );
+      BOOST_REQUIRE_EQUAL( stats.max_lock_hold_us, 3000u );
+
+      BOOST_TEST_MESSAGE( "Testing that the write thread wakes up on push" );
+      std::thread writer( [&]()
+      {
+         write_context* c = nullptr;
+         BOOST_REQUIRE( queue.pop( c ) );
+         BOOST_REQUIRE( c == &requests[2] );
+         BOOST_REQUIRE( queue.pop( c ) );
+         BOOST_REQUIRE( c == &requests[3] );
+      });
+      BOOST_REQUIRE( queue.push( &requests[3] ) );
+      writer.join();
+
+      BOOST_TEST_MESSAGE( "Testing stop" );
+      BOOST_REQUIRE( queue.push( &requests[0] ) );
+      auto remaining = queue.stop();
+      BOOST_REQUIRE_EQUAL( remaining.size(), 1u );
+      BOOST_REQUIRE( remaining.front() == &requests[0] );
+      BOOST_REQUIRE( !queue.push( &requests[1] ) );
+      BOOST_REQUIRE( !queue.pop( cxt ) );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( state_snapshot_test )
+{
+   try {
+      fc::temp_directory source_dir( sophiatx::utilities::temp_directory_path() );
+      fc::temp_directory import_dir( sophiatx::utilities::temp_directory_path() );
+      fc::path snapshot_file = source_dir.path() / "snapshot.bin";
+      fc::ecc::private_key init_account_priv_key = *(sophiatx::utilities::wif_to_key("5JPwY3bwFgfsGtxMeLkLqXzUrQDMAsqSyAZDnMBkg7PDDRhQgaV"));
+
+      genesis_state_type gen;
+      gen.genesis_time = fc::time_point_sec(1530644400);
+      database_interface::open_args args;
+      args.shared_file_size = TEST_SHARED_MEM_SIZE;
+
+      BOOST_TEST_MESSAGE( "Exporting state of a database with 50 blocks" );
+      auto db = std::make_shared<database>();
+      db->_log_hardforks = false;
+      open_test_database( db, source_dir.path() );
+      for( uint32_t i = 0; i < 50; ++i )
+         db->generate_block( db->get_slot_time(1), db->get_scheduled_witness(1), init_account_priv_key, database::skip_nothing );
+      db->close();
+      db = std::make_shared<database>();
+      db->_log_hardforks = false;
+      args.shared_mem_dir = source_dir.path();
+      db->open( args, gen );
+
+      auto digest = db->export_snapshot( snapshot_file );
+      BOOST_REQUIRE( digest == db->get_state_digest() );
+
+      BOOST_TEST_MESSAGE( "Importing the snapshot next to a copy of the block log" );
+      fc::copy( source_dir.path() / "block_log", import_dir.path() / "block_log" );
+      fc::copy( source_dir.path() / "block_log.index", import_dir.path() / "block_log.index" );
+      auto imported = std::make_shared<database>();
+      imported->_log_hardforks = false;
+      args.shared_mem_dir = import_dir.path();
+      args.snapshot_import = snapshot_file;
+      imported->open( args, gen );
+
+      BOOST_REQUIRE_EQUAL( imported->head_block_num(), db->head_block_num() );
+      BOOST_REQUIRE( imported->head_block_id() == db->head_block_id() );
+      BOOST_REQUIRE_EQUAL( imported->revision(), db->revision() );
+      BOOST_REQUIRE( imported->get_state_digest() == digest );
+      BOOST_REQUIRE_EQUAL( imported->get_account( "initminer" ).balance.amount.value, db->get_account( "initminer" ).balance.amount.value );
+
+      BOOST_TEST_MESSAGE( "Both databases produce the same block and state" );
+      auto b = db->generate_block( db->get_slot_time(1), db->get_scheduled_witness(1), init_account_priv_key, database::skip_nothing );
+      auto ib = imported->generate_block( imported->get_slot_time(1), imported->get_scheduled_witness(1), init_account_priv_key, database::skip_nothing );
+      BOOST_REQUIRE( b.id() == ib.id() );
+      BOOST_REQUIRE( db->get_state_digest() == imported->get_state_digest() );
+      imported->close();
+      db->close();
+
+      BOOST_TEST_MESSAGE( "A corrupted snapshot is rejected" );
+      {
+         std::fstream f( snapshot_file.generic_string().c_str(), std::ios::in | std::ios::out | std::ios::binary );
+         f.seekp( fc::file_size( snapshot_file ) / 2 );
+         f.put( 0x5a );
+      }
+      imported = std::make_shared<database>();
+      imported->_log_hardforks = false;
+      imported->wipe( import_dir.path(), false );
+      SOPHIATX_REQUIRE_THROW( imported->open( args, gen ), fc::exception );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( block_log_concurrent_reads )
+{
+   try {
+      fc::temp_directory data_dir( sophiatx::utilities::temp_directory_path() );
+      block_log log;
+      log.open( data_dir.path() / "block_log" );
+
+      std::vector< signed_block > blocks;
+      auto make_block = [&]()
+      {
+         signed_block b;
+         b.witness = "initminer";
+         b.timestamp = fc::time_point_sec( SOPHIATX_GENESIS_TIME ) + blocks.size() * 3;
+         if( blocks.size() )
+            b.previous = blocks.back().id();
+         blocks.push_back( b );
+         log.append( b );
+      };
+
+      for( int i = 0; i < 10; ++i )
+         make_block();
+
+      std::atomic< bool > done( false );
+      std::atomic< uint32_t > failures( 0 );
+      std::atomic< uint64_t > reads( 0 );
+      std::vector< std::thread > readers;
+      for( uint32_t t = 0; t < 4; ++t )
+      {
+         readers.emplace_back( [&, t]()
+         {
+            // Blocks past the published head are not found yet, every block that is found must be complete
+            uint32_t num = t + 1;
+            while( !done.load() )
+            {
+               auto b = log.read_block_by_num( num );
+               if( b.has_value() )
+               {
+                  ++reads;
+                  if( b->block_num() != num || b->witness != "initminer" )
+                     ++failures;
+               }
+
+               num = num % 600 + 1;
+            }
+         });
+      }
+
+      for( int i = 0; i < 590; ++i )
+         make_block();
+
+      done = true;
+      for( auto& r : readers )
+         r.join();
+      BOOST_REQUIRE_EQUAL( failures.load(), 0u );
+      BOOST_REQUIRE( reads.load() > 0 );
+
+      BOOST_REQUIRE( log.head()->id() == blocks.back().id() );
+      BOOST_REQUIRE( log.read_head().id() == blocks.back().id() );
+      BOOST_REQUIRE( !log.read_block_by_num( 601 ).has_value() );
+      for( uint32_t i = 1; i <= blocks.size(); ++i )
+         BOOST_REQUIRE( log.read_block_by_num( i )->id() == blocks[ i - 1 ].id() );
+
+      auto raw = log.read_raw_blocks( 591, 10 );
+      BOOST_REQUIRE_EQUAL( raw.size(), 10u );
+      BOOST_REQUIRE( fc::raw::unpack_from_vector< signed_block >( raw.back(), 0 ).id() == blocks.back().id() );
+
+      log.close();
+      log.open( data_dir.path() / "block_log" );
+      BOOST_REQUIRE( log.head()->id() == blocks.back().id() );
+      BOOST_REQUIRE( log.read_block_by_num( 300 )->id() == blocks[ 299 ].id() );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( compressed_block_log_test )
+{
+   try {
+      fc::temp_directory data_dir( sophiatx::utilities::temp_directory_path() );
+      fc::path file = data_dir.path() / "block_log";
+
+      std::vector< signed_block > blocks;
+      block_log log;
+      log.open( file, 64 );
+      BOOST_REQUIRE( compressed_block_log::is_compressed( file ) );
+
+      auto append_blocks = [&]( uint32_t count )
+      {
+         for( uint32_t i = 0; i < count; ++i )
+         {
+            signed_block b;
+            b.witness = "initminer";
+            b.timestamp = fc::time_point_sec( SOPHIATX_GENESIS_TIME ) + blocks.size() * 3;
+            if( blocks.size() )
+               b.previous = blocks.back().id();
+            blocks.push_back( b );
+            BOOST_REQUIRE_EQUAL( log.append( b ), blocks.size() - 1 );
+         }
+      };
+
+      auto check_blocks = [&]()
+      {
+         BOOST_REQUIRE( log.head()->id() == blocks.back().id() );
+         BOOST_REQUIRE( log.read_head().id() == blocks.back().id() );
+         BOOST_REQUIRE( !log.read_block_by_num( blocks.size() + 1 ).has_value() );
+         BOOST_REQUIRE_EQUAL( log.get_block_pos( blocks.size() + 1 ), block_log::npos );
+
+         for( uint32_t i = blocks.size(); i > 0; i -= std::min< uint32_t >( i, 7 ) )
+            BOOST_REQUIRE( log.read_block_by_num( i )->id() == blocks[ i - 1 ].id() );
+
+         auto itr = log.read_block( log.get_block_pos( 1 ) );
+         for( uint32_t i = 1; i < blocks.size(); ++i )
+         {
+            BOOST_REQUIRE( itr.first.id() == blocks[ i - 1 ].id() );
+            itr = log.read_block( itr.second );
+         }
+         BOOST_REQUIRE( itr.first.id() == blocks.back().id() );
+
+         // Across a chunk boundary into the uncompressed tail
+         uint32_t first = blocks.size() - 70;
+         auto raw = log.read_raw_blocks( first, 70 );
+         BOOST_REQUIRE_EQUAL( raw.size(), 70u );
+         for( uint32_t i = 0; i < raw.size(); ++i )
+            BOOST_REQUIRE( fc::raw::unpack_from_vector< signed_block >( raw[i], 0 ).id() == blocks[ first + i - 1 ].id() );
+      };
+
+      append_blocks( 300 );
+      check_blocks();
+
+      // Existing logs keep their format
+      log.close();
+      log.open( file );
+      check_blocks();
+      append_blocks( 30 );
+      check_blocks();
+
+      // The index is reconstructed from the chunk sizes
+      log.close();
+      fc::remove_all( fc::path( file.generic_string() + ".index" ) );
+      log.open( file );
+      check_blocks();
+
+      {
+         compressed_block_log clog;
+         clog.open( file );
+         BOOST_REQUIRE_EQUAL( clog.blocks_per_chunk(), 64u );
+         BOOST_REQUIRE_EQUAL( clog.chunk_count(), 330u / 64 );
+         BOOST_REQUIRE_EQUAL( clog.head_block_num(), 330u );
+      }
+
+      // Read only opens do not touch the files, not even to rebuild a missing index
+      {
+         log.close();
+         auto size = fc::file_size( file );
+         auto tail_size = fc::file_size( fc::path( file.generic_string() + ".tail" ) );
+         fc::remove_all( fc::path( file.generic_string() + ".index" ) );
+
+         log.open_read_only( file );
+         check_blocks();
+         SOPHIATX_REQUIRE_THROW( log.append( blocks.back() ), fc::exception );
+         log.close();
+
+         BOOST_REQUIRE( !fc::exists( fc::path( file.generic_string() + ".index" ) ) );
+         BOOST_REQUIRE_EQUAL( fc::file_size( file ), size );
+         BOOST_REQUIRE_EQUAL( fc::file_size( fc::path( file.generic_string() + ".tail" ) ), tail_size );
+      }
+
+      // A raw log stays raw
+      fc::path raw_file = data_dir.path() / "raw_block_log";
+      block_log raw_log;
+      raw_log.open( raw_file );
+      for( const auto& b : blocks )
+         raw_log.append( b );
+      raw_log.close();
+      raw_log.open( raw_file, 64 );
+      BOOST_REQUIRE( !compressed_block_log::is_compressed( raw_file ) );
+      BOOST_REQUIRE( raw_log.read_head().id() == blocks.back().id() );
+
+      raw_log.close();
+      raw_log.open_read_only( raw_file );
+      BOOST_REQUIRE( raw_log.read_block_by_num( 1 )->id() == blocks.front().id() );
+      BOOST_REQUIRE( raw_log.read_head().id() == blocks.back().id() );
+      SOPHIATX_REQUIRE_THROW( raw_log.append( blocks.back() ), fc::exception );
+
+      // A stale index is rejected instead of being rebuilt
+      raw_log.close();
+      fc::path raw_index = fc::path( raw_file.generic_string() + ".index" );
+      fc::resize_file( raw_index, fc::file_size( raw_index ) - sizeof( uint64_t ) );
+      SOPHIATX_REQUIRE_THROW( raw_log.open_read_only( raw_file ), fc::exception );
+      BOOST_REQUIRE_EQUAL( fc::file_size( raw_index ), sizeof( uint64_t ) * ( blocks.size() - 1 ) );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_FIXTURE_TEST_CASE( hardfork_test, database_fixture )
 {
    try
@@ -9,6 +9,7 @@
 #include <sophiatx/chain/database/database_exceptions.hpp>
 #include <sophiatx/chain/sophiatx_objects.hpp>
 #include <sophiatx/chain/application_object.hpp>
+#include <sophiatx/chain/custom_content_object.hpp>
 
 #include <fc/macros.hpp>
 #include <fc/crypto/digest.hpp>
@@ -1488,6 +1489,72 @@ BOOST_AUTO_TEST_CASE( custom_binary_authorities )
    BOOST_REQUIRE( auths == expected );
 }*/
 
+BOOST_AUTO_TEST_CASE( custom_content_apply )
+{
+   try
+   {
+      BOOST_TEST_MESSAGE( "Testing: custom_content_apply" );
+
+      ACTORS( (alice)(bob)(sam) )
+      fund( AN("alice"), 10000000 );
+
+      auto symbol = chain::sophiatx_config::get<protocol::asset_symbol_type>("SOPHIATX_SYMBOL");
+
+      custom_json_operation json_op;
+      json_op.sender = AN("alice");
+      json_op.recipients = { AN("bob"), AN("sam") };
+      json_op.app_id = 1;
+      json_op.json = "{\"message\":\"hello\"}";
+      json_op.fee = json_op.get_required_fee( symbol );
+
+      custom_binary_operation binary_op;
+      binary_op.sender = AN("alice");
+      binary_op.recipients = { AN("bob") };
+      binary_op.app_id = 1;
+      binary_op.data = { 1, 2, 3 };
+      binary_op.fee = binary_op.get_required_fee( symbol );
+
+      signed_transaction tx;
+      tx.set_expiration( db->head_block_time() + SOPHIATX_MAX_TIME_UNTIL_EXPIRATION );
+      tx.operations.push_back( json_op );
+      tx.operations.push_back( binary_op );
+      sign( tx, alice_private_key );
+      db->push_transaction( tx, 0 );
+
+      BOOST_TEST_MESSAGE( "--- Test the document is stored once for all of its recipients" );
+      const auto& content_idx = db->get_index< custom_content_index, by_sender >();
+      BOOST_REQUIRE_EQUAL( db->get_index< custom_content_index >().indices().size(), 2u );
+
+      auto json_doc = content_idx.find( boost::make_tuple( AN("alice"), uint64_t(1), uint64_t(1) ) );
+      BOOST_REQUIRE( json_doc != content_idx.end() );
+      BOOST_REQUIRE( !json_doc->binary );
+      BOOST_REQUIRE( to_string( json_doc->json ) == json_op.json );
+      BOOST_REQUIRE_EQUAL( json_doc->all_recipients.size(), 2u );
+      BOOST_REQUIRE_EQUAL( json_doc->app_message_sequence, 1u );
+
+      auto binary_doc = content_idx.find( boost::make_tuple( AN("alice"), uint64_t(1), uint64_t(2) ) );
+      BOOST_REQUIRE( binary_doc != content_idx.end() );
+      BOOST_REQUIRE( binary_doc->binary );
+      BOOST_REQUIRE( std::vector< char >( binary_doc->data.begin(), binary_doc->data.end() ) == binary_op.data );
+      BOOST_REQUIRE_EQUAL( binary_doc->app_message_sequence, 2u );
+
+      BOOST_TEST_MESSAGE( "--- Test the recipients reference the document with their own sequences" );
+      const auto& recipient_idx = db->get_index< custom_content_recipient_index, by_recipient >();
+      BOOST_REQUIRE_EQUAL( db->get_index< custom_content_recipient_index >().indices().size(), 3u );
+
+      auto entry = recipient_idx.find( boost::make_tuple( AN("bob"), uint64_t(1), uint64_t(1) ) );
+      BOOST_REQUIRE( entry != recipient_idx.end() && entry->content == json_doc->id );
+      entry = recipient_idx.find( boost::make_tuple( AN("bob"), uint64_t(1), uint64_t(2) ) );
+      BOOST_REQUIRE( entry != recipient_idx.end() && entry->content == binary_doc->id );
+      entry = recipient_idx.find( boost::make_tuple( AN("sam"), uint64_t(1), uint64_t(1) ) );
+      BOOST_REQUIRE( entry != recipient_idx.end() && entry->content == json_doc->id );
+      BOOST_REQUIRE( entry->received == json_doc->received );
+
+      validate_database();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE( feed_publish_validate )
 {
    try
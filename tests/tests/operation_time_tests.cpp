@@ -11,6 +11,7 @@
 
 
 #include <sophiatx/plugins/debug_node/debug_node_plugin.hpp>
+#include <sophiatx/plugins/account_history/account_history_plugin.hpp>
 
 #include <fc/macros.hpp>
 #include <fc/crypto/digest.hpp>
@@ -543,4 +544,70 @@ BOOST_AUTO_TEST_CASE( clear_null_account )
    FC_LOG_AND_RETHROW()*/
 }
 
+BOOST_AUTO_TEST_CASE( account_history_pruning )
+{
+   try
+   {
+      ACTORS( (alice)(bob) )
+      fund( AN("alice"), 100000000 );
+      generate_block();
+
+      const auto& history = appbase::app().get_plugin< sophiatx::plugins::account_history::account_history_plugin >();
+      const auto& hist_idx = db->get_index< account_history_index, by_account >();
+      const auto& op_idx = db->get_index< operation_index, by_id >();
+      auto count_entries = [&]( const account_name_type& account )
+      {
+         uint32_t count = 0;
+         for( auto itr = hist_idx.lower_bound( boost::make_tuple( account, uint32_t( -1 ) ) ); itr != hist_idx.end() && itr->account == account; ++itr )
+            ++count;
+         return count;
+      };
+
+      BOOST_TEST_MESSAGE( "Creating history older than the retention" );
+      auto amount = asset( 10, chain::sophiatx_config::get< protocol::asset_symbol_type >( "SOPHIATX_SYMBOL" ) );
+      for( int i = 0; i < 40; ++i )
+         transfer( AN("alice"), AN("bob"), amount );
+      generate_block();
+      BOOST_REQUIRE( count_entries( AN("alice") ) > 40 );
+
+      generate_blocks( db->head_block_time() + fc::days( 31 ), true );
+      if( db->head_block_num() % 1200 == 0 )
+         generate_block();
+
+      BOOST_TEST_MESSAGE( "Entries are only removed by the periodic pass" );
+      transfer( AN("alice"), AN("bob"), amount );
+      generate_block();
+      auto entries = count_entries( AN("alice") );
+      auto operations = op_idx.size();
+      auto stats = history.get_prune_stats();
+      BOOST_REQUIRE( entries > 40 );
+
+      generate_blocks( 1200 - db->head_block_num() % 1200 );
+
+      BOOST_TEST_MESSAGE( "The pass keeps the latest 30 entries and removes the operations nobody references" );
+      BOOST_REQUIRE_EQUAL( count_entries( AN("alice") ), 30u );
+      BOOST_REQUIRE_EQUAL( count_entries( AN("bob") ), 30u );
+      BOOST_REQUIRE( op_idx.size() < operations );
+
+      auto new_stats = history.get_prune_stats();
+      BOOST_REQUIRE( new_stats.passes > stats.passes );
+      BOOST_REQUIRE( new_stats.history_entries - stats.history_entries >= entries - 30 );
+      BOOST_REQUIRE( new_stats.operations > stats.operations );
+      BOOST_REQUIRE( new_stats.bytes > stats.bytes );
+      BOOST_REQUIRE_EQUAL( new_stats.last_block, db->head_block_num() );
+
+      BOOST_TEST_MESSAGE( "A pass undone with its block is repeated by the block replacing it" );
+      db->pop_block();
+      BOOST_REQUIRE_EQUAL( count_entries( AN("alice") ), entries );
+      BOOST_REQUIRE_EQUAL( history.get_prune_stats().passes, new_stats.passes - 1 );
+
+      generate_block();
+      BOOST_REQUIRE_EQUAL( count_entries( AN("alice") ), 30u );
+      BOOST_REQUIRE_EQUAL( history.get_prune_stats().passes, new_stats.passes );
+
+      validate_database();
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()